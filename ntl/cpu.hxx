@@ -14,6 +14,8 @@ namespace ntl {
   namespace intrinsic {
     extern "C" void __cdecl _mm_pause();
     #pragma intrinsic(_mm_pause)
+    extern "C" void __cdecl _mm_prefetch(const char* p, int hint);
+    #pragma intrinsic(_mm_prefetch)
   }
 
   /// CPU functions
@@ -29,6 +31,16 @@ namespace ntl {
         intrinsic::_mm_pause();
     }
 
+    /** Hints the processor to fetch the cache line containing \p p into all levels of the cache hierarchy */
+    static inline void prefetch(const void* p)
+    {
+    #ifdef __GNUC__
+      __builtin_prefetch(p);
+    #else
+      intrinsic::_mm_prefetch(static_cast<const char*>(p), 1 /* _MM_HINT_T0 */);
+    #endif
+    }
+
 #ifdef NTL__NT_BASEDEF
     static inline void yield() { ntl::nt::ZwYieldExecution(); }
 #endif
@@ -0,0 +1,1099 @@
+/**\file*********************************************************************
+ *                                                                     \brief
+ *  Intrusive containers
+ *
+ ****************************************************************************
+ */
+#ifndef NTL__INTRUSIVE
+#define NTL__INTRUSIVE
+#pragma once
+
+#include "linked_list.hxx"
+#include "stlx/functional.hxx"
+#include "stlx/utility.hxx"
+#include "stlx/cassert.hxx"
+
+namespace ntl {
+
+/**
+ *  Intrusive containers.
+ *
+ *  The containers link the objects through the hooks embedded into them and addressed by the member pointer,
+ *  so an object may live in several containers at once (one hook per container). The containers never allocate
+ *  and never copy or destroy the objects; the object must outlive its membership.
+ *
+ *  - list    : circular doubly linked list on linked<2> (the native \c LIST_ENTRY);
+ *  - slist   : singly linked list on linked<1> (the native \c SINGLE_LIST_ENTRY) with O(1) push_back;
+ *  - hash_set: chained hash table on linked<2> over a bucket array supplied by the user;
+ *  - rbtree  : red-black tree on rbtree_hook.
+ *
+ *  Every container except slist unlinks an element in O(1) given the element itself (the rbtree rebalancing is
+ *  amortized O(1)). Unlinked list and hash_set hooks are reset, so is_linked() tells whether an object is in a container.
+ **/
+namespace intrusive {
+
+  /// Conversion between an object and its hook addressed by the member pointer
+  template<class T, class Hook, Hook T::* Member>
+  struct member_hook
+  {
+    typedef T     value_type;
+    typedef Hook  hook_type;
+
+    static hook_type* to_hook(T& x) { return &(x.*Member); }
+    static const hook_type* to_hook(const T& x) { return &(x.*Member); }
+
+    static T* to_value(hook_type* h)
+    {
+      return reinterpret_cast<T*>(reinterpret_cast<char*>(h) - offset());
+    }
+    static const T* to_value(const hook_type* h)
+    {
+      return reinterpret_cast<const T*>(reinterpret_cast<const char*>(h) - offset());
+    }
+
+  private:
+    static ptrdiff_t offset()
+    {
+      // any suitably aligned address fits, the object is never accessed
+      T* const p = reinterpret_cast<T*>(0x1000);
+      return reinterpret_cast<char*>(&(p->*Member)) - reinterpret_cast<char*>(p);
+    }
+  };
+
+  namespace __
+  {
+    /// Bidirectional iterator over the linked<2> hooks
+    template<class Hooks, class Value>
+    struct list_iterator:
+      public std::iterator<std::bidirectional_iterator_tag, Value, ptrdiff_t, Value*, Value&>
+    {
+      typedef typename Hooks::value_type value_type;
+      typedef linked<2> hook_type;
+
+      list_iterator() : p() {}
+      list_iterator(const list_iterator<Hooks, value_type>& i) : p(i.p) {}
+      explicit list_iterator(const hook_type* p) : p(const_cast<hook_type*>(p)) {}
+
+      Value& operator* () const { return *Hooks::to_value(p); }
+      Value* operator->() const { return Hooks::to_value(p); }
+      list_iterator& operator++() { p = p->next; return *this; }
+      list_iterator& operator--() { p = p->prev; return *this; }
+      list_iterator operator++(int) { list_iterator tmp(*this); ++*this; return tmp; }
+      list_iterator operator--(int) { list_iterator tmp(*this); --*this; return tmp; }
+
+      friend bool operator==(const list_iterator& x, const list_iterator& y) { return x.p == y.p; }
+      friend bool operator!=(const list_iterator& x, const list_iterator& y) { return x.p != y.p; }
+
+      hook_type* p;
+    };
+
+    /// Forward iterator over the linked<1> hooks
+    template<class Hooks, class Value>
+    struct slist_iterator:
+      public std::iterator<std::forward_iterator_tag, Value, ptrdiff_t, Value*, Value&>
+    {
+      typedef typename Hooks::value_type value_type;
+      typedef linked<1> hook_type;
+
+      slist_iterator() : p() {}
+      slist_iterator(const slist_iterator<Hooks, value_type>& i) : p(i.p) {}
+      explicit slist_iterator(const hook_type* p) : p(const_cast<hook_type*>(p)) {}
+
+      Value& operator* () const { return *Hooks::to_value(p); }
+      Value* operator->() const { return Hooks::to_value(p); }
+      slist_iterator& operator++() { p = p->next; return *this; }
+      slist_iterator operator++(int) { slist_iterator tmp(*this); ++*this; return tmp; }
+
+      friend bool operator==(const slist_iterator& x, const slist_iterator& y) { return x.p == y.p; }
+      friend bool operator!=(const slist_iterator& x, const slist_iterator& y) { return x.p != y.p; }
+
+      hook_type* p;
+    };
+  }
+
+
+  /**
+   *	@brief Intrusive doubly linked list
+   *  @details The list is circular with the head as a sentinel, so its layout is the native \c LIST_ENTRY.
+   **/
+  template<class T, linked<2> T::* Hook>
+  class list
+  {
+    list(const list&) __deleted;
+    list& operator=(const list&) __deleted;
+
+    typedef member_hook<T, linked<2>, Hook> hooks;
+  public:
+    typedef T                                             value_type;
+    typedef T&                                            reference;
+    typedef const T&                                      const_reference;
+    typedef T*                                            pointer;
+    typedef const T*                                      const_pointer;
+    typedef size_t                                        size_type;
+    typedef ptrdiff_t                                     difference_type;
+    typedef linked<2>                                     hook_type;
+
+    typedef __::list_iterator<hooks, T>                   iterator;
+    typedef __::list_iterator<hooks, const T>             const_iterator;
+    typedef std::reverse_iterator<iterator>               reverse_iterator;
+    typedef std::reverse_iterator<const_iterator>         const_reverse_iterator;
+
+    list()
+      :size_()
+    {
+      head_.prev = head_.next = &head_;
+    }
+
+    /** The elements stay as they are, but their hooks are reset */
+    ~list()
+    {
+      clear();
+    }
+
+    ///\name iterators
+    iterator        begin()       { return iterator(head_.next); }
+    const_iterator  begin() const { return const_iterator(head_.next); }
+    iterator        end()         { return iterator(&head_); }
+    const_iterator  end()   const { return const_iterator(&head_); }
+
+    reverse_iterator        rbegin()       { return reverse_iterator(end()); }
+    const_reverse_iterator  rbegin() const { return const_reverse_iterator(end()); }
+    reverse_iterator        rend()         { return reverse_iterator(begin()); }
+    const_reverse_iterator  rend()   const { return const_reverse_iterator(begin()); }
+
+    /** Returns the iterator to the linked element \p x */
+    iterator        iterator_to(reference x)             { return iterator(hooks::to_hook(x)); }
+    const_iterator  iterator_to(const_reference x) const { return const_iterator(hooks::to_hook(x)); }
+
+    ///\name capacity
+    bool      empty() const { return head_.next == &head_; }
+    size_type size()  const { return size_; }
+
+    ///\name element access
+    reference       front()       { assert(!empty()); return *begin(); }
+    const_reference front() const { assert(!empty()); return *begin(); }
+    reference       back()        { assert(!empty()); return *hooks::to_value(head_.prev); }
+    const_reference back()  const { assert(!empty()); return *hooks::to_value(head_.prev); }
+
+    ///\name modifiers
+    void push_front(reference x)  { insert(begin(), x); }
+    void push_back(reference x)   { insert(end(), x); }
+    void pop_front()              { assert(!empty()); erase(begin()); }
+    void pop_back()               { assert(!empty()); erase(iterator(head_.prev)); }
+
+    /** Links \p x before \p position */
+    iterator insert(const_iterator position, reference x)
+    {
+      hook_type* const h = hooks::to_hook(x);
+      assert(!is_linked(x));
+      h->link(position.p->prev, position.p);
+      ++size_;
+      return iterator(h);
+    }
+
+    /** Unlinks the element at \p position, returns the iterator to the next one */
+    iterator erase(const_iterator position)
+    {
+      assert(position != end());
+      hook_type* const h = position.p, * const next = h->next;
+      unlink(h);
+      return iterator(next);
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+      while(first != last)
+        first = erase(first);
+      return iterator(last.p);
+    }
+
+    /** Unlinks \p x in O(1) */
+    void erase(reference x)
+    {
+      assert(is_linked(x));
+      unlink(hooks::to_hook(x));
+    }
+
+    void clear()
+    {
+      for(hook_type* h = head_.next; h != &head_; ){
+        hook_type* const next = h->next;
+        h->prev = h->next = nullptr;
+        h = next;
+      }
+      head_.prev = head_.next = &head_;
+      size_ = 0;
+    }
+
+    /** Moves all elements of \p x before \p position */
+    void splice(const_iterator position, list& x)
+    {
+      if(x.empty() || &x == this)
+        return;
+      hook_type* const first = x.head_.next, * const last = x.head_.prev, * const pos = position.p;
+      first->prev = pos->prev;
+      pos->prev->next = first;
+      last->next = pos;
+      pos->prev = last;
+      size_ += x.size_;
+      x.head_.prev = x.head_.next = &x.head_;
+      x.size_ = 0;
+    }
+
+    /** Moves the element \p i of \p x before \p position */
+    void splice(const_iterator position, list& x, const_iterator i)
+    {
+      hook_type* const h = i.p;
+      if(h == position.p || h->next == position.p)
+        return;
+      hook_type::unlink(h->prev, h->next);
+      --x.size_;
+      h->link(position.p->prev, position.p);
+      ++size_;
+    }
+
+    void swap(list& x)
+    {
+      if(this == &x)
+        return;
+      list tmp;
+      tmp.splice(tmp.end(), x);
+      x.splice(x.end(), *this);
+      splice(end(), tmp);
+    }
+
+    ///\name operations
+    template<class Predicate>
+    void remove_if(Predicate pred)
+    {
+      for(iterator i = begin(); i != end(); )
+        if(pred(*i))
+          i = erase(i);
+        else
+          ++i;
+    }
+
+    /** Checks whether the hook of \p x is linked to some list */
+    static bool is_linked(const_reference x) { return hooks::to_hook(x)->next != nullptr; }
+    ///\}
+
+  private:
+    void unlink(hook_type* h)
+    {
+      h->unlink();
+      h->prev = h->next = nullptr;
+      --size_;
+    }
+
+    hook_type head_;
+    size_type size_;
+  };
+
+
+  /**
+   *	@brief Intrusive singly linked list
+   *  @details The list is null-terminated and keeps the tail, so it works as a FIFO queue as well as a stack.
+   *  Unlinking an element requires its predecessor: erase_after() is O(1), erase(x) is O(N).
+   **/
+  template<class T, linked<1> T::* Hook>
+  class slist
+  {
+    slist(const slist&) __deleted;
+    slist& operator=(const slist&) __deleted;
+
+    typedef member_hook<T, linked<1>, Hook> hooks;
+  public:
+    typedef T                                             value_type;
+    typedef T&                                            reference;
+    typedef const T&                                      const_reference;
+    typedef T*                                            pointer;
+    typedef const T*                                      const_pointer;
+    typedef size_t                                        size_type;
+    typedef ptrdiff_t                                     difference_type;
+    typedef linked<1>                                     hook_type;
+
+    typedef __::slist_iterator<hooks, T>                  iterator;
+    typedef __::slist_iterator<hooks, const T>            const_iterator;
+
+    slist()
+      :tail_(&head_), size_()
+    {
+      head_.next = nullptr;
+    }
+
+    ~slist()
+    {
+      clear();
+    }
+
+    ///\name iterators
+    iterator        before_begin()       { return iterator(&head_); }
+    const_iterator  before_begin() const { return const_iterator(&head_); }
+    iterator        begin()              { return iterator(head_.next); }
+    const_iterator  begin()        const { return const_iterator(head_.next); }
+    iterator        end()                { return iterator(nullptr); }
+    const_iterator  end()          const { return const_iterator(nullptr); }
+
+    iterator        iterator_to(reference x)             { return iterator(hooks::to_hook(x)); }
+    const_iterator  iterator_to(const_reference x) const { return const_iterator(hooks::to_hook(x)); }
+
+    ///\name capacity
+    bool      empty() const { return head_.next == nullptr; }
+    size_type size()  const { return size_; }
+
+    ///\name element access
+    reference       front()       { assert(!empty()); return *begin(); }
+    const_reference front() const { assert(!empty()); return *begin(); }
+    reference       back()        { assert(!empty()); return *hooks::to_value(tail_); }
+    const_reference back()  const { assert(!empty()); return *hooks::to_value(tail_); }
+
+    ///\name modifiers
+    void push_front(reference x)  { insert_after(before_begin(), x); }
+    void push_back(reference x)   { insert_after(iterator(tail_), x); }
+    void pop_front()              { assert(!empty()); erase_after(before_begin()); }
+
+    /** Links \p x after \p position */
+    iterator insert_after(const_iterator position, reference x)
+    {
+      hook_type* const h = hooks::to_hook(x);
+      h->link(position.p);
+      if(tail_ == position.p)
+        tail_ = h;
+      ++size_;
+      return iterator(h);
+    }
+
+    /** Unlinks the element after \p position, returns the iterator to the next one */
+    iterator erase_after(const_iterator position)
+    {
+      hook_type* const h = position.p->next;
+      assert(h != nullptr);
+      h->unlink(position.p);
+      if(tail_ == h)
+        tail_ = position.p;
+      h->next = nullptr;
+      --size_;
+      return iterator(position.p->next);
+    }
+
+    /** Unlinks \p x, O(N) */
+    void erase(reference x)
+    {
+      const hook_type* const h = hooks::to_hook(x);
+      for(hook_type* prev = &head_; prev->next; prev = prev->next)
+        if(prev->next == h){
+          erase_after(const_iterator(prev));
+          return;
+        }
+      assert(!"element is not in the list");
+    }
+
+    void clear()
+    {
+      for(hook_type* h = head_.next; h; ){
+        hook_type* const next = h->next;
+        h->next = nullptr;
+        h = next;
+      }
+      head_.next = nullptr;
+      tail_ = &head_;
+      size_ = 0;
+    }
+
+    void swap(slist& x)
+    {
+      using std::swap;
+      swap(head_.next, x.head_.next);
+      swap(size_, x.size_);
+      swap(tail_, x.tail_);
+      if(!head_.next) tail_ = &head_;
+      if(!x.head_.next) x.tail_ = &x.head_;
+    }
+    ///\}
+
+  private:
+    hook_type head_;
+    hook_type* tail_;
+    size_type size_;
+  };
+
+
+  /**
+   *	@brief Intrusive hash set
+   *  @details A chained hash table over the bucket array supplied by the user; each bucket is a circular linked<2> list.
+   *  The table never rehashes itself: call rehash() with a new bucket array when load_factor() gets too high.
+   *  Lookups with a key of another type use \c hash(key) and \c equal(key, value).
+   **/
+  template<class T, linked<2> T::* Hook, class Hash = std::hash<T>, class Pred = std::equal_to<T> >
+  class hash_set
+  {
+    hash_set(const hash_set&) __deleted;
+    hash_set& operator=(const hash_set&) __deleted;
+
+    typedef member_hook<T, linked<2>, Hook> hooks;
+
+    template<class Value>
+    struct iterator_impl:
+      public std::iterator<std::forward_iterator_tag, Value, ptrdiff_t, Value*, Value&>
+    {
+      iterator_impl() : p(), bucket(), last() {}
+      iterator_impl(const iterator_impl<T>& i) : p(i.p), bucket(i.bucket), last(i.last) {}
+
+      Value& operator* () const { return *hooks::to_value(p); }
+      Value* operator->() const { return hooks::to_value(p); }
+      iterator_impl& operator++()
+      {
+        p = p->next;
+        if(p == bucket)
+          skip_empty(bucket+1);
+        return *this;
+      }
+      iterator_impl operator++(int) { iterator_impl tmp(*this); ++*this; return tmp; }
+
+      friend bool operator==(const iterator_impl& x, const iterator_impl& y) { return x.p == y.p; }
+      friend bool operator!=(const iterator_impl& x, const iterator_impl& y) { return x.p != y.p; }
+
+      iterator_impl(linked<2>* p, linked<2>* bucket, linked<2>* last)
+        :p(p), bucket(bucket), last(last)
+      {}
+
+      /** moves to the first element of the first non-empty bucket starting from \p b */
+      void skip_empty(linked<2>* b)
+      {
+        for(; b != last; ++b)
+          if(b->next != b){
+            bucket = b;
+            p = b->next;
+            return;
+          }
+        p = nullptr;
+      }
+
+      linked<2> *p, *bucket, *last;
+    };
+
+  public:
+    typedef T                                             key_type;
+    typedef T                                             value_type;
+    typedef Hash                                          hasher;
+    typedef Pred                                          key_equal;
+    typedef T&                                            reference;
+    typedef const T&                                      const_reference;
+    typedef T*                                            pointer;
+    typedef const T*                                      const_pointer;
+    typedef size_t                                        size_type;
+    typedef ptrdiff_t                                     difference_type;
+    typedef linked<2>                                     hook_type;
+    typedef linked<2>                                     bucket_type;
+
+    typedef iterator_impl<T>                              iterator;
+    typedef iterator_impl<const T>                        const_iterator;
+
+    /** Uses \p buckets array of \p n buckets, which must outlive the set */
+    hash_set(bucket_type* buckets, size_type n, const Hash& hf = Hash(), const Pred& eql = Pred())
+      :buckets_(buckets), bucket_count_(n), size_(), hash_(hf), equal_(eql)
+    {
+      assert(buckets && n);
+      init_buckets(buckets, n);
+    }
+
+    ~hash_set()
+    {
+      clear();
+    }
+
+    ///\name iterators
+    iterator begin()
+    {
+      iterator i(nullptr, buckets_, buckets_ + bucket_count_);
+      i.skip_empty(buckets_);
+      return i;
+    }
+    const_iterator begin() const  { return const_cast<hash_set*>(this)->begin(); }
+    iterator end()                { return iterator(nullptr, nullptr, nullptr); }
+    const_iterator end() const    { return const_iterator(nullptr, nullptr, nullptr); }
+
+    iterator iterator_to(reference x)
+    {
+      hook_type* const h = hooks::to_hook(x);
+      return iterator(h, buckets_ + bucket(x), buckets_ + bucket_count_);
+    }
+    const_iterator iterator_to(const_reference x) const { return const_cast<hash_set*>(this)->iterator_to(const_cast<reference>(x)); }
+
+    ///\name capacity
+    bool      empty() const { return size_ == 0; }
+    size_type size()  const { return size_; }
+
+    ///\name modifiers
+    /** Links \p x unless an equal element is linked already */
+    std::pair<iterator, bool> insert(reference x)
+    {
+      const size_type n = bucket(x);
+      bucket_type* const b = buckets_ + n;
+      for(hook_type* h = b->next; h != b; h = h->next)
+        if(equal_(x, *hooks::to_value(h)))
+          return std::make_pair(iterator(h, b, buckets_ + bucket_count_), false);
+      hook_type* const h = hooks::to_hook(x);
+      assert(!is_linked(x));
+      h->link(b);
+      ++size_;
+      return std::make_pair(iterator(h, b, buckets_ + bucket_count_), true);
+    }
+
+    /** Unlinks \p x in O(1) */
+    void erase(reference x)
+    {
+      assert(is_linked(x));
+      unlink(hooks::to_hook(x));
+    }
+
+    iterator erase(const_iterator position)
+    {
+      iterator next(position.p, position.bucket, position.last);
+      ++next;
+      unlink(position.p);
+      return next;
+    }
+
+    template<class K>
+    size_type erase_key(const K& k)
+    {
+      iterator i = find(k);
+      if(i == end())
+        return 0;
+      erase(i);
+      return 1;
+    }
+
+    void clear()
+    {
+      for(bucket_type* b = buckets_; b != buckets_ + bucket_count_; ++b){
+        for(hook_type* h = b->next; h != b; ){
+          hook_type* const next = h->next;
+          h->prev = h->next = nullptr;
+          h = next;
+        }
+        b->prev = b->next = b;
+      }
+      size_ = 0;
+    }
+
+    ///\name lookup
+    template<class K>
+    iterator find(const K& k)
+    {
+      bucket_type* const b = buckets_ + hash_(k) % bucket_count_;
+      for(hook_type* h = b->next; h != b; h = h->next)
+        if(equal_(k, *hooks::to_value(h)))
+          return iterator(h, b, buckets_ + bucket_count_);
+      return end();
+    }
+
+    template<class K>
+    const_iterator find(const K& k) const { return const_cast<hash_set*>(this)->find(k); }
+
+    template<class K>
+    size_type count(const K& k) const { return find(k) != end() ? 1 : 0; }
+
+    ///\name bucket interface
+    size_type bucket_count() const { return bucket_count_; }
+    size_type bucket(const_reference x) const { return hash_(x) % bucket_count_; }
+
+    ///\name hash policy
+    float load_factor() const { return static_cast<float>(size_) / static_cast<float>(bucket_count_); }
+
+    /** Relinks all elements into the \p buckets array of \p n buckets; the old array is not used anymore */
+    void rehash(bucket_type* buckets, size_type n)
+    {
+      assert(buckets && n);
+      init_buckets(buckets, n);
+      for(bucket_type* b = buckets_; b != buckets_ + bucket_count_; ++b){
+        for(hook_type* h = b->next; h != b; ){
+          hook_type* const next = h->next;
+          h->link(buckets + hash_(*hooks::to_value(h)) % n);
+          h = next;
+        }
+      }
+      buckets_ = buckets;
+      bucket_count_ = n;
+    }
+
+    ///\name observers
+    hasher    hash_function() const { return hash_; }
+    key_equal key_eq()        const { return equal_; }
+
+    static bool is_linked(const_reference x) { return hooks::to_hook(x)->next != nullptr; }
+    ///\}
+
+  private:
+    static void init_buckets(bucket_type* buckets, size_type n)
+    {
+      for(bucket_type* b = buckets; b != buckets + n; ++b)
+        b->prev = b->next = b;
+    }
+
+    void unlink(hook_type* h)
+    {
+      h->unlink();
+      h->prev = h->next = nullptr;
+      --size_;
+    }
+
+    bucket_type* buckets_;
+    size_type bucket_count_;
+    size_type size_;
+    Hash hash_;
+    Pred equal_;
+  };
+
+
+  /// Red-black tree hook
+  struct rbtree_hook
+  {
+    enum color_type { black, red };
+
+    rbtree_hook* child[2];
+    uintptr_t parent_and_color; // pointers are always aligned
+
+    color_type color() const { return color_type(parent_and_color & 1); }
+    void color(color_type c) { parent_and_color = (parent_and_color & ~uintptr_t(1)) | c; }
+    rbtree_hook* parent() const { return reinterpret_cast<rbtree_hook*>(parent_and_color & ~uintptr_t(1)); }
+    void parent(rbtree_hook* p)
+    {
+      assert( (reinterpret_cast<uintptr_t>(p) & 1) == 0 );
+      parent_and_color = reinterpret_cast<uintptr_t>(p) | color();
+    }
+
+    static bool is_red(const rbtree_hook* h) { return h && h->color() == red; }
+  };
+
+  namespace __
+  {
+    /// Red-black tree algorithms over the hooks
+    struct rbtree_algorithms
+    {
+      typedef rbtree_hook hook_type;
+      enum { left, right };
+
+      /** The in-order neighbour of \p h in direction \p dir or null */
+      static hook_type* next(const hook_type* h, int dir)
+      {
+        if(h->child[dir]){
+          h = h->child[dir];
+          while(h->child[!dir])
+            h = h->child[!dir];
+          return const_cast<hook_type*>(h);
+        }
+        const hook_type* p = h->parent();
+        while(p && h == p->child[dir]){
+          h = p;
+          p = p->parent();
+        }
+        return const_cast<hook_type*>(p);
+      }
+
+      static void replace_child(hook_type*& root, hook_type* parent, hook_type* old, hook_type* h)
+      {
+        if(!parent)
+          root = h;
+        else
+          parent->child[parent->child[right] == old] = h;
+      }
+
+      /** Rotates \p x down in direction \p dir (left rotation for dir == left) */
+      static void rotate(hook_type*& root, hook_type* x, int dir)
+      {
+        hook_type* const y = x->child[!dir];
+        x->child[!dir] = y->child[dir];
+        if(y->child[dir])
+          y->child[dir]->parent(x);
+        y->parent(x->parent());
+        replace_child(root, x->parent(), x, y);
+        y->child[dir] = x;
+        x->parent(y);
+      }
+
+      /** Links \p h as the \p dir child of \p parent (or as the root) and rebalances */
+      static void insert(hook_type*& root, hook_type* parent, int dir, hook_type* h)
+      {
+        h->child[left] = h->child[right] = nullptr;
+        h->parent_and_color = reinterpret_cast<uintptr_t>(parent) | hook_type::red;
+        if(!parent)
+          root = h;
+        else
+          parent->child[dir] = h;
+
+        while(h != root && hook_type::is_red(h->parent())){
+          hook_type* p = h->parent(), * const g = p->parent();
+          const int d = p == g->child[right];
+          hook_type* const u = g->child[!d];
+          if(hook_type::is_red(u)){
+            p->color(hook_type::black);
+            u->color(hook_type::black);
+            g->color(hook_type::red);
+            h = g;
+          }else{
+            if(h == p->child[!d]){
+              h = p;
+              rotate(root, h, d);
+              p = h->parent();
+            }
+            p->color(hook_type::black);
+            g->color(hook_type::red);
+            rotate(root, g, !d);
+          }
+        }
+        root->color(hook_type::black);
+      }
+
+      /** Unlinks \p z and rebalances */
+      static void erase(hook_type*& root, hook_type* z)
+      {
+        hook_type* y = z, * x, * x_parent;
+        if(!z->child[left])
+          x = z->child[right];
+        else if(!z->child[right])
+          x = z->child[left];
+        else{
+          y = z->child[right];
+          while(y->child[left])
+            y = y->child[left];
+          x = y->child[right];
+        }
+
+        hook_type::color_type removed_color;
+        if(y != z){
+          // the successor y takes the place of z
+          z->child[left]->parent(y);
+          y->child[left] = z->child[left];
+          if(y != z->child[right]){
+            x_parent = y->parent();
+            if(x)
+              x->parent(x_parent);
+            x_parent->child[left] = x;
+            y->child[right] = z->child[right];
+            z->child[right]->parent(y);
+          }else{
+            x_parent = y;
+          }
+          replace_child(root, z->parent(), z, y);
+          removed_color = y->color();
+          y->parent_and_color = z->parent_and_color;
+        }else{
+          x_parent = z->parent();
+          if(x)
+            x->parent(x_parent);
+          replace_child(root, x_parent, z, x);
+          removed_color = z->color();
+        }
+
+        if(removed_color == hook_type::black){
+          while(x != root && !hook_type::is_red(x)){
+            const int d = x != x_parent->child[left];
+            hook_type* w = x_parent->child[!d];
+            if(hook_type::is_red(w)){
+              w->color(hook_type::black);
+              x_parent->color(hook_type::red);
+              rotate(root, x_parent, d);
+              w = x_parent->child[!d];
+            }
+            if(!hook_type::is_red(w->child[left]) && !hook_type::is_red(w->child[right])){
+              w->color(hook_type::red);
+              x = x_parent;
+              x_parent = x_parent->parent();
+            }else{
+              if(!hook_type::is_red(w->child[!d])){
+                w->child[d]->color(hook_type::black);
+                w->color(hook_type::red);
+                rotate(root, w, !d);
+                w = x_parent->child[!d];
+              }
+              w->color(x_parent->color());
+              x_parent->color(hook_type::black);
+              if(w->child[!d])
+                w->child[!d]->color(hook_type::black);
+              rotate(root, x_parent, d);
+              x = root;
+              break;
+            }
+          }
+          if(x)
+            x->color(hook_type::black);
+        }
+        z->child[left] = z->child[right] = nullptr;
+        z->parent_and_color = 0;
+      }
+    };
+  }
+
+  /**
+   *	@brief Intrusive red-black tree
+   *  @details Ordered by \c Compare over the values; lookups with a key of another type use \c comp(key, value)
+   *  and \c comp(value, key). begin() and rbegin() are O(1), erase of a known element does not search.
+   **/
+  template<class T, rbtree_hook T::* Hook, class Compare = std::less<T> >
+  class rbtree
+  {
+    rbtree(const rbtree&) __deleted;
+    rbtree& operator=(const rbtree&) __deleted;
+
+    typedef member_hook<T, rbtree_hook, Hook> hooks;
+    typedef __::rbtree_algorithms algo;
+
+    template<class Value>
+    struct iterator_impl:
+      public std::iterator<std::bidirectional_iterator_tag, Value, ptrdiff_t, Value*, Value&>
+    {
+      iterator_impl() : p(), tree() {}
+      iterator_impl(const iterator_impl<T>& i) : p(i.p), tree(i.tree) {}
+
+      Value& operator* () const { return *hooks::to_value(p); }
+      Value* operator->() const { return hooks::to_value(p); }
+      iterator_impl& operator++() { p = algo::next(p, algo::right); return *this; }
+      iterator_impl& operator--() { p = p ? algo::next(p, algo::left) : tree->last_; return *this; }
+      iterator_impl operator++(int) { iterator_impl tmp(*this); ++*this; return tmp; }
+      iterator_impl operator--(int) { iterator_impl tmp(*this); --*this; return tmp; }
+
+      friend bool operator==(const iterator_impl& x, const iterator_impl& y) { return x.p == y.p; }
+      friend bool operator!=(const iterator_impl& x, const iterator_impl& y) { return x.p != y.p; }
+
+      iterator_impl(const rbtree_hook* p, const rbtree* tree)
+        :p(const_cast<rbtree_hook*>(p)), tree(tree)
+      {}
+
+      rbtree_hook* p;
+      const rbtree* tree;
+    };
+
+  public:
+    typedef T                                             key_type;
+    typedef T                                             value_type;
+    typedef Compare                                       key_compare;
+    typedef Compare                                       value_compare;
+    typedef T&                                            reference;
+    typedef const T&                                      const_reference;
+    typedef T*                                            pointer;
+    typedef const T*                                      const_pointer;
+    typedef size_t                                        size_type;
+    typedef ptrdiff_t                                     difference_type;
+    typedef rbtree_hook                                   hook_type;
+
+    typedef iterator_impl<T>                              iterator;
+    typedef iterator_impl<const T>                        const_iterator;
+    typedef std::reverse_iterator<iterator>               reverse_iterator;
+    typedef std::reverse_iterator<const_iterator>         const_reverse_iterator;
+
+    explicit rbtree(const Compare& comp = Compare())
+      :root_(), first_(), last_(), size_(), comp_(comp)
+    {}
+
+    ~rbtree()
+    {
+      clear();
+    }
+
+    ///\name iterators
+    iterator        begin()       { return iterator(first_, this); }
+    const_iterator  begin() const { return const_iterator(first_, this); }
+    iterator        end()         { return iterator(nullptr, this); }
+    const_iterator  end()   const { return const_iterator(nullptr, this); }
+
+    reverse_iterator        rbegin()       { return reverse_iterator(end()); }
+    const_reverse_iterator  rbegin() const { return const_reverse_iterator(end()); }
+    reverse_iterator        rend()         { return reverse_iterator(begin()); }
+    const_reverse_iterator  rend()   const { return const_reverse_iterator(begin()); }
+
+    iterator        iterator_to(reference x)             { return iterator(hooks::to_hook(x), this); }
+    const_iterator  iterator_to(const_reference x) const { return const_iterator(hooks::to_hook(x), this); }
+
+    ///\name capacity
+    bool      empty() const { return size_ == 0; }
+    size_type size()  const { return size_; }
+
+    ///\name modifiers
+    /** Links \p x unless an equivalent element is linked already */
+    std::pair<iterator, bool> insert_unique(reference x)
+    {
+      hook_type* parent = nullptr;
+      int dir = algo::left;
+      for(hook_type* p = root_; p; p = p->child[dir]){
+        parent = p;
+        if(comp_(x, value(p)))
+          dir = algo::left;
+        else if(comp_(value(p), x))
+          dir = algo::right;
+        else
+          return std::make_pair(iterator(p, this), false);
+      }
+      return std::make_pair(link(parent, dir, x), true);
+    }
+
+    /** Links \p x after the equivalent elements */
+    iterator insert_equal(reference x)
+    {
+      hook_type* parent = nullptr;
+      int dir = algo::left;
+      for(hook_type* p = root_; p; p = p->child[dir]){
+        parent = p;
+        dir = comp_(x, value(p)) ? algo::left : algo::right;
+      }
+      return link(parent, dir, x);
+    }
+
+    /** Unlinks \p x without searching */
+    void erase(reference x)
+    {
+      unlink(hooks::to_hook(x));
+    }
+
+    iterator erase(const_iterator position)
+    {
+      assert(position.p);
+      iterator next(algo::next(position.p, algo::right), this);
+      unlink(position.p);
+      return next;
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+      while(first != last)
+        first = erase(first);
+      return iterator(last.p, this);
+    }
+
+    template<class K>
+    size_type erase_key(const K& k)
+    {
+      size_type n = 0;
+      for(iterator i = lower_bound(k); i != end() && !comp_(k, *i); ++n)
+        i = erase(i);
+      return n;
+    }
+
+    /** Unlinks all elements (and resets their hooks) in O(N) without rebalancing */
+    void clear()
+    {
+      for(hook_type* h = root_; h; ){
+        if(h->child[algo::left])
+          h = h->child[algo::left];
+        else if(h->child[algo::right])
+          h = h->child[algo::right];
+        else{
+          hook_type* const parent = h->parent();
+          if(parent)
+            parent->child[parent->child[algo::right] == h] = nullptr;
+          h->parent_and_color = 0;
+          h = parent;
+        }
+      }
+      root_ = first_ = last_ = nullptr;
+      size_ = 0;
+    }
+
+    void swap(rbtree& x)
+    {
+      using std::swap;
+      swap(root_, x.root_);
+      swap(first_, x.first_);
+      swap(last_, x.last_);
+      swap(size_, x.size_);
+      swap(comp_, x.comp_);
+    }
+
+    ///\name lookup
+    template<class K>
+    iterator find(const K& k)
+    {
+      iterator i = lower_bound(k);
+      return i == end() || comp_(k, *i) ? end() : i;
+    }
+    template<class K>
+    const_iterator find(const K& k) const { return const_cast<rbtree*>(this)->find(k); }
+
+    template<class K>
+    iterator lower_bound(const K& k)
+    {
+      hook_type* p = root_, * bound = nullptr;
+      while(p){
+        if(comp_(value(p), k))
+          p = p->child[algo::right];
+        else
+          bound = p, p = p->child[algo::left];
+      }
+      return iterator(bound, this);
+    }
+    template<class K>
+    const_iterator lower_bound(const K& k) const { return const_cast<rbtree*>(this)->lower_bound(k); }
+
+    template<class K>
+    iterator upper_bound(const K& k)
+    {
+      hook_type* p = root_, * bound = nullptr;
+      while(p){
+        if(comp_(k, value(p)))
+          bound = p, p = p->child[algo::left];
+        else
+          p = p->child[algo::right];
+      }
+      return iterator(bound, this);
+    }
+    template<class K>
+    const_iterator upper_bound(const K& k) const { return const_cast<rbtree*>(this)->upper_bound(k); }
+
+    template<class K>
+    std::pair<iterator, iterator> equal_range(const K& k)
+    {
+      return std::make_pair(lower_bound(k), upper_bound(k));
+    }
+
+    template<class K>
+    size_type count(const K& k) const
+    {
+      size_type n = 0;
+      for(const_iterator i = lower_bound(k); i != end() && !comp_(k, *i); ++i)
+        ++n;
+      return n;
+    }
+
+    ///\name observers
+    key_compare key_comp() const { return comp_; }
+    ///\}
+
+  private:
+    static reference value(hook_type* h) { return *hooks::to_value(h); }
+
+    iterator link(hook_type* parent, int dir, reference x)
+    {
+      hook_type* const h = hooks::to_hook(x);
+      if(!parent)
+        first_ = last_ = h;
+      else if(parent == first_ && dir == algo::left)
+        first_ = h;
+      else if(parent == last_ && dir == algo::right)
+        last_ = h;
+      algo::insert(root_, parent, dir, h);
+      ++size_;
+      return iterator(h, this);
+    }
+
+    void unlink(hook_type* h)
+    {
+      if(h == first_)
+        first_ = algo::next(h, algo::right);
+      if(h == last_)
+        last_ = algo::next(h, algo::left);
+      algo::erase(root_, h);
+      --size_;
+    }
+
+    hook_type* root_, * first_, * last_;
+    size_type size_;
+    Compare comp_;
+
+    template<class> friend struct iterator_impl;
+  };
+
+}//namespace intrusive
+}//namespace ntl
+
+#endif//#ifndef NTL__INTRUSIVE
@@ -10,6 +10,7 @@
 
 #include "basedef.hxx"
 #include "pool.hxx"
+#include "../stlx/new.hxx"
 
 
 namespace ntl {
@@ -178,6 +179,42 @@ void npaged_lookaside_list<CellType>::_initialize(
 }
 
 
+/**
+ *	@brief The pool of std::ext::node_pool_allocator which keeps the nodes in the nonpaged lookaside lists
+ *  @details Each node size has its own list, a static object of the driver, which is deleted on the driver unload.
+ *  The system tunes the depth of the lists, so the chunk size is not used.
+ **/
+struct lookaside_node_pool
+{
+  template<size_t NodeSize, size_t ChunkSize>
+  class pool
+  {
+    struct node { char data[NodeSize]; };
+  public:
+    typedef npaged_lookaside_list<node> list_type;
+
+    static void* allocate()
+    {
+      void* const p = list.allocate();
+      if(!p)
+        __ntl_throw(std::bad_alloc());
+      return p;
+    }
+
+    static void deallocate(void* p)
+    {
+      list.free(p);
+    }
+
+  private:
+    static list_type list;
+  };
+};
+
+template<size_t NodeSize, size_t ChunkSize>
+typename lookaside_node_pool::pool<NodeSize, ChunkSize>::list_type lookaside_node_pool::pool<NodeSize, ChunkSize>::list;
+
+
 }//namspace km
 }//namespace ntl
 
@@ -0,0 +1,417 @@
+/**\file*********************************************************************
+ *                                                                     \brief
+ *  Thread caching size class heap
+ *
+ ****************************************************************************
+ */
+#ifndef NTL__NT_CACHED_HEAP
+#define NTL__NT_CACHED_HEAP
+#pragma once
+
+#include "../basedef.hxx"
+#ifndef __linux__
+# include "../atomic.hxx"
+# include "heap.hxx"
+# include "virtualmem.hxx"
+#endif
+
+#ifdef __linux__
+# include <sched.h>
+# include <sys/mman.h>
+#endif
+
+namespace ntl {
+namespace nt {
+
+/**\addtogroup  native_types_support *** NT Types support library ***********
+ *@{*/
+
+#ifndef __linux__
+  /**
+   *	@brief The page source of the cached_heap which uses the NT virtual memory
+   *  @details The virtual memory is allocated with the 64K granularity, so the regions are aligned on the segment size.
+   *  The large objects are passed to the process heap.
+   **/
+  struct virtual_page_source
+  {
+    /** Allocates the zeroed \p size bytes aligned on 64K */
+    static void* allocate(size_t size)
+    {
+      void* p = nullptr;
+      return nt::success(NtAllocateVirtualMemory(current_process(), &p, 0, &size,
+        allocation_attributes::mem_reserve|allocation_attributes::mem_commit, page_protection::page_readwrite)) ? p : nullptr;
+    }
+
+    static void free(void* p, size_t)
+    {
+      size_t size = 0;
+      NtFreeVirtualMemory(current_process(), &p, &size, allocation_attributes::mem_release);
+    }
+
+    static void* allocate_large(size_t size)
+    {
+      return heap::alloc(process_heap(), size);
+    }
+
+    static void free_large(void* p)
+    {
+      heap::free(process_heap(), p);
+    }
+
+    static void yield()
+    {
+      ZwYieldExecution();
+    }
+  };
+
+  typedef virtual_page_source default_page_source;
+
+#else
+  /**
+   *	@brief The page source of the cached_heap for Linux, which allows to test and benchmark the heap off Windows
+   *  @details The large objects are mapped separately with their size in front of them.
+   **/
+  struct mmap_page_source
+  {
+    static const size_t alignment = 0x10000;
+
+    /** Allocates the zeroed \p size bytes aligned on 64K */
+    static void* allocate(size_t size)
+    {
+      char* const p = static_cast<char*>(map(size + alignment));
+      if(!p)
+        return nullptr;
+      char* const aligned = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(p) + alignment - 1) & ~(alignment - 1));
+      if(aligned != p)
+        munmap(p, aligned - p);
+      munmap(aligned + size, p + alignment - aligned);
+      return aligned;
+    }
+
+    static void free(void* p, size_t size)
+    {
+      munmap(p, size);
+    }
+
+    static void* allocate_large(size_t size)
+    {
+      size_t* const p = static_cast<size_t*>(map(size + header_size));
+      if(!p)
+        return nullptr;
+      *p = size + header_size;
+      return reinterpret_cast<char*>(p) + header_size;
+    }
+
+    static void free_large(void* p)
+    {
+      char* const base = static_cast<char*>(p) - header_size;
+      munmap(base, *reinterpret_cast<size_t*>(base));
+    }
+
+    static void yield()
+    {
+      sched_yield();
+    }
+
+  private:
+    static const size_t header_size = 16;
+
+    static void* map(size_t size)
+    {
+      void* const p = mmap(nullptr, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+      return p == MAP_FAILED ? nullptr : p;
+    }
+  };
+
+  typedef mmap_page_source default_page_source;
+#endif
+
+  /**
+   *	@brief Thread caching size class heap
+   *
+   *  Serves the blocks up to \c max_small_size bytes from the size classes: every 16 bytes up to 128 and four classes
+   *  per power of two above. Each thread keeps the free lists of its own, so the allocation and deallocation take no locks
+   *  until the list of the class is empty or grows beyond two batches; then a batch of blocks moves between the thread cache
+   *  and the central transfer cache of the class, which is guarded by its own spin lock. The central cache carves new blocks
+   *  from the spans of the PageSource; the segments of the spans are tagged with their class in the page map, which tells
+   *  the class of a freed block and the large objects, which go to the PageSource directly.
+   *
+   *  The spans are never returned to the PageSource. A thread should call flush_thread_cache() before it exits,
+   *  otherwise its cached blocks (up to two batches per class) are lost.
+   *
+   *  The heap keeps no dynamically initialized state, so it is usable before the static constructors run.
+   *  Define \c NTL_CACHED_HEAP to make it the backend of the global operator new.
+   **/
+  template<class PageSource = default_page_source>
+  class cached_heap
+  {
+  public:
+    static const size_t segment_shift = 16;
+    static const size_t segment_size = size_t(1) << segment_shift;
+    static const size_t max_small_size = 32 * 1024;
+    static const size_t class_count = 40;
+
+    /** Allocates \p size bytes aligned on 16, returns nullptr on failure */
+    static void* allocate(size_t size)
+    {
+      if(size > max_small_size)
+        return PageSource::allocate_large(size);
+      const size_t cls = size_class(size);
+      thread_cache& tc = cache;
+      free_block* const b = tc.list[cls];
+      if(!b)
+        return refill(tc, cls);
+      tc.list[cls] = b->next;
+      --tc.length[cls];
+      return b;
+    }
+
+    /** Frees the block allocated by allocate() */
+    static void deallocate(void* p)
+    {
+      if(!p)
+        return;
+      const size_t tag = class_tag(p);
+      if(!tag)
+        return PageSource::free_large(p);
+      const size_t cls = tag - 1;
+      thread_cache& tc = cache;
+      free_block* const b = static_cast<free_block*>(p);
+      b->next = tc.list[cls];
+      tc.list[cls] = b;
+      if(++tc.length[cls] > 2 * batch_size(cls))
+        release_batch(tc, cls);
+    }
+
+    /** Returns the usable size of the block, 0 for the large objects */
+    static size_t usable_size(const void* p)
+    {
+      const size_t tag = class_tag(p);
+      return tag ? class_size(tag - 1) : 0;
+    }
+
+    /** Returns the blocks cached by the calling thread to the central cache */
+    static void flush_thread_cache()
+    {
+      thread_cache& tc = cache;
+      for(size_t cls = 0; cls < class_count; ++cls){
+        free_block* const first = tc.list[cls];
+        if(!first)
+          continue;
+        free_block* last = first;
+        while(last->next)
+          last = last->next;
+        central_cache& c = central[cls];
+        lock(c.lock);
+        last->next = c.loose;
+        c.loose = first;
+        unlock(c.lock);
+        tc.list[cls] = nullptr;
+        tc.length[cls] = 0;
+      }
+    }
+
+    ///\name Size classes
+    static size_t size_class(size_t size)
+    {
+      if(size <= 128)
+        return size ? (size - 1) >> 4 : 0;
+      const size_t s = size - 1;
+      size_t b = 7;
+      while(s >> (b + 1))
+        ++b;
+      return 8 + (b - 7) * 4 + ((s >> (b - 2)) & 3);
+    }
+
+    static size_t class_size(size_t cls)
+    {
+      if(cls < 8)
+        return (cls + 1) << 4;
+      const size_t k = cls - 8, b = 7 + k / 4;
+      return (size_t(1) << b) + ((k % 4) + 1) * (size_t(1) << (b - 2));
+    }
+    ///\}
+
+  private:
+    struct free_block
+    {
+      free_block* next;
+      /** links the batches in the transfer cache */
+      free_block* next_batch;
+    };
+
+    struct thread_cache
+    {
+      free_block* list[class_count];
+      uint32_t    length[class_count];
+    };
+
+    struct central_cache
+    {
+      volatile uint32_t lock;
+      /** the full batches */
+      free_block* batches;
+      /** the blocks flushed by the threads */
+      free_block* loose;
+      /** the unused rest of the current span */
+      char*       carve;
+      char*       carve_end;
+    };
+
+    static const size_t address_bits = sizeof(void*) == 8 ? 48 : 32;
+    static const size_t leaf_bits = 16;
+    static const size_t root_bits = address_bits - segment_shift - leaf_bits;
+
+    static uint32_t exchange(volatile uint32_t& l, uint32_t value)
+    {
+    #ifdef __GNUC__
+      return __atomic_exchange_n(&l, value, __ATOMIC_ACQ_REL);
+    #else
+      return atomic::exchange(l, value);
+    #endif
+    }
+
+    static void lock(volatile uint32_t& l)
+    {
+      for(unsigned spins = 0; exchange(l, 1); ++spins){
+        if(spins < 64){
+        #ifdef __GNUC__
+          __builtin_ia32_pause();
+        #else
+          cpu::pause();
+        #endif
+        }else{
+          PageSource::yield();
+        }
+      }
+    }
+
+    static void unlock(volatile uint32_t& l)
+    {
+      exchange(l, 0);
+    }
+
+    static size_t batch_size(size_t cls)
+    {
+      const size_t n = segment_size / 4 / class_size(cls);
+      return n < 2 ? 2 : n > 32 ? 32 : n;
+    }
+
+    /** the spans hold at least 8 blocks */
+    static size_t span_size(size_t cls)
+    {
+      return (class_size(cls) * 8 + segment_size - 1) & ~(segment_size - 1);
+    }
+
+    static size_t class_tag(const void* p)
+    {
+      const uintptr_t segment = reinterpret_cast<uintptr_t>(p) >> segment_shift;
+      if(segment >> (root_bits + leaf_bits))
+        return 0;
+      const uint8_t* const leaf = pagemap[segment >> leaf_bits];
+      return leaf ? leaf[segment & ((size_t(1) << leaf_bits) - 1)] : 0;
+    }
+
+    /** tags the segments of the span, the page map leaves are allocated on demand */
+    static bool tag_span(const char* p, size_t size, size_t cls)
+    {
+      const uintptr_t first = reinterpret_cast<uintptr_t>(p) >> segment_shift, last = first + (size >> segment_shift) - 1;
+      lock(pagemap_lock);
+      for(uintptr_t i = first >> leaf_bits; i <= last >> leaf_bits; ++i){
+        if(!pagemap[i] && !(pagemap[i] = static_cast<uint8_t*>(PageSource::allocate(size_t(1) << leaf_bits)))){
+          unlock(pagemap_lock);
+          return false;
+        }
+      }
+      for(uintptr_t segment = first; segment <= last; ++segment)
+        pagemap[segment >> leaf_bits][segment & ((size_t(1) << leaf_bits) - 1)] = static_cast<uint8_t>(cls + 1);
+      unlock(pagemap_lock);
+      return true;
+    }
+
+    /** moves up to a batch of blocks from the central cache, returns the first block and the rest to the thread cache */
+    static void* refill(thread_cache& tc, size_t cls)
+    {
+      central_cache& c = central[cls];
+      const size_t n = batch_size(cls);
+      lock(c.lock);
+      free_block* first = c.batches;
+      size_t count = 0;
+      if(first){
+        c.batches = first->next_batch;
+        count = n;
+      }else{
+        // gather the loose blocks and carve the span
+        free_block** tail = &first;
+        for(; count < n && c.loose; ++count){
+          *tail = c.loose;
+          c.loose = c.loose->next;
+          tail = &(*tail)->next;
+        }
+        const size_t size = class_size(cls);
+        if(!count && c.carve == c.carve_end){
+          const size_t span = span_size(cls);
+          char* const p = static_cast<char*>(PageSource::allocate(span));
+          if(p && !tag_span(p, span, cls)){
+            PageSource::free(p, span);
+            unlock(c.lock);
+            return nullptr;
+          }
+          c.carve = p;
+          c.carve_end = p ? p + span / size * size : p;
+        }
+        for(; count < n && c.carve != c.carve_end; ++count){
+          *tail = reinterpret_cast<free_block*>(c.carve);
+          c.carve += size;
+          tail = &(*tail)->next;
+        }
+        *tail = nullptr;
+      }
+      unlock(c.lock);
+      if(!count)
+        return nullptr;
+      tc.list[cls] = first->next;
+      tc.length[cls] = static_cast<uint32_t>(count - 1);
+      return first;
+    }
+
+    /** moves a batch of blocks from the thread cache to the central cache */
+    static void release_batch(thread_cache& tc, size_t cls)
+    {
+      const size_t n = batch_size(cls);
+      free_block* const first = tc.list[cls];
+      free_block* last = first;
+      for(size_t i = 1; i < n; ++i)
+        last = last->next;
+      tc.list[cls] = last->next;
+      tc.length[cls] -= static_cast<uint32_t>(n);
+      last->next = nullptr;
+      central_cache& c = central[cls];
+      lock(c.lock);
+      first->next_batch = c.batches;
+      c.batches = first;
+      unlock(c.lock);
+    }
+
+  private:
+    static __thread_local thread_cache cache;
+    static central_cache central[class_count];
+    static uint8_t* volatile pagemap[size_t(1) << root_bits];
+    static volatile uint32_t pagemap_lock;
+  };
+
+  template<class PageSource>
+  __thread_local typename cached_heap<PageSource>::thread_cache cached_heap<PageSource>::cache;
+  template<class PageSource>
+  typename cached_heap<PageSource>::central_cache cached_heap<PageSource>::central[cached_heap<PageSource>::class_count];
+  template<class PageSource>
+  uint8_t* volatile cached_heap<PageSource>::pagemap[size_t(1) << cached_heap<PageSource>::root_bits];
+  template<class PageSource>
+  volatile uint32_t cached_heap<PageSource>::pagemap_lock;
+
+/**@} native_types_support */
+
+}//namespace nt
+}//namespace ntl
+
+#endif//#ifndef NTL__NT_CACHED_HEAP
@@ -0,0 +1,73 @@
+/**\file*********************************************************************
+ *                                                                     \brief
+ *  NT heap allocator
+ *
+ ****************************************************************************
+ */
+#ifndef NTL__NT_HEAP_ALLOCATOR
+#define NTL__NT_HEAP_ALLOCATOR
+#pragma once
+
+#include "heap.hxx"
+#include "../stlx/memory.hxx"
+
+namespace ntl {
+namespace nt {
+
+/**\addtogroup  native_types_support *** NT Types support library ***********
+ *@{*/
+
+  /**
+   *	@brief Process heap allocator
+   *  @details Allocates from the process heap and supports the in place growth of the allocated blocks,
+   *  so \c std::vector can extend its storage without moving the elements.
+   **/
+  template<class T>
+  class heap_allocator:
+    public std::allocator<T>
+  {
+  public:
+    typedef typename std::allocator<T>::pointer   pointer;
+    typedef typename std::allocator<T>::size_type size_type;
+    template<class U> struct rebind { typedef heap_allocator<U> other; };
+
+    heap_allocator() __ntl_nothrow {}
+    template<class U> heap_allocator(const heap_allocator<U>&) __ntl_nothrow {}
+
+    __noalias __forceinline T* __restrict allocate(size_type n, std::allocator<void>::const_pointer = 0)
+      __ntl_throws(std::bad_alloc)
+    {
+      void* p = heap::alloc(process_heap(), n*sizeof(T));
+      if(!p)
+        __ntl_throw(std::bad_alloc());
+      return reinterpret_cast<T*>(p);
+    }
+
+    __noalias __forceinline void deallocate(pointer p, size_type)
+    {
+      heap::free(process_heap(), p);
+    }
+
+    /** Tries to grow the block of \c n objects at \p p up to \c new_n objects without moving it */
+    bool expand(pointer p, size_type /*n*/, size_type new_n)
+    {
+      return RtlReAllocateHeap(process_heap(), heap::realloc_in_place_only, p, new_n*sizeof(T)) != nullptr;
+    }
+  };
+
+  template<class T, class U>
+  inline bool operator==(const heap_allocator<T>&, const heap_allocator<U>&) __ntl_nothrow { return true; }
+  template<class T, class U>
+  inline bool operator!=(const heap_allocator<T>&, const heap_allocator<U>&) __ntl_nothrow { return false; }
+
+/**@} native_types_support */
+
+}//namespace nt
+}//namespace ntl
+
+namespace std { namespace ext {
+  template<class T>
+  struct allocator_can_expand<ntl::nt::heap_allocator<T> >: true_type {};
+}}
+
+#endif//#ifndef NTL__NT_HEAP_ALLOCATOR
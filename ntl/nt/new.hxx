@@ -12,6 +12,9 @@
 
 #include "heap.hxx"
 #include "../stlx/new.hxx"
+#ifdef NTL_CACHED_HEAP
+# include "cached_heap.hxx"
+#endif
 
 #ifdef __ICL
 # pragma warning(push)
@@ -41,17 +44,39 @@ namespace std
   using ::abort;
 }
 
+namespace ntl
+{
+  /** The backend of the global operator new, the process heap or the cached_heap if \c NTL_CACHED_HEAP is defined */
+  __forceinline void* __new_alloc(std::size_t size)
+  {
+  #ifdef NTL_CACHED_HEAP
+    return nt::cached_heap<>::allocate(size);
+  #else
+    return nt::heap::alloc(nt::process_heap(), size);
+  #endif
+  }
+
+  __forceinline void __new_free(void* ptr)
+  {
+  #ifdef NTL_CACHED_HEAP
+    nt::cached_heap<>::deallocate(ptr);
+  #else
+    nt::heap::free(nt::process_heap(), ptr);
+  #endif
+  }
+}
+
 ///\name  Single-object forms
 
 __forceinline
 void* __cdecl operator new(std::size_t size)
 {
 #ifdef NTL_NO_NEW_HANDLERS
-  return ntl::nt::heap::alloc(ntl::nt::process_heap(), size);
+  return ntl::__new_alloc(size);
 #else
   void* ptr;
   for(;;) {
-    ptr = ntl::nt::heap::alloc(ntl::nt::process_heap(), size); if(ptr) return ptr;
+    ptr = ntl::__new_alloc(size); if(ptr) return ptr;
 
     std::new_handler nh = ntl::__new_handler;
   #if STLX_USE_EXCEPTIONS
@@ -69,7 +94,7 @@ void* __cdecl operator new(std::size_t size)
 __forceinline
 void __cdecl operator delete(void* ptr) __ntl_nothrow
 {
-  ntl::nt::heap::free(ntl::nt::process_heap(), ptr);
+  ntl::__new_free(ptr);
 }
 
 __forceinline
@@ -101,11 +126,11 @@ __forceinline
 void* __cdecl operator new(std::size_t size, const std::nothrow_t&) __ntl_nothrow
 {
 #ifdef NTL_NO_NEW_HANDLERS
-  return ntl::nt::heap::alloc(ntl::nt::process_heap(), size);
+  return ntl::__new_alloc(size);
 #else
   void* ptr;
   for(;;) {
-    ptr = ntl::nt::heap::alloc(ntl::nt::process_heap(), size); if(ptr) return ptr;
+    ptr = ntl::__new_alloc(size); if(ptr) return ptr;
 
     std::new_handler nh = ntl::__new_handler;
     if ( nh )
@@ -119,7 +144,7 @@ __forceinline
 void __cdecl
   operator delete(void* ptr, const std::nothrow_t&) __ntl_nothrow
 {
-  ntl::nt::heap::free(ntl::nt::process_heap(), ptr);
+  ntl::__new_free(ptr);
 }
 
 __forceinline
@@ -147,7 +172,7 @@ void* __cdecl operator new[](std::size_t size)
 __forceinline
 void __cdecl operator delete[](void* ptr) __ntl_nothrow
 {
-  ntl::nt::heap::free(ntl::nt::process_heap(), ptr);
+  ntl::__new_free(ptr);
 }
 
 __forceinline
@@ -165,7 +190,7 @@ void* __cdecl operator new[](std::size_t size, const std::nothrow_t&) __ntl_noth
 __forceinline
 void __cdecl operator delete[](void* ptr, const std::nothrow_t&) __ntl_nothrow
 {
-  ntl::nt::heap::free(ntl::nt::process_heap(), ptr);
+  ntl::__new_free(ptr);
 }
 
 __forceinline
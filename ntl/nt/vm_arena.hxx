@@ -0,0 +1,277 @@
+/**\file*********************************************************************
+ *                                                                     \brief
+ *  Reserve/commit virtual memory arena
+ *
+ ****************************************************************************
+ */
+#ifndef NTL__NT_VM_ARENA
+#define NTL__NT_VM_ARENA
+#pragma once
+
+#include "../basedef.hxx"
+#ifndef __linux__
+# include "shared_data.hxx"
+# include "virtualmem.hxx"
+#endif
+
+#ifdef __linux__
+# include <sys/mman.h>
+#endif
+
+namespace ntl {
+namespace nt {
+
+/**\addtogroup  native_types_support *** NT Types support library ***********
+ *@{*/
+
+#ifndef __linux__
+  /**
+   *	@brief The memory source of the vm_arena which uses the NT virtual memory
+   *  @details The large pages are available to the processes holding the \c SeLockMemoryPrivilege; they are never paged out,
+   *  so they have to be reserved and committed at once.
+   **/
+  struct virtual_memory_source
+  {
+    /** The size of the large page, 0 if the system does not support them */
+    static size_t large_page_size()
+    {
+      return user_shared_data::instance().LargePageMinimum;
+    }
+
+    static void* reserve(size_t size)
+    {
+      return allocate(size, allocation_attributes::mem_reserve);
+    }
+
+    /** Reserves and commits \p size bytes of the large pages, returns nullptr if they are not available */
+    static void* allocate_large(size_t size)
+    {
+      return allocate(size, allocation_attributes::mem_reserve|allocation_attributes::mem_commit|allocation_attributes::mem_large_pages);
+    }
+
+    static bool commit(void* p, size_t size)
+    {
+      return nt::success(NtAllocateVirtualMemory(current_process(), &p, 0, &size, allocation_attributes::mem_commit, page_protection::page_readwrite));
+    }
+
+    static void decommit(void* p, size_t size)
+    {
+      NtFreeVirtualMemory(current_process(), &p, &size, allocation_attributes::mem_decommit);
+    }
+
+    static void release(void* p, size_t)
+    {
+      size_t size = 0;
+      NtFreeVirtualMemory(current_process(), &p, &size, allocation_attributes::mem_release);
+    }
+
+  private:
+    static void* allocate(size_t size, allocation_attributes::type type)
+    {
+      void* p = nullptr;
+      return nt::success(NtAllocateVirtualMemory(current_process(), &p, 0, &size, type, page_protection::page_readwrite)) ? p : nullptr;
+    }
+  };
+
+  typedef virtual_memory_source default_memory_source;
+
+#else
+  /**
+   *	@brief The memory source of the vm_arena for Linux, which allows to test the arena off Windows
+   *  @details The reserved range is mapped inaccessible and the commit opens the pages for reading and writing.
+   *  The large pages are the transparent huge pages, the kernel backs the range with them when it can.
+   **/
+  struct mmap_memory_source
+  {
+    static size_t large_page_size()
+    {
+      return 0x200000;
+    }
+
+    static void* reserve(size_t size)
+    {
+      return map(size, PROT_NONE);
+    }
+
+    static void* allocate_large(size_t size)
+    {
+      // map the extra large page to align the range on it
+      const size_t page = large_page_size();
+      char* const p = static_cast<char*>(map(size + page, PROT_READ|PROT_WRITE));
+      if(!p)
+        return nullptr;
+      char* const aligned = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(p) + page - 1) & ~(page - 1));
+      if(aligned != p)
+        munmap(p, aligned - p);
+      munmap(aligned + size, p + page - aligned);
+      madvise(aligned, size, MADV_HUGEPAGE);
+      return aligned;
+    }
+
+    static bool commit(void* p, size_t size)
+    {
+      return mprotect(p, size, PROT_READ|PROT_WRITE) == 0;
+    }
+
+    static void decommit(void* p, size_t size)
+    {
+      madvise(p, size, MADV_DONTNEED);
+      mprotect(p, size, PROT_NONE);
+    }
+
+    static void release(void* p, size_t size)
+    {
+      munmap(p, size);
+    }
+
+  private:
+    static void* map(size_t size, int prot)
+    {
+      void* const p = mmap(nullptr, size, prot, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+      return p == MAP_FAILED ? nullptr : p;
+    }
+  };
+
+  typedef mmap_memory_source default_memory_source;
+#endif
+
+  /**
+   *	@brief Reserve/commit virtual memory arena
+   *
+   *  Reserves the address range up front and commits it by \c commit_step as the bump allocation reaches it, so the range
+   *  may be as large as the biggest expected load while only the used part takes the memory. The last block can grow
+   *  in place with extend() up to the end of the range, which lets the growing buffers avoid the copying:
+   *  \code
+   *  ntl::nt::vm_arena arena(1024 * 1024 * 1024);
+   *  char* buf = static_cast<char*>(arena.allocate(size));
+   *  if(!arena.extend(buf, size, size * 2)) ...
+   *  \endcode
+   *  The allocations are released all at once by rollback() to the mark() taken before them or by reset();
+   *  the committed pages stay for the reuse until trim().
+   *
+   *  With the large pages the whole range is committed at construction (falling back to the regular pages
+   *  if they are not available), which takes fewer TLB entries for the large working sets.
+   *  The arena is not synchronized.
+   **/
+  template<class MemorySource = default_memory_source>
+  class basic_vm_arena:
+    noncopyable
+  {
+  public:
+    static const size_t commit_step = 0x10000;
+
+    /** The position of the arena to return to */
+    typedef size_t marker;
+
+    explicit basic_vm_arena(size_t reserve_size, bool large_pages = false)
+      :base(), top(), committed_end(), end(), large(false)
+    {
+      const size_t large_page = large_pages ? MemorySource::large_page_size() : 0;
+      if(large_page){
+        const size_t size = align_up(reserve_size, large_page);
+        if(char* const p = static_cast<char*>(MemorySource::allocate_large(size))){
+          base = top = p;
+          committed_end = end = p + size;
+          large = true;
+          return;
+        }
+      }
+      const size_t size = align_up(reserve_size, commit_step);
+      if(char* const p = static_cast<char*>(MemorySource::reserve(size))){
+        base = top = committed_end = p;
+        end = p + size;
+      }
+    }
+
+    ~basic_vm_arena()
+    {
+      if(base)
+        MemorySource::release(base, end - base);
+    }
+
+    /** Tells whether the range has been reserved */
+    operator bool() const { return base != nullptr; }
+
+    /** Allocates \p size bytes aligned on \p alignment (a power of 2), returns nullptr when the range is exhausted or the commit fails */
+    void* allocate(size_t size, size_t alignment = sizeof(void*))
+    {
+      char* const p = reinterpret_cast<char*>(align_up(reinterpret_cast<uintptr_t>(top), alignment));
+      if(p > end || size > static_cast<size_t>(end - p) || !commit_to(p + size))
+        return nullptr;
+      top = p + size;
+      return p;
+    }
+
+    /** Resizes the last allocated block \p p of \p old_size bytes in place, returns false if it is not the last one or the range is exhausted */
+    bool extend(void* p, size_t old_size, size_t new_size)
+    {
+      char* const b = static_cast<char*>(p);
+      if(!b || b + old_size != top || new_size > static_cast<size_t>(end - b) || !commit_to(b + new_size))
+        return false;
+      top = b + new_size;
+      return true;
+    }
+
+    marker mark() const { return top - base; }
+
+    /** Frees all allocations made after the mark() which returned \p m, ignores the mark above the allocated part */
+    void rollback(marker m)
+    {
+      if(m <= used())
+        top = base + m;
+    }
+
+    void reset() { top = base; }
+
+    /** Decommits the pages above the allocated part */
+    void trim()
+    {
+      if(large)
+        return;
+      char* const keep = base + align_up(static_cast<size_t>(top - base), commit_step);
+      if(keep < committed_end){
+        MemorySource::decommit(keep, committed_end - keep);
+        committed_end = keep;
+      }
+    }
+
+    bool owns(const void* p) const { return p >= base && p < end; }
+
+    size_t used() const { return top - base; }
+    size_t committed() const { return committed_end - base; }
+    size_t reserved() const { return end - base; }
+    bool large_pages() const { return large; }
+
+  private:
+    static size_t align_up(size_t n, size_t alignment)
+    {
+      return (n + alignment - 1) & ~(alignment - 1);
+    }
+
+    bool commit_to(char* need)
+    {
+      if(need <= committed_end)
+        return true;
+      char* const next = base + align_up(static_cast<size_t>(need - base), commit_step);
+      char* const to = next < end ? next : end;
+      if(!MemorySource::commit(committed_end, to - committed_end))
+        return false;
+      committed_end = to;
+      return true;
+    }
+
+    char* base;
+    char* top;
+    char* committed_end;
+    char* end;
+    bool large;
+  };
+
+  typedef basic_vm_arena<> vm_arena;
+
+/**@} native_types_support */
+
+}//namespace nt
+}//namespace ntl
+
+#endif//#ifndef NTL__NT_VM_ARENA
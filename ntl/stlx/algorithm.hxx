@@ -793,6 +793,8 @@ OutputIterator
 template<class ForwardIterator>
 inline void rotate(ForwardIterator first, ForwardIterator middle, ForwardIterator last)
 {
+  if(first == middle || middle == last)
+    return;
   ForwardIterator next = middle;
   while(first != next) {
     std::iter_swap(first++, next++);
@@ -1047,32 +1049,141 @@ inline bool binary_search(ForwardIterator first, ForwardIterator last, const T&
 }
 
 ///\name 25.3.4, merge:
-template<class InputIterator1, class InputIterator2, class OutputIterator>
+template<class InputIterator1, class InputIterator2, class OutputIterator,
+         class Compare>
 inline
 OutputIterator
   merge(InputIterator1 first1, InputIterator1 last1,
         InputIterator2 first2, InputIterator2 last2,
-        OutputIterator result);
+        OutputIterator result, Compare comp)
+{
+  // equivalent elements of the first range precede the ones of the second
+  for ( ; first1 != last1 && first2 != last2; ++result )
+  {
+    if ( comp(*first2, *first1) )
+      *result = *first2, ++first2;
+    else
+      *result = *first1, ++first1;
+  }
+  return copy(first2, last2, copy(first1, last1, result));
+}
 
-template<class InputIterator1, class InputIterator2, class OutputIterator,
-         class Compare>
+template<class InputIterator1, class InputIterator2, class OutputIterator>
 inline
 OutputIterator
   merge(InputIterator1 first1, InputIterator1 last1,
         InputIterator2 first2, InputIterator2 last2,
-        OutputIterator result, Compare comp);
+        OutputIterator result)
+{
+  typedef typename iterator_traits<InputIterator1>::value_type value_type;
+  return merge(first1, last1, first2, last2, result, less<value_type>());
+}
 
-template<class BidirectionalIterator>
+namespace __
+{
+  /** Merges [first, middle) and [middle, last) without the temporary storage: O(N log N) */
+  template<class BidirectionalIterator, class Distance, class Compare>
+  void merge_without_buffer(BidirectionalIterator first, BidirectionalIterator middle, BidirectionalIterator last,
+                            Distance len1, Distance len2, Compare comp)
+  {
+    if ( len1 == 0 || len2 == 0 )
+      return;
+    if ( len1 + len2 == 2 )
+    {
+      if ( comp(*middle, *first) )
+        std::iter_swap(first, middle);
+      return;
+    }
+    BidirectionalIterator first_cut = first, second_cut = middle;
+    Distance len11, len22;
+    if ( len1 > len2 )
+    {
+      len11 = len1 / 2;
+      std::advance(first_cut, len11);
+      second_cut = std::lower_bound(middle, last, *first_cut, comp);
+      len22 = std::distance(middle, second_cut);
+    }
+    else
+    {
+      len22 = len2 / 2;
+      std::advance(second_cut, len22);
+      first_cut = std::upper_bound(first, middle, *second_cut, comp);
+      len11 = std::distance(first, first_cut);
+    }
+    std::rotate(first_cut, middle, second_cut);
+    BidirectionalIterator new_middle = first_cut;
+    std::advance(new_middle, len22);
+    merge_without_buffer(first, first_cut, new_middle, len11, len22, comp);
+    merge_without_buffer(new_middle, second_cut, last, len1 - len11, len2 - len22, comp);
+  }
+
+  template<class RandomAccessIterator, class Compare>
+  void insertion_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+  {
+    typedef typename iterator_traits<RandomAccessIterator>::value_type value_type;
+    if ( first == last )
+      return;
+    for ( RandomAccessIterator i = first + 1; i != last; ++i )
+    {
+      if ( !comp(*i, *(i - 1)) )
+        continue;
+      value_type tmp(std::move(*i));
+      RandomAccessIterator j = i;
+      do
+        *j = std::move(*(j - 1));
+      while ( --j != first && comp(tmp, *(j - 1)) );
+      *j = std::move(tmp);
+    }
+  }
+} // __
+
+template<class BidirectionalIterator, class Compare>
 inline
 void
   inplace_merge(BidirectionalIterator first, BidirectionalIterator middle,
-                BidirectionalIterator last);
+                BidirectionalIterator last, Compare comp)
+{
+  __::merge_without_buffer(first, middle, last, distance(first, middle), distance(middle, last), comp);
+}
 
-template<class BidirectionalIterator, class Compare>
+template<class BidirectionalIterator>
 inline
 void
   inplace_merge(BidirectionalIterator first, BidirectionalIterator middle,
-                BidirectionalIterator last, Compare comp);
+                BidirectionalIterator last)
+{
+  typedef typename iterator_traits<BidirectionalIterator>::value_type value_type;
+  inplace_merge(first, middle, last, less<value_type>());
+}
+
+// 25.3.1.2 stable_sort, defined here because of the merge dependency
+template<class RandomAccessIterator, class Compare>
+inline
+void
+  stable_sort(RandomAccessIterator first, RandomAccessIterator last,
+              Compare comp)
+{
+  typedef typename iterator_traits<RandomAccessIterator>::difference_type difference_type;
+  const difference_type len = last - first;
+  if ( len <= 16 )
+  {
+    __::insertion_sort(first, last, comp);
+    return;
+  }
+  const RandomAccessIterator middle = first + len / 2;
+  stable_sort(first, middle, comp);
+  stable_sort(middle, last, comp);
+  __::merge_without_buffer(first, middle, last, middle - first, last - middle, comp);
+}
+
+template<class RandomAccessIterator>
+inline
+void
+  stable_sort(RandomAccessIterator first, RandomAccessIterator last)
+{
+  typedef typename iterator_traits<RandomAccessIterator>::value_type value_type;
+  stable_sort(first, last, less<value_type>());
+}
 
 ///\name 25.3.5, set operations on sorted structures:
 template<class InputIterator1, class InputIterator2>
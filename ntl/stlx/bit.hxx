@@ -0,0 +1,231 @@
+/**\file*********************************************************************
+ *                                                                     \brief
+ *  Bit manipulation [bit]
+ *
+ ****************************************************************************
+ */
+#ifndef NTL__STLX_BIT
+#define NTL__STLX_BIT
+#pragma once
+
+#include "cstdint.hxx"
+#include "type_traits.hxx"
+
+#if defined(_MSC_VER) && !defined(__clang__)
+namespace ntl { namespace intrinsic
+{
+  extern "C" {
+    unsigned char __cdecl _BitScanForward(unsigned long* index, unsigned long mask);
+    unsigned char __cdecl _BitScanReverse(unsigned long* index, unsigned long mask);
+    unsigned int  __cdecl __popcnt(unsigned int);
+  #ifdef _M_X64
+    unsigned char __cdecl _BitScanForward64(unsigned long* index, uint64_t mask);
+    unsigned char __cdecl _BitScanReverse64(unsigned long* index, uint64_t mask);
+    uint64_t      __cdecl __popcnt64(uint64_t);
+  #endif
+  }
+#ifndef __ICL
+# pragma intrinsic(_BitScanForward, _BitScanReverse, __popcnt)
+# ifdef _M_X64
+#  pragma intrinsic(_BitScanForward64, _BitScanReverse64, __popcnt64)
+# endif
+#endif
+}}
+#endif
+
+/**
+ *  \c popcnt instruction is not available on the pre-SSE4 processors, so it is used only when
+ *  NTL_CPU_POPCNT is defined (or the compiler targets AVX); otherwise the counting is done by the bit twiddling.
+ *  \c bsf/bsr are always available.
+ **/
+#if !defined(NTL_CPU_POPCNT) && (defined(__AVX__) || defined(__POPCNT__))
+# define NTL_CPU_POPCNT
+#endif
+
+namespace std {
+
+  /**\addtogroup  lib_numeric *** 26 Numerics library [numerics]
+   *@{*/
+
+  /**\addtogroup  lib_bit ******** Bit manipulation [bit]
+   *@{*/
+
+  namespace __
+  {
+    namespace bits
+    {
+      inline int popcount32(uint32_t x)
+      {
+      #if defined(__GNUC__) || defined(__clang__)
+        return __builtin_popcount(x);
+      #elif defined(_MSC_VER) && defined(NTL_CPU_POPCNT)
+        return static_cast<int>(ntl::intrinsic::__popcnt(x));
+      #else
+        x = x - ((x >> 1) & 0x55555555);
+        x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+        x = (x + (x >> 4)) & 0x0F0F0F0F;
+        return static_cast<int>((x * 0x01010101) >> 24);
+      #endif
+      }
+
+      inline int popcount64(uint64_t x)
+      {
+      #if defined(__GNUC__) || defined(__clang__)
+        return __builtin_popcountll(x);
+      #elif defined(_MSC_VER) && defined(NTL_CPU_POPCNT) && defined(_M_X64)
+        return static_cast<int>(ntl::intrinsic::__popcnt64(x));
+      #else
+        return popcount32(static_cast<uint32_t>(x)) + popcount32(static_cast<uint32_t>(x >> 32));
+      #endif
+      }
+
+      /** index of the lowest set bit, \p x shall not be zero */
+      inline int ctz32(uint32_t x)
+      {
+      #if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctz(x);
+      #elif defined(_MSC_VER)
+        unsigned long i;
+        ntl::intrinsic::_BitScanForward(&i, x);
+        return static_cast<int>(i);
+      #else
+        int n = 0;
+        while(!(x & 1))
+          x >>= 1, ++n;
+        return n;
+      #endif
+      }
+
+      inline int ctz64(uint64_t x)
+      {
+      #if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctzll(x);
+      #elif defined(_MSC_VER) && defined(_M_X64)
+        unsigned long i;
+        ntl::intrinsic::_BitScanForward64(&i, x);
+        return static_cast<int>(i);
+      #else
+        const uint32_t lo = static_cast<uint32_t>(x);
+        return lo ? ctz32(lo) : 32 + ctz32(static_cast<uint32_t>(x >> 32));
+      #endif
+      }
+
+      /** count of the leading zero bits, \p x shall not be zero */
+      inline int clz32(uint32_t x)
+      {
+      #if defined(__GNUC__) || defined(__clang__)
+        return __builtin_clz(x);
+      #elif defined(_MSC_VER)
+        unsigned long i;
+        ntl::intrinsic::_BitScanReverse(&i, x);
+        return 31 - static_cast<int>(i);
+      #else
+        int n = 0;
+        while(!(x & 0x80000000))
+          x <<= 1, ++n;
+        return n;
+      #endif
+      }
+
+      inline int clz64(uint64_t x)
+      {
+      #if defined(__GNUC__) || defined(__clang__)
+        return __builtin_clzll(x);
+      #elif defined(_MSC_VER) && defined(_M_X64)
+        unsigned long i;
+        ntl::intrinsic::_BitScanReverse64(&i, x);
+        return 63 - static_cast<int>(i);
+      #else
+        const uint32_t hi = static_cast<uint32_t>(x >> 32);
+        return hi ? clz32(hi) : 32 + clz32(static_cast<uint32_t>(x));
+      #endif
+      }
+
+      template<size_t Size> struct ops;
+      template<> struct ops<1>
+      {
+        static int popcount(uint32_t x) { return popcount32(x); }
+        static int ctz(uint32_t x) { return ctz32(x); }
+        static int clz(uint32_t x) { return clz32(x) - 24; }
+      };
+      template<> struct ops<2>
+      {
+        static int popcount(uint32_t x) { return popcount32(x); }
+        static int ctz(uint32_t x) { return ctz32(x); }
+        static int clz(uint32_t x) { return clz32(x) - 16; }
+      };
+      template<> struct ops<4>
+      {
+        static int popcount(uint32_t x) { return popcount32(x); }
+        static int ctz(uint32_t x) { return ctz32(x); }
+        static int clz(uint32_t x) { return clz32(x); }
+      };
+      template<> struct ops<8>
+      {
+        static int popcount(uint64_t x) { return popcount64(x); }
+        static int ctz(uint64_t x) { return ctz64(x); }
+        static int clz(uint64_t x) { return clz64(x); }
+      };
+    }
+
+    template<class T> struct is_bit_unsigned: false_type {};
+    template<> struct is_bit_unsigned<unsigned char>: true_type {};
+    template<> struct is_bit_unsigned<unsigned short>: true_type {};
+    template<> struct is_bit_unsigned<unsigned int>: true_type {};
+    template<> struct is_bit_unsigned<unsigned long>: true_type {};
+    template<> struct is_bit_unsigned<unsigned long long>: true_type {};
+  }
+
+  /** Number of 1 bits in \p x */
+  template<class T>
+  inline typename enable_if<__::is_bit_unsigned<T>::value, int>::type popcount(T x) __ntl_nothrow
+  {
+    return __::bits::ops<sizeof(T)>::popcount(x);
+  }
+
+  /** Number of consecutive 0 bits starting from the least significant one */
+  template<class T>
+  inline typename enable_if<__::is_bit_unsigned<T>::value, int>::type countr_zero(T x) __ntl_nothrow
+  {
+    return x ? __::bits::ops<sizeof(T)>::ctz(x) : static_cast<int>(sizeof(T)*8);
+  }
+
+  /** Number of consecutive 0 bits starting from the most significant one */
+  template<class T>
+  inline typename enable_if<__::is_bit_unsigned<T>::value, int>::type countl_zero(T x) __ntl_nothrow
+  {
+    return x ? __::bits::ops<sizeof(T)>::clz(x) : static_cast<int>(sizeof(T)*8);
+  }
+
+  /** Number of consecutive 1 bits starting from the least significant one */
+  template<class T>
+  inline typename enable_if<__::is_bit_unsigned<T>::value, int>::type countr_one(T x) __ntl_nothrow
+  {
+    return countr_zero(static_cast<T>(~x));
+  }
+
+  /** Number of consecutive 1 bits starting from the most significant one */
+  template<class T>
+  inline typename enable_if<__::is_bit_unsigned<T>::value, int>::type countl_one(T x) __ntl_nothrow
+  {
+    return countl_zero(static_cast<T>(~x));
+  }
+
+  /** Checks whether \p x is an integral power of two */
+  template<class T>
+  inline typename enable_if<__::is_bit_unsigned<T>::value, bool>::type has_single_bit(T x) __ntl_nothrow
+  {
+    return x && !(x & (x - 1));
+  }
+
+  /** Number of bits needed to represent \p x */
+  template<class T>
+  inline typename enable_if<__::is_bit_unsigned<T>::value, int>::type bit_width(T x) __ntl_nothrow
+  {
+    return static_cast<int>(sizeof(T)*8) - countl_zero(x);
+  }
+
+  /**@} lib_bit */
+  /**@} lib_numeric */
+} // namespace std
+#endif // NTL__STLX_BIT
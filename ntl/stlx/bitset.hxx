@@ -11,6 +11,7 @@
 #include "cstddef.hxx"
 #include "stdexcept.hxx"
 #include "stdstring.hxx"
+#include "bit.hxx"
 #ifndef NTL__STLX_IOSFWD
 #include "iosfwd.hxx"    // for ios
 #endif
@@ -137,7 +138,7 @@ namespace std {
     bitset<N>& operator&=(const bitset<N>& rhs)
     {
       for(unsigned i = 0; i < elements_count_; ++i)
-        storage_[i] &= ~rhs.storage_[i];
+        storage_[i] &= rhs.storage_[i];
       return *this;
     }
 
@@ -159,50 +160,17 @@ namespace std {
     {
       if(pos >= N)
         return reset();
-      else if(pos == 0)
-        return *this; // nothing to do
-      else if(pos >= element_size_){
-        large_shift_left(pos);
-        return *this;
-      }
-
-      storage_type preval = 0, curval = 0;
-      for(unsigned i = 0; i < elements_count_; ++i){
-        // save shifted bits
-        curval = storage_[i] >> (element_size_ - pos);
-        // shift
-        storage_[i] <<= pos;
-        // restore previous bits
-        storage_[i] |= preval;
-        preval = curval;
-      }
-
-      // cut garbage bits
-      storage_[elements_count_-1] &= digits_mod_;
+      if(pos != 0)
+        shift_left(pos / element_size_, pos % element_size_);
       return *this;
     }
 
     bitset<N>& operator>>=(size_t pos)
     {
-      if(pos > N)
+      if(pos >= N)
         return reset();
-      else if(pos == 0)
-        return *this; // nothing to do
-      else if(pos >= element_size_){
-        large_shift_right(pos);
-        return *this;
-      }
-
-      storage_type xval = 0, yval = 0;
-      for(int i = elements_count_-1; i >= 0; --i){
-        // save shifted bits
-        yval = storage_[i] & ((native_one_ << pos) - 1);
-        // shift
-        storage_[i] >>= pos;
-        // restore previous bits
-        storage_[i] |= xval << (element_size_ - pos);
-        xval = yval;
-      }
+      if(pos != 0)
+        shift_right(pos / element_size_, pos % element_size_);
       return *this;
     }
 
@@ -210,6 +178,7 @@ namespace std {
     {
       for(unsigned i = 0; i < elements_count_; ++i)
         storage_[i] = set_bits_;
+      storage_[elements_count_-1] &= digits_mod_;
       return *this;
     }
 
@@ -218,8 +187,8 @@ namespace std {
       check_bounds(pos);
       storage_type xval = storage_[pos / element_size_];
       const size_t mod = pos & element_mod_;
-      xval &= ~(1 << mod);
-      xval |= (val << mod);
+      xval &= ~(native_one_ << mod);
+      xval |= (static_cast<storage_type>(val) << mod);
       storage_[pos / element_size_] = xval;
       return *this;
     }
@@ -236,7 +205,7 @@ namespace std {
       check_bounds(pos);
       storage_type val = storage_[pos / element_size_];
       const size_t mod = pos & element_mod_;
-      val &= ~(1 << mod);
+      val &= ~(native_one_ << mod);
       storage_[pos / element_size_] = val;
       return *this;
     }
@@ -250,6 +219,7 @@ namespace std {
     {
       for(unsigned i = 0; i < elements_count_; ++i)
         storage_[i] = ~storage_[i];
+      storage_[elements_count_-1] &= digits_mod_;
       return *this;
     }
 
@@ -301,15 +271,12 @@ namespace std {
       return to_stringT<char, char_traits<char>, allocator<char> >('0', '1');
     }
 
-    size_t count() const
+    size_t count() const __ntl_nothrow
     {
-      static const char table[] = "\0\1\1\2\1\2\2\3\1\2\2\3\2\3\3\4";
-      unsigned count_ = 0;
-      for(storage_type j = storage_[elements_count_-1] & digits_mod_; j; j >>= 4)
-        count_ += table[j & 0xF];
-      for(ssize_t i = elements_count_-2; i >= 0; --i)
-        for(storage_type j = storage_[i]; j; j >>= 4)
-          count_ += table[j & 0xF];
+      // the unused bits of the last word are always zero
+      size_t count_ = 0;
+      for(unsigned i = 0; i < elements_count_; ++i)
+        count_ += popcount(storage_[i]);
       return count_;
     }
 
@@ -329,14 +296,20 @@ namespace std {
     {
       check_bounds(pos);
       const storage_type val = storage_[pos / element_size_];
-      return (val & static_cast<storage_type>(1 << (pos & element_mod_)) ) != 0;
+      return (val & (native_one_ << (pos & element_mod_)) ) != 0;
     }
 
-    bool none() const { return !any(); }
-    bool all()  const { return count() == size(); }
-    bool any()  const
+    bool none() const __ntl_nothrow { return !any(); }
+    bool all()  const __ntl_nothrow
+    {
+      for(unsigned i = 0; i < elements_count_-1; ++i)
+        if(storage_[i] != set_bits_)
+          return false;
+      return storage_[elements_count_-1] == digits_mod_;
+    }
+    bool any()  const __ntl_nothrow
     {
-      for(uint32_t i = 0; i < elements_count_; i++)
+      for(unsigned i = 0; i < elements_count_; ++i)
         if(storage_[i])
           return true;
       return false;
@@ -352,6 +325,24 @@ namespace std {
       return bitset<N>(*this) >>= pos;
     }
 
+    ///\name extensions
+    /** Returns the index of the first set bit or size() if there is none */
+    size_t _Find_first() const __ntl_nothrow
+    {
+      return find_from(0);
+    }
+
+    /** Returns the index of the first set bit after \p prev or size() if there is none */
+    size_t _Find_next(size_t prev) const __ntl_nothrow
+    {
+      if(++prev >= N)
+        return N;
+      const size_t i = prev / element_size_;
+      const storage_type word = storage_[i] & (set_bits_ << (prev & element_mod_));
+      return word ? i*element_size_ + countr_zero(word) : find_from(i+1);
+    }
+    ///\}
+
   private:
     void check_bounds(const size_t pos) const __ntl_throws (out_of_range)
     {
@@ -391,52 +382,47 @@ namespace std {
       return str;
     }
 
-    void large_shift_left(size_t pos)
+    size_t find_from(size_t i) const
+    {
+      for(; i < elements_count_; ++i)
+        if(storage_[i])
+          return i*element_size_ + countr_zero(storage_[i]);
+      return N;
+    }
+
+    // every word is computed from the source words only, so the compiler can vectorize the loops
+
+    void shift_left(size_t words, size_t shift)
     {
-      const size_t shift = pos % element_size_;
-      const unsigned lookup = static_cast<unsigned>(pos / element_size_);
       if(shift == 0){
-        // shift by words, fastest pass
-        for(unsigned i = elements_count_-1; i >= lookup; --i)
-          storage_[i] = storage_[i-lookup];
-        for(int i = lookup-1; i >= 0; --i)
-          storage_[i] = 0;
+        for(size_t i = elements_count_-1; i > words; --i)
+          storage_[i] = storage_[i-words];
       }else{
-        // shift by bits
-        for(unsigned i = elements_count_-1; i > lookup; --i){
-          storage_[i]  = storage_[i-lookup] << shift;
-          storage_[i] |= storage_[i-lookup-1] >> (element_size_-shift);
-        }
-        storage_[lookup] = storage_[0] << shift;
-        // clear remaining bits
-        for(int i = lookup-1; i >= 0; --i)
-          storage_[i] = 0;
+        const size_t rshift = element_size_ - shift;
+        for(size_t i = elements_count_-1; i > words; --i)
+          storage_[i] = (storage_[i-words] << shift) | (storage_[i-words-1] >> rshift);
       }
+      storage_[words] = storage_[0] << shift;
+      for(size_t i = 0; i < words; ++i)
+        storage_[i] = 0;
       // cut garbage bits
       storage_[elements_count_-1] &= digits_mod_;
     }
 
-    void large_shift_right(size_t pos)
+    void shift_right(size_t words, size_t shift)
     {
-      const size_t shift = pos % element_size_;
-      const unsigned lookup = static_cast<unsigned>(pos / element_size_);
+      const size_t last = elements_count_ - words - 1;
       if(shift == 0){
-        // shift by words, fastest pass
-        for(unsigned i = 0; i < elements_count_-lookup; ++i)
-          storage_[i] = storage_[i+lookup];
-        for(unsigned i = elements_count_-lookup; i < elements_count_; ++i)
-          storage_[i] = 0;
+        for(size_t i = 0; i < last; ++i)
+          storage_[i] = storage_[i+words];
       }else{
-        // shift by bits
-        for(unsigned i = 0; i < elements_count_-lookup-1; ++i){
-          storage_[i]  = storage_[i+lookup] >> shift;
-          storage_[i] |= storage_[i+lookup+1] << (element_size_-shift);
-        }
-        storage_[elements_count_-lookup-1] = storage_[elements_count_-1] >> shift;
-        // clear remaining bits
-        for(unsigned i = elements_count_-lookup; i < elements_count_; ++i)
-          storage_[i] = 0;
+        const size_t lshift = element_size_ - shift;
+        for(size_t i = 0; i < last; ++i)
+          storage_[i] = (storage_[i+words] >> shift) | (storage_[i+words+1] << lshift);
       }
+      storage_[last] = storage_[elements_count_-1] >> shift;
+      for(size_t i = last+1; i < elements_count_; ++i)
+        storage_[i] = 0;
     }
 
   private:
@@ -445,7 +431,7 @@ namespace std {
     enum { digits = N };
     enum { element_size_ = sizeof(storage_type) * 8 }; // bits count
 
-    static const size_t native_one_ = 1;
+    static const storage_type native_one_ = 1;
     static const storage_type set_bits_ = static_cast<storage_type>(-1);
     static const size_t element_mod_ = element_size_ - 1;
     static const size_t digits_mod_val_ = static_cast<size_t>(native_one_ << (N % element_size_)) - 1;//static_cast<size_t>(1 << (N & (element_size_-1))) - 1;
@@ -478,19 +464,19 @@ namespace std {
   template <size_t N>
   bitset<N> operator&(const bitset<N>& lhs, const bitset<N>& rhs)
   {
-    return lhs &= rhs;
+    return bitset<N>(lhs) &= rhs;
   }
 
   template <size_t N>
   bitset<N> operator|(const bitset<N>& lhs, const bitset<N>& rhs)
   {
-    return lhs |= rhs;
+    return bitset<N>(lhs) |= rhs;
   }
 
   template <size_t N>
   bitset<N> operator^(const bitset<N>& lhs, const bitset<N>& rhs)
   {
-    return lhs ^= rhs;
+    return bitset<N>(lhs) ^= rhs;
   }
 
   template <class charT, class traits, size_t N>
@@ -83,6 +83,15 @@
 	#define __inline_ns
 #endif
 
+// thread local storage
+#if defined(NTL_CXX_THREADL)
+  #define __thread_local thread_local
+#elif defined(__GNUC__)
+  #define __thread_local __thread
+#else
+  #define __thread_local __declspec(thread)
+#endif
+
 #ifdef NTL_CXX_CONSTEXPR
   #define __declare_tag constexpr
 #else
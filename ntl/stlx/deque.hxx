@@ -10,6 +10,7 @@
 
 #include "memory.hxx"
 #include "algorithm.hxx"
+#include "stdexcept_fwd.hxx"
 
 namespace std {
 
@@ -19,10 +20,17 @@ namespace std {
 /**\addtogroup  lib_sequence *********** 23.2 Sequence containers [sequences]
  *@{*/
 
+  /**
+   *  Class template deque [23.2.2]
+   *
+   *  Elements are kept in fixed-size chunks addressed through a map of chunk pointers,
+   *  so growth at either end never relocates the stored elements and keeps references valid.
+   *  A couple of released chunks are cached to avoid allocator churn in queue-like usage.
+   **/
   template <class T, class Allocator = allocator<T> >
-  class deque 
+  class deque
   {
-    typedef typename  
+    typedef typename
       Allocator::template rebind<T>::other          allocator;
   public:
     // types:
@@ -35,90 +43,192 @@ namespace std {
     typedef typename  allocator::size_type          size_type;
     typedef typename  allocator::difference_type    difference_type;
 
-    typedef pointer                                 iterator;
-    typedef const_pointer                           const_iterator;
-    typedef std::reverse_iterator<iterator>         reverse_iterator;
-    typedef std::reverse_iterator<const_iterator>   const_reverse_iterator;
+  private:
+    typedef typename
+      Allocator::template rebind<pointer>::other    map_allocator;
+    typedef pointer*                                map_pointer;
+
+    /// number of elements in each chunk
+    static const size_type chunk_size = sizeof(T) < 256 ? 4096 / sizeof(T) : 16;
+    /// number of released chunks kept for reuse
+    static const size_type cache_limit = 2;
+    /// minimal map size
+    static const size_type initial_map_size = 8;
+
+    template<class Pointer, class Reference>
+    struct iterator__impl
+    : public std::iterator<random_access_iterator_tag, value_type,
+                           difference_type, Pointer, Reference>
+    {
+        iterator__impl() : cur(), first(), last(), node() {}
+        iterator__impl(const iterator__impl<typename deque::pointer, typename deque::reference>& i) //`typename deque::' works around MSVC's /Ze
+          : cur(i.cur), first(i.first), last(i.last), node(i.node)
+        {}
+
+        Reference operator* () const { return *cur; }
+        Pointer   operator->() const { return cur; }
+        Reference operator[](difference_type n) const { return *(*this + n); }
+
+        iterator__impl& operator++()
+        {
+          if(++cur == last){
+            set_node(node+1);
+            cur = first;
+          }
+          return *this;
+        }
+        iterator__impl& operator--()
+        {
+          if(cur == first){
+            set_node(node-1);
+            cur = last;
+          }
+          --cur;
+          return *this;
+        }
+        iterator__impl operator++(int) { iterator__impl tmp(*this); ++*this; return tmp; }
+        iterator__impl operator--(int) { iterator__impl tmp(*this); --*this; return tmp; }
+
+        iterator__impl& operator+=(difference_type n)
+        {
+          const difference_type offset = n + (cur - first);
+          if(offset >= 0 && offset < static_cast<difference_type>(chunk_size))
+            cur += n;
+          else{
+            const difference_type cs = static_cast<difference_type>(chunk_size),
+              node_offset = offset > 0 ? offset / cs : -((-offset - 1) / cs) - 1;
+            set_node(node + node_offset);
+            cur = first + (offset - node_offset * cs);
+          }
+          return *this;
+        }
+        iterator__impl& operator-=(difference_type n) { return *this += -n; }
+
+      friend iterator__impl operator+(iterator__impl i, difference_type n) { return i += n; }
+      friend iterator__impl operator+(difference_type n, iterator__impl i) { return i += n; }
+      friend iterator__impl operator-(iterator__impl i, difference_type n) { return i -= n; }
+      friend difference_type operator-(const iterator__impl& x, const iterator__impl& y)
+        {
+          return static_cast<difference_type>(chunk_size) * (x.node - y.node) + (x.cur - x.first) - (y.cur - y.first);
+        }
+
+      friend bool operator==(const iterator__impl& x, const iterator__impl& y) { return x.cur == y.cur; }
+      friend bool operator!=(const iterator__impl& x, const iterator__impl& y) { return x.cur != y.cur; }
+      friend bool operator< (const iterator__impl& x, const iterator__impl& y)
+        {
+          return x.node == y.node ? x.cur < y.cur : x.node < y.node;
+        }
+      friend bool operator> (const iterator__impl& x, const iterator__impl& y) { return y < x; }
+      friend bool operator<=(const iterator__impl& x, const iterator__impl& y) { return !(y < x); }
+      friend bool operator>=(const iterator__impl& x, const iterator__impl& y) { return !(x < y); }
+
+      friend class deque;
+      friend struct iterator__impl<typename deque::const_pointer, typename deque::const_reference>;
+
+      private:
+        typename deque::pointer cur, first, last;
+        map_pointer node;
+
+        void set_node(map_pointer n)
+        {
+          node = n;
+          first = *n;
+          last = first + chunk_size;
+        }
+    };
+
+  public:
+    typedef iterator__impl<pointer, reference>              iterator;
+    typedef iterator__impl<const_pointer, const_reference>  const_iterator;
+    typedef std::reverse_iterator<iterator>                 reverse_iterator;
+    typedef std::reverse_iterator<const_iterator>           const_reverse_iterator;
 
   public:
     ///\name 23.2.2.1 construct/copy/destroy:
     explicit deque(const Allocator& a = Allocator())
-      :alloc(a), left(), right(), capL(), capR(), base_(), cap_()
+      :alloc(a), map_(), map_size_(), cache_(), cached_()
     {}
     explicit deque(size_type n)
-      :alloc(), left(), right(), capL(), capR(), base_(), cap_()
-    {
-      if(n){
-        reserve(n);
-        capR -= n;
-      #if !defined(NTL_CXX_RV) || defined(NTL_CXX_RVFIX)
-        while(n--)
-          alloc.construct(right++, T());
-      #else
-        while(n--)
-          alloc.construct(right++, forward<value_type>(T()));
-      #endif
+      :alloc(), map_(), map_size_(), cache_(), cached_()
+    {
+      __ntl_try{
+        while(n--){
+        #if !defined(NTL_CXX_RV) || defined(NTL_CXX_RVFIX)
+          push_back(T());
+        #else
+          push_back(forward<value_type>(T()));
+        #endif
+        }
+      }
+      __ntl_catch(...){
+        dispose();
+        __ntl_rethrow;
       }
     }
 
     deque(size_type n, const T& value, const Allocator& a = Allocator())
-      :alloc(a), left(), right(), capL(), capR(), base_(), cap_()
+      :alloc(a), map_(), map_size_(), cache_(), cached_()
     {
-      if(n){
-        reserve(n);
-        capR -= n;
-        while(n--)
-          alloc.construct(right++, value);
+      __ntl_try{
+        assign(n, value);
+      }
+      __ntl_catch(...){
+        dispose();
+        __ntl_rethrow;
       }
     }
 
     template <class InputIterator>
     deque(InputIterator first, InputIterator last, const Allocator& a = Allocator(), typename enable_if<!is_integral<InputIterator>::value>::type* =0)
-      :alloc(a), left(), right(), capL(), capR(), base_(), cap_()
+      :alloc(a), map_(), map_size_(), cache_(), cached_()
     {
-      assign(first, last, typename iterator_traits<InputIterator>::iterator_category());
+      init(first, last);
     }
 
     deque(const deque<T,Allocator>& x)
-      :alloc(x.alloc), left(), right(), capL(), capR(), base_(), cap_()
+      :alloc(x.alloc), map_(), map_size_(), cache_(), cached_()
     {
-      assign(x.cbegin(), x.cend());
+      init(x.cbegin(), x.cend());
     }
 
     deque(const deque& x, const Allocator& a)
-      :alloc(a), left(), right(), capL(), capR(), base_(), cap_()
+      :alloc(a), map_(), map_size_(), cache_(), cached_()
     {
-      assign(x.cbegin(), x.cend());
+      init(x.cbegin(), x.cend());
     }
-    
+
     deque(initializer_list<T> il)
-      :left(), right(), capL(), capR(), base_(), cap_()
+      :map_(), map_size_(), cache_(), cached_()
     {
-      assign(il.begin(), il.end(), forward_iterator_tag());
+      init(il.begin(), il.end());
     }
     deque(initializer_list<T> il, const Allocator& a)
-      :alloc(a), left(), right(), capL(), capR(), base_(), cap_()
+      :alloc(a), map_(), map_size_(), cache_(), cached_()
     {
-      assign(il.begin(), il.end(), forward_iterator_tag());
+      init(il.begin(), il.end());
     }
 
     #ifdef NTL_CXX_RV
     deque(deque&& x)
-      :alloc(), left(), right(), capL(), capR(), base_(), cap_()
+      :alloc(), map_(), map_size_(), cache_(), cached_()
     {
       swap(x);
     }
     deque(deque&& x, const Allocator& a)
-      :alloc(a), left(), right(), capL(), capR(), base_(), cap_()
+      :alloc(a), map_(), map_size_(), cache_(), cached_()
     {
       if(x.get_allocator() == a){
         swap(x);
       }else{
-        // move elements using the array_allocator
-        // TODO: reserve(x.size())
-        reserve(x.size());
-        right = uninitialized_move(x.begin(), x.end(), right);
-        capR -= x.size();
+        // allocators differ, move the elements one by one
+        __ntl_try{
+          for(iterator i = x.begin(); i != x.end(); ++i)
+            push_back(std::move(*i));
+        }
+        __ntl_catch(...){
+          dispose();
+          __ntl_rethrow;
+        }
         x.clear();
       }
     }
@@ -127,13 +237,13 @@ namespace std {
     ///\name Range extension
     template<class Iter>
     explicit deque(std::range<Iter>&& R)
-      :left(), right(), capL(), capR(), base_(), cap_()
+      :map_(), map_size_(), cache_(), cached_()
     {
       assign(forward<Range>(R));
     }
     template<class Iter>
     explicit deque(std::range<Iter>&& R, const Allocator& a)
-      :alloc(a), left(), right(), capL(), capR(), base_(), cap_()
+      :alloc(a), map_(), map_size_(), cache_(), cached_()
     {
       assign(forward<Range>(R));
     }
@@ -161,23 +271,20 @@ namespace std {
     {
       dispose();
     }
-    
+
     deque& operator=(initializer_list<T> il)
     {
-      //dispose();
-      assign(il.begin(), il.end(), forward_iterator_tag());
+      assign(il.begin(), il.end());
       return *this;
     }
 
     deque<T,Allocator>& operator=(const deque<T,Allocator>& x)
     {
-      if(&x != this){
-        //dispose();
+      if(&x != this)
         assign(x.cbegin(), x.cend());
-      }
       return *this;
     }
-    
+
     #ifdef NTL_CXX_RV
     deque<T,Allocator>& operator=(deque<T,Allocator>&& x)
     {
@@ -188,85 +295,74 @@ namespace std {
       return *this;
     }
     #endif
-    
+
     template <class InputIterator>
     void assign(InputIterator first, InputIterator last, typename enable_if<!is_integral<InputIterator>::value>::type* =0)
     {
-      assign(first, last, typename iterator_traits<InputIterator>::iterator_category());
+      // reuse the existing elements, then append or truncate
+      iterator i = begin();
+      for(; i != end() && first != last; ++i, ++first)
+        *i = *first;
+      if(first == last)
+        erase_at_end(i);
+      else for(; first != last; ++first)
+        push_back(*first);
     }
 
     void assign(size_type n, const T& t)
     {
-      const size_type cap = capacity();
-      if(n > cap){
-        dispose();
-        reserve(n);
-        capR -= n;
-      }else{
-        clear();
-        // adjust pointers to place elements
-        // after clear they are in the middle
-        const size_type d = n/2;
-        left -= d; capL -= d;
-        capR -= d + (n&1);
-        right = left;
-      }
-      while(n--)
-        alloc.construct(right++, t);
-      validate();
+      iterator i = begin();
+      for(; i != end() && n; ++i, --n)
+        *i = t;
+      if(!n)
+        erase_at_end(i);
+      else while(n--)
+        push_back(t);
     }
 
     void assign(initializer_list<T> il)
     {
-      assign(il.begin(), il.end(), forward_iterator_tag());
+      assign(il.begin(), il.end());
     }
-    
+
     allocator_type get_allocator() const { return alloc; }
 
     ///\name iterators:
-    iterator        begin()                 { return left; }
-    const_iterator  begin() const           { return left; }
-    const_iterator cbegin() const           { return left; }
+    iterator        begin()                 { return start_; }
+    const_iterator  begin() const           { return start_; }
+    const_iterator cbegin() const           { return start_; }
+
+    iterator        end()                   { return finish_; }
+    const_iterator  end() const             { return finish_; }
+    const_iterator cend() const             { return finish_; }
 
-    iterator        end()                   { return right; }
-    const_iterator  end() const             { return right; }
-    const_iterator cend() const             { return right; }
+    reverse_iterator        rbegin()        { return reverse_iterator(end()); }
+    const_reverse_iterator  rbegin() const  { return const_reverse_iterator(end()); }
+    const_reverse_iterator crbegin() const  { return const_reverse_iterator(end()); }
 
-    reverse_iterator        rbegin()        { return reverse_iterator(right); }
-    const_reverse_iterator  rbegin() const  { return const_reverse_iterator(right); }
-    const_reverse_iterator crbegin() const  { return const_reverse_iterator(right); }
+    reverse_iterator        rend()          { return reverse_iterator(begin()); }
+    const_reverse_iterator  rend() const    { return const_reverse_iterator(begin()); }
+    const_reverse_iterator crend() const    { return const_reverse_iterator(begin()); }
 
-    reverse_iterator        rend()          { return reverse_iterator(left); }
-    const_reverse_iterator  rend() const    { return const_reverse_iterator(left); }
-    const_reverse_iterator crend() const    { return const_reverse_iterator(left); }
-    
 
     ///\name 23.2.2.2 capacity:
-    size_type size() const      { return right - left; }
+    size_type size() const      { return finish_ - start_; }
     size_type max_size() const  { return alloc.max_size(); }
-    
+
     void resize(size_type sz)
     {
     #ifndef NTL_CXX_RV
       resize(sz, value_type());
-      return;
     #else
       const size_type len = size();
       if(sz < len)
-        erase(left+sz, right);
-      else if(sz > len){
-        sz -= len;
-        if(sz > capR)
-          reallocate(sz/*-capR*/);
-        capR -= sz;
+        erase_at_end(begin() + sz);
+      else for(sz -= len; sz; --sz){
       #if !defined(NTL_CXX_RV) || defined(NTL_CXX_RVFIX)
-        while(sz--)
-          alloc.construct(right++, T());
+        push_back(T());
       #else
-        while(sz--)
-          alloc.construct(right++, forward<value_type>(T()));
+        push_back(forward<value_type>(T()));
       #endif
-        validate();
       }
     #endif
     }
@@ -274,177 +370,223 @@ namespace std {
     {
       const size_type len = size();
       if(sz < len)
-        erase(left+sz, right);
+        erase_at_end(begin() + sz);
       else if(sz > len)
-        insert(right, sz-len, c);
-      validate();
+        insert(cend(), sz-len, c);
     }
 
+    /** Releases the cached chunks, and the whole storage if the deque is empty */
     void shrink_to_fit()
     {
-      if(!empty() && size() > can_shrink)
-        reallocate();
-      validate();
+      if(empty())
+        dispose();
+      else
+        drain_cache();
     }
-    
-    bool empty() const { return left == right; }
-    
+
+    bool empty() const { return start_ == finish_; }
+
     ///\name element access:
-    reference       operator[](size_type n)       { return *(left+n); }
-    const_reference operator[](size_type n) const { return *(left+n); }
-    
-    reference at(size_type n)
+    reference       operator[](size_type n)       { return *locate(n); }
+    const_reference operator[](size_type n) const { return *locate(n); }
+
+    reference at(size_type n) __ntl_throws(out_of_range)
     {
-      if(n > size()) __ntl_throw(out_of_range());
-      return *(left+n);
+      check_bounds(n);
+      return *locate(n);
     }
-    const_reference at(size_type n) const
+    const_reference at(size_type n) const __ntl_throws(out_of_range)
     {
-      if(n > size()) __ntl_throw(out_of_range());
-      return *(left+n);
+      check_bounds(n);
+      return *locate(n);
     }
-    
-    reference front()             { return *left; }
-    const_reference front() const { return *left; }
-    reference back()              { return *(right-1); }
-    const_reference back() const  { return *(right-1); }
-    
+
+    reference front()             { return *start_.cur; }
+    const_reference front() const { return *start_.cur; }
+    reference back()              { return *(finish_ - 1); }
+    const_reference back() const  { return *(finish_ - 1); }
+
     ///\name 23.2.2.3 modifiers:
     #ifdef NTL_CXX_VT
     template <class... Args> void emplace_front(Args&&... args)
     {
-      if(empty())
-        reserve();
-      else if(!capL)
-        relocate(false);
-      alloc.construct(--left, std::forward<Args>(args)...); --capL;
-      validate();
+      pointer p = front_slot();
+      __ntl_try{
+        alloc.construct(p, std::forward<Args>(args)...);
+      }
+      __ntl_catch(...){
+        front_rollback();
+        __ntl_rethrow;
+      }
+      front_commit(p);
     }
 
     template <class... Args> void emplace_back(Args&&... args)
     {
-      if(empty())
-        reserve();
-      else if(!capR)
-        relocate(true);
-      alloc.construct(right++, std::forward<Args>(args)...); --capR;
-      validate();
+      pointer p = back_slot();
+      __ntl_try{
+        alloc.construct(p, std::forward<Args>(args)...);
+      }
+      __ntl_catch(...){
+        back_rollback();
+        __ntl_rethrow;
+      }
+      back_commit();
     }
 
     template <class... Args> iterator emplace(const_iterator position, Args&&... args)
     {
-      assert(position >= left && position <= right);
-      if(position == right){
+      if(position == cbegin()){
+        emplace_front(std::forward<Args>(args)...);
+        return begin();
+      }else if(position == cend()){
         emplace_back(std::forward<Args>(args)...);
-        return right-1;
+        return end()-1;
       }
-      pointer pos = insert_impl(position);
-      alloc.construct(pos, std::forward<Args>(args)...);
-      validate();
-      return pos;
+      value_type x(std::forward<Args>(args)...);
+      return insert_impl(position, x);
     }
     #endif
 
     #ifdef NTL_CXX_RV
     void push_front(T&& x)
     {
-      if(empty())
-        reserve();
-      else if(!capL)
-        relocate(false);
-      alloc.construct(--left, forward<value_type>(x)); --capL;
-      validate();
+      pointer p = front_slot();
+      __ntl_try{
+        alloc.construct(p, forward<value_type>(x));
+      }
+      __ntl_catch(...){
+        front_rollback();
+        __ntl_rethrow;
+      }
+      front_commit(p);
     }
     void push_back(T&& x)
     {
-      if(empty())
-        reserve();
-      else if(!capR)
-        relocate(true);
-      alloc.construct(right++, forward<value_type>(x)); --capR;
-      validate();
+      pointer p = back_slot();
+      __ntl_try{
+        alloc.construct(p, forward<value_type>(x));
+      }
+      __ntl_catch(...){
+        back_rollback();
+        __ntl_rethrow;
+      }
+      back_commit();
     }
     #endif
 
     void push_front(const T& x)
     {
-      if(empty())
-        reserve();
-      else if(!capL)
-        relocate(false);
-      alloc.construct(--left, x); --capL;
-      validate();
+      pointer p = front_slot();
+      __ntl_try{
+        alloc.construct(p, x);
+      }
+      __ntl_catch(...){
+        front_rollback();
+        __ntl_rethrow;
+      }
+      front_commit(p);
     }
 
     void push_back(const T& x)
     {
-      if(empty())
-        reserve();
-      else if(!capR)
-        relocate(true);
-      alloc.construct(right++, x); --capR;
-      validate();
+      pointer p = back_slot();
+      __ntl_try{
+        alloc.construct(p, x);
+      }
+      __ntl_catch(...){
+        back_rollback();
+        __ntl_rethrow;
+      }
+      back_commit();
     }
 
     void pop_front()
     {
-      if(!empty())
-        alloc.destroy(left++), ++capL;
-      validate();
+      if(empty())
+        return;
+      alloc.destroy(start_.cur);
+      if(start_.cur+1 == start_.last){
+        release_chunk(start_.first);
+        start_.set_node(start_.node+1);
+        start_.cur = start_.first;
+      }else{
+        ++start_.cur;
+      }
     }
     void pop_back()
     {
-      if(!empty())
-        alloc.destroy(--right), ++capR;
-      validate();
+      if(empty())
+        return;
+      if(finish_.cur == finish_.first){
+        release_chunk(finish_.first);
+        finish_.set_node(finish_.node-1);
+        finish_.cur = finish_.last;
+      }
+      alloc.destroy(--finish_.cur);
     }
 
     #ifdef NTL_CXX_RV
     iterator insert(const_iterator position, T&& x)
     {
-      assert(position >= left && position <= right);
-      if(position == right){
+      if(position == cbegin()){
+        push_front(forward<value_type>(x));
+        return begin();
+      }else if(position == cend()){
         push_back(forward<value_type>(x));
-        return right-1;
+        return end()-1;
       }
-      pointer pos = insert_impl(position);
-      alloc.construct(pos, forward<value_type>(x));
-      validate();
-      return pos;
+      return insert_impl(position, x);
     }
     #endif
 
     iterator insert(const_iterator position, const T& x)
     {
-      assert(position >= left && position <= right);
-      if(position == right){
+      if(position == cbegin()){
+        push_front(x);
+        return begin();
+      }else if(position == cend()){
         push_back(x);
-        return right-1;
+        return end()-1;
       }
-      pointer pos = insert_impl(position);
-      alloc.construct(pos, x);
-      validate();
-      return pos;
+      value_type tmp(x);
+      return insert_impl(position, tmp);
     }
 
     void insert(const_iterator position, size_type n, const T& x)
     {
-      assert(position >= left && position <= right);
-      const ptrdiff_t diff = position-left;
-      if(n > capR)
-        reallocate(n/*-capR*/); // invalidates iterators
-      pointer pos = left + diff;
-      move_backward(pos, right, pos+n+(right-pos)); // shift right
-      capR -= n; right += n;
-      while(n--)
-        alloc.construct(pos++, x);
-      validate();
+      // grow at the nearest end (references to the elements stay valid), then rotate the new elements into place
+      const size_type index = position - cbegin(), len = size();
+      if(index < len / 2){
+        size_type i = 0;
+        __ntl_try{
+          for(; i < n; ++i)
+            push_front(x);
+        }
+        __ntl_catch(...){
+          while(i--)
+            pop_front();
+          __ntl_rethrow;
+        }
+        std::rotate(begin(), begin()+n, begin()+(n+index));
+      }else{
+        insert_at_back(index, len, x, n);
+      }
     }
 
     template <class InputIterator>
     void insert(const_iterator position, InputIterator first, InputIterator last, typename enable_if<!is_integral<InputIterator>::value>::type* =0)
     {
-      insert(position, first, last, typename iterator_traits<InputIterator>::iterator_category());
+      const size_type index = position - cbegin(), len = size();
+      __ntl_try{
+        for(; first != last; ++first)
+          push_back(*first);
+      }
+      __ntl_catch(...){
+        erase_at_end(begin()+len);
+        __ntl_rethrow;
+      }
+      std::rotate(begin()+index, begin()+len, end());
     }
 
     void insert(const_iterator position, initializer_list<T> il)
@@ -454,260 +596,311 @@ namespace std {
 
     iterator erase(const_iterator position)
     {
-      assert(!empty() && position >= left && position < right);
-      iterator pos;
-      if(position == left) // front
-        alloc.destroy(left++), ++capL, pos = left;
-      else if(position == right-1) // back
-        alloc.destroy(--right), ++capR, pos = right;
-      else{
-        // erasing element inside deque, move elements
-        pos = const_cast<iterator>(position);
-        alloc.destroy(pos);
-        move(pos+1, right, pos);
-        --right, ++capR;
+      assert(!empty() && position >= cbegin() && position < cend());
+      iterator pos = make_iterator(position);
+      const size_type index = pos - start_;
+      if(index < size() / 2){
+        std::move_backward(start_, pos, pos+1);
+        pop_front();
+      }else{
+        std::move(pos+1, finish_, pos);
+        pop_back();
       }
-      validate();
-      return pos;
+      return start_ + index;
     }
 
     iterator erase(const_iterator first, const_iterator last)
     {
-      assert(first >= left && last <= right);
-      if(first == left && last == right){
-        // clear all
-        return erase_all(no_dtor());
+      assert(first >= cbegin() && last <= cend() && first <= last);
+      if(first == last)
+        return make_iterator(first);
+      if(first == cbegin() && last == cend()){
+        clear();
+        return end();
+      }
+      const size_type n = last - first, index = first - cbegin();
+      if(index < (size() - n) / 2){
+        // move the leading elements right
+        std::move_backward(start_, make_iterator(first), make_iterator(last));
+        erase_at_begin(start_ + n);
       }else{
-        if(first != last){
-          pointer l = const_cast<pointer>(last), f = const_cast<pointer>(first);
-          if(l == right)
-            l = f;
-          else
-            l = move(l, right, f);  // move left tailing elements, l points to remainder
-          capR += right-l;
-          if(no_dtor::value)
-            right = l;
-          else while(right != l)     // destroy reminder
-            alloc.destroy(--right);
-          validate();
-        }
-        return const_cast<pointer>(first);
+        // move the tailing elements left
+        erase_at_end(std::move(make_iterator(last), finish_, make_iterator(first)));
       }
+      return start_ + index;
     }
 
     void swap(deque<T,Allocator>& x)
     {
       if(this != &x){
         using std::swap;
-        pointer l = left, r = right;
-        size_type cl = capL, cr = capR;
-        left = x.left, right = x.right;
-        capL = x.capL, capR = x.capR;
-        x.left = l, x.right = r;
-        x.capL = cl, x.capR = cr;
         swap(alloc, x.alloc);
-        swap(base_, x.base_);
-        swap(cap_,  x.cap_);
+        swap(map_, x.map_);
+        swap(map_size_, x.map_size_);
+        swap(start_, x.start_);
+        swap(finish_, x.finish_);
+        swap(cache_, x.cache_);
+        swap(cached_, x.cached_);
       }
     }
 
     void clear()
     {
-      if(!empty())
-        erase_all(no_dtor());
+      erase_at_end(start_);
     }
     ///\}
   protected:
-    // we can fast relocate if type is pod
-    static const bool can_fast_relocate = 0 && has_trivial_copy_constructor<T>::value;
-    static const size_type can_shrink = 32;
-    //typedef __::bool_type<is_pod<T>::value || has_trivial_destructor<T>::value> no_dtor;
     typedef false_type no_dtor;
 
-    // capacity helpers
-    size_type capacity_factor(size_type n) const { /*if(n == 0) n = 1; return n*2; }*/ return (n + 4) * 2; }
-    size_type capacity() const 
+    void check_bounds(size_type n) const __ntl_throws(out_of_range)
     {
-      size_type c = (right - left) + capL + capR;
-      assert(c == cap_);
-      __unused(c);
-      return cap_;
+      if(n >= size()) __throw_out_of_range(__name__": no such element.");
     }
-    bool can_relocate(size_type n) const { return n > capacity_factor(size()); }
 
-    void validate()
+    pointer locate(size_type n) const
     {
-      capacity(); //-V530
-      base();
-    }
-    // allocate memory
-    void reserve(size_type n = 0)
-    { // pre: container must be cleared
-      const size_type cap = cap_ = capacity_factor(n);
-      pointer p = base_ = alloc.allocate(cap);
-      //if(!p) return;
-      pointer middle = p + cap/2;
-      right = left = middle - n/2;
-      capL = left - p; capR = cap - capL;
-      validate();
-      // post: left & right points to the new uninitialized element (or in the middle if n == 0)
+      const size_type offset = n + (start_.cur - start_.first);
+      return start_.node[offset / chunk_size] + offset % chunk_size;
     }
 
-    pointer base() const 
+    static iterator make_iterator(const const_iterator& i)
     {
-      pointer b = left - capL;
-      assert(!b || b == base_);
-      __unused(b);
-      return base_;
+      iterator it;
+      it.cur = i.cur, it.first = i.first, it.last = i.last, it.node = i.node;
+      return it;
     }
 
-    void relocate(bool is_right)
+    template <class InputIterator>
+    void init(InputIterator first, InputIterator last)
     {
-      validate();
-      // param: which side needed a space
-      if(can_fast_relocate){
-        // TODO: define offset to relocate
-        if(is_right && can_relocate(capL)){
-          // move the contents left
-        }else if(!is_right && can_relocate(capR)){
-          // move the contents right
-        }
-        return;
+      __ntl_try{
+        for(; first != last; ++first)
+          push_back(*first);
+      }
+      __ntl_catch(...){
+        dispose();
+        __ntl_rethrow;
       }
-      reallocate();
     }
 
-    void reallocate(size_type n = 0)
+    ///\name chunk management
+    pointer allocate_chunk()
     {
-      validate();
-      pointer l = left, r = right, p = base();
-      const size_type cap = capacity(), c = max(capacity(), n);
-      reserve(c);
-      validate();
-      if(r-l){
-        right = uninitialized_move(l, r, right);
-        capR -= r - l;
+      if(cache_){
+        pointer p = cache_;
+        cache_ = *reinterpret_cast<pointer*>(p);
+        --cached_;
+        return p;
       }
-      if(p)
-        alloc.deallocate(p, cap);
-      validate();
+      return alloc.allocate(chunk_size);
     }
 
-    iterator erase_all(true_type)
+    void release_chunk(pointer p)
     {
-      // no dtor, just adjust pointers
-      const pointer p = base();
-      const size_type cap = capacity();
-      right = left = p + cap/2;
-      capL = left - p; capR = cap - capL;
-      validate();
-      return right;
+      if(cached_ < cache_limit){
+        // keep the chunk in the singly linked cache, its first bytes hold the link
+        *reinterpret_cast<pointer*>(p) = cache_;
+        cache_ = p;
+        ++cached_;
+      }else{
+        alloc.deallocate(p, chunk_size);
+      }
     }
 
-    iterator erase_all(false_type)
+    void drain_cache()
     {
-      pointer p = left;
-      while(p != right)
-        alloc.destroy(p++);
-      return erase_all(true_type());
+      while(cache_){
+        pointer p = cache_;
+        cache_ = *reinterpret_cast<pointer*>(p);
+        alloc.deallocate(p, chunk_size);
+      }
+      cached_ = 0;
     }
 
-    void dispose()
+    ///\name map management
+    /** Allocates the map with one empty chunk in the middle */
+    void initialize_map()
     {
-      if(base()){
-        if(!empty())
-          clear();
-        alloc.deallocate(base(), capacity());
-        left = right = base_ = nullptr;
-        capL = capR = cap_ = 0;
+      map_allocator ma(alloc);
+      map_pointer m = ma.allocate(initial_map_size);
+      __ntl_try{
+        m[initial_map_size/2] = allocate_chunk();
+      }
+      __ntl_catch(...){
+        ma.deallocate(m, initial_map_size);
+        __ntl_rethrow;
       }
+      map_ = m, map_size_ = initial_map_size;
+      start_.set_node(map_ + initial_map_size/2);
+      start_.cur = start_.first + chunk_size/2;
+      finish_ = start_;
     }
 
-    template <class InputIterator>
-    void assign(InputIterator first, InputIterator last, random_access_iterator_tag)
+    void reserve_map_at_back()
     {
-      const size_type n = last - first;
-      const size_type cap = capacity();
-      if(n > cap){
-        dispose();
-        reserve(n);
-        capR -= n;
+      if(finish_.node + 1 == map_ + map_size_)
+        reallocate_map(false);
+    }
+
+    void reserve_map_at_front()
+    {
+      if(start_.node == map_)
+        reallocate_map(true);
+    }
+
+    /** Makes room for one node pointer at the given side: recenters the nodes when the map is half empty, grows it otherwise */
+    void reallocate_map(bool at_front)
+    {
+      const size_type old_nodes = finish_.node - start_.node + 1, new_nodes = old_nodes + 1;
+      map_pointer new_start;
+      if(map_size_ > 2 * new_nodes){
+        new_start = map_ + (map_size_ - new_nodes) / 2 + (at_front ? 1 : 0);
+        if(new_start < start_.node)
+          std::copy(start_.node, finish_.node + 1, new_start);
+        else
+          std::copy_backward(start_.node, finish_.node + 1, new_start + old_nodes);
       }else{
-        clear();
-        // adjust pointers to place elements
-        // after clear they are in the middle
-        const size_type d = n/2;
-        left -= d; capL -= d;
-        capR -= d + (n&1); // +1 if odd
-        right = left;
+        map_allocator ma(alloc);
+        const size_type new_map_size = map_size_ * 2 + 2;
+        map_pointer new_map = ma.allocate(new_map_size);
+        new_start = new_map + (new_map_size - new_nodes) / 2 + (at_front ? 1 : 0);
+        std::copy(start_.node, finish_.node + 1, new_start);
+        ma.deallocate(map_, map_size_);
+        map_ = new_map, map_size_ = new_map_size;
       }
-      while(first != last){
-        alloc.construct(right++, *first);
-        ++first;
+      start_.set_node(new_start);
+      finish_.set_node(new_start + old_nodes - 1);
+    }
+
+    ///\name end growth
+    /** Returns the slot for a new front element, allocating its chunk if needed */
+    pointer front_slot()
+    {
+      if(!map_)
+        initialize_map();
+      if(start_.cur != start_.first)
+        return start_.cur - 1;
+      reserve_map_at_front();
+      start_.node[-1] = allocate_chunk();
+      return start_.node[-1] + (chunk_size - 1);
+    }
+
+    void front_commit(pointer p)
+    {
+      if(start_.cur == start_.first)
+        start_.set_node(start_.node - 1);
+      start_.cur = p;
+    }
+
+    void front_rollback()
+    {
+      if(start_.cur == start_.first)
+        release_chunk(start_.node[-1]);
+    }
+
+    /** Returns the slot for a new back element; the chunk after it is allocated beforehand, so \c end() always points into a chunk */
+    pointer back_slot()
+    {
+      if(!map_)
+        initialize_map();
+      if(finish_.cur + 1 == finish_.last){
+        reserve_map_at_back();
+        finish_.node[1] = allocate_chunk();
       }
-      validate();
+      return finish_.cur;
     }
-    template <class InputIterator>
-    void assign(InputIterator first, InputIterator last, input_iterator_tag)
+
+    void back_commit()
     {
-      clear();
-      while(first != last)
-        push_back(*first++);
-      validate();
+      if(++finish_.cur == finish_.last){
+        finish_.set_node(finish_.node + 1);
+        finish_.cur = finish_.first;
+      }
     }
 
-    pointer insert_impl(const_iterator position)
+    void back_rollback()
     {
-      const ptrdiff_t diff = position - left;
-      if(empty() || !capR)
-        reallocate(size());
-      validate();
-      pointer pos = left+diff;
-      move_backward(pos, right, pos+1+(right-pos)); // shift right
-      ++right;
-      --capR;
-      validate();
-      return pos;
+      if(finish_.cur + 1 == finish_.last)
+        release_chunk(finish_.node[1]);
     }
 
-#if 0
-    template <class InputIterator>
-    void insert(const_iterator position, InputIterator first, InputIterator last, random_access_iterator_tag)
+    ///\name shrinking
+    void destroy(iterator first, iterator last)
     {
-      // if need realloc, save pointers, allocate new and then move there old & new elements with 3 move operations
-      // if not, shift right & insert new elements
-      size_type n = last - first;
-      if(n > capR)
-        reallocate(n-capR);
-      move_backward(pos, right, pos+n); // shift right
-      capR -= n;
+      if(!no_dtor::value)
+        for(; first != last; ++first)
+          alloc.destroy(first.cur);
+    }
 
-      while(n--)
-        alloc.construct(right++, *first++);
+    void erase_at_begin(iterator pos)
+    {
+      destroy(start_, pos);
+      for(map_pointer n = start_.node; n < pos.node; ++n)
+        release_chunk(*n);
+      start_ = pos;
     }
-#endif
 
-    template <class InputIterator>
-    void insert(const_iterator position, InputIterator first, InputIterator last, input_iterator_tag)
+    void erase_at_end(iterator pos)
     {
-      iterator pos = const_cast<iterator>(position);
-      while(first != last)
-        pos = insert(pos, *first++);
-      validate();
+      destroy(pos, finish_);
+      for(map_pointer n = pos.node + 1; n <= finish_.node; ++n)
+        release_chunk(*n);
+      finish_ = pos;
     }
 
-    pointer uninitialized_move(pointer first, pointer last, pointer result)
+    void dispose()
     {
-      while(first != last)
-        alloc.construct(result++, move(*first++));
-      return result;
+      if(map_){
+        clear();
+        alloc.deallocate(start_.first, chunk_size);
+        map_allocator(alloc).deallocate(map_, map_size_);
+        map_ = nullptr, map_size_ = 0;
+        start_ = finish_ = iterator();
+      }
+      drain_cache();
+    }
+
+    ///\name insertion helpers
+    /** Inserts \p x (moved from) in the middle of the deque, shifting the shorter half */
+    iterator insert_impl(const_iterator position, value_type& x)
+    {
+      const size_type index = position - cbegin();
+      if(index < size() / 2){
+        push_front(std::move(front()));
+        iterator pos = start_ + index;
+        std::move(start_ + 2, pos + 1, start_ + 1);
+        *pos = std::move(x);
+        return pos;
+      }else{
+        push_back(std::move(back()));
+        iterator pos = start_ + index;
+        std::move_backward(pos, finish_ - 2, finish_ - 1);
+        *pos = std::move(x);
+        return pos;
+      }
     }
 
+    void insert_at_back(size_type index, size_type len, const T& x, size_type n)
+    {
+      __ntl_try{
+        while(n--)
+          push_back(x);
+      }
+      __ntl_catch(...){
+        erase_at_end(begin()+len);
+        __ntl_rethrow;
+      }
+      std::rotate(begin()+index, begin()+len, end());
+    }
+    ///\}
 
   private:
-    pointer left, right, base_;
-    size_type capL, capR, cap_;
     allocator alloc;
+    map_pointer map_;
+    size_type map_size_;
+    iterator start_, finish_;
+    pointer cache_;
+    size_type cached_;
   };
 
 
@@ -741,12 +934,12 @@ namespace std {
   {
     return rel_ops::operator <=(x, y);
   }
-  
-  
+
+
   // specialized algorithms:
   template <class T, class Allocator>
   inline void swap(deque<T,Allocator>& x, deque<T,Allocator>& y)  { x.swap(y); }
-  
+
   /**@} lib_sequence */
   /**@} lib_containers */
 }//namespace std
@@ -0,0 +1,750 @@
+/**\file*********************************************************************
+ *                                                                     \brief
+ *  Shared ownership with the selectable reference counting
+ *
+ ****************************************************************************
+ */
+#ifndef NTL__EXT_BASIC_SHARED_PTR
+#define NTL__EXT_BASIC_SHARED_PTR
+#pragma once
+
+#include "../algorithm.hxx"
+#include "../atomic.hxx"
+#include "../new.hxx"
+#include "../type_traits.hxx"
+#include "../utility.hxx"
+
+namespace std
+{
+  namespace ext
+  {
+    /**\addtogroup  lib_memory
+     *@{*/
+
+    /**
+     *	@brief The reference counting policies
+     *
+     *  A policy provides the counter \c type and the static \c init(type&, long), \c load(const type&),
+     *  \c increment(type&) and \c decrement(type&) which returns the new value of the counter.
+     **/
+
+    /** Counts the references with the plain arithmetic, for the objects which never leave their thread */
+    struct local_refcount
+    {
+      typedef long type;
+
+      static void init(type& c, long value) { c = value; }
+      static long load(const type& c) { return c; }
+      static void increment(type& c) { ++c; }
+      static long decrement(type& c) { return --c; }
+    };
+
+    /** Counts the references with the interlocked operations, for the objects shared between the threads */
+    struct atomic_refcount
+    {
+      typedef atomic_long type;
+
+      static void init(type& c, long value) { c.store(value, memory_order_relaxed); }
+      static long load(const type& c) { return c.load(memory_order_relaxed); }
+      static void increment(type& c) { c.fetch_add(1, memory_order_relaxed); }
+      static long decrement(type& c) { return c.fetch_sub(1, memory_order_acq_rel) - 1; }
+    };
+
+    template<class T, class RefCountPolicy = atomic_refcount> class basic_shared_ptr;
+
+    namespace __
+    {
+      template<class Policy>
+      struct shared_block:
+        noncopyable
+      {
+        typename Policy::type refs;
+
+        shared_block()
+        {
+          Policy::init(refs, 1);
+        }
+
+        /** Destroys the object and the block */
+        virtual void dispose() __ntl_nothrow = 0;
+
+        void add_ref() { Policy::increment(refs); }
+        void release()
+        {
+          if(Policy::decrement(refs) == 0)
+            dispose();
+        }
+      protected:
+        ~shared_block() {}
+      };
+
+      template<class T, class Policy>
+      struct shared_block_ptr:
+        shared_block<Policy>
+      {
+        T* p;
+
+        explicit shared_block_ptr(T* p)
+          :p(p)
+        {}
+        void dispose() __ntl_nothrow
+        {
+          delete p;
+          delete this;
+        }
+      };
+
+      template<class T, class D, class Policy>
+      struct shared_block_deleter:
+        shared_block<Policy>
+      {
+        T* p;
+        D deleter;
+
+        shared_block_deleter(T* p, const D& d)
+          :p(p), deleter(d)
+        {}
+        void dispose() __ntl_nothrow
+        {
+          deleter(p);
+          delete this;
+        }
+      };
+
+      /** The block which holds the object itself, used by make_basic_shared */
+      template<class T, class Policy>
+      struct shared_block_inplace:
+        shared_block<Policy>
+      {
+        typename aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+        T* get() { return reinterpret_cast<T*>(&storage); }
+        void dispose() __ntl_nothrow
+        {
+          get()->~T();
+          delete this;
+        }
+      };
+
+      /** Frees the block if the constructor of the object throws */
+      template<class T, class Policy>
+      class shared_block_inplace_guard:
+        noncopyable
+      {
+        typedef shared_block_inplace<T, Policy> block;
+        block* b;
+      public:
+        shared_block_inplace_guard()
+          :b(new block())
+        {}
+        ~shared_block_inplace_guard()
+        {
+          if(b)
+            delete b;
+        }
+        void* place() { return b->get(); }
+        basic_shared_ptr<T, Policy> share()
+        {
+          block* const p = b; b = nullptr;
+          return basic_shared_ptr<T, Policy>(p, p->get(), typename basic_shared_ptr<T, Policy>::adopt_block());
+        }
+      };
+    }
+
+    /**
+     *	@brief Shared ownership pointer with the reference counting of \p RefCountPolicy
+     *
+     *  Works as \c std::shared_ptr but its counter is chosen by the policy: \c local_refcount costs no locked
+     *  instructions for the object graphs confined to a thread, \c atomic_refcount may be shared between threads
+     *  and has the lock-free \c std::atomic specialization. The control block keeps the single counter,
+     *  there is no weak reference to it.
+     **/
+    template<class T, class RefCountPolicy>
+    class basic_shared_ptr
+    {
+      typedef __::shared_block<RefCountPolicy> block_type;
+
+      template<class, class> friend class basic_shared_ptr;
+      template<class, class> friend class __::shared_block_inplace_guard;
+
+      struct adopt_block {};
+      basic_shared_ptr(block_type* block, T* p, adopt_block) __ntl_nothrow
+        :block(block), ptr(p)
+      {}
+
+      struct explicit_bool { int _; };
+      typedef int explicit_bool::*  explicit_bool_type;
+    public:
+      typedef T element_type;
+      typedef RefCountPolicy refcount_policy;
+
+      basic_shared_ptr() __ntl_nothrow
+        :block(), ptr()
+      {}
+
+      basic_shared_ptr(nullptr_t) __ntl_nothrow
+        :block(), ptr()
+      {}
+
+      template<class Y>
+      explicit basic_shared_ptr(Y* p)
+        :block(), ptr()
+      {
+        __ntl_try {
+          block = new __::shared_block_ptr<Y, RefCountPolicy>(p);
+          ptr = p;
+        }
+        __ntl_catch(bad_alloc){
+          delete p;
+          __ntl_rethrow;
+        }
+      }
+
+      template<class Y, class D>
+      basic_shared_ptr(Y* p, D d)
+        :block(), ptr()
+      {
+        __ntl_try {
+          block = new __::shared_block_deleter<Y, D, RefCountPolicy>(p, d);
+          ptr = p;
+        }
+        __ntl_catch(bad_alloc){
+          d(p);
+          __ntl_rethrow;
+        }
+      }
+
+      basic_shared_ptr(const basic_shared_ptr& r) __ntl_nothrow
+        :block(r.block), ptr(r.ptr)
+      {
+        add_ref();
+      }
+
+      template<class Y>
+      basic_shared_ptr(const basic_shared_ptr<Y, RefCountPolicy>& r) __ntl_nothrow
+        :block(r.block), ptr(r.ptr)
+      {
+        add_ref();
+      }
+
+      /** Shares the ownership of \p r and points to \p p */
+      template<class Y>
+      basic_shared_ptr(const basic_shared_ptr<Y, RefCountPolicy>& r, T* p) __ntl_nothrow
+        :block(r.block), ptr(p)
+      {
+        add_ref();
+      }
+
+    #ifdef NTL_CXX_RV
+      basic_shared_ptr(basic_shared_ptr&& r) __ntl_nothrow
+        :block(r.block), ptr(r.ptr)
+      {
+        r.block = nullptr;
+        r.ptr = nullptr;
+      }
+
+      template<class Y>
+      basic_shared_ptr(basic_shared_ptr<Y, RefCountPolicy>&& r) __ntl_nothrow
+        :block(r.block), ptr(r.ptr)
+      {
+        r.block = nullptr;
+        r.ptr = nullptr;
+      }
+
+      basic_shared_ptr& operator=(basic_shared_ptr&& r) __ntl_nothrow
+      {
+        basic_shared_ptr(move(r)).swap(*this);
+        return *this;
+      }
+    #endif
+
+      ~basic_shared_ptr() __ntl_nothrow
+      {
+        if(block)
+          block->release();
+      }
+
+      basic_shared_ptr& operator=(const basic_shared_ptr& r) __ntl_nothrow
+      {
+        basic_shared_ptr(r).swap(*this);
+        return *this;
+      }
+
+      template<class Y>
+      basic_shared_ptr& operator=(const basic_shared_ptr<Y, RefCountPolicy>& r) __ntl_nothrow
+      {
+        basic_shared_ptr(r).swap(*this);
+        return *this;
+      }
+
+      void swap(basic_shared_ptr& r) __ntl_nothrow
+      {
+        std::swap(block, r.block);
+        std::swap(ptr, r.ptr);
+      }
+
+      void reset() __ntl_nothrow
+      {
+        basic_shared_ptr().swap(*this);
+      }
+      template<class Y> void reset(Y* p)
+      {
+        basic_shared_ptr(p).swap(*this);
+      }
+      template<class Y, class D> void reset(Y* p, D d)
+      {
+        basic_shared_ptr(p, d).swap(*this);
+      }
+
+      T* get() const __ntl_nothrow { return ptr; }
+      typename add_lvalue_reference<T>::type operator*() const __ntl_nothrow { return *ptr; }
+      T* operator->() const __ntl_nothrow { return ptr; }
+
+      long use_count() const __ntl_nothrow
+      {
+        return block ? RefCountPolicy::load(block->refs) : 0;
+      }
+      bool unique() const __ntl_nothrow { return use_count() == 1; }
+
+      operator explicit_bool_type() const __ntl_nothrow { return ptr ? &explicit_bool::_ : 0; }
+
+      /** Orders the pointers by their ownership */
+      template<class Y>
+      bool owner_before(const basic_shared_ptr<Y, RefCountPolicy>& r) const __ntl_nothrow
+      {
+        return block < r.block;
+      }
+
+    private:
+      void add_ref()
+      {
+        if(block)
+          block->add_ref();
+      }
+
+      block_type* block;
+      T* ptr;
+    };
+
+    template<class T, class U, class P>
+    inline bool operator==(const basic_shared_ptr<T, P>& a, const basic_shared_ptr<U, P>& b) __ntl_nothrow
+    {
+      return a.get() == b.get();
+    }
+    template<class T, class U, class P>
+    inline bool operator!=(const basic_shared_ptr<T, P>& a, const basic_shared_ptr<U, P>& b) __ntl_nothrow
+    {
+      return a.get() != b.get();
+    }
+    template<class T, class U, class P>
+    inline bool operator<(const basic_shared_ptr<T, P>& a, const basic_shared_ptr<U, P>& b) __ntl_nothrow
+    {
+      return a.get() < b.get();
+    }
+    template<class T, class P>
+    inline void swap(basic_shared_ptr<T, P>& a, basic_shared_ptr<T, P>& b) __ntl_nothrow
+    {
+      a.swap(b);
+    }
+
+    template<class T, class U, class P>
+    inline basic_shared_ptr<T, P> static_pointer_cast(const basic_shared_ptr<U, P>& r) __ntl_nothrow
+    {
+      return basic_shared_ptr<T, P>(r, static_cast<T*>(r.get()));
+    }
+    template<class T, class U, class P>
+    inline basic_shared_ptr<T, P> const_pointer_cast(const basic_shared_ptr<U, P>& r) __ntl_nothrow
+    {
+      return basic_shared_ptr<T, P>(r, const_cast<T*>(r.get()));
+    }
+
+    /**
+     *	Creates the object owned by the basic_shared_ptr with the single allocation of the object and its counter:
+     *  \code auto p = std::ext::make_basic_shared<node, std::ext::local_refcount>(key, value); \endcode
+     **/
+  #ifdef NTL_CXX_VT
+    template<class T, class P, class... Args>
+    inline basic_shared_ptr<T, P> make_basic_shared(Args&&... args)
+    {
+      __::shared_block_inplace_guard<T, P> g;
+      ::new(g.place()) T(forward<Args>(args)...);
+      return g.share();
+    }
+  #else
+    template<class T, class P>
+    inline basic_shared_ptr<T, P> make_basic_shared()
+    {
+      __::shared_block_inplace_guard<T, P> g;
+      ::new(g.place()) T();
+      return g.share();
+    }
+    template<class T, class P, class A1>
+    inline basic_shared_ptr<T, P> make_basic_shared(const A1& a1)
+    {
+      __::shared_block_inplace_guard<T, P> g;
+      ::new(g.place()) T(a1);
+      return g.share();
+    }
+    template<class T, class P, class A1, class A2>
+    inline basic_shared_ptr<T, P> make_basic_shared(const A1& a1, const A2& a2)
+    {
+      __::shared_block_inplace_guard<T, P> g;
+      ::new(g.place()) T(a1, a2);
+      return g.share();
+    }
+    template<class T, class P, class A1, class A2, class A3>
+    inline basic_shared_ptr<T, P> make_basic_shared(const A1& a1, const A2& a2, const A3& a3)
+    {
+      __::shared_block_inplace_guard<T, P> g;
+      ::new(g.place()) T(a1, a2, a3);
+      return g.share();
+    }
+  #endif
+
+  #ifdef NTL_CXX_TT
+    /** The shared pointer for the objects which never leave their thread */
+    template<class T>
+    using local_shared_ptr = basic_shared_ptr<T, local_refcount>;
+  #endif
+
+    /**
+     *	@brief The base class of the objects with the embedded reference counter
+     *
+     *  Provides \c intrusive_ptr_add_ref and \c intrusive_ptr_release for \c intrusive_ptr, which deletes
+     *  the object as \p Derived when the last reference goes away. The counter is not copied with the object.
+     **/
+    template<class Derived, class RefCountPolicy = atomic_refcount>
+    class intrusive_ref_counter
+    {
+      mutable typename RefCountPolicy::type refs;
+    public:
+      long use_count() const __ntl_nothrow { return RefCountPolicy::load(refs); }
+
+      friend void intrusive_ptr_add_ref(const intrusive_ref_counter* p) __ntl_nothrow
+      {
+        RefCountPolicy::increment(p->refs);
+      }
+      friend void intrusive_ptr_release(const intrusive_ref_counter* p) __ntl_nothrow
+      {
+        if(RefCountPolicy::decrement(p->refs) == 0)
+          delete static_cast<const Derived*>(p);
+      }
+
+    protected:
+      intrusive_ref_counter() __ntl_nothrow
+      {
+        RefCountPolicy::init(refs, 0);
+      }
+      intrusive_ref_counter(const intrusive_ref_counter&) __ntl_nothrow
+      {
+        RefCountPolicy::init(refs, 0);
+      }
+      intrusive_ref_counter& operator=(const intrusive_ref_counter&) __ntl_nothrow
+      {
+        return *this;
+      }
+      ~intrusive_ref_counter() {}
+    };
+
+    /**
+     *	@brief Shared ownership of the objects which count their references themselves
+     *
+     *  There is no control block: the pointer is a single word and the counter lives in the object, which is managed
+     *  by the \c intrusive_ptr_add_ref(T*) and \c intrusive_ptr_release(T*) found by the argument dependent lookup,
+     *  e.g. the ones of intrusive_ref_counter. A raw pointer to the object may be turned to an intrusive_ptr again at any time.
+     **/
+    template<class T>
+    class intrusive_ptr
+    {
+      struct explicit_bool { int _; };
+      typedef int explicit_bool::*  explicit_bool_type;
+
+      template<class> friend class intrusive_ptr;
+    public:
+      typedef T element_type;
+
+      intrusive_ptr() __ntl_nothrow
+        :p()
+      {}
+
+      intrusive_ptr(T* p, bool add_ref = true)
+        :p(p)
+      {
+        if(p && add_ref)
+          intrusive_ptr_add_ref(p);
+      }
+
+      intrusive_ptr(const intrusive_ptr& r)
+        :p(r.p)
+      {
+        if(p)
+          intrusive_ptr_add_ref(p);
+      }
+
+      template<class U>
+      intrusive_ptr(const intrusive_ptr<U>& r)
+        :p(r.p)
+      {
+        if(p)
+          intrusive_ptr_add_ref(p);
+      }
+
+    #ifdef NTL_CXX_RV
+      intrusive_ptr(intrusive_ptr&& r) __ntl_nothrow
+        :p(r.p)
+      {
+        r.p = nullptr;
+      }
+      intrusive_ptr& operator=(intrusive_ptr&& r) __ntl_nothrow
+      {
+        intrusive_ptr(move(r)).swap(*this);
+        return *this;
+      }
+    #endif
+
+      ~intrusive_ptr()
+      {
+        if(p)
+          intrusive_ptr_release(p);
+      }
+
+      intrusive_ptr& operator=(const intrusive_ptr& r)
+      {
+        intrusive_ptr(r).swap(*this);
+        return *this;
+      }
+      template<class U>
+      intrusive_ptr& operator=(const intrusive_ptr<U>& r)
+      {
+        intrusive_ptr(r).swap(*this);
+        return *this;
+      }
+      intrusive_ptr& operator=(T* r)
+      {
+        intrusive_ptr(r).swap(*this);
+        return *this;
+      }
+
+      void reset() { intrusive_ptr().swap(*this); }
+      void reset(T* r, bool add_ref = true) { intrusive_ptr(r, add_ref).swap(*this); }
+
+      /** Gives up the ownership without the release of the reference */
+      T* detach() __ntl_nothrow
+      {
+        T* const r = p;
+        p = nullptr;
+        return r;
+      }
+
+      void swap(intrusive_ptr& r) __ntl_nothrow { std::swap(p, r.p); }
+
+      T* get() const __ntl_nothrow { return p; }
+      T& operator*() const __ntl_nothrow { return *p; }
+      T* operator->() const __ntl_nothrow { return p; }
+
+      operator explicit_bool_type() const __ntl_nothrow { return p ? &explicit_bool::_ : 0; }
+
+    private:
+      T* p;
+    };
+
+    template<class T, class U>
+    inline bool operator==(const intrusive_ptr<T>& a, const intrusive_ptr<U>& b) __ntl_nothrow { return a.get() == b.get(); }
+    template<class T, class U>
+    inline bool operator!=(const intrusive_ptr<T>& a, const intrusive_ptr<U>& b) __ntl_nothrow { return a.get() != b.get(); }
+    template<class T, class U>
+    inline bool operator<(const intrusive_ptr<T>& a, const intrusive_ptr<U>& b) __ntl_nothrow { return a.get() < b.get(); }
+    template<class T>
+    inline void swap(intrusive_ptr<T>& a, intrusive_ptr<T>& b) __ntl_nothrow { a.swap(b); }
+
+    namespace __
+    {
+      /**
+       *  The immutable holder of the value stored in the atomic basic_shared_ptr.
+       *
+       *  The word owns the node and keeps the count of its loads in progress. \c refs counts the loads in progress
+       *  which have moved to the node after it has left the word: the loads which end before the move take it
+       *  below zero, the move adds the count taken from the word, and the node is freed when it returns to zero.
+       **/
+      template<class SharedPtr>
+      struct atomic_shared_node:
+        noncopyable
+      {
+        SharedPtr value;
+        atomic_long refs;
+
+        explicit atomic_shared_node(const SharedPtr& value)
+          :value(value)
+        {
+          refs.store(0, memory_order_relaxed);
+        }
+
+        /** Moves \p n loads in progress from the word to the node which has left it */
+        void detach(long n)
+        {
+          if(refs.fetch_add(n, memory_order_acq_rel) + n == 0)
+            delete this;
+        }
+        /** Ends the load in progress of the node which has left the word */
+        void release()
+        {
+          if(refs.fetch_sub(1, memory_order_acq_rel) == 1)
+            delete this;
+        }
+      };
+    }
+
+    /**@} lib_memory */
+  } // ext
+
+  /**
+   *	@brief Lock-free atomic basic_shared_ptr
+   *
+   *  The value is kept in the node referenced by the single word together with the count of the loads in progress
+   *  (the split reference count): a load increments the count in the word, copies the value and gives the count back,
+   *  so it never touches a node which may be freed. The store which replaces the node moves the loads in progress
+   *  to the counter of the node with a single addition, which keeps the node alive until they finish; the loads which
+   *  find the node replaced end in that counter, before or after the move. The stores allocate the node,
+   *  the loads take no allocations and no locks.
+   **/
+  template<class T>
+  struct atomic<ext::basic_shared_ptr<T, ext::atomic_refcount> >
+  {
+    typedef ext::basic_shared_ptr<T, ext::atomic_refcount> value_type;
+  private:
+    typedef ext::__::atomic_shared_node<value_type> node;
+
+    // the node address is kept in the low bits of the word, the count of the loads in progress above it
+    static const unsigned count_shift = sizeof(void*) == 8 ? 48 : 32;
+    static const uint64_t address_mask = (uint64_t(1) << count_shift) - 1;
+    static const uint64_t one_load = uint64_t(1) << count_shift;
+
+    static uint64_t pack(node* p)
+    {
+      return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(p)) & address_mask;
+    }
+    static node* unpack(uint64_t w)
+    {
+      // the high part of the address is the sign extension of its top bit
+      const int64_t address = static_cast<int64_t>(w << (64 - count_shift)) >> (64 - count_shift);
+      return reinterpret_cast<node*>(static_cast<uintptr_t>(address));
+    }
+    static long loads(uint64_t w) { return static_cast<long>(w >> count_shift); }
+
+    static node* make_node(const value_type& v)
+    {
+      return v.get() || v.use_count() ? new node(v) : nullptr;
+    }
+
+    atomic(const atomic&) __deleted;
+    atomic& operator=(const atomic&) __deleted;
+  public:
+    atomic()
+      :word(0)
+    {}
+
+    atomic(const value_type& value)
+      :word(pack(make_node(value)))
+    {}
+
+    ~atomic()
+    {
+      delete unpack(word.load(memory_order_relaxed));
+    }
+
+    bool is_lock_free() const volatile { return true; }
+
+    value_type load(memory_order = memory_order_seq_cst) const
+    {
+      uint64_t w = word.load(memory_order_relaxed);
+      node* n;
+      do{
+        n = unpack(w);
+        if(!n)
+          return value_type();
+      }while(!word.compare_exchange_weak(w, w + one_load, memory_order_acquire, memory_order_relaxed));
+      value_type v(n->value);
+      give_back(n, w + one_load);
+      return v;
+    }
+
+    operator value_type() const { return load(); }
+
+    void store(const value_type& desired, memory_order mo = memory_order_seq_cst)
+    {
+      exchange(desired, mo);
+    }
+
+    value_type operator=(const value_type& desired)
+    {
+      store(desired);
+      return desired;
+    }
+
+    value_type exchange(const value_type& desired, memory_order = memory_order_seq_cst)
+    {
+      const uint64_t w = word.exchange(pack(make_node(desired)), memory_order_acq_rel);
+      node* const n = unpack(w);
+      if(!n)
+        return value_type();
+      // the node is ours until the loads in progress move to it
+      value_type v(n->value);
+      n->detach(loads(w));
+      return v;
+    }
+
+    bool compare_exchange_strong(value_type& expected, const value_type& desired, memory_order = memory_order_seq_cst, memory_order = memory_order_seq_cst)
+    {
+      node* const replacement = make_node(desired);
+      uint64_t w = word.load(memory_order_relaxed);
+      for(;;){
+        node* const n = unpack(w);
+        if(n){
+          // take the load reference to compare the value safely
+          if(!word.compare_exchange_weak(w, w + one_load, memory_order_acquire, memory_order_relaxed))
+            continue;
+          w += one_load;
+        }
+        const value_type& current = n ? n->value : value_type();
+        if(current != expected || current.owner_before(expected) || expected.owner_before(current)){
+          expected = current;
+          if(n)
+            give_back(n, w);
+          delete replacement;
+          return false;
+        }
+        // replace the node while the word still refers to it, the count of the loads may change meanwhile
+        do{
+          if(word.compare_exchange_weak(w, pack(replacement), memory_order_acq_rel, memory_order_relaxed)){
+            // the loads in progress move to the node, ours ends here
+            if(n)
+              n->detach(loads(w) - 1);
+            return true;
+          }
+        }while(unpack(w) == n);
+        if(n)
+          give_back(n, w);
+      }
+    }
+
+    bool compare_exchange_weak(value_type& expected, const value_type& desired, memory_order success = memory_order_seq_cst, memory_order failure = memory_order_seq_cst)
+    {
+      return compare_exchange_strong(expected, desired, success, failure);
+    }
+
+  private:
+    /** Ends the load reference of \p n: in the word if it still refers to \p n, or in the node which has got it from the store */
+    void give_back(node* n, uint64_t w) const
+    {
+      while(unpack(w) == n && loads(w) > 0){
+        if(word.compare_exchange_weak(w, w - one_load, memory_order_release, memory_order_relaxed))
+          return;
+      }
+      n->release();
+    }
+
+    mutable atomic_ullong word;
+  };
+} // std
+
+#endif // NTL__EXT_BASIC_SHARED_PTR
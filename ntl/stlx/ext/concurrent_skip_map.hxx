@@ -0,0 +1,446 @@
+/**\file*********************************************************************
+ *                                                                     \brief
+ *  Lock-free ordered map
+ *
+ ****************************************************************************
+ */
+#ifndef NTL__EXT_CONCURRENT_SKIP_MAP
+#define NTL__EXT_CONCURRENT_SKIP_MAP
+#pragma once
+
+#include "../functional.hxx"  // for less
+#include "../memory.hxx"      // for allocator
+#include "../utility.hxx"     // for pair
+#include "epoch.hxx"
+
+namespace std
+{
+  namespace ext
+  {
+    /**\addtogroup  lib_containers *********** 23 Containers library [containers]
+     *@{*/
+
+    /**
+     *	@brief Ordered map for the concurrent access
+     *
+     *  The elements are kept in a skip list whose links carry the deletion mark in the low bit. find(), insert()
+     *  and erase() take no lock: an element is inserted by the CAS on the bottom level link of its predecessor and
+     *  erased by marking its own links, top-down, the bottom level mark being the linearization point. The marked
+     *  nodes are unlinked by the traversals which meet them and reclaimed through the epoch_domain, so a reader
+     *  never touches the freed memory. The elements are immutable once published.
+     *
+     *  for_each() and the range visits are weakly consistent: they see every element which stays in the map
+     *  during the whole traversal, in the order, and may or may not see the concurrently modified ones.
+     **/
+    template<class Key, class T,
+             class Compare = less<Key>,
+             class Allocator = allocator<pair<const Key, T> > >
+    class concurrent_skip_map
+    {
+    public:
+      ///\name types
+      typedef Key                     key_type;
+      typedef T                       mapped_type;
+      typedef pair<const Key, T>      value_type;
+      typedef Compare                 key_compare;
+      typedef Allocator               allocator_type;
+      typedef size_t                  size_type;
+      ///\}
+
+      /** The maximal number of levels, enough for 4^max_height elements */
+      static const size_type max_height = 24;
+
+    private:
+      /** the node pointer with the deletion mark of the owner node in the low bit */
+      typedef atomic_size_t link_type;
+
+      struct node:
+        epoch_domain::retired
+      {
+        value_type    elem;
+        atomic_size_t refs;     // held by the inserter and the remover
+        size_t        height;
+        link_type     next[1];  // height links
+
+        node(const value_type& elem, size_t height)
+          :elem(elem), refs(2), height(height)
+        {}
+      };
+
+      typedef typename Allocator::template rebind<node>::other node_allocator;
+
+    public:
+      ///\name construct/destroy
+      explicit concurrent_skip_map(const key_compare& comp = key_compare(), const allocator_type& a = allocator_type())
+        :comp_(comp), nalloc(a), count_(0), seed_(0), domain(this)
+      {
+        for(size_t l = 0; l < max_height; ++l)
+          head_[l].store(0, memory_order_relaxed);
+      }
+
+      /** There shall be no concurrent access during the destruction */
+      ~concurrent_skip_map()
+      {
+        domain.drain();
+        for(node* p = ptr(head_[0].load(memory_order_relaxed)); p; ){
+          node* const next = ptr(p->next[0].load(memory_order_relaxed));
+          destroy_node(p);
+          p = next;
+        }
+      }
+
+      ///\name size
+      /** The number of elements, approximate while the map is modified concurrently */
+      size_type size() const { return count_.load(memory_order_relaxed); }
+      bool empty() const
+      {
+        epoch_domain::guard g(domain);
+        return first_node() == nullptr;
+      }
+
+      ///\name lookup
+      /** Copies the value mapped to \p k into \p value, returns \c false if there is no such element */
+      bool find(const key_type& k, mapped_type& value) const
+      {
+        epoch_domain::guard g(domain);
+        const node* p = lookup(k);
+        if(!p)
+          return false;
+        value = p->elem.second;
+        return true;
+      }
+
+      bool contains(const key_type& k) const
+      {
+        epoch_domain::guard g(domain);
+        return lookup(k) != nullptr;
+      }
+
+      size_type count(const key_type& k) const { return contains(k) ? 1 : 0; }
+
+      /** Calls <tt>f(const value_type&)</tt> for the element with the key \p k without copying it, returns \c false if there is no such element */
+      template<class F>
+      bool visit(const key_type& k, F f) const
+      {
+        epoch_domain::guard g(domain);
+        const node* p = lookup(k);
+        if(!p)
+          return false;
+        f(p->elem);
+        return true;
+      }
+
+      /** Copies the least element, returns \c false if the map is empty */
+      bool front(key_type& k, mapped_type& value) const
+      {
+        epoch_domain::guard g(domain);
+        const node* p = first_node();
+        if(!p)
+          return false;
+        k = p->elem.first;
+        value = p->elem.second;
+        return true;
+      }
+
+      ///\name ordered traversal
+      /** Calls <tt>f(const value_type&)</tt> for every element in the order */
+      template<class F>
+      void for_each(F f) const
+      {
+        epoch_domain::guard g(domain);
+        for(const node* p = first_node(); p; p = next_node(p))
+          f(p->elem);
+      }
+
+      /** Calls <tt>f(const value_type&)</tt> for the elements with the keys in [\p first, \p last) in the order */
+      template<class F>
+      void for_each(const key_type& first, const key_type& last, F f) const
+      {
+        epoch_domain::guard g(domain);
+        for(const node* p = lower_bound_node(first); p && comp_(p->elem.first, last); p = next_node(p))
+          f(p->elem);
+      }
+
+      ///\name modifiers
+      /** Inserts \p v if there is no element with the same key, returns \c true if the insertion took place */
+      bool insert(const value_type& v)
+      {
+        epoch_domain::guard g(domain);
+        node* preds[max_height], *succs[max_height];
+        node* x = nullptr;
+        for(;;){
+          if(find_node(v.first, preds, succs)){
+            if(x)
+              destroy_node(x);
+            return false;
+          }
+          if(!x)
+            x = create_node(v, random_height());
+          for(size_t l = 0; l < x->height; ++l)
+            x->next[l].store(link(succs[l]), memory_order_relaxed);
+          size_t expected = link(succs[0]);
+          if(links(preds[0])[0].compare_exchange_strong(expected, link(x)))
+            break;
+        }
+        count_.fetch_add(1, memory_order_relaxed);
+        link_tower(x, preds, succs);
+        return true;
+      }
+
+      /** Removes the element with the key \p k, returns the number of removed elements */
+      size_type erase(const key_type& k)
+      {
+        epoch_domain::guard g(domain);
+        node* preds[max_height], *succs[max_height];
+        if(!find_node(k, preds, succs))
+          return 0;
+        return remove(succs[0], preds, succs) ? 1 : 0;
+      }
+
+      /** Removes the least element and copies it, returns \c false if the map is empty */
+      bool pop_front(key_type& k, mapped_type& value)
+      {
+        epoch_domain::guard g(domain);
+        node* preds[max_height], *succs[max_height];
+        for(;;){
+          node* const x = const_cast<node*>(first_node());
+          if(!x)
+            return false;
+          if(remove(x, preds, succs)){
+            // the node stays alive until the guard is released
+            k = x->elem.first;
+            value = x->elem.second;
+            return true;
+          }
+        }
+      }
+
+      void clear()
+      {
+        epoch_domain::guard g(domain);
+        node* preds[max_height], *succs[max_height];
+        while(node* const x = const_cast<node*>(first_node()))
+          remove(x, preds, succs);
+      }
+
+      ///\name observers
+      key_compare key_comp() const { return comp_; }
+      allocator_type get_allocator() const { return allocator_type(nalloc); }
+      ///\}
+
+    private:
+      concurrent_skip_map(const concurrent_skip_map&) __deleted;
+      concurrent_skip_map& operator=(const concurrent_skip_map&) __deleted;
+
+      static node* ptr(size_t l) { return reinterpret_cast<node*>(l & ~static_cast<size_t>(1)); }
+      static bool marked(size_t l) { return (l & 1) != 0; }
+      static size_t link(const node* p) { return reinterpret_cast<uintptr_t>(p); }
+
+      /** the links of \p p or of the head if \p p is null */
+      link_type* links(node* p) const { return p ? p->next : head_; }
+      const link_type* links(const node* p) const { return p ? p->next : head_; }
+
+      size_t random_height()
+      {
+        // every level above the bottom one is taken with the probability 1/4
+        size_t z = seed_.fetch_add(static_cast<size_t>(0x9E3779B97F4A7C15ULL), memory_order_relaxed);
+        z ^= z >> (sizeof(size_t) * 4);
+        z *= static_cast<size_t>(0xBF58476D1CE4E5B9ULL);
+        z ^= z >> (sizeof(size_t) * 4 - 1);
+        size_t h = 1;
+        for(; h < max_height && (z & 3) == 0 && z; z >>= 2)
+          ++h;
+        return h;
+      }
+
+      /**
+       *  Finds the neighbours of \p k on every level, unlinking the marked nodes on the way;
+       *  returns \c true if <tt>succs[0]</tt> is the element with the key \p k. Shall be called under the guard.
+       **/
+      bool find_node(const key_type& k, node** preds, node** succs)
+      {
+        while(!try_find_node(k, preds, succs))
+          ;
+        return succs[0] && !comp_(k, succs[0]->elem.first);
+      }
+
+      /** returns \c false if a predecessor has been modified concurrently and the search shall be restarted */
+      bool try_find_node(const key_type& k, node** preds, node** succs)
+      {
+        node* pred = nullptr;
+        for(size_t l = max_height; l--; ){
+          node* curr = ptr(links(pred)[l].load(memory_order_acquire));
+          while(curr){
+            const size_t succ = curr->next[l].load(memory_order_acquire);
+            if(marked(succ)){
+              size_t expected = link(curr);
+              if(!links(pred)[l].compare_exchange_strong(expected, link(ptr(succ))))
+                return false;
+              curr = ptr(succ);
+              continue;
+            }
+            if(!comp_(curr->elem.first, k))
+              break;
+            pred = curr;
+            curr = ptr(succ);
+          }
+          preds[l] = pred;
+          succs[l] = curr;
+        }
+        return true;
+      }
+
+      /** the first unmarked node not less than \p k, shall be called under the guard */
+      const node* lower_bound_node(const key_type& k) const
+      {
+        const node* pred = nullptr, *curr = nullptr;
+        for(size_t l = max_height; l--; ){
+          curr = ptr(links(pred)[l].load(memory_order_acquire));
+          while(curr){
+            const size_t succ = curr->next[l].load(memory_order_acquire);
+            if(!marked(succ)){
+              if(!comp_(curr->elem.first, k))
+                break;
+              pred = curr;
+            }
+            curr = ptr(succ);
+          }
+        }
+        return curr;
+      }
+
+      const node* lookup(const key_type& k) const
+      {
+        const node* p = lower_bound_node(k);
+        return p && !comp_(k, p->elem.first) ? p : nullptr;
+      }
+
+      const node* first_node() const
+      {
+        return skip_marked(ptr(head_[0].load(memory_order_acquire)));
+      }
+
+      static const node* next_node(const node* p)
+      {
+        return skip_marked(ptr(p->next[0].load(memory_order_acquire)));
+      }
+
+      static const node* skip_marked(const node* p)
+      {
+        while(p){
+          const size_t succ = p->next[0].load(memory_order_acquire);
+          if(!marked(succ))
+            break;
+          p = ptr(succ);
+        }
+        return p;
+      }
+
+      /** Links the upper levels of the published node \p x unless it is being removed */
+      void link_tower(node* x, node** preds, node** succs)
+      {
+        const key_type& k = x->elem.first;
+        for(size_t l = 1; l < x->height; ++l){
+          if(!link_level(x, l, preds, succs))
+            break;
+        }
+        // the remover may have missed the levels linked after its search
+        if(marked(x->next[0].load(memory_order_acquire)))
+          find_node(k, preds, succs);
+        release(x);
+      }
+
+      bool link_level(node* x, size_t l, node** preds, node** succs)
+      {
+        for(;;){
+          size_t next = x->next[l].load(memory_order_acquire);
+          if(marked(next))
+            return false;
+          if(ptr(next) != succs[l] && !x->next[l].compare_exchange_strong(next, link(succs[l])))
+            return false; // marked meanwhile
+          size_t expected = link(succs[l]);
+          if(links(preds[l])[l].compare_exchange_strong(expected, link(x)))
+            return true;
+          find_node(x->elem.first, preds, succs);
+          if(succs[0] != x)
+            return false; // removed
+        }
+      }
+
+      static void mark(link_type& l)
+      {
+        size_t v = l.load(memory_order_relaxed);
+        while(!marked(v) && !l.compare_exchange_weak(v, v | 1))
+          ;
+      }
+
+      /** Removes \p x, returns \c false if it has been removed by another thread. Shall be called under the guard */
+      bool remove(node* x, node** preds, node** succs)
+      {
+        for(size_t l = x->height; --l > 0; )
+          mark(x->next[l]);
+        size_t next = x->next[0].load(memory_order_relaxed);
+        do{
+          if(marked(next))
+            return false;
+        }while(!x->next[0].compare_exchange_weak(next, next | 1));
+        count_.fetch_sub(1, memory_order_relaxed);
+        find_node(x->elem.first, preds, succs);
+        release(x);
+        return true;
+      }
+
+      /** the last of the inserter and the remover retires the node, which is unlinked from every level by then */
+      void release(node* x)
+      {
+        if(x->refs.fetch_sub(1) == 1)
+          domain.retire(x, &reclaim_node);
+      }
+
+      /** the number of node-sized blocks holding the node with \p height links */
+      static size_t block_count(size_t height)
+      {
+        return 1 + ((height - 1) * sizeof(link_type) + sizeof(node) - 1) / sizeof(node);
+      }
+
+      node* create_node(const value_type& v, size_t height)
+      {
+        node* p = nalloc.allocate(block_count(height));
+        __ntl_try{
+          new (p) node(v, height);
+        }
+        __ntl_catch(...){
+          nalloc.deallocate(p, block_count(height));
+          __ntl_rethrow;
+        }
+        for(size_t l = 1; l < height; ++l)
+          new (&p->next[l]) link_type(0);
+        return p;
+      }
+
+      void destroy_node(node* p)
+      {
+        const size_t height = p->height;
+        p->~node();
+        nalloc.deallocate(p, block_count(height));
+      }
+
+      static void reclaim_node(epoch_domain::retired* p, void* context)
+      {
+        static_cast<concurrent_skip_map*>(context)->destroy_node(static_cast<node*>(p));
+      }
+
+    private:
+      key_compare       comp_;
+      node_allocator    nalloc;
+      mutable link_type head_[max_height];
+      atomic_size_t     count_;
+      atomic_size_t     seed_;
+      epoch_domain      domain;
+    };
+
+    /**@} lib_containers */
+  } // ext
+} // std
+
+#endif // NTL__EXT_CONCURRENT_SKIP_MAP
@@ -0,0 +1,457 @@
+/**\file*********************************************************************
+ *                                                                     \brief
+ *  Concurrent hash map with lock-free lookups
+ *
+ ****************************************************************************
+ */
+#ifndef NTL__EXT_CONCURRENT_UNORDERED_MAP
+#define NTL__EXT_CONCURRENT_UNORDERED_MAP
+#pragma once
+
+#include "../functional.hxx"  // for hash & predicates
+#include "../memory.hxx"      // for allocator
+#include "../utility.hxx"     // for pair
+#include "epoch.hxx"
+
+namespace std
+{
+  namespace ext
+  {
+    /**\addtogroup  lib_containers *********** 23 Containers library [containers]
+     *@{*/
+
+    /**
+     *	@brief Hash map for the concurrent access
+     *
+     *  The lookups take no lock: the chains are traversed through the atomic links and the removed nodes are
+     *  reclaimed through the epoch_domain, so a reader never touches the freed memory. The elements are immutable
+     *  once published, insert_or_assign() replaces the whole node.
+     *
+     *  The modifications lock one of the \c lock_stripes stripes; a stripe owns the buckets with the same low bits
+     *  of the index, so it stays the same when the table grows. The growth locks every stripe and relinks the nodes
+     *  into the new bucket array; the lookups validate their misses against the resize sequence and retry.
+     *
+     *  for_each() and erase_if() sweep the table stripe by stripe, holding the lock of the visited stripe only,
+     *  so the function shall not modify the map.
+     **/
+    template<class Key, class T,
+             class Hash = hash<Key>,
+             class Pred = equal_to<Key>,
+             class Allocator = allocator<pair<const Key, T> > >
+    class concurrent_unordered_map
+    {
+    public:
+      ///\name types
+      typedef Key                     key_type;
+      typedef T                       mapped_type;
+      typedef pair<const Key, T>      value_type;
+      typedef Hash                    hasher;
+      typedef Pred                    key_equal;
+      typedef Allocator               allocator_type;
+      typedef size_t                  size_type;
+      ///\}
+
+      /** The number of the independently locked parts of the table */
+      static const size_type lock_stripes = 64;
+
+    private:
+      typedef size_t hash_t;
+
+      struct node:
+        epoch_domain::retired
+      {
+        atomic<node*> next;
+        hash_t        hkey;
+        value_type    elem;
+
+        node(const value_type& elem, hash_t h)
+          :next(nullptr), hkey(h), elem(elem)
+        {}
+      };
+
+      typedef atomic<node*> bucket_type;
+
+      struct table:
+        epoch_domain::retired
+      {
+        size_t        mask;
+        bucket_type*  buckets;
+      };
+
+      struct stripe
+      {
+        mutex         m;
+        atomic_size_t count;
+        char          pad[64 - (sizeof(mutex) + sizeof(atomic_size_t)) % 64];
+      };
+
+      typedef typename Allocator::template rebind<node>::other        node_allocator;
+      typedef typename Allocator::template rebind<table>::other       table_allocator;
+      typedef typename Allocator::template rebind<bucket_type>::other bucket_allocator;
+
+    public:
+      ///\name construct/destroy
+      explicit concurrent_unordered_map(size_type n = lock_stripes, const hasher& hf = hasher(), const key_equal& eql = key_equal(), const allocator_type& a = allocator_type())
+        :hash_(hf), equal_(eql), nalloc(a), talloc(a), balloc(a), table_(nullptr), resize_seq(0), domain(this)
+      {
+        for(size_t i = 0; i < lock_stripes; ++i)
+          stripes[i].count.store(0, memory_order_relaxed);
+        table_.store(create_table(n), memory_order_relaxed);
+      }
+
+      /** There shall be no concurrent access during the destruction */
+      ~concurrent_unordered_map()
+      {
+        domain.drain();
+        table* t = table_.load(memory_order_relaxed);
+        for(size_t i = 0; i <= t->mask; ++i)
+          destroy_chain(t->buckets[i].load(memory_order_relaxed));
+        destroy_table(t);
+      }
+
+      ///\name size and capacity
+      /** The number of elements, approximate while the map is modified concurrently */
+      size_type size() const
+      {
+        size_type n = 0;
+        for(size_t i = 0; i < lock_stripes; ++i)
+          n += stripes[i].count.load(memory_order_relaxed);
+        return n;
+      }
+      bool empty() const { return size() == 0; }
+
+      size_type bucket_count() const { return table_.load(memory_order_relaxed)->mask + 1; }
+
+      ///\name lookup
+      /** Copies the value mapped to \p k into \p value, returns \c false if there is no such element */
+      bool find(const key_type& k, mapped_type& value) const
+      {
+        epoch_domain::guard g(domain);
+        const node* p = lookup(k, hash_of(k));
+        if(!p)
+          return false;
+        value = p->elem.second;
+        return true;
+      }
+
+      bool contains(const key_type& k) const
+      {
+        epoch_domain::guard g(domain);
+        return lookup(k, hash_of(k)) != nullptr;
+      }
+
+      size_type count(const key_type& k) const { return contains(k) ? 1 : 0; }
+
+      /** Calls <tt>f(const value_type&)</tt> for the element with the key \p k without copying it, returns \c false if there is no such element */
+      template<class F>
+      bool visit(const key_type& k, F f) const
+      {
+        epoch_domain::guard g(domain);
+        const node* p = lookup(k, hash_of(k));
+        if(!p)
+          return false;
+        f(p->elem);
+        return true;
+      }
+
+      ///\name modifiers
+      /** Inserts \p v if there is no element with the same key, returns \c true if the insertion took place */
+      bool insert(const value_type& v)
+      {
+        const hash_t h = hash_of(v.first);
+        stripe& s = stripe_of(h);
+        bool grow;
+        {
+          lock_guard<mutex> lock(s.m);
+          table* t = table_.load(memory_order_relaxed);
+          bucket_type& b = t->buckets[h & t->mask];
+          if(find_locked(b, v.first, h))
+            return false;
+          node* p = create_node(v, h);
+          p->next.store(b.load(memory_order_relaxed), memory_order_relaxed);
+          b.store(p, memory_order_release);
+          grow = s.count.fetch_add(1, memory_order_relaxed) >= (t->mask + 1) / lock_stripes;
+        }
+        if(grow)
+          rehash(bucket_count() * 2);
+        return true;
+      }
+
+      /** Inserts the element or replaces the value of the existing one, returns \c true if the insertion took place */
+      bool insert_or_assign(const key_type& k, const mapped_type& value)
+      {
+        const hash_t h = hash_of(k);
+        stripe& s = stripe_of(h);
+        node* old;
+        {
+          lock_guard<mutex> lock(s.m);
+          table* t = table_.load(memory_order_relaxed);
+          bucket_type& b = t->buckets[h & t->mask];
+          bucket_type* link = find_locked(b, k, h);
+          if(link){
+            old = link->load(memory_order_relaxed);
+            node* p = create_node(value_type(k, value), h);
+            p->next.store(old->next.load(memory_order_relaxed), memory_order_relaxed);
+            link->store(p, memory_order_release);
+          }else{
+            old = nullptr;
+            node* p = create_node(value_type(k, value), h);
+            p->next.store(b.load(memory_order_relaxed), memory_order_relaxed);
+            b.store(p, memory_order_release);
+            if(s.count.fetch_add(1, memory_order_relaxed) < (t->mask + 1) / lock_stripes)
+              return true;
+          }
+        }
+        if(old){
+          domain.retire(old, &reclaim_node);
+          return false;
+        }
+        rehash(bucket_count() * 2);
+        return true;
+      }
+
+      /** Removes the element with the key \p k, returns the number of removed elements */
+      size_type erase(const key_type& k)
+      {
+        const hash_t h = hash_of(k);
+        stripe& s = stripe_of(h);
+        node* p;
+        {
+          lock_guard<mutex> lock(s.m);
+          table* t = table_.load(memory_order_relaxed);
+          bucket_type* link = find_locked(t->buckets[h & t->mask], k, h);
+          if(!link)
+            return 0;
+          p = link->load(memory_order_relaxed);
+          link->store(p->next.load(memory_order_relaxed), memory_order_release);
+          s.count.fetch_sub(1, memory_order_relaxed);
+        }
+        domain.retire(p, &reclaim_node);
+        return 1;
+      }
+
+      /** Removes the elements satisfying \p pred, returns the number of removed elements */
+      template<class Predicate>
+      size_type erase_if(Predicate pred)
+      {
+        size_type n = 0;
+        for(size_t i = 0; i < lock_stripes; ++i){
+          stripe& s = stripes[i];
+          lock_guard<mutex> lock(s.m);
+          table* t = table_.load(memory_order_relaxed);
+          for(size_t bi = i; bi <= t->mask; bi += lock_stripes){
+            bucket_type* link = &t->buckets[bi];
+            while(node* p = link->load(memory_order_relaxed)){
+              if(!pred(const_cast<const value_type&>(p->elem))){
+                link = &p->next;
+                continue;
+              }
+              link->store(p->next.load(memory_order_relaxed), memory_order_release);
+              s.count.fetch_sub(1, memory_order_relaxed);
+              domain.retire(p, &reclaim_node);
+              ++n;
+            }
+          }
+        }
+        return n;
+      }
+
+      void clear()
+      {
+        erase_if(always());
+      }
+
+      /** Calls <tt>f(const value_type&)</tt> for every element */
+      template<class F>
+      void for_each(F f) const
+      {
+        for(size_t i = 0; i < lock_stripes; ++i){
+          lock_guard<mutex> lock(stripes[i].m);
+          const table* t = table_.load(memory_order_relaxed);
+          for(size_t bi = i; bi <= t->mask; bi += lock_stripes){
+            for(const node* p = t->buckets[bi].load(memory_order_relaxed); p; p = p->next.load(memory_order_relaxed))
+              f(p->elem);
+          }
+        }
+      }
+
+      ///\name hash policy
+      /** Grows the table to at least \p n buckets */
+      void rehash(size_type n)
+      {
+        if(n <= bucket_count())
+          return;
+        table* t = create_table(n);
+        for(size_t i = 0; i < lock_stripes; ++i)
+          stripes[i].m.lock();
+
+        table* old = table_.load(memory_order_relaxed);
+        if(t->mask <= old->mask){
+          // grown by another thread meanwhile
+          unlock_stripes();
+          destroy_table(t);
+          return;
+        }
+
+        // the lookups missing a relinked node retry until the sequence is even and unchanged
+        const size_t seq = resize_seq.load(memory_order_relaxed);
+        resize_seq.store(seq + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        table_.store(t, memory_order_release);
+        for(size_t i = 0; i <= old->mask; ++i){
+          for(node* p = old->buckets[i].load(memory_order_relaxed); p; ){
+            node* const next = p->next.load(memory_order_relaxed);
+            bucket_type& b = t->buckets[p->hkey & t->mask];
+            p->next.store(b.load(memory_order_relaxed), memory_order_release);
+            b.store(p, memory_order_release);
+            p = next;
+          }
+        }
+        resize_seq.store(seq + 2, memory_order_release);
+        unlock_stripes();
+        domain.retire(old, &reclaim_table);
+      }
+
+      ///\name observers
+      hasher hash_function() const { return hash_; }
+      key_equal key_eq() const { return equal_; }
+      allocator_type get_allocator() const { return allocator_type(nalloc); }
+      ///\}
+
+    private:
+      concurrent_unordered_map(const concurrent_unordered_map&) __deleted;
+      concurrent_unordered_map& operator=(const concurrent_unordered_map&) __deleted;
+
+      struct always
+      {
+        bool operator()(const value_type&) const { return true; }
+      };
+
+      hash_t hash_of(const key_type& k) const
+      {
+        // spread the bits, the low ones select both the bucket and the stripe
+        hash_t h = hash_(k);
+        h ^= h >> (sizeof(hash_t) * 4);
+        h *= static_cast<hash_t>(0x9E3779B97F4A7C15ULL);
+        return h ^ (h >> (sizeof(hash_t) * 4));
+      }
+
+      stripe& stripe_of(hash_t h) const { return stripes[h & (lock_stripes - 1)]; }
+
+      /** shall be called under the guard */
+      const node* lookup(const key_type& k, hash_t h) const
+      {
+        for(;;){
+          const size_t seq = resize_seq.load(memory_order_acquire);
+          const table* t = table_.load(memory_order_acquire);
+          for(const node* p = t->buckets[h & t->mask].load(memory_order_acquire); p; p = p->next.load(memory_order_acquire)){
+            if(p->hkey == h && equal_(k, p->elem.first))
+              return p;
+          }
+          // the miss is reliable only if the chains weren't relinked meanwhile
+          atomic_thread_fence(memory_order_acquire);
+          if(!(seq & 1) && resize_seq.load(memory_order_relaxed) == seq)
+            return nullptr;
+        }
+      }
+
+      /** the link pointing to the node with the key \p k or null, shall be called under the stripe lock */
+      bucket_type* find_locked(bucket_type& b, const key_type& k, hash_t h) const
+      {
+        for(bucket_type* link = &b; ; ){
+          node* p = link->load(memory_order_relaxed);
+          if(!p)
+            return nullptr;
+          if(p->hkey == h && equal_(k, p->elem.first))
+            return link;
+          link = &p->next;
+        }
+      }
+
+      void unlock_stripes()
+      {
+        for(size_t i = lock_stripes; i; --i)
+          stripes[i-1].m.unlock();
+      }
+
+      node* create_node(const value_type& v, hash_t h)
+      {
+        node* p = nalloc.allocate(1);
+        __ntl_try{
+          nalloc.construct(p, v, h);
+        }
+        __ntl_catch(...){
+          nalloc.deallocate(p, 1);
+          __ntl_rethrow;
+        }
+        return p;
+      }
+
+      void destroy_node(node* p)
+      {
+        nalloc.destroy(p);
+        nalloc.deallocate(p, 1);
+      }
+
+      void destroy_chain(node* p)
+      {
+        while(p){
+          node* next = p->next.load(memory_order_relaxed);
+          destroy_node(p);
+          p = next;
+        }
+      }
+
+      table* create_table(size_type n)
+      {
+        size_t count = lock_stripes;
+        while(count < n)
+          count <<= 1;
+        table* t = talloc.allocate(1);
+        __ntl_try{
+          t->buckets = balloc.allocate(count);
+        }
+        __ntl_catch(...){
+          talloc.deallocate(t, 1);
+          __ntl_rethrow;
+        }
+        t->mask = count - 1;
+        for(size_t i = 0; i < count; ++i)
+          new (&t->buckets[i]) bucket_type(nullptr);
+        return t;
+      }
+
+      void destroy_table(table* t)
+      {
+        balloc.deallocate(t->buckets, t->mask + 1);
+        talloc.deallocate(t, 1);
+      }
+
+      static void reclaim_node(epoch_domain::retired* p, void* context)
+      {
+        static_cast<concurrent_unordered_map*>(context)->destroy_node(static_cast<node*>(p));
+      }
+
+      static void reclaim_table(epoch_domain::retired* p, void* context)
+      {
+        static_cast<concurrent_unordered_map*>(context)->destroy_table(static_cast<table*>(p));
+      }
+
+    private:
+      hasher            hash_;
+      key_equal         equal_;
+      node_allocator    nalloc;
+      table_allocator   talloc;
+      bucket_allocator  balloc;
+
+      atomic<table*>    table_;
+      atomic_size_t     resize_seq;
+      mutable stripe    stripes[lock_stripes];
+      epoch_domain      domain;
+    };
+
+    /**@} lib_containers */
+  } // ext
+} // std
+
+#endif // NTL__EXT_CONCURRENT_UNORDERED_MAP
@@ -0,0 +1,270 @@
+/**\file*********************************************************************
+ *                                                                     \brief
+ *  Instrumented allocator adaptor
+ *
+ ****************************************************************************
+ */
+#ifndef NTL__EXT_COUNTING_ALLOCATOR
+#define NTL__EXT_COUNTING_ALLOCATOR
+#pragma once
+
+#include "../atomic.hxx"
+#include "../iosfwd.hxx"
+#include "../memory.hxx"
+
+namespace std
+{
+  namespace ext
+  {
+    /**\addtogroup  lib_memory
+     *@{*/
+
+    /**
+     *	@brief Allocation statistics of a tag
+     *  @details The counters are updated atomically and may be read while the allocations go on.
+     *  The histogram counts the allocations by size: the bucket \c i holds the sizes up to <tt>16 << i</tt> bytes,
+     *  the last one holds the rest.
+     **/
+    class allocation_stats
+    {
+    public:
+      static const size_t histogram_size = 16;
+
+      const char* name() const { return name_ ? name_() : ""; }
+
+      size_t allocations() const { return allocs.load(memory_order_relaxed); }
+      size_t deallocations() const { return deallocs.load(memory_order_relaxed); }
+      size_t live_bytes() const { return live.load(memory_order_relaxed); }
+      size_t peak_bytes() const { return peak.load(memory_order_relaxed); }
+      size_t histogram(size_t bucket) const { return hist[bucket].load(memory_order_relaxed); }
+
+      static size_t bucket_of(size_t bytes)
+      {
+        size_t i = 0;
+        while(i < histogram_size - 1 && bytes > (size_t(16) << i))
+          ++i;
+        return i;
+      }
+
+      /** The largest size counted in the \p bucket, 0 for the last one */
+      static size_t bucket_limit(size_t bucket)
+      {
+        return bucket < histogram_size - 1 ? size_t(16) << bucket : 0;
+      }
+
+      void on_allocate(size_t bytes)
+      {
+        allocs.fetch_add(1, memory_order_relaxed);
+        hist[bucket_of(bytes)].fetch_add(1, memory_order_relaxed);
+        const size_t now = live.fetch_add(bytes, memory_order_relaxed) + bytes;
+        for(size_t top = peak.load(memory_order_relaxed); now > top && !peak.compare_exchange_weak(top, now, memory_order_relaxed); )
+          ;
+      }
+
+      void on_deallocate(size_t bytes)
+      {
+        deallocs.fetch_add(1, memory_order_relaxed);
+        live.fetch_sub(bytes, memory_order_relaxed);
+      }
+
+      /** Restarts the counting, the peak starts from the current live bytes */
+      void reset()
+      {
+        allocs.store(0, memory_order_relaxed);
+        deallocs.store(0, memory_order_relaxed);
+        peak.store(live.load(memory_order_relaxed), memory_order_relaxed);
+        for(size_t i = 0; i < histogram_size; ++i)
+          hist[i].store(0, memory_order_relaxed);
+      }
+
+      const allocation_stats* next() const { return next_; }
+
+    private:
+      friend class allocation_registry;
+      template<class> friend struct allocation_tag_stats;
+
+      atomic_size_t allocs, deallocs, live, peak;
+      atomic_size_t hist[histogram_size];
+      const char* (*name_)();
+      allocation_stats* next_;
+      atomic_size_t registered;
+    };
+
+    namespace __
+    {
+      template<class T>
+      struct allocation_registry_head
+      {
+        static atomic<T*> head;
+      };
+
+      template<class T>
+      atomic<T*> allocation_registry_head<T>::head;
+    }
+
+    /**
+     *	@brief The process-wide list of the allocation statistics
+     *  @details The statistics of a tag join the registry on the first allocation of that tag and stay there.
+     **/
+    class allocation_registry
+    {
+      typedef __::allocation_registry_head<allocation_stats> list;
+    public:
+      static const allocation_stats* first()
+      {
+        return list::head.load(memory_order_acquire);
+      }
+
+      /** Calls \p f with every registered allocation_stats */
+      template<class F>
+      static void for_each(F f)
+      {
+        for(const allocation_stats* s = first(); s; s = s->next())
+          f(*s);
+      }
+
+      static const allocation_stats* find(const char* name)
+      {
+        for(const allocation_stats* s = first(); s; s = s->next()){
+          const char* a = s->name(), *b = name;
+          while(*a && *a == *b)
+            ++a, ++b;
+          if(*a == *b)
+            return s;
+        }
+        return nullptr;
+      }
+
+      /** Writes the statistics of all tags to \p os, one line per tag, e.g. to the \c ntl::nt::dbg streams */
+      template<class charT, class traits>
+      static basic_ostream<charT, traits>& dump(basic_ostream<charT, traits>& os)
+      {
+        for(const allocation_stats* s = first(); s; s = s->next())
+          os << *s << '\n';
+        return os;
+      }
+
+    private:
+      template<class> friend struct allocation_tag_stats;
+
+      static void add(allocation_stats& s)
+      {
+        allocation_stats* h = list::head.load(memory_order_relaxed);
+        do{
+          s.next_ = h;
+        }while(!list::head.compare_exchange_weak(h, &s, memory_order_release, memory_order_relaxed));
+      }
+    };
+
+    template<class charT, class traits>
+    inline basic_ostream<charT, traits>& operator<<(basic_ostream<charT, traits>& os, const allocation_stats& s)
+    {
+      os << s.name() << ": " << s.allocations() << " allocations, " << s.deallocations() << " deallocations, "
+         << s.live_bytes() << " bytes live, " << s.peak_bytes() << " bytes peak; sizes";
+      for(size_t i = 0; i < allocation_stats::histogram_size; ++i){
+        if(const size_t n = s.histogram(i)){
+          if(const size_t limit = allocation_stats::bucket_limit(i))
+            os << " <=" << limit << ':' << n;
+          else
+            os << " >" << allocation_stats::bucket_limit(i - 1) << ':' << n;
+        }
+      }
+      return os;
+    }
+
+    /** The statistics of the allocations tagged with \p Tag */
+    template<class Tag>
+    struct allocation_tag_stats
+    {
+      static allocation_stats& get()
+      {
+        if(stats.registered.load(memory_order_acquire) != 2){
+          size_t expected = 0;
+          if(stats.registered.compare_exchange_strong(expected, 1)){
+            stats.name_ = &Tag::name;
+            allocation_registry::add(stats);
+            stats.registered.store(2, memory_order_release);
+          }
+        }
+        return stats;
+      }
+    private:
+      static allocation_stats stats;
+    };
+
+    template<class Tag>
+    allocation_stats allocation_tag_stats<Tag>::stats;
+
+    /**
+     *	@brief Instrumented allocator adaptor
+     *
+     *  Passes the requests to \p Alloc and records them in the statistics of the \p Tag, which is a type with
+     *  the static member function <tt>const char* name()</tt>; e.g.
+     *  \code
+     *  struct network_heap { static const char* name() { return "network"; } };
+     *  std::vector<packet, std::ext::counting_allocator<std::allocator<packet>, network_heap> > queue;
+     *  \endcode
+     *  The rebound allocators keep the tag, so the nodes of a container are counted with the container.
+     *  The statistics of all tags are available from allocation_registry.
+     **/
+    template<class Alloc, class Tag>
+    class counting_allocator:
+      public Alloc
+    {
+    public:
+      typedef typename Alloc::value_type      value_type;
+      typedef typename Alloc::pointer         pointer;
+      typedef typename Alloc::const_pointer   const_pointer;
+      typedef typename Alloc::reference       reference;
+      typedef typename Alloc::const_reference const_reference;
+      typedef typename Alloc::size_type       size_type;
+      typedef typename Alloc::difference_type difference_type;
+      template<class U> struct rebind { typedef counting_allocator<typename Alloc::template rebind<U>::other, Tag> other; };
+
+      counting_allocator()
+      {}
+
+      counting_allocator(const Alloc& a)
+        :Alloc(a)
+      {}
+
+      template<class A2>
+      counting_allocator(const counting_allocator<A2, Tag>& a)
+        :Alloc(a.upstream())
+      {}
+
+      pointer allocate(size_type n, const void* hint = 0)
+      {
+        const pointer p = Alloc::allocate(n, hint);
+        stats().on_allocate(n * sizeof(value_type));
+        return p;
+      }
+
+      void deallocate(pointer p, size_type n)
+      {
+        Alloc::deallocate(p, n);
+        stats().on_deallocate(n * sizeof(value_type));
+      }
+
+      const Alloc& upstream() const { return *this; }
+
+      static allocation_stats& stats() { return allocation_tag_stats<Tag>::get(); }
+    };
+
+    template<class A1, class A2, class Tag>
+    inline bool operator==(const counting_allocator<A1, Tag>& x, const counting_allocator<A2, Tag>& y)
+    {
+      return x.upstream() == y.upstream();
+    }
+
+    template<class A1, class A2, class Tag>
+    inline bool operator!=(const counting_allocator<A1, Tag>& x, const counting_allocator<A2, Tag>& y)
+    {
+      return !(x == y);
+    }
+
+    /**@} lib_memory */
+  } // ext
+} // std
+
+#endif // NTL__EXT_COUNTING_ALLOCATOR
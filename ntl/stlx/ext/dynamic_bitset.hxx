@@ -0,0 +1,565 @@
+/**\file*********************************************************************
+ *                                                                     \brief
+ *  Resizable bitset
+ *
+ ****************************************************************************
+ */
+#ifndef NTL__EXT_DYNAMIC_BITSET
+#define NTL__EXT_DYNAMIC_BITSET
+#pragma once
+
+#include "../vector.hxx"
+#include "../bit.hxx"
+#include "../stdexcept_fwd.hxx"
+
+namespace std
+{
+  namespace ext
+  {
+    /**\addtogroup  lib_utilities *** 20 General utilities library [utilities]
+     *@{*/
+
+    /**
+     *	@brief Resizable bitset
+     *
+     *  dynamic_bitset has the interface of \c std::bitset with the size set at run time. The bits are stored in the
+     *  blocks of \p Block type (the native word by default) from the lowest bit of the first block, the unused bits
+     *  of the last block are always zero.
+     *
+     *  The set operations (and, or, xor, andnot) work block-wise either in place or into the destination and require
+     *  the operands of the same size; the loops are written so the compiler can vectorize them.
+     **/
+    template<class Block = uintptr_t, class Allocator = allocator<Block> >
+    class dynamic_bitset
+    {
+      static_assert(is_unsigned<Block>::value, "Block shall be an unsigned integral type");
+
+      typedef vector<Block, Allocator> storage_type;
+    public:
+      typedef Block                                   block_type;
+      typedef Allocator                               allocator_type;
+      typedef size_t                                  size_type;
+
+      static const size_type bits_per_block = sizeof(Block) * 8;
+      static const size_type npos = static_cast<size_type>(-1);
+
+      /// bit reference
+      class reference
+      {
+        friend class dynamic_bitset;
+        reference(block_type& block, size_type pos)
+          :block(block), mask(block_type(1) << pos)
+        {}
+      public:
+        reference& operator=(bool x)
+        {
+          if(x) block |= mask; else block &= ~mask;
+          return *this;
+        }
+        reference& operator=(const reference& rhs) { return *this = static_cast<bool>(rhs); }
+        reference& operator|=(bool x) { if(x) block |= mask; return *this; }
+        reference& operator&=(bool x) { if(!x) block &= ~mask; return *this; }
+        reference& operator^=(bool x) { if(x) block ^= mask; return *this; }
+
+        bool operator~() const    { return (block & mask) == 0; }
+        operator bool() const     { return (block & mask) != 0; }
+        reference& flip()         { block ^= mask; return *this; }
+      private:
+        block_type& block;
+        const block_type mask;
+      };
+      typedef bool const_reference;
+
+      /// Forward iterator over the indices of the set bits
+      class set_bit_iterator:
+        public iterator<forward_iterator_tag, size_type, ptrdiff_t, const size_type*, const size_type&>
+      {
+        friend class dynamic_bitset;
+        set_bit_iterator(const dynamic_bitset* b, size_type pos)
+          :b(b), pos(pos)
+        {}
+      public:
+        set_bit_iterator() :b(), pos() {}
+
+        const size_type& operator*() const { return pos; }
+        set_bit_iterator& operator++() { pos = b->find_next(pos); return *this; }
+        set_bit_iterator operator++(int) { set_bit_iterator tmp(*this); ++*this; return tmp; }
+
+        friend bool operator==(const set_bit_iterator& x, const set_bit_iterator& y) { return x.pos == y.pos; }
+        friend bool operator!=(const set_bit_iterator& x, const set_bit_iterator& y) { return x.pos != y.pos; }
+      private:
+        const dynamic_bitset* b;
+        size_type pos;
+      };
+
+    public:
+      ///\name construct/copy/destroy
+      explicit dynamic_bitset(const Allocator& a = Allocator())
+        :blocks(a), size_()
+      {}
+
+      /** Constructs \p n bits initialized from the bits of \p val */
+      explicit dynamic_bitset(size_type n, unsigned long long val = 0, const Allocator& a = Allocator())
+        :blocks(blocks_for(n), block_type(), a), size_(n)
+      {
+        for(size_type i = 0; i < blocks.size() && i*bits_per_block < sizeof(val)*8; ++i)
+          blocks[i] = static_cast<block_type>(val >> (i*bits_per_block));
+        tidy();
+      }
+
+      dynamic_bitset(const dynamic_bitset& x)
+        :blocks(x.blocks), size_(x.size_)
+      {}
+
+      dynamic_bitset& operator=(const dynamic_bitset& x)
+      {
+        blocks = x.blocks;
+        size_ = x.size_;
+        return *this;
+      }
+
+    #ifdef NTL_CXX_RV
+      dynamic_bitset(dynamic_bitset&& x)
+        :blocks(move(x.blocks)), size_(x.size_)
+      {
+        x.size_ = 0;
+      }
+
+      dynamic_bitset& operator=(dynamic_bitset&& x)
+      {
+        blocks = move(x.blocks);
+        size_ = x.size_;
+        x.size_ = 0;
+        return *this;
+      }
+    #endif
+
+      allocator_type get_allocator() const { return blocks.get_allocator(); }
+
+      ///\name capacity
+      size_type size()        const __ntl_nothrow { return size_; }
+      size_type num_blocks()  const __ntl_nothrow { return blocks.size(); }
+      size_type capacity()    const __ntl_nothrow { return blocks.capacity() * bits_per_block; }
+      bool      empty()       const __ntl_nothrow { return size_ == 0; }
+      size_type max_size()    const __ntl_nothrow { return blocks.max_size() > npos / bits_per_block ? npos : blocks.max_size() * bits_per_block; }
+
+      void reserve(size_type n) { blocks.reserve(blocks_for(n)); }
+
+      /** Changes the size to \p n bits, the new bits are set to \p value */
+      void resize(size_type n, bool value = false)
+      {
+        const size_type old_size = size_;
+        blocks.resize(blocks_for(n), value ? ones() : block_type());
+        size_ = n;
+        if(value && n > old_size && old_size % bits_per_block)
+          blocks[old_size / bits_per_block] |= ones() << (old_size % bits_per_block);
+        tidy();
+      }
+
+      void clear() __ntl_nothrow
+      {
+        blocks.clear();
+        size_ = 0;
+      }
+
+      void push_back(bool value)
+      {
+        if(size_ % bits_per_block == 0)
+          blocks.push_back(block_type());
+        if(value)
+          blocks.back() |= block_type(1) << (size_ % bits_per_block);
+        ++size_;
+      }
+
+      void pop_back()
+      {
+        assert(!empty());
+        --size_;
+        if(size_ % bits_per_block == 0)
+          blocks.pop_back();
+        else
+          tidy();
+      }
+
+      void swap(dynamic_bitset& x)
+      {
+        blocks.swap(x.blocks);
+        std::swap(size_, x.size_);
+      }
+
+      ///\name element access
+      bool operator[](size_type pos) const
+      {
+        assert(pos < size_);
+        return (blocks[pos / bits_per_block] & bit(pos)) != 0;
+      }
+
+      reference operator[](size_type pos)
+      {
+        assert(pos < size_);
+        return reference(blocks[pos / bits_per_block], pos % bits_per_block);
+      }
+
+      bool test(size_type pos) const __ntl_throws(out_of_range)
+      {
+        check_bounds(pos);
+        return (*this)[pos];
+      }
+
+      /** Sets the bit at \p pos and returns its previous value */
+      bool test_set(size_type pos, bool value = true) __ntl_throws(out_of_range)
+      {
+        const bool old = test(pos);
+        set(pos, value);
+        return old;
+      }
+
+      /** Direct access to the blocks */
+      const block_type* data() const __ntl_nothrow { return blocks.data(); }
+      ///\}
+
+      ///\name bit operations
+      dynamic_bitset& set() __ntl_nothrow
+      {
+        fill_n(blocks.begin(), blocks.size(), ones());
+        tidy();
+        return *this;
+      }
+
+      dynamic_bitset& set(size_type pos, bool value = true) __ntl_throws(out_of_range)
+      {
+        check_bounds(pos);
+        if(value)
+          blocks[pos / bits_per_block] |= bit(pos);
+        else
+          blocks[pos / bits_per_block] &= ~bit(pos);
+        return *this;
+      }
+
+      /** Sets \p n bits starting from \p pos */
+      dynamic_bitset& set(size_type pos, size_type n, bool value) __ntl_throws(out_of_range)
+      {
+        if(pos > size_ || n > size_ - pos)
+          __throw_out_of_range(__name__": range is out of bounds");
+        while(n){
+          const size_type shift = pos % bits_per_block, len = min(n, bits_per_block - shift);
+          const block_type mask = (len == bits_per_block ? ones() : (block_type(1) << len) - 1) << shift;
+          if(value)
+            blocks[pos / bits_per_block] |= mask;
+          else
+            blocks[pos / bits_per_block] &= ~mask;
+          pos += len, n -= len;
+        }
+        return *this;
+      }
+
+      dynamic_bitset& reset() __ntl_nothrow
+      {
+        fill_n(blocks.begin(), blocks.size(), block_type());
+        return *this;
+      }
+
+      dynamic_bitset& reset(size_type pos) __ntl_throws(out_of_range)
+      {
+        return set(pos, false);
+      }
+
+      dynamic_bitset& flip() __ntl_nothrow
+      {
+        block_type* __restrict p = blocks.data();
+        for(size_type i = 0, n = blocks.size(); i < n; ++i)
+          p[i] = ~p[i];
+        tidy();
+        return *this;
+      }
+
+      dynamic_bitset& flip(size_type pos) __ntl_throws(out_of_range)
+      {
+        check_bounds(pos);
+        blocks[pos / bits_per_block] ^= bit(pos);
+        return *this;
+      }
+
+      dynamic_bitset operator~() const
+      {
+        return dynamic_bitset(*this).flip();
+      }
+
+      dynamic_bitset& operator<<=(size_type pos)
+      {
+        if(pos >= size_)
+          return reset();
+        if(pos == 0)
+          return *this;
+        block_type* const p = blocks.data();
+        const size_type words = pos / bits_per_block, shift = pos % bits_per_block, last = blocks.size() - 1;
+        if(shift == 0){
+          for(size_type i = last; i > words; --i)
+            p[i] = p[i-words];
+        }else{
+          for(size_type i = last; i > words; --i)
+            p[i] = (p[i-words] << shift) | (p[i-words-1] >> (bits_per_block - shift));
+        }
+        p[words] = p[0] << shift;
+        fill_n(p, words, block_type());
+        tidy();
+        return *this;
+      }
+
+      dynamic_bitset& operator>>=(size_type pos)
+      {
+        if(pos >= size_)
+          return reset();
+        if(pos == 0)
+          return *this;
+        block_type* const p = blocks.data();
+        const size_type words = pos / bits_per_block, shift = pos % bits_per_block, last = blocks.size() - words - 1;
+        if(shift == 0){
+          for(size_type i = 0; i < last; ++i)
+            p[i] = p[i+words];
+        }else{
+          for(size_type i = 0; i < last; ++i)
+            p[i] = (p[i+words] >> shift) | (p[i+words+1] << (bits_per_block - shift));
+        }
+        p[last] = p[blocks.size()-1] >> shift;
+        fill_n(p + last + 1, words, block_type());
+        return *this;
+      }
+
+      dynamic_bitset operator<<(size_type pos) const { return dynamic_bitset(*this) <<= pos; }
+      dynamic_bitset operator>>(size_type pos) const { return dynamic_bitset(*this) >>= pos; }
+
+      ///\name set operations
+      dynamic_bitset& operator&=(const dynamic_bitset& x) { return apply(x, and_op()); }
+      dynamic_bitset& operator|=(const dynamic_bitset& x) { return apply(x, or_op()); }
+      dynamic_bitset& operator^=(const dynamic_bitset& x) { return apply(x, xor_op()); }
+      /** Clears the bits set in \p x (and not) */
+      dynamic_bitset& operator-=(const dynamic_bitset& x) { return apply(x, andnot_op()); }
+
+      /** Stores <tt>x & y</tt> into \c *this reusing its storage */
+      dynamic_bitset& assign_and(const dynamic_bitset& x, const dynamic_bitset& y)    { return apply(x, y, and_op()); }
+      /** Stores <tt>x | y</tt> into \c *this reusing its storage */
+      dynamic_bitset& assign_or(const dynamic_bitset& x, const dynamic_bitset& y)     { return apply(x, y, or_op()); }
+      /** Stores <tt>x ^ y</tt> into \c *this reusing its storage */
+      dynamic_bitset& assign_xor(const dynamic_bitset& x, const dynamic_bitset& y)    { return apply(x, y, xor_op()); }
+      /** Stores <tt>x & ~y</tt> into \c *this reusing its storage */
+      dynamic_bitset& assign_andnot(const dynamic_bitset& x, const dynamic_bitset& y) { return apply(x, y, andnot_op()); }
+
+      ///\name observers
+      size_type count() const __ntl_nothrow
+      {
+        const block_type* const p = blocks.data();
+        size_type n = 0;
+        for(size_type i = 0, nb = blocks.size(); i < nb; ++i)
+          n += popcount(p[i]);
+        return n;
+      }
+
+      /** Returns <tt>(*this & x).count()</tt> without building the intersection */
+      size_type intersection_count(const dynamic_bitset& x) const __ntl_nothrow
+      {
+        assert(size_ == x.size_);
+        const block_type* const p = blocks.data(), * const q = x.blocks.data();
+        size_type n = 0;
+        for(size_type i = 0, nb = blocks.size(); i < nb; ++i)
+          n += popcount(static_cast<block_type>(p[i] & q[i]));
+        return n;
+      }
+
+      bool any() const __ntl_nothrow
+      {
+        const block_type* const p = blocks.data();
+        for(size_type i = 0, nb = blocks.size(); i < nb; ++i)
+          if(p[i])
+            return true;
+        return false;
+      }
+
+      bool none() const __ntl_nothrow { return !any(); }
+
+      bool all() const __ntl_nothrow
+      {
+        if(empty())
+          return true;
+        const block_type* const p = blocks.data();
+        const size_type last = blocks.size() - 1;
+        for(size_type i = 0; i < last; ++i)
+          if(p[i] != ones())
+            return false;
+        return p[last] == last_mask();
+      }
+
+      /** Checks whether \p x has a common set bit */
+      bool intersects(const dynamic_bitset& x) const __ntl_nothrow
+      {
+        const block_type* const p = blocks.data(), * const q = x.blocks.data();
+        for(size_type i = 0, nb = min(blocks.size(), x.blocks.size()); i < nb; ++i)
+          if(p[i] & q[i])
+            return true;
+        return false;
+      }
+
+      /** Checks whether every bit set in \c *this is set in \p x */
+      bool is_subset_of(const dynamic_bitset& x) const __ntl_nothrow
+      {
+        assert(size_ == x.size_);
+        const block_type* const p = blocks.data(), * const q = x.blocks.data();
+        for(size_type i = 0, nb = blocks.size(); i < nb; ++i)
+          if(p[i] & ~q[i])
+            return false;
+        return true;
+      }
+
+      ///\name set bits lookup
+      /** Returns the index of the first set bit or npos */
+      size_type find_first() const __ntl_nothrow
+      {
+        return find_from(0);
+      }
+
+      /** Returns the index of the first set bit after \p prev or npos */
+      size_type find_next(size_type prev) const __ntl_nothrow
+      {
+        if(size_ == 0 || prev >= size_ - 1)
+          return npos;
+        ++prev;
+        const size_type i = prev / bits_per_block;
+        const block_type word = blocks[i] & (ones() << (prev % bits_per_block));
+        return word ? i*bits_per_block + countr_zero(word) : find_from(i+1);
+      }
+
+      set_bit_iterator set_bits_begin() const { return set_bit_iterator(this, find_first()); }
+      set_bit_iterator set_bits_end()   const { return set_bit_iterator(this, npos); }
+
+      /** Calls \p f with the index of each set bit in ascending order */
+      template<class Function>
+      Function for_each_set(Function f) const
+      {
+        const block_type* const p = blocks.data();
+        for(size_type i = 0, nb = blocks.size(); i < nb; ++i)
+          for(block_type word = p[i]; word; word &= word - 1)
+            f(i*bits_per_block + countr_zero(word));
+        return f;
+      }
+      ///\}
+
+      friend bool operator==(const dynamic_bitset& x, const dynamic_bitset& y)
+      {
+        return x.size_ == y.size_ && x.blocks == y.blocks;
+      }
+
+      friend bool operator!=(const dynamic_bitset& x, const dynamic_bitset& y)
+      {
+        return !(x == y);
+      }
+
+    private:
+      struct and_op     { block_type operator()(block_type x, block_type y) const { return x & y; } };
+      struct or_op      { block_type operator()(block_type x, block_type y) const { return x | y; } };
+      struct xor_op     { block_type operator()(block_type x, block_type y) const { return x ^ y; } };
+      struct andnot_op  { block_type operator()(block_type x, block_type y) const { return x & ~y; } };
+
+      template<class Op>
+      dynamic_bitset& apply(const dynamic_bitset& x, Op op)
+      {
+        assert(size_ == x.size_);
+        block_type* const p = blocks.data();
+        const block_type* const q = x.blocks.data();
+        // x may be *this
+        for(size_type i = 0, nb = blocks.size(); i < nb; ++i)
+          p[i] = op(p[i], q[i]);
+        return *this;
+      }
+
+      template<class Op>
+      dynamic_bitset& apply(const dynamic_bitset& x, const dynamic_bitset& y, Op op)
+      {
+        assert(x.size_ == y.size_);
+        if(this == &x)
+          return apply(y, op);
+        if(this == &y){
+          // the operands are not symmetric for andnot
+          const dynamic_bitset tmp(y);
+          return apply(x, tmp, op);
+        }
+        blocks.resize(x.blocks.size());
+        size_ = x.size_;
+        block_type* __restrict const p = blocks.data();
+        const block_type* __restrict const q = x.blocks.data(), * __restrict const r = y.blocks.data();
+        for(size_type i = 0, nb = blocks.size(); i < nb; ++i)
+          p[i] = op(q[i], r[i]);
+        return *this;
+      }
+
+      size_type find_from(size_type i) const
+      {
+        const block_type* const p = blocks.data();
+        for(const size_type nb = blocks.size(); i < nb; ++i)
+          if(p[i])
+            return i*bits_per_block + countr_zero(p[i]);
+        return npos;
+      }
+
+      static block_type ones() { return static_cast<block_type>(~block_type()); }
+      static size_type blocks_for(size_type n) { return n / bits_per_block + (n % bits_per_block != 0); }
+      static block_type bit(size_type pos) { return block_type(1) << (pos % bits_per_block); }
+
+      block_type last_mask() const
+      {
+        const size_type extra = size_ % bits_per_block;
+        return extra ? (block_type(1) << extra) - 1 : ones();
+      }
+
+      /** clears the unused bits of the last block */
+      void tidy()
+      {
+        if(!blocks.empty())
+          blocks.back() &= last_mask();
+      }
+
+      void check_bounds(size_type pos) const __ntl_throws(out_of_range)
+      {
+        if(pos >= size_)
+          __throw_out_of_range(__name__": position is out of range");
+      }
+
+    private:
+      storage_type blocks;
+      size_type size_;
+    };
+
+    template<class Block, class Allocator>
+    inline dynamic_bitset<Block, Allocator> operator&(const dynamic_bitset<Block, Allocator>& x, const dynamic_bitset<Block, Allocator>& y)
+    {
+      return dynamic_bitset<Block, Allocator>(x) &= y;
+    }
+
+    template<class Block, class Allocator>
+    inline dynamic_bitset<Block, Allocator> operator|(const dynamic_bitset<Block, Allocator>& x, const dynamic_bitset<Block, Allocator>& y)
+    {
+      return dynamic_bitset<Block, Allocator>(x) |= y;
+    }
+
+    template<class Block, class Allocator>
+    inline dynamic_bitset<Block, Allocator> operator^(const dynamic_bitset<Block, Allocator>& x, const dynamic_bitset<Block, Allocator>& y)
+    {
+      return dynamic_bitset<Block, Allocator>(x) ^= y;
+    }
+
+    template<class Block, class Allocator>
+    inline dynamic_bitset<Block, Allocator> operator-(const dynamic_bitset<Block, Allocator>& x, const dynamic_bitset<Block, Allocator>& y)
+    {
+      return dynamic_bitset<Block, Allocator>(x) -= y;
+    }
+
+    template<class Block, class Allocator>
+    inline void swap(dynamic_bitset<Block, Allocator>& x, dynamic_bitset<Block, Allocator>& y)
+    {
+      x.swap(y);
+    }
+
+    /**@} lib_utilities */
+  } // ext
+} // std
+
+#endif // NTL__EXT_DYNAMIC_BITSET
@@ -0,0 +1,197 @@
+/**\file*********************************************************************
+ *                                                                     \brief
+ *  Epoch based memory reclamation
+ *
+ ****************************************************************************
+ */
+#ifndef NTL__EXT_EPOCH
+#define NTL__EXT_EPOCH
+#pragma once
+
+#include "../atomic.hxx"
+#include "../mutex.hxx"
+
+namespace std
+{
+  namespace ext
+  {
+    /**\addtogroup  lib_memory
+     *@{*/
+
+    /**
+     *	@brief Epoch based reclamation domain
+     *
+     *  Lets the lock-free readers traverse the nodes which the writers unlink concurrently. A reader holds a guard
+     *  for the duration of the traversal, which announces the current global epoch in one of the reader slots.
+     *  A writer unlinks a node and retires it; the node is reclaimed once the epoch has advanced twice since,
+     *  and the epoch advances only when every active reader has announced the current one, so no reader can still
+     *  reach a reclaimed node.
+     *
+     *  Entering and leaving the guard costs an uncontended CAS and a store on the own slot of the reader,
+     *  the slots are on separate cache lines and are spread by the stack address of the thread.
+     *  Retirement and reclamation are serialized by the domain mutex.
+     **/
+    class epoch_domain
+    {
+      static const size_t cache_line_size = 64;
+      static const size_t slot_count = 64;
+      static const size_t collect_threshold = 64;
+    public:
+      /** The header of the retired objects */
+      struct retired
+      {
+        retired*  next_retired;
+        size_t    retire_epoch;
+        void    (*reclaim)(retired* p, void* context);
+      };
+
+      typedef void (*reclaim_function)(retired* p, void* context);
+
+      /** Protects the objects reachable during the lifetime of the guard from reclamation */
+      class guard
+      {
+      public:
+        explicit guard(const epoch_domain& domain)
+          :domain(domain), slot(domain.enter())
+        {}
+        ~guard()
+        {
+          domain.leave(slot);
+        }
+      private:
+        guard(const guard&) __deleted;
+        guard& operator=(const guard&) __deleted;
+
+        const epoch_domain& domain;
+        const size_t slot;
+      };
+
+    public:
+      /** \p context is passed to the reclaim functions */
+      explicit epoch_domain(void* context = nullptr)
+        :epoch(1), limbo(), pending(), context(context)
+      {
+        for(size_t i = 0; i < slot_count; ++i)
+          slots[i].state.store(0, memory_order_relaxed);
+      }
+
+      /** Reclaims all retired objects, there shall be no active guards */
+      ~epoch_domain()
+      {
+        drain();
+      }
+
+      /** Schedules the reclamation of \p p, which is already unreachable for the new readers */
+      void retire(retired* p, reclaim_function reclaim)
+      {
+        p->reclaim = reclaim;
+        lock_guard<mutex> lock(m);
+        p->retire_epoch = epoch.load(memory_order_relaxed);
+        p->next_retired = limbo;
+        limbo = p;
+        if(++pending >= collect_threshold)
+          collect_locked();
+      }
+
+      /** Tries to advance the epoch and reclaims the objects no reader can reach */
+      void collect()
+      {
+        lock_guard<mutex> lock(m);
+        collect_locked();
+      }
+
+      /** Reclaims all retired objects, there shall be no active guards */
+      void drain()
+      {
+        lock_guard<mutex> lock(m);
+        reclaim_list(limbo);
+        limbo = nullptr;
+        pending = 0;
+      }
+
+    private:
+      epoch_domain(const epoch_domain&) __deleted;
+      epoch_domain& operator=(const epoch_domain&) __deleted;
+
+      static size_t active_tag(size_t e) { return e << 1 | 1; }
+
+      static size_t slot_hint()
+      {
+        // the threads run on different stacks, so the stack address spreads them over the slots
+        const char local = 0;
+        const size_t h = static_cast<size_t>(reinterpret_cast<uintptr_t>(&local) >> 16) * 0x9E3779B1u;
+        return (h >> 16) % slot_count;
+      }
+
+      size_t enter() const
+      {
+        for(size_t i = slot_hint(); ; i = (i + 1) % slot_count){
+          size_t e = epoch.load(), free_slot = 0;
+          if(!slots[i].state.compare_exchange_weak(free_slot, active_tag(e)))
+            continue;
+          // the epoch may have been advanced before the announcement became visible
+          for(size_t e2; (e2 = epoch.load()) != e; e = e2)
+            slots[i].state.store(active_tag(e2));
+          return i;
+        }
+      }
+
+      void leave(size_t i) const
+      {
+        slots[i].state.store(0, memory_order_release);
+      }
+
+      void collect_locked()
+      {
+        size_t e = epoch.load(memory_order_relaxed);
+        const size_t tag = active_tag(e);
+        bool advance = true;
+        for(size_t i = 0; i < slot_count && advance; ++i){
+          const size_t s = slots[i].state.load();
+          advance = s == 0 || s == tag;
+        }
+        if(advance)
+          epoch.store(++e);
+
+        // the list is ordered by the retire epoch, newest first
+        retired** pp = &limbo;
+        while(*pp && (*pp)->retire_epoch + 2 > e)
+          pp = &(*pp)->next_retired;
+        retired* p = *pp;
+        *pp = nullptr;
+        for(pending = 0, pp = &limbo; *pp; pp = &(*pp)->next_retired)
+          ++pending;
+        reclaim_list(p);
+      }
+
+      void reclaim_list(retired* p)
+      {
+        while(p){
+          retired* next = p->next_retired;
+          p->reclaim(p, context);
+          p = next;
+        }
+      }
+
+    private:
+      struct slot
+      {
+        atomic_size_t state;
+        char pad[cache_line_size - sizeof(atomic_size_t)];
+      };
+
+      mutable slot  slots[slot_count];
+      atomic_size_t epoch;
+      char          pad[cache_line_size - sizeof(atomic_size_t)];
+
+      mutex         m;
+      retired*      limbo;
+      size_t        pending;
+      void*         context;
+    };
+
+    /**@} lib_memory */
+  } // ext
+} // std
+
+#endif // NTL__EXT_EPOCH
@@ -0,0 +1,1157 @@
+/**\file*********************************************************************
+ *                                                                     \brief
+ *  Sorted vector associative containers
+ *
+ ****************************************************************************
+ */
+#ifndef NTL__EXT_FLAT_MAP
+#define NTL__EXT_FLAT_MAP
+#pragma once
+
+#include "../vector.hxx"
+#include "../algorithm.hxx"
+#include "../stdexcept_fwd.hxx"
+
+namespace std
+{
+  namespace ext
+  {
+    /**\addtogroup  lib_containers *********** 23 Containers library [containers]
+     *@{*/
+
+    /// Tag: the range is sorted by key and contains no equivalent keys
+    struct sorted_unique_t {};
+    /// Tag: the range is sorted by key
+    struct sorted_equivalent_t {};
+
+    __declare_tag const sorted_unique_t     sorted_unique = {};
+    __declare_tag const sorted_equivalent_t sorted_equivalent = {};
+
+    /**
+     *	@brief Sorted vector containers
+     *
+     *  flat_set, flat_map and their multi variants keep keys (and mapped values) in the separate contiguous vectors,
+     *  sorted by key. Lookups are binary searches over the key vector, iteration is a linear walk over memory.
+     *  Single element insertion and erasure are O(N), so these containers are intended for the data which is built
+     *  once and looked up many times.
+     *
+     *  Bulk construction has two modes:
+     *  - <tt>insert(first, last)</tt> appends the range, sorts the appended part and merges it with the existing one;
+     *  - <tt>insert_deferred(x)</tt> appends a single element without sorting; the pending elements are merged by
+     *    <tt>commit()</tt>. Until then the container may be used only for size(), pending(), reserve(),
+     *    insert_deferred() and commit().
+     *
+     *  For the unique containers the first of the equivalent elements wins, the same way as for \c std::map.
+     **/
+    namespace flat_tree
+    {
+      /** Sorted key vector with the pending (unsorted) tail */
+      template<class Key, class Compare, class Allocator, bool IsUnique>
+      class sorted_keys
+      {
+      public:
+        typedef           Key                                         key_type;
+        typedef           Compare                                     key_compare;
+        typedef           Allocator                                   allocator_type;
+        typedef typename  Allocator::template rebind<Key>::other      key_allocator;
+        typedef           vector<Key, key_allocator>                  key_container_type;
+        typedef typename  key_container_type::size_type               size_type;
+        typedef typename  key_container_type::difference_type         difference_type;
+
+        ///\name capacity
+        bool      empty()    const { return keys_.empty(); }
+        size_type size()     const { return keys_.size(); }
+        size_type max_size() const { return keys_.max_size(); }
+
+        /** Number of the elements inserted by insert_deferred() and not merged yet */
+        size_type pending()  const { return keys_.size() - sorted_; }
+
+        ///\name observers
+        key_compare key_comp() const { return comp_; }
+        allocator_type get_allocator() const { return static_cast<allocator_type>(keys_.get_allocator()); }
+
+        /** Sorted keys */
+        const key_container_type& keys() const { return keys_; }
+        ///\}
+
+      protected:
+        typedef typename Allocator::template rebind<size_type>::other index_allocator;
+        typedef vector<size_type, index_allocator> index_vector;
+
+        explicit sorted_keys(const Compare& comp, const Allocator& a)
+          :keys_(a), comp_(comp), sorted_(0)
+        {}
+
+        sorted_keys(const sorted_keys& x)
+          :keys_(x.keys_), comp_(x.comp_), sorted_(x.sorted_)
+        {}
+
+        sorted_keys& operator=(const sorted_keys& x)
+        {
+          keys_ = x.keys_;
+          comp_ = x.comp_;
+          sorted_ = x.sorted_;
+          return *this;
+        }
+
+        void swap(sorted_keys& x)
+        {
+          using std::swap;
+          keys_.swap(x.keys_);
+          swap(comp_, x.comp_);
+          swap(sorted_, x.sorted_);
+        }
+
+        ///\name lookup by index
+
+        template<class K>
+        size_type lower_bound_index(const K& k) const
+        {
+          assert(pending() == 0);
+          return static_cast<size_type>(std::lower_bound(keys_.begin(), keys_.end(), k, comp_) - keys_.begin());
+        }
+
+        template<class K>
+        size_type upper_bound_index(const K& k) const
+        {
+          assert(pending() == 0);
+          return static_cast<size_type>(std::upper_bound(keys_.begin(), keys_.end(), k, comp_) - keys_.begin());
+        }
+
+        template<class K>
+        size_type find_index(const K& k) const
+        {
+          const size_type i = lower_bound_index(k);
+          return i != keys_.size() && !comp_(k, keys_[i]) ? i : keys_.size();
+        }
+
+        template<class K>
+        pair<size_type, size_type> equal_range_index(const K& k) const
+        {
+          const size_type first = lower_bound_index(k);
+          if(first == keys_.size() || comp_(k, keys_[first]))
+            return make_pair(first, first);
+          if(IsUnique)
+            return make_pair(first, first + 1);
+          size_type last = first;
+          while(++last != keys_.size() && !comp_(k, keys_[last]))
+            ;
+          return make_pair(first, last);
+        }
+
+        /** Position of \c k for insertion, \c keys_.size() is returned if the unique key already exists */
+        size_type insert_index(const Key& k, size_type& found) const
+        {
+          found = keys_.size();
+          if(IsUnique){
+            const size_type i = lower_bound_index(k);
+            if(i != keys_.size() && !comp_(k, keys_[i]))
+              found = i;
+            return i;
+          }
+          return upper_bound_index(k);
+        }
+
+        /** Checks whether the \c hint is a valid insertion place of \c k */
+        bool valid_hint(size_type hint, const Key& k) const
+        {
+          assert(hint <= keys_.size());
+          // keys_[hint-1] < k (<= for multi) and k < keys_[hint] (<= for multi)
+          if(hint != 0 && (IsUnique ? !comp_(keys_[hint-1], k) : comp_(k, keys_[hint-1])))
+            return false;
+          if(hint != keys_.size() && (IsUnique ? !comp_(k, keys_[hint]) : comp_(keys_[hint], k)))
+            return false;
+          return true;
+        }
+
+        ///\name merging of the pending elements
+
+        struct index_compare
+        {
+          const key_container_type& keys;
+          const Compare& comp;
+
+          index_compare(const key_container_type& keys, const Compare& comp)
+            :keys(keys), comp(comp)
+          {}
+          bool operator()(size_type x, size_type y) const { return comp(keys[x], keys[y]); }
+        private:
+          index_compare& operator=(const index_compare&);
+        };
+
+        /**
+         *	@brief Computes the order of elements after the merge of pending ones.
+         *
+         *  The elements before the returned position stay in place, \c order holds the source indices
+         *  of the elements starting from this position. Dropped duplicates are not included.
+         *
+         *	@param[in] presorted the pending elements are already sorted by key
+         **/
+        size_type merge_order(index_vector& order, bool presorted) const
+        {
+          const size_type n = sorted_, total = keys_.size();
+          index_vector tail(total - n, size_type(), static_cast<index_allocator>(keys_.get_allocator()));
+          for(size_type i = 0; i != tail.size(); ++i)
+            tail[i] = n + i;
+          if(!presorted)
+            std::stable_sort(tail.begin(), tail.end(), index_compare(keys_, comp_));
+
+          // the existing elements which are not greater than the smallest pending one are untouched
+          const size_type start = static_cast<size_type>(
+            std::upper_bound(keys_.begin(), keys_.begin() + n, keys_[tail.front()], comp_) - keys_.begin());
+
+          order.reserve(total - start);
+          size_type i = start, j = 0;
+          const size_type m = tail.size();
+          while(i < n || j < m){
+            // the existing element wins among the equivalent ones
+            const size_type src = (j == m || (i < n && !comp_(keys_[tail[j]], keys_[i]))) ? i++ : tail[j++];
+            if(IsUnique && (start != 0 || !order.empty())){
+              // drop the element equivalent to the previous one
+              const Key& prev = keys_[order.empty() ? start - 1 : order.back()];
+              if(!comp_(prev, keys_[src]))
+                continue;
+            }
+            order.push_back(src);
+          }
+          return start;
+        }
+
+        /** Reorders \c c according to the \c order computed by merge_order() */
+        template<class Container>
+        static void apply_order(Container& c, size_type start, const index_vector& order)
+        {
+          bool ascending = true;
+          for(size_type i = 0; i != order.size(); ++i){
+            if(order[i] < start + i || (i && order[i] <= order[i-1])){
+              ascending = false;
+              break;
+            }
+          }
+          if(ascending){
+            // compact in place: order[i] >= start + i
+            for(size_type i = 0; i != order.size(); ++i)
+              if(order[i] != start + i)
+                c[start + i] = std::move(c[order[i]]);
+            c.erase(c.begin() + (start + order.size()), c.end());
+            return;
+          }
+          Container tmp(c.get_allocator());
+          tmp.reserve(start + order.size());
+          for(size_type i = 0; i != start; ++i)
+            tmp.push_back(std::move(c[i]));
+          for(size_type i = 0; i != order.size(); ++i)
+            tmp.push_back(std::move(c[order[i]]));
+          c.swap(tmp);
+        }
+        ///\}
+
+      protected:
+        key_container_type keys_;
+        Compare   comp_;
+        size_type sorted_;
+      };
+
+
+      /** Reference to the element of flat_map */
+      template<class Key, class T>
+      struct pair_reference
+      {
+        const Key&  first;
+        T&          second;
+
+        pair_reference(const Key& k, T& v)
+          :first(k), second(v)
+        {}
+
+        template<class T2>
+        pair_reference(const pair_reference<Key, T2>& r)
+          :first(r.first), second(r.second)
+        {}
+
+        operator pair<Key, typename remove_const<T>::type>() const
+        {
+          return pair<Key, typename remove_const<T>::type>(first, second);
+        }
+
+        /** serves as the iterator's pointer */
+        const pair_reference* operator->() const { return this; }
+      private:
+        pair_reference& operator=(const pair_reference&);
+      };
+
+
+      /** Random access iterator over the parallel key and value vectors */
+      template<class Key, class T, class Mapped, class Distance>
+      class map_iterator:
+        public std::iterator<random_access_iterator_tag, pair<Key, T>, Distance, pair_reference<Key, Mapped>, pair_reference<Key, Mapped> >
+      {
+        template<class, class, class, class> friend class map_iterator;
+      public:
+        typedef pair_reference<Key, Mapped> reference;
+        typedef pair_reference<Key, Mapped> pointer;
+        typedef Distance                    difference_type;
+
+        map_iterator()
+          :k(), v()
+        {}
+        map_iterator(const Key* k, Mapped* v)
+          :k(k), v(v)
+        {}
+        /** iterator to const_iterator conversion */
+        template<class M2>
+        map_iterator(const map_iterator<Key, T, M2, Distance>& i, typename enable_if<is_same<const M2, Mapped>::value>::type* = 0)
+          :k(i.k), v(i.v)
+        {}
+
+        reference operator* () const { return reference(*k, *v); }
+        pointer   operator->() const { return reference(*k, *v); }
+        reference operator[](difference_type n) const { return reference(k[n], v[n]); }
+
+        map_iterator& operator++()    { ++k, ++v; return *this; }
+        map_iterator& operator--()    { --k, --v; return *this; }
+        map_iterator  operator++(int) { map_iterator tmp(*this); ++*this; return tmp; }
+        map_iterator  operator--(int) { map_iterator tmp(*this); --*this; return tmp; }
+
+        map_iterator& operator+=(difference_type n) { k += n, v += n; return *this; }
+        map_iterator& operator-=(difference_type n) { k -= n, v -= n; return *this; }
+
+        friend map_iterator operator+(map_iterator i, difference_type n) { return i += n; }
+        friend map_iterator operator+(difference_type n, map_iterator i) { return i += n; }
+        friend map_iterator operator-(map_iterator i, difference_type n) { return i -= n; }
+        friend difference_type operator-(const map_iterator& x, const map_iterator& y) { return x.k - y.k; }
+
+        friend bool operator==(const map_iterator& x, const map_iterator& y) { return x.k == y.k; }
+        friend bool operator!=(const map_iterator& x, const map_iterator& y) { return x.k != y.k; }
+        friend bool operator< (const map_iterator& x, const map_iterator& y) { return x.k <  y.k; }
+        friend bool operator> (const map_iterator& x, const map_iterator& y) { return x.k >  y.k; }
+        friend bool operator<=(const map_iterator& x, const map_iterator& y) { return x.k <= y.k; }
+        friend bool operator>=(const map_iterator& x, const map_iterator& y) { return x.k >= y.k; }
+
+        /** key of the current element */
+        const Key* key() const { return k; }
+      private:
+        const Key* k;
+        Mapped*    v;
+      };
+
+
+      /** Base of flat_set and flat_multiset */
+      template<class Key, class Compare, class Allocator, bool IsUnique>
+      class set_base:
+        public sorted_keys<Key, Compare, Allocator, IsUnique>
+      {
+        typedef sorted_keys<Key, Compare, Allocator, IsUnique> base;
+        typedef typename base::index_vector index_vector;
+      public:
+        ///\name types
+        typedef           Key                                   value_type;
+        typedef           Compare                               value_compare;
+        typedef typename  base::key_allocator::pointer          pointer;
+        typedef typename  base::key_allocator::const_pointer    const_pointer;
+        typedef const     value_type&                           reference;
+        typedef const     value_type&                           const_reference;
+        typedef typename  base::size_type                       size_type;
+        typedef typename  base::difference_type                 difference_type;
+
+        typedef           const_pointer                         iterator;
+        typedef           const_pointer                         const_iterator;
+        typedef std::reverse_iterator<iterator>                 reverse_iterator;
+        typedef std::reverse_iterator<const_iterator>           const_reverse_iterator;
+
+        ///\name iterators
+        iterator                begin()  const { assert(this->pending() == 0); return this->keys_.begin(); }
+        iterator                end()    const { return this->keys_.end(); }
+        reverse_iterator        rbegin() const { return reverse_iterator(end()); }
+        reverse_iterator        rend()   const { return reverse_iterator(begin()); }
+        const_iterator          cbegin() const { return begin(); }
+        const_iterator          cend()   const { return end(); }
+        const_reverse_iterator  crbegin()const { return rbegin(); }
+        const_reverse_iterator  crend()  const { return rend(); }
+
+        ///\name observers
+        value_compare value_comp() const { return this->comp_; }
+
+        ///\name lookup
+        iterator find(const Key& x) const                     { return begin() + this->find_index(x); }
+        size_type count(const Key& x) const                   { pair<size_type,size_type> r = this->equal_range_index(x); return r.second - r.first; }
+        bool contains(const Key& x) const                     { return this->find_index(x) != this->size(); }
+        iterator lower_bound(const Key& x) const              { return begin() + this->lower_bound_index(x); }
+        iterator upper_bound(const Key& x) const              { return begin() + this->upper_bound_index(x); }
+        pair<iterator, iterator> equal_range(const Key& x) const
+        {
+          pair<size_type,size_type> r = this->equal_range_index(x);
+          return make_pair(begin() + r.first, begin() + r.second);
+        }
+
+        template<class K>
+        typename enable_if<std::__::is_transparent<Compare, K>::value, iterator>::type find(const K& x) const
+        { return begin() + this->find_index(x); }
+        template<class K>
+        typename enable_if<std::__::is_transparent<Compare, K>::value, size_type>::type count(const K& x) const
+        { pair<size_type,size_type> r = this->equal_range_index(x); return r.second - r.first; }
+        template<class K>
+        typename enable_if<std::__::is_transparent<Compare, K>::value, bool>::type contains(const K& x) const
+        { return this->find_index(x) != this->size(); }
+        template<class K>
+        typename enable_if<std::__::is_transparent<Compare, K>::value, iterator>::type lower_bound(const K& x) const
+        { return begin() + this->lower_bound_index(x); }
+        template<class K>
+        typename enable_if<std::__::is_transparent<Compare, K>::value, iterator>::type upper_bound(const K& x) const
+        { return begin() + this->upper_bound_index(x); }
+        template<class K>
+        typename enable_if<std::__::is_transparent<Compare, K>::value, pair<iterator, iterator> >::type equal_range(const K& x) const
+        {
+          pair<size_type,size_type> r = this->equal_range_index(x);
+          return make_pair(begin() + r.first, begin() + r.second);
+        }
+
+        ///\name modifiers
+        iterator erase(const_iterator position)
+        {
+          assert(this->pending() == 0);
+          const size_type i = position - begin();
+          this->keys_.erase(this->keys_.begin() + i);
+          this->sorted_--;
+          return begin() + i;
+        }
+
+        iterator erase(const_iterator first, const_iterator last)
+        {
+          assert(this->pending() == 0);
+          const size_type i = first - begin(), n = last - first;
+          this->keys_.erase(this->keys_.begin() + i, this->keys_.begin() + (i + n));
+          this->sorted_ -= n;
+          return begin() + i;
+        }
+
+        size_type erase(const Key& x)
+        {
+          pair<size_type,size_type> r = this->equal_range_index(x);
+          erase(begin() + r.first, begin() + r.second);
+          return r.second - r.first;
+        }
+
+        void clear()
+        {
+          this->keys_.clear();
+          this->sorted_ = 0;
+        }
+
+        void reserve(size_type n)   { this->keys_.reserve(n); }
+        void shrink_to_fit()        { this->keys_.shrink_to_fit(); }
+
+        /** Appends \c x without sorting, see commit() */
+        void insert_deferred(const value_type& x)
+        {
+          this->keys_.push_back(x);
+        }
+        #ifdef NTL_CXX_RV
+        void insert_deferred(value_type&& x)
+        {
+          this->keys_.push_back(std::move(x));
+        }
+        #endif
+
+        /** Sorts and merges the elements added by insert_deferred() */
+        void commit()
+        {
+          merge_pending(false);
+        }
+        ///\}
+
+      protected:
+        explicit set_base(const Compare& comp, const Allocator& a)
+          :base(comp, a)
+        {}
+
+        template<class InputIterator>
+        void insert_range(InputIterator first, InputIterator last)
+        {
+          assert(this->pending() == 0);
+          for(; first != last; ++first)
+            this->keys_.push_back(*first);
+          merge_pending(false);
+        }
+
+        template<class InputIterator>
+        void insert_sorted(InputIterator first, InputIterator last)
+        {
+          assert(this->pending() == 0);
+          for(; first != last; ++first)
+            this->keys_.push_back(*first);
+          merge_pending(true);
+        }
+
+        pair<iterator, bool> insert_value(const value_type& x)
+        {
+          size_type found;
+          const size_type i = this->insert_index(x, found);
+          if(found != this->size())
+            return make_pair(begin() + found, false);
+          this->keys_.insert(this->keys_.begin() + i, x);
+          this->sorted_++;
+          return make_pair(begin() + i, true);
+        }
+
+        pair<iterator, bool> insert_value(const_iterator hint, const value_type& x)
+        {
+          const size_type i = hint - begin();
+          if(!this->valid_hint(i, x))
+            return insert_value(x);
+          this->keys_.insert(this->keys_.begin() + i, x);
+          this->sorted_++;
+          return make_pair(begin() + i, true);
+        }
+
+        #ifdef NTL_CXX_RV
+        pair<iterator, bool> insert_value(value_type&& x)
+        {
+          size_type found;
+          const size_type i = this->insert_index(x, found);
+          if(found != this->size())
+            return make_pair(begin() + found, false);
+          this->keys_.insert(this->keys_.begin() + i, std::move(x));
+          this->sorted_++;
+          return make_pair(begin() + i, true);
+        }
+        #endif
+
+        void merge_pending(bool presorted)
+        {
+          if(this->pending() == 0)
+            return;
+          index_vector order(static_cast<typename base::index_allocator>(this->keys_.get_allocator()));
+          const size_type start = this->merge_order(order, presorted);
+          this->apply_order(this->keys_, start, order);
+          this->sorted_ = this->keys_.size();
+        }
+      };
+
+
+      /** Base of flat_map and flat_multimap */
+      template<class Key, class T, class Compare, class Allocator, bool IsUnique>
+      class map_base:
+        public sorted_keys<Key, Compare, Allocator, IsUnique>
+      {
+        typedef sorted_keys<Key, Compare, Allocator, IsUnique> base;
+        typedef typename base::index_vector index_vector;
+      public:
+        ///\name types
+        typedef           T                                           mapped_type;
+        typedef           pair<Key, T>                                value_type;
+        typedef typename  Allocator::template rebind<T>::other        mapped_allocator;
+        typedef           vector<T, mapped_allocator>                 mapped_container_type;
+        typedef typename  base::size_type                             size_type;
+        typedef typename  base::difference_type                       difference_type;
+
+        typedef           pair_reference<Key, T>                      reference;
+        typedef           pair_reference<Key, const T>                const_reference;
+        typedef           map_iterator<Key, T, T, difference_type>        iterator;
+        typedef           map_iterator<Key, T, const T, difference_type>  const_iterator;
+        typedef           iterator                                    pointer;
+        typedef           const_iterator                              const_pointer;
+        typedef std::reverse_iterator<iterator>                       reverse_iterator;
+        typedef std::reverse_iterator<const_iterator>                 const_reverse_iterator;
+
+        class value_compare:
+          public binary_function<value_type, value_type, bool>
+        {
+          friend class map_base;
+        public:
+          bool operator()(const value_type& x, const value_type& y) const
+          {
+            return comp(x.first, y.first);
+          }
+        protected:
+          Compare comp;
+          value_compare(Compare c) : comp(c) {}
+        };
+
+        ///\name iterators
+        iterator                begin()        { assert(this->pending() == 0); return iterator(this->keys_.begin(), values_.begin()); }
+        const_iterator          begin()  const { assert(this->pending() == 0); return const_iterator(this->keys_.begin(), values_.begin()); }
+        iterator                end()          { return iterator(this->keys_.end(), values_.end()); }
+        const_iterator          end()    const { return const_iterator(this->keys_.end(), values_.end()); }
+
+        reverse_iterator        rbegin()       { return reverse_iterator(end()); }
+        const_reverse_iterator  rbegin() const { return const_reverse_iterator(end()); }
+        reverse_iterator        rend()         { return reverse_iterator(begin()); }
+        const_reverse_iterator  rend()   const { return const_reverse_iterator(begin()); }
+
+        const_iterator          cbegin() const { return begin(); }
+        const_iterator          cend()   const { return end(); }
+        const_reverse_iterator  crbegin()const { return rbegin(); }
+        const_reverse_iterator  crend()  const { return rend(); }
+
+        ///\name observers
+        value_compare value_comp() const { return value_compare(this->comp_); }
+
+        /** Mapped values in the order of keys() */
+        const mapped_container_type& values() const { return values_; }
+
+        ///\name lookup
+        iterator        find(const Key& x)              { return begin() + this->find_index(x); }
+        const_iterator  find(const Key& x) const        { return begin() + this->find_index(x); }
+        size_type       count(const Key& x) const       { pair<size_type,size_type> r = this->equal_range_index(x); return r.second - r.first; }
+        bool            contains(const Key& x) const    { return this->find_index(x) != this->size(); }
+        iterator        lower_bound(const Key& x)       { return begin() + this->lower_bound_index(x); }
+        const_iterator  lower_bound(const Key& x) const { return begin() + this->lower_bound_index(x); }
+        iterator        upper_bound(const Key& x)       { return begin() + this->upper_bound_index(x); }
+        const_iterator  upper_bound(const Key& x) const { return begin() + this->upper_bound_index(x); }
+
+        pair<iterator, iterator> equal_range(const Key& x)
+        {
+          pair<size_type,size_type> r = this->equal_range_index(x);
+          return make_pair(begin() + r.first, begin() + r.second);
+        }
+        pair<const_iterator, const_iterator> equal_range(const Key& x) const
+        {
+          pair<size_type,size_type> r = this->equal_range_index(x);
+          return make_pair(begin() + r.first, begin() + r.second);
+        }
+
+        template<class K>
+        typename enable_if<std::__::is_transparent<Compare, K>::value, iterator>::type find(const K& x)
+        { return begin() + this->find_index(x); }
+        template<class K>
+        typename enable_if<std::__::is_transparent<Compare, K>::value, const_iterator>::type find(const K& x) const
+        { return begin() + this->find_index(x); }
+        template<class K>
+        typename enable_if<std::__::is_transparent<Compare, K>::value, size_type>::type count(const K& x) const
+        { pair<size_type,size_type> r = this->equal_range_index(x); return r.second - r.first; }
+        template<class K>
+        typename enable_if<std::__::is_transparent<Compare, K>::value, bool>::type contains(const K& x) const
+        { return this->find_index(x) != this->size(); }
+        template<class K>
+        typename enable_if<std::__::is_transparent<Compare, K>::value, iterator>::type lower_bound(const K& x)
+        { return begin() + this->lower_bound_index(x); }
+        template<class K>
+        typename enable_if<std::__::is_transparent<Compare, K>::value, const_iterator>::type lower_bound(const K& x) const
+        { return begin() + this->lower_bound_index(x); }
+        template<class K>
+        typename enable_if<std::__::is_transparent<Compare, K>::value, iterator>::type upper_bound(const K& x)
+        { return begin() + this->upper_bound_index(x); }
+        template<class K>
+        typename enable_if<std::__::is_transparent<Compare, K>::value, const_iterator>::type upper_bound(const K& x) const
+        { return begin() + this->upper_bound_index(x); }
+        template<class K>
+        typename enable_if<std::__::is_transparent<Compare, K>::value, pair<iterator, iterator> >::type equal_range(const K& x)
+        {
+          pair<size_type,size_type> r = this->equal_range_index(x);
+          return make_pair(begin() + r.first, begin() + r.second);
+        }
+        template<class K>
+        typename enable_if<std::__::is_transparent<Compare, K>::value, pair<const_iterator, const_iterator> >::type equal_range(const K& x) const
+        {
+          pair<size_type,size_type> r = this->equal_range_index(x);
+          return make_pair(begin() + r.first, begin() + r.second);
+        }
+
+        ///\name modifiers
+        iterator erase(const_iterator position)
+        {
+          assert(this->pending() == 0);
+          const size_type i = position.key() - this->keys_.begin();
+          this->keys_.erase(this->keys_.begin() + i);
+          values_.erase(values_.begin() + i);
+          this->sorted_--;
+          return begin() + i;
+        }
+
+        iterator erase(const_iterator first, const_iterator last)
+        {
+          assert(this->pending() == 0);
+          const size_type i = first.key() - this->keys_.begin(), n = last - first;
+          this->keys_.erase(this->keys_.begin() + i, this->keys_.begin() + (i + n));
+          values_.erase(values_.begin() + i, values_.begin() + (i + n));
+          this->sorted_ -= n;
+          return begin() + i;
+        }
+
+        size_type erase(const Key& x)
+        {
+          pair<size_type,size_type> r = this->equal_range_index(x);
+          erase(cbegin() + r.first, cbegin() + r.second);
+          return r.second - r.first;
+        }
+
+        void clear()
+        {
+          this->keys_.clear();
+          values_.clear();
+          this->sorted_ = 0;
+        }
+
+        void reserve(size_type n)
+        {
+          this->keys_.reserve(n);
+          values_.reserve(n);
+        }
+
+        void shrink_to_fit()
+        {
+          this->keys_.shrink_to_fit();
+          values_.shrink_to_fit();
+        }
+
+        /** Appends \c x without sorting, see commit() */
+        void insert_deferred(const value_type& x)
+        {
+          append(x.first, x.second);
+        }
+
+        /** Sorts and merges the elements added by insert_deferred() */
+        void commit()
+        {
+          merge_pending(false);
+        }
+        ///\}
+
+      protected:
+        explicit map_base(const Compare& comp, const Allocator& a)
+          :base(comp, a), values_(a)
+        {}
+
+        map_base(const map_base& x)
+          :base(x), values_(x.values_)
+        {}
+
+        map_base& operator=(const map_base& x)
+        {
+          base::operator=(x);
+          values_ = x.values_;
+          return *this;
+        }
+
+        void swap(map_base& x)
+        {
+          base::swap(x);
+          values_.swap(x.values_);
+        }
+
+        void append(const Key& k, const T& v)
+        {
+          this->keys_.push_back(k);
+          __ntl_try {
+            values_.push_back(v);
+          }
+          __ntl_catch(...){
+            this->keys_.pop_back();
+            __ntl_rethrow;
+          }
+        }
+
+        template<class InputIterator>
+        void insert_range(InputIterator first, InputIterator last)
+        {
+          assert(this->pending() == 0);
+          for(; first != last; ++first)
+            append((*first).first, (*first).second);
+          merge_pending(false);
+        }
+
+        template<class InputIterator>
+        void insert_sorted(InputIterator first, InputIterator last)
+        {
+          assert(this->pending() == 0);
+          for(; first != last; ++first)
+            append((*first).first, (*first).second);
+          merge_pending(true);
+        }
+
+        iterator insert_at(size_type i, const Key& k, const T& v)
+        {
+          this->keys_.insert(this->keys_.begin() + i, k);
+          __ntl_try {
+            values_.insert(values_.begin() + i, v);
+          }
+          __ntl_catch(...){
+            this->keys_.erase(this->keys_.begin() + i);
+            __ntl_rethrow;
+          }
+          this->sorted_++;
+          return begin() + i;
+        }
+
+        pair<iterator, bool> insert_value(const value_type& x)
+        {
+          size_type found;
+          const size_type i = this->insert_index(x.first, found);
+          if(found != this->size())
+            return make_pair(begin() + found, false);
+          return make_pair(insert_at(i, x.first, x.second), true);
+        }
+
+        pair<iterator, bool> insert_value(const_iterator hint, const value_type& x)
+        {
+          const size_type i = hint.key() - this->keys_.begin();
+          if(!this->valid_hint(i, x.first))
+            return insert_value(x);
+          return make_pair(insert_at(i, x.first, x.second), true);
+        }
+
+        T& subscript(const Key& k)
+        {
+          size_type found;
+          const size_type i = this->insert_index(k, found);
+          if(found != this->size())
+            return values_[found];
+          insert_at(i, k, T());
+          return values_[i];
+        }
+
+        void merge_pending(bool presorted)
+        {
+          if(this->pending() == 0)
+            return;
+          index_vector order(static_cast<typename base::index_allocator>(this->keys_.get_allocator()));
+          const size_type start = this->merge_order(order, presorted);
+          this->apply_order(values_, start, order);
+          this->apply_order(this->keys_, start, order);
+          this->sorted_ = this->keys_.size();
+        }
+
+      protected:
+        mapped_container_type values_;
+      };
+
+      template<class Base>
+      inline bool equal_ranges(const Base& x, const Base& y)
+      {
+        return x.size() == y.size() && std::equal(x.cbegin(), x.cend(), y.cbegin());
+      }
+    } // flat_tree
+
+
+    /// Unique keys set over a sorted vector
+    template<class Key, class Compare = less<Key>, class Allocator = allocator<Key> >
+    class flat_set:
+      public flat_tree::set_base<Key, Compare, Allocator, true>
+    {
+      typedef flat_tree::set_base<Key, Compare, Allocator, true> base;
+    public:
+      typedef typename base::iterator       iterator;
+      typedef typename base::const_iterator const_iterator;
+      typedef typename base::value_type     value_type;
+
+      ///\name construct/copy/destroy
+      explicit flat_set(const Compare& comp = Compare(), const Allocator& a = Allocator())
+        :base(comp, a)
+      {}
+
+      template<class InputIterator>
+      flat_set(InputIterator first, InputIterator last, const Compare& comp = Compare(), const Allocator& a = Allocator())
+        :base(comp, a)
+      {
+        base::insert_range(first, last);
+      }
+
+      template<class InputIterator>
+      flat_set(sorted_unique_t, InputIterator first, InputIterator last, const Compare& comp = Compare(), const Allocator& a = Allocator())
+        :base(comp, a)
+      {
+        base::insert_sorted(first, last);
+      }
+
+      flat_set(initializer_list<value_type> il, const Compare& comp = Compare(), const Allocator& a = Allocator())
+        :base(comp, a)
+      {
+        base::insert_range(il.begin(), il.end());
+      }
+
+      flat_set& operator=(initializer_list<value_type> il)
+      {
+        base::clear();
+        base::insert_range(il.begin(), il.end());
+        return *this;
+      }
+
+      ///\name modifiers
+      pair<iterator, bool> insert(const value_type& x)          { return base::insert_value(x); }
+      iterator insert(const_iterator hint, const value_type& x) { return base::insert_value(hint, x).first; }
+      #ifdef NTL_CXX_RV
+      pair<iterator, bool> insert(value_type&& x)               { return base::insert_value(std::move(x)); }
+      #endif
+      #ifdef NTL_CXX_VT
+      template<class... Args>
+      pair<iterator, bool> emplace(Args&&... args)              { return base::insert_value(value_type(std::forward<Args>(args)...)); }
+      #endif
+
+      /** Appends the range, sorts and merges it */
+      template<class InputIterator>
+      void insert(InputIterator first, InputIterator last)      { base::insert_range(first, last); }
+      /** Appends the range which is already sorted and unique */
+      template<class InputIterator>
+      void insert(sorted_unique_t, InputIterator first, InputIterator last) { base::insert_sorted(first, last); }
+      void insert(initializer_list<value_type> il)              { base::insert_range(il.begin(), il.end()); }
+
+      void swap(flat_set& x)                                    { base::swap(x); }
+    };
+
+    /// Equivalent keys set over a sorted vector
+    template<class Key, class Compare = less<Key>, class Allocator = allocator<Key> >
+    class flat_multiset:
+      public flat_tree::set_base<Key, Compare, Allocator, false>
+    {
+      typedef flat_tree::set_base<Key, Compare, Allocator, false> base;
+    public:
+      typedef typename base::iterator       iterator;
+      typedef typename base::const_iterator const_iterator;
+      typedef typename base::value_type     value_type;
+
+      ///\name construct/copy/destroy
+      explicit flat_multiset(const Compare& comp = Compare(), const Allocator& a = Allocator())
+        :base(comp, a)
+      {}
+
+      template<class InputIterator>
+      flat_multiset(InputIterator first, InputIterator last, const Compare& comp = Compare(), const Allocator& a = Allocator())
+        :base(comp, a)
+      {
+        base::insert_range(first, last);
+      }
+
+      template<class InputIterator>
+      flat_multiset(sorted_equivalent_t, InputIterator first, InputIterator last, const Compare& comp = Compare(), const Allocator& a = Allocator())
+        :base(comp, a)
+      {
+        base::insert_sorted(first, last);
+      }
+
+      flat_multiset(initializer_list<value_type> il, const Compare& comp = Compare(), const Allocator& a = Allocator())
+        :base(comp, a)
+      {
+        base::insert_range(il.begin(), il.end());
+      }
+
+      flat_multiset& operator=(initializer_list<value_type> il)
+      {
+        base::clear();
+        base::insert_range(il.begin(), il.end());
+        return *this;
+      }
+
+      ///\name modifiers
+      iterator insert(const value_type& x)                      { return base::insert_value(x).first; }
+      iterator insert(const_iterator hint, const value_type& x) { return base::insert_value(hint, x).first; }
+      #ifdef NTL_CXX_RV
+      iterator insert(value_type&& x)                           { return base::insert_value(std::move(x)).first; }
+      #endif
+      #ifdef NTL_CXX_VT
+      template<class... Args>
+      iterator emplace(Args&&... args)                          { return base::insert_value(value_type(std::forward<Args>(args)...)).first; }
+      #endif
+
+      /** Appends the range, sorts and merges it */
+      template<class InputIterator>
+      void insert(InputIterator first, InputIterator last)      { base::insert_range(first, last); }
+      /** Appends the range which is already sorted */
+      template<class InputIterator>
+      void insert(sorted_equivalent_t, InputIterator first, InputIterator last) { base::insert_sorted(first, last); }
+      void insert(initializer_list<value_type> il)              { base::insert_range(il.begin(), il.end()); }
+
+      void swap(flat_multiset& x)                               { base::swap(x); }
+    };
+
+
+    /// Unique keys map over the sorted key and value vectors
+    template<class Key, class T, class Compare = less<Key>, class Allocator = allocator<pair<Key, T> > >
+    class flat_map:
+      public flat_tree::map_base<Key, T, Compare, Allocator, true>
+    {
+      typedef flat_tree::map_base<Key, T, Compare, Allocator, true> base;
+    public:
+      typedef typename base::iterator       iterator;
+      typedef typename base::const_iterator const_iterator;
+      typedef typename base::value_type     value_type;
+
+      ///\name construct/copy/destroy
+      explicit flat_map(const Compare& comp = Compare(), const Allocator& a = Allocator())
+        :base(comp, a)
+      {}
+
+      template<class InputIterator>
+      flat_map(InputIterator first, InputIterator last, const Compare& comp = Compare(), const Allocator& a = Allocator())
+        :base(comp, a)
+      {
+        base::insert_range(first, last);
+      }
+
+      template<class InputIterator>
+      flat_map(sorted_unique_t, InputIterator first, InputIterator last, const Compare& comp = Compare(), const Allocator& a = Allocator())
+        :base(comp, a)
+      {
+        base::insert_sorted(first, last);
+      }
+
+      flat_map(initializer_list<value_type> il, const Compare& comp = Compare(), const Allocator& a = Allocator())
+        :base(comp, a)
+      {
+        base::insert_range(il.begin(), il.end());
+      }
+
+      flat_map& operator=(initializer_list<value_type> il)
+      {
+        base::clear();
+        base::insert_range(il.begin(), il.end());
+        return *this;
+      }
+
+      ///\name element access
+      T& operator[](const Key& k) { return base::subscript(k); }
+
+      T& at(const Key& k)
+      {
+        const typename base::size_type i = base::find_index(k);
+        if(i == base::size())
+          __throw_out_of_range(__name__": no such element");
+        return base::values_[i];
+      }
+      const T& at(const Key& k) const
+      {
+        const typename base::size_type i = base::find_index(k);
+        if(i == base::size())
+          __throw_out_of_range(__name__": no such element");
+        return base::values_[i];
+      }
+
+      ///\name modifiers
+      pair<iterator, bool> insert(const value_type& x)          { return base::insert_value(x); }
+      iterator insert(const_iterator hint, const value_type& x) { return base::insert_value(hint, x).first; }
+      #ifdef NTL_CXX_VT
+      template<class... Args>
+      pair<iterator, bool> emplace(Args&&... args)              { return base::insert_value(value_type(std::forward<Args>(args)...)); }
+      #endif
+
+      /** Appends the range, sorts and merges it */
+      template<class InputIterator>
+      void insert(InputIterator first, InputIterator last)      { base::insert_range(first, last); }
+      /** Appends the range which is already sorted and unique */
+      template<class InputIterator>
+      void insert(sorted_unique_t, InputIterator first, InputIterator last) { base::insert_sorted(first, last); }
+      void insert(initializer_list<value_type> il)              { base::insert_range(il.begin(), il.end()); }
+
+      void swap(flat_map& x)                                    { base::swap(x); }
+    };
+
+    /// Equivalent keys map over the sorted key and value vectors
+    template<class Key, class T, class Compare = less<Key>, class Allocator = allocator<pair<Key, T> > >
+    class flat_multimap:
+      public flat_tree::map_base<Key, T, Compare, Allocator, false>
+    {
+      typedef flat_tree::map_base<Key, T, Compare, Allocator, false> base;
+    public:
+      typedef typename base::iterator       iterator;
+      typedef typename base::const_iterator const_iterator;
+      typedef typename base::value_type     value_type;
+
+      ///\name construct/copy/destroy
+      explicit flat_multimap(const Compare& comp = Compare(), const Allocator& a = Allocator())
+        :base(comp, a)
+      {}
+
+      template<class InputIterator>
+      flat_multimap(InputIterator first, InputIterator last, const Compare& comp = Compare(), const Allocator& a = Allocator())
+        :base(comp, a)
+      {
+        base::insert_range(first, last);
+      }
+
+      template<class InputIterator>
+      flat_multimap(sorted_equivalent_t, InputIterator first, InputIterator last, const Compare& comp = Compare(), const Allocator& a = Allocator())
+        :base(comp, a)
+      {
+        base::insert_sorted(first, last);
+      }
+
+      flat_multimap(initializer_list<value_type> il, const Compare& comp = Compare(), const Allocator& a = Allocator())
+        :base(comp, a)
+      {
+        base::insert_range(il.begin(), il.end());
+      }
+
+      flat_multimap& operator=(initializer_list<value_type> il)
+      {
+        base::clear();
+        base::insert_range(il.begin(), il.end());
+        return *this;
+      }
+
+      ///\name modifiers
+      iterator insert(const value_type& x)                      { return base::insert_value(x).first; }
+      iterator insert(const_iterator hint, const value_type& x) { return base::insert_value(hint, x).first; }
+      #ifdef NTL_CXX_VT
+      template<class... Args>
+      iterator emplace(Args&&... args)                          { return base::insert_value(value_type(std::forward<Args>(args)...)).first; }
+      #endif
+
+      /** Appends the range, sorts and merges it */
+      template<class InputIterator>
+      void insert(InputIterator first, InputIterator last)      { base::insert_range(first, last); }
+      /** Appends the range which is already sorted */
+      template<class InputIterator>
+      void insert(sorted_equivalent_t, InputIterator first, InputIterator last) { base::insert_sorted(first, last); }
+      void insert(initializer_list<value_type> il)              { base::insert_range(il.begin(), il.end()); }
+
+      void swap(flat_multimap& x)                               { base::swap(x); }
+    };
+
+    ///\name comparisons
+    template<class Key, class Compare, class Allocator>
+    inline bool operator==(const flat_set<Key, Compare, Allocator>& x, const flat_set<Key, Compare, Allocator>& y)
+    {
+      return flat_tree::equal_ranges(x, y);
+    }
+    template<class Key, class Compare, class Allocator>
+    inline bool operator!=(const flat_set<Key, Compare, Allocator>& x, const flat_set<Key, Compare, Allocator>& y)
+    {
+      return !(x == y);
+    }
+    template<class Key, class Compare, class Allocator>
+    inline bool operator==(const flat_multiset<Key, Compare, Allocator>& x, const flat_multiset<Key, Compare, Allocator>& y)
+    {
+      return flat_tree::equal_ranges(x, y);
+    }
+    template<class Key, class Compare, class Allocator>
+    inline bool operator!=(const flat_multiset<Key, Compare, Allocator>& x, const flat_multiset<Key, Compare, Allocator>& y)
+    {
+      return !(x == y);
+    }
+    template<class Key, class T, class Compare, class Allocator>
+    inline bool operator==(const flat_map<Key, T, Compare, Allocator>& x, const flat_map<Key, T, Compare, Allocator>& y)
+    {
+      return x.keys() == y.keys() && x.values() == y.values();
+    }
+    template<class Key, class T, class Compare, class Allocator>
+    inline bool operator!=(const flat_map<Key, T, Compare, Allocator>& x, const flat_map<Key, T, Compare, Allocator>& y)
+    {
+      return !(x == y);
+    }
+    template<class Key, class T, class Compare, class Allocator>
+    inline bool operator==(const flat_multimap<Key, T, Compare, Allocator>& x, const flat_multimap<Key, T, Compare, Allocator>& y)
+    {
+      return x.keys() == y.keys() && x.values() == y.values();
+    }
+    template<class Key, class T, class Compare, class Allocator>
+    inline bool operator!=(const flat_multimap<Key, T, Compare, Allocator>& x, const flat_multimap<Key, T, Compare, Allocator>& y)
+    {
+      return !(x == y);
+    }
+
+    ///\name specialized algorithms
+    template<class Key, class Compare, class Allocator>
+    inline void swap(flat_set<Key, Compare, Allocator>& x, flat_set<Key, Compare, Allocator>& y)            { x.swap(y); }
+    template<class Key, class Compare, class Allocator>
+    inline void swap(flat_multiset<Key, Compare, Allocator>& x, flat_multiset<Key, Compare, Allocator>& y)  { x.swap(y); }
+    template<class Key, class T, class Compare, class Allocator>
+    inline void swap(flat_map<Key, T, Compare, Allocator>& x, flat_map<Key, T, Compare, Allocator>& y)          { x.swap(y); }
+    template<class Key, class T, class Compare, class Allocator>
+    inline void swap(flat_multimap<Key, T, Compare, Allocator>& x, flat_multimap<Key, T, Compare, Allocator>& y){ x.swap(y); }
+    ///\}
+
+    /**@} lib_containers */
+  } // ext
+} // std
+
+#endif // NTL__EXT_FLAT_MAP
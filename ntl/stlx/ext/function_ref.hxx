@@ -0,0 +1,210 @@
+/**\file*********************************************************************
+ *                                                                     \brief
+ *  Non-owning reference to a callable
+ *
+ ****************************************************************************
+ */
+#ifndef NTL__EXT_FUNCTION_REF
+#define NTL__EXT_FUNCTION_REF
+#pragma once
+
+#include "../type_traits.hxx"
+#include "../utility.hxx"
+
+namespace std
+{
+  namespace ext
+  {
+    /**\addtogroup  lib_utilities
+     *@{*/
+
+    namespace __
+    {
+      /** The referenced callable: the address of the object or the function pointer itself */
+      union function_ref_target
+      {
+        void* object;
+        void (*function)();
+      };
+
+      template<class F, class Self>
+      struct is_function_ref_target:
+        integral_constant<bool, !is_same<typename remove_cv<typename remove_reference<F>::type>::type, Self>::value>
+      {};
+    }
+
+    /**
+     *	@brief Non-owning reference to a callable
+     *
+     *  Binds to any callable object or function without copying and allocating, so it is the parameter type for the callbacks
+     *  which are called only during the call of the function taking them:
+     *  \code
+     *  void for_each_packet(std::ext::function_ref<void(const packet&)> f);
+     *  for_each_packet([&](const packet& p) { total += p.size; });
+     *  \endcode
+     *  The referenced object shall outlive the function_ref; the functions are held by their pointers.
+     **/
+    template<class> class function_ref;
+
+#ifdef NTL_CXX_VT
+
+    template<class R, class... Args>
+    class function_ref<R(Args...)>
+    {
+      typedef R (*thunk_type)(__::function_ref_target, Args...);
+
+      template<class F>
+      static R call_object(__::function_ref_target t, Args... args)
+      {
+        return (*static_cast<F*>(t.object))(forward<Args>(args)...);
+      }
+      static R call_function(__::function_ref_target t, Args... args)
+      {
+        return reinterpret_cast<R(*)(Args...)>(t.function)(forward<Args>(args)...);
+      }
+    public:
+      function_ref(R (*f)(Args...)) __ntl_nothrow
+        :thunk(&call_function)
+      {
+        target.function = reinterpret_cast<void(*)()>(f);
+      }
+
+      template<class F>
+      function_ref(F&& f, typename enable_if<__::is_function_ref_target<F, function_ref>::value>::type* = 0) __ntl_nothrow
+        :thunk(&call_object<typename remove_reference<F>::type>)
+      {
+        target.object = const_cast<void*>(static_cast<const volatile void*>(&f));
+      }
+
+      R operator()(Args... args) const
+      {
+        return thunk(target, forward<Args>(args)...);
+      }
+
+    private:
+      __::function_ref_target target;
+      thunk_type thunk;
+    };
+
+#else // NTL_CXX_VT
+
+  #ifdef NTL_CXX_RV
+  # define NTL_FUNCTION_REF_CTOR() \
+      template<class F> \
+      function_ref(F&& f, typename enable_if<__::is_function_ref_target<F, function_ref>::value>::type* = 0) __ntl_nothrow \
+        :thunk(&call_object<typename remove_reference<F>::type>) \
+      { \
+        target.object = const_cast<void*>(static_cast<const volatile void*>(&f)); \
+      }
+  #else
+  # define NTL_FUNCTION_REF_CTOR() \
+      template<class F> \
+      function_ref(F& f, typename enable_if<__::is_function_ref_target<F, function_ref>::value>::type* = 0) __ntl_nothrow \
+        :thunk(&call_object<F>) \
+      { \
+        target.object = const_cast<void*>(static_cast<const volatile void*>(&f)); \
+      } \
+      template<class F> \
+      function_ref(const F& f, typename enable_if<__::is_function_ref_target<F, function_ref>::value>::type* = 0) __ntl_nothrow \
+        :thunk(&call_object<const F>) \
+      { \
+        target.object = const_cast<void*>(static_cast<const volatile void*>(&f)); \
+      }
+  #endif
+
+    template<class R>
+    class function_ref<R()>
+    {
+      typedef R (*thunk_type)(__::function_ref_target);
+
+      template<class F>
+      static R call_object(__::function_ref_target t) { return (*static_cast<F*>(t.object))(); }
+      static R call_function(__::function_ref_target t) { return reinterpret_cast<R(*)()>(t.function)(); }
+    public:
+      function_ref(R (*f)()) __ntl_nothrow
+        :thunk(&call_function)
+      {
+        target.function = reinterpret_cast<void(*)()>(f);
+      }
+      NTL_FUNCTION_REF_CTOR()
+
+      R operator()() const { return thunk(target); }
+    private:
+      __::function_ref_target target;
+      thunk_type thunk;
+    };
+
+    template<class R, class A1>
+    class function_ref<R(A1)>
+    {
+      typedef R (*thunk_type)(__::function_ref_target, A1);
+
+      template<class F>
+      static R call_object(__::function_ref_target t, A1 a1) { return (*static_cast<F*>(t.object))(a1); }
+      static R call_function(__::function_ref_target t, A1 a1) { return reinterpret_cast<R(*)(A1)>(t.function)(a1); }
+    public:
+      function_ref(R (*f)(A1)) __ntl_nothrow
+        :thunk(&call_function)
+      {
+        target.function = reinterpret_cast<void(*)()>(f);
+      }
+      NTL_FUNCTION_REF_CTOR()
+
+      R operator()(A1 a1) const { return thunk(target, a1); }
+    private:
+      __::function_ref_target target;
+      thunk_type thunk;
+    };
+
+    template<class R, class A1, class A2>
+    class function_ref<R(A1, A2)>
+    {
+      typedef R (*thunk_type)(__::function_ref_target, A1, A2);
+
+      template<class F>
+      static R call_object(__::function_ref_target t, A1 a1, A2 a2) { return (*static_cast<F*>(t.object))(a1, a2); }
+      static R call_function(__::function_ref_target t, A1 a1, A2 a2) { return reinterpret_cast<R(*)(A1, A2)>(t.function)(a1, a2); }
+    public:
+      function_ref(R (*f)(A1, A2)) __ntl_nothrow
+        :thunk(&call_function)
+      {
+        target.function = reinterpret_cast<void(*)()>(f);
+      }
+      NTL_FUNCTION_REF_CTOR()
+
+      R operator()(A1 a1, A2 a2) const { return thunk(target, a1, a2); }
+    private:
+      __::function_ref_target target;
+      thunk_type thunk;
+    };
+
+    template<class R, class A1, class A2, class A3>
+    class function_ref<R(A1, A2, A3)>
+    {
+      typedef R (*thunk_type)(__::function_ref_target, A1, A2, A3);
+
+      template<class F>
+      static R call_object(__::function_ref_target t, A1 a1, A2 a2, A3 a3) { return (*static_cast<F*>(t.object))(a1, a2, a3); }
+      static R call_function(__::function_ref_target t, A1 a1, A2 a2, A3 a3) { return reinterpret_cast<R(*)(A1, A2, A3)>(t.function)(a1, a2, a3); }
+    public:
+      function_ref(R (*f)(A1, A2, A3)) __ntl_nothrow
+        :thunk(&call_function)
+      {
+        target.function = reinterpret_cast<void(*)()>(f);
+      }
+      NTL_FUNCTION_REF_CTOR()
+
+      R operator()(A1 a1, A2 a2, A3 a3) const { return thunk(target, a1, a2, a3); }
+    private:
+      __::function_ref_target target;
+      thunk_type thunk;
+    };
+
+  #undef NTL_FUNCTION_REF_CTOR
+#endif // NTL_CXX_VT
+
+    /**@} lib_utilities */
+  } // ext
+} // std
+
+#endif // NTL__EXT_FUNCTION_REF
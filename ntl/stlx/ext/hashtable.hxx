@@ -6,6 +6,7 @@
 #include "../functional.hxx"  // for hash & predicates
 #include "../utility.hxx"     // for pair
 #include "../algorithm.hxx"   // for swap<>
+#include "../../cpu.hxx"      // for prefetch
 
 namespace std
 {
@@ -13,6 +14,9 @@ namespace std
   {
     namespace hashtable
     {
+      template<class Key, class Value, class Hash, class Pred, class Allocator, bool IsMap, bool IsUnique>
+      class chained_hashtable;
+
       namespace __
       {
         template<class Key, class Value, bool IsMap>
@@ -33,6 +37,140 @@ namespace std
           typedef           Key                    key_type;
           typedef           Value                  mapped_type;
         };
+
+        /** Node of the bucket chain, it depends on the value type only, so the nodes can be moved between the compatible tables */
+        template<class Value>
+        struct hash_node
+        {
+          hash_node* prev;
+          hash_node* next;
+
+          size_t     hkey;
+          Value      elem;
+
+          hash_node(const Value& elem, size_t h)
+            :prev(), next(), hkey(h), elem(elem)
+          {}
+        #ifdef NTL_CXX_RV
+          hash_node(Value&& elem, size_t h)
+            :prev(), next(), hkey(h), elem(forward<Value>(elem))
+          {}
+        #endif
+        private:
+          hash_node(const hash_node&) __deleted;
+          hash_node& operator=(const hash_node&) __deleted;
+
+        public:
+          /** links this node before \p pos */
+          void link_before(hash_node* pos)
+          {
+            next = pos; prev = pos->prev;
+            if(prev) prev->next = this;
+            pos->prev = this;
+          }
+
+          /** links this node after \p pos */
+          void link_after(hash_node* pos)
+          {
+            prev = pos; next = pos->next;
+            if(next) next->prev = this;
+            pos->next = this;
+          }
+
+          void unlink()
+          {
+            if(prev) prev->next = next;
+            if(next) next->prev = prev;
+            prev = next = nullptr;
+          }
+        };
+
+      #ifdef NTL_CXX_RV
+        /**
+         *	@brief Node handle [container.node]
+         *
+         *  Owns a node extracted from the hashtable, so the element can be moved to another table with the same
+         *  key, value and allocator types without copying it.
+         **/
+        template<class Key, class Value, class Allocator, bool IsMap>
+        class node_handle
+        {
+          typedef container_policy<Key,Value,IsMap> policy;
+        public:
+          typedef typename policy::key_type     key_type;
+          typedef typename policy::mapped_type  mapped_type;
+          typedef typename policy::value_type   value_type;
+          typedef Allocator                     allocator_type;
+
+        private:
+          typedef hash_node<value_type>                                 node;
+          typedef typename Allocator::template rebind<node>::other      node_allocator;
+
+        public:
+          node_handle()
+            :p()
+          {}
+          node_handle(node_handle&& x)
+            :p(x.p), alloc(move(x.alloc))
+          {
+            x.p = nullptr;
+          }
+          node_handle& operator=(node_handle&& x)
+          {
+            if(this != &x){
+              reset();
+              p = x.p; x.p = nullptr;
+              alloc = move(x.alloc);
+            }
+            return *this;
+          }
+          ~node_handle()
+          {
+            reset();
+          }
+
+          bool empty() const { return p == nullptr; }
+          allocator_type get_allocator() const { return allocator_type(alloc); }
+
+          value_type&  value()  const { assert(p); return p->elem; }
+          key_type&    key()    const { assert(p); return const_cast<key_type&>(p->elem.first); }
+          mapped_type& mapped() const { assert(p); return p->elem.second; }
+
+          void swap(node_handle& x)
+          {
+            using std::swap;
+            swap(p, x.p);
+            swap(alloc, x.alloc);
+          }
+
+        private:
+          node_handle(node* p, const node_allocator& a)
+            :p(p), alloc(a)
+          {}
+          node_handle(const node_handle&) __deleted;
+          node_handle& operator=(const node_handle&) __deleted;
+
+          void reset()
+          {
+            if(p){
+              alloc.destroy(p);
+              alloc.deallocate(p, 1);
+              p = nullptr;
+            }
+          }
+
+          template<class, class, class, class, class, bool, bool> friend class hashtable::chained_hashtable;
+
+          node* p;
+          node_allocator alloc;
+        };
+
+        template<class Key, class Value, class Allocator, bool IsMap>
+        inline void swap(node_handle<Key,Value,Allocator,IsMap>& x, node_handle<Key,Value,Allocator,IsMap>& y)
+        {
+          x.swap(y);
+        }
+      #endif
       }
 
       template<class Key, class Value, 
@@ -80,67 +218,16 @@ namespace std
         // hash value type
         typedef size_t hash_t;
 
-        struct node;
+        typedef __::hash_node<value_type> node;
         typedef node double_linked;
-        struct node
-        {
-          double_linked* prev;
-          double_linked* next;
-
-          hash_t         hkey;
-          value_type     elem;
-
-          node(const value_type& elem, hash_t h)
-            :elem(elem), hkey(h), next(), prev()
-          {}
-        #ifdef NTL_CXX_RV
-          node(value_type&& elem, hash_t h)
-            :elem(forward<value_type>(elem)), hkey(h), next(), prev()
-          {}
-          node(node&& x)
-            :elem(move(x.elem)), hkey(x.hkey), next(x.next), prev(x.prev)
-          { 
-            x.hkey = 0;
-            x.prev = x.next = nullptr;
-          }
-        #endif
-        protected:
-          node(const node& n)
-            :elem(n.elem), hkey(n.hkey), next(n.next), prev(n.prev)
-          {}
-        private:
-          node& operator=(const node&);
-
-        public:
-          void link(double_linked * prev, double_linked * next)
-          {
-            this->prev = prev; this->next = next;
-            prev->next = this; next->prev = this;
-          }
 
-          void link(double_linked* next)
-          {
-            next->next = this->next; next->prev = this;
-            this->next = next;
-          }
-
-          void link_prev(double_linked* prev)
-          {
-            prev->next = this;
-            prev->prev = this->prev;
-            this->prev = prev;
-          }
-
-          void unlink()
-          {
-            if(prev) prev->next = next; 
-            if(next) next->prev = prev;
-          }
-
-        };
+#ifdef NTL_CXX_TYPEOF
+        template<typename K>
+        struct is_transparent_key:
+          integral_constant<bool, std::__::is_transparent<Hash, K>::value && std::__::is_transparent<Pred, K>::value>
+        {};
+#endif
 
-        // node type
-        typedef node   node_type;
         /**
          *	Bucket represented as list of collided nodes, count of it and hash value for collided nodes.
          **/
@@ -156,12 +243,12 @@ namespace std
         /** hash table represented as buckets array and buckets count */
         typedef pair<bucket_type*, bucket_type*>   table;
         
-        typedef typename allocator_type::template rebind<node_type>::other    node_allocator;
+        typedef typename allocator_type::template rebind<node>::other         node_allocator;
         typedef typename allocator_type::template rebind<bucket_type>::other  bucket_allocator;
 
         struct base_iterator
         {
-          node_type* p;
+          node* p;
           bucket_type *b, *be;
 
           void increment()
@@ -183,7 +270,7 @@ namespace std
 
         struct base_local_iterator
         {
-          node_type *p;
+          node *p;
 
           void increment()
           {
@@ -205,7 +292,7 @@ namespace std
         {
           iterator_impl()
           {
-            p = nullptr;
+            this->p = nullptr;
           }
           iterator_impl(double_linked* p, bucket_type* b, bucket_type* end)
           {
@@ -220,8 +307,8 @@ namespace std
             this->be = end;
           }
 
-          reference operator* () const { return p->elem; }
-          pointer   operator->() const { return &p->elem; }
+          reference operator* () const { return this->p->elem; }
+          pointer   operator->() const { return &this->p->elem; }
           iterator_impl & operator++()
           {
             increment();
@@ -252,7 +339,7 @@ namespace std
           { return x.p != y.p; }
 
         private:
-          friend class hashtable;
+          friend class chained_hashtable;
           friend struct const_iterator_impl;
         };
 
@@ -262,13 +349,13 @@ namespace std
         {
           const_iterator_impl()
           {
-            p = nullptr;
+            this->p = nullptr;
           }
           const_iterator_impl(const iterator_impl& i)
           {
-            p = i.p;
-            b = i.b;
-            be = i.be;
+            this->p = i.p;
+            this->b = i.b;
+            this->be = i.be;
           }
           const_iterator_impl(double_linked* p, bucket_type* b, bucket_type* end)
           {
@@ -277,8 +364,8 @@ namespace std
             this->be = end;
           }
 
-          const_reference operator* () const { return p->elem; }
-          const_pointer   operator->() const { return &p->elem; }
+          const_reference operator* () const { return this->p->elem; }
+          const_pointer   operator->() const { return &this->p->elem; }
           const_iterator_impl& operator++()
           {
             increment();
@@ -311,7 +398,7 @@ namespace std
           { return x.p != y.p; }
 
         private:
-          friend class hashtable;
+          friend class chained_hashtable;
         };
 
         struct local_iterator_impl:
@@ -320,15 +407,15 @@ namespace std
         {
           local_iterator_impl()
           {
-            p = nullptr;
+            this->p = nullptr;
           }
           local_iterator_impl(double_linked* p)
           {
             this->p = p;
           }
 
-          reference operator* () const { return p->elem; }
-          pointer   operator->() const { return &p->elem; }
+          reference operator* () const { return this->p->elem; }
+          pointer   operator->() const { return &this->p->elem; }
           local_iterator_impl & operator++()
           {
             increment();
@@ -359,7 +446,7 @@ namespace std
           { return x.p != y.p; }
 
         private:
-          friend class hashtable;
+          friend class chained_hashtable;
           friend struct const_local_iterator_impl;
         };
 
@@ -369,19 +456,19 @@ namespace std
         {
           const_local_iterator_impl()
           {
-            p = nullptr;
+            this->p = nullptr;
           }
           const_local_iterator_impl(const local_iterator_impl& i)
           {
-            p = i.p;
+            this->p = i.p;
           }
           const_local_iterator_impl(const double_linked* p)
           {
-            this->p = const_cast<node_type*>(p);
+            this->p = const_cast<node*>(p);
           }
 
-          const_reference operator* () const { return p->elem; }
-          const_pointer   operator->() const { return &p->elem; }
+          const_reference operator* () const { return this->p->elem; }
+          const_pointer   operator->() const { return &this->p->elem; }
           const_local_iterator_impl& operator++()
           {
             increment();
@@ -414,7 +501,7 @@ namespace std
           { return x.p != y.p; }
 
         private:
-          friend class hashtable;
+          friend class chained_hashtable;
         };
 
       public:
@@ -426,6 +513,25 @@ namespace std
         typedef local_iterator_impl                   local_iterator;
         typedef const_local_iterator_impl             const_local_iterator;
 
+      #ifdef NTL_CXX_RV
+        typedef __::node_handle<Key,Value,Allocator,IsMap> node_type;
+
+        /** Result of the node handle insertion into the table with unique keys */
+        struct insert_return_type
+        {
+          iterator  position;
+          bool      inserted;
+          node_type node;
+
+          insert_return_type(iterator position, bool inserted, node_type&& node)
+            :position(position), inserted(inserted), node(move(node))
+          {}
+          insert_return_type(insert_return_type&& x)
+            :position(x.position), inserted(x.inserted), node(move(x.node))
+          {}
+        };
+      #endif
+
       public:
         ///\name Construct/copy/destroy
         explicit chained_hashtable(size_type n, const hasher& hf = hasher(), const key_equal& eql = key_equal(), const allocator_type& a = allocator_type())
@@ -436,6 +542,8 @@ namespace std
         ~chained_hashtable()
         {
           clear();
+          if(buckets_.first)
+            balloc.deallocate(buckets_.first, bucket_count());
         }
         chained_hashtable(const chained_hashtable& r)
           :nalloc(r.nalloc), balloc(r.balloc), hash_(r.hash_), equal_(r.equal_), count_(0), max_factor(r.max_factor), head_()
@@ -516,57 +624,25 @@ namespace std
         }
 
       protected:
-        std::pair<iterator, bool> insert_impl(const_iterator hint, const value_type& v)
+        std::pair<iterator, bool> insert_impl(const_iterator /*hint*/, const value_type& v)
         {
-          const hash_t hkey = hash_(value2key(v, is_map()));
-          const size_type n = mapkey(hkey);
-          assert(buckets_.first && n < static_cast<size_type>(buckets_.second-buckets_.first));
-          bucket_type& b = buckets_.first[n];
-
-          if(is_unique::value && b.elems){
+          const key_type& k = value2key(v, is_map());
+          const hash_t hkey = hash_(k);
+          if(is_unique::value){
             // allow only unique keys
-            if(b.hash == hkey || b.dirty){
-              for(const node_type* p = b.elems; p; p = p->next)
-                if(p->hkey == hkey && equal_(value2key(p->elem, is_map()), value2key(v, is_map())))
-                  return std::make_pair(iterator(const_cast<node_type*>(p), &b, buckets_.second), false);
-            }
+            node* p = find_node(k, hkey);
+            if(p)
+              return std::make_pair(make_iterator(p), false);
           }
-          // construct node(value, hash)
           node* p = nalloc.allocate(1);
-          nalloc.construct(p, v, hkey);
-
-          //       ,    ,   ?  ?.
-          //     
-
-          if(hint.p && hint.p->hkey == hkey){
-            // link with the hint
-            //const_cast<node_type*>(hint.p)->link(p);
-            hint = hint;
-          }
-          //}else{
-          {
-            if(b.elems){
-              const bool to_end = b.hash != hkey; //     
-              if(!to_end)
-                b.elems->link_prev(p);            //     
-              else{
-                node_type* n = b.elems; 
-                while(n->next && n->hkey == hkey)
-                  n = n->next;
-                n->link(p);
-                b.dirty = true;
-              }
-            }else{
-              // construct bucket
-              b.elems = p;
-              b.hash = hkey;
-              if(count_ == 0 || head_ > &b)
-                head_ = &b;
-            }
-            b.size++;
+          __ntl_try{
+            nalloc.construct(p, v, hkey);
           }
-          count_++;
-          return std::make_pair(iterator(p, &b, buckets_.second), true);
+          __ntl_catch(...){
+            nalloc.deallocate(p, 1);
+            __ntl_rethrow;
+          }
+          return std::make_pair(link_node(p), true);
         }
 
     public:
@@ -577,55 +653,85 @@ namespace std
             i = insert(i, *first);
         }
 
+      #ifdef NTL_CXX_RV
+        /** Inserts the node owned by \p nh, the node is left in \p nh if the table has unique keys and already contains its key */
+        typename conditional<IsUnique, insert_return_type, iterator>::type insert(node_type&& nh)
+        {
+          return insert_node(nh, is_unique());
+        }
+
+        iterator insert(const_iterator /*hint*/, node_type&& nh)
+        {
+          return link_handle(nh).first;
+        }
+
+        /** Unlinks the element from the table and returns its node */
+        node_type extract(const_iterator position)
+        {
+          assert(position.p);
+          unlink_node(*position.b, position.p);
+          return node_type(position.p, nalloc);
+        }
+
+        node_type extract(const key_type& k)
+        {
+          const iterator i = find(k);
+          return i == end() ? node_type() : extract(i);
+        }
+      #endif
+
+        /**
+         *  Moves the nodes of \p source into this table, without copying the elements.
+         *  If this table has unique keys, the elements whose keys are already present stay in \p source.
+         **/
+        template<class H2, class P2, bool U2>
+        void merge(chained_hashtable<Key,Value,H2,P2,Allocator,IsMap,U2>& source)
+        {
+          typedef chained_hashtable<Key,Value,H2,P2,Allocator,IsMap,U2> source_type;
+          if(static_cast<void*>(&source) == static_cast<void*>(this))
+            return;
+          assert(nalloc == source.nalloc);
+          for(typename source_type::bucket_type* b = source.buckets_.first; b != source.buckets_.second; ++b){
+            for(node* p = b->elems; p; ){
+              node* const next = p->next;
+              const hash_t hkey = merge_hash(source.hash_, p);
+              if(!is_unique::value || !find_node(node_key(p), hkey)){
+                source.unlink_node(*b, p);
+                p->hkey = hkey;
+                link_node(p);
+              }
+              p = next;
+            }
+          }
+        }
+      #ifdef NTL_CXX_RV
+        template<class H2, class P2, bool U2>
+        void merge(chained_hashtable<Key,Value,H2,P2,Allocator,IsMap,U2>&& source)
+        {
+          merge(source);
+        }
+      #endif
+
         iterator  erase(const_iterator position)
         {
           if(!position.p)
             return end();
-          node_type* next = position.p->next;
-          if(position.b->elems == position.p){
-            bucket_type* b = position.b;
-            const bool head = head_ == b;
-            b->elems = next;
-            if(!--b->size || (b->dirty && b->hash != next->hkey)){
-              b->dirty = false;
-              if(next)
-                b->hash = next->hkey;
-            }
-            if(!next || head){
-              // find next nonempty bucket for head
-              b = buckets_.first;
-              while(b != buckets_.second && !b->elems) ++b;
-              if(b != buckets_.second){
-                if(head)
-                  head_ = b;
-                position.b = b;
-                next = b->elems;
-              }else if(head)
-                head_ = nullptr;
-            }
-          }else{
-            --position.b->size;
-          }
-          --count_;
-          position.p->unlink();
+          iterator next(position.p, position.b, buckets_.second);
+          ++next;
+          unlink_node(*position.b, position.p);
           nalloc.destroy(position.p);
           nalloc.deallocate(position.p,1);
-          return iterator(next, position.b, position.be);
+          return next;
         }
 
         size_type erase(const key_type& k)
         {
-          const_iterator i = find(k);
-          if(i == cend())
-            return 0;
-          if(is_unique::value){
-            erase(i);
-            return 1;
-          }
           pair<iterator,iterator> range = equal_range(k);
-          size_type n = distance(range.first, range.second);
-          while(range.first != range.second)
-            erase(range.first);
+          size_type n = 0;
+          while(range.first != range.second){
+            range.first = erase(range.first);
+            ++n;
+          }
           return n;
         }
 
@@ -664,60 +770,87 @@ namespace std
         ///\name lookup
         iterator find(const key_type& k)
         {
-          const size_type n = bucket(k);
-          bucket_type& b = buckets_.first[n];
-          if(b.size == 0)
-            return end();
-          for(local_iterator li = begin(n), lend = end(n); li != lend; ++li){
-            if(equal_(k, value2key(li.p->elem, is_map())))
-              return iterator(li.p, &b, buckets_.second);
-          }
-          return end();
+          return find_impl(k);
         }
 
         const_iterator find(const key_type& k) const
         {
-          return const_cast<hashtable*>(this)->find(k);
+          return const_cast<hashtable*>(this)->find_impl(k);
         }
 
         size_type count(const key_type& k) const
         {
-          return find(k) != end() ? 1 : 0;
+          return count_impl(k);
+        }
+
+        bool contains(const key_type& k) const
+        {
+          return find_node(k, hash_(k)) != nullptr;
         }
 
         std::pair<iterator, iterator> equal_range(const key_type& k)
         {
-          const hash_t hkey = hash_(k);
-          const size_type n = mapkey(hkey);
-          bucket_type& b = buckets_.first[n];
-          iterator e = end();
-          if(!b.size)
-            return make_pair(e, e);
-
-          node_type* p = b.elems;
-          while(p && p->hkey != hkey)
-            p = p->next;
-          if(!p)
-            return make_pair(e, e);
-
-          e.p = p,
-            e.b = &b,
-            e.be = buckets_.second;
-          iterator i = e;
-          if(e.b->dirty){
-            while(e.p && e.p->hkey == i.p->hkey && equal_(value2key(e.p->elem, is_map()), value2key(i.p->elem, is_map())) )
-              e.p = e.p->next;
-          }else{
-            e.p = nullptr;
-          }
-          return make_pair(i,e);
+          return equal_range_impl(k);
         }
 
         std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const
         {
-          return const_cast<hashtable*>(this)->equal_range(k);
+          return const_cast<hashtable*>(this)->equal_range_impl(k);
+        }
+
+        /**
+         *  Looks up the keys <tt>[first, last)</tt> and writes the position of each of them (or end()) to \p result.
+         *
+         *  The keys are processed in groups: all keys of the group are hashed and their buckets and chain heads
+         *  are prefetched before the chains are searched, so the cache misses of the independent lookups overlap
+         *  instead of being taken one by one.
+         **/
+        template<class ForwardIterator, class OutputIterator>
+        OutputIterator find_batch(ForwardIterator first, ForwardIterator last, OutputIterator result)
+        {
+          return find_batch_impl<iterator>(first, last, result);
         }
 
+        template<class ForwardIterator, class OutputIterator>
+        OutputIterator find_batch(ForwardIterator first, ForwardIterator last, OutputIterator result) const
+        {
+          return find_batch_impl<const_iterator>(first, last, result);
+        }
+
+#ifdef NTL_CXX_TYPEOF
+        // heterogeneous lookup, available if both hasher and key_equal are transparent
+        template<typename K>
+        typename enable_if<is_transparent_key<K>::value, iterator>::type find(const K& k)
+        {
+          return find_impl(k);
+        }
+        template<typename K>
+        typename enable_if<is_transparent_key<K>::value, const_iterator>::type find(const K& k) const
+        {
+          return const_cast<hashtable*>(this)->find_impl(k);
+        }
+        template<typename K>
+        typename enable_if<is_transparent_key<K>::value, size_type>::type count(const K& k) const
+        {
+          return count_impl(k);
+        }
+        template<typename K>
+        typename enable_if<is_transparent_key<K>::value, bool>::type contains(const K& k) const
+        {
+          return find_node(k, hash_(k)) != nullptr;
+        }
+        template<typename K>
+        typename enable_if<is_transparent_key<K>::value, std::pair<iterator, iterator> >::type equal_range(const K& k)
+        {
+          return equal_range_impl(k);
+        }
+        template<typename K>
+        typename enable_if<is_transparent_key<K>::value, std::pair<const_iterator, const_iterator> >::type equal_range(const K& k) const
+        {
+          return const_cast<hashtable*>(this)->equal_range_impl(k);
+        }
+#endif
+
         ///\name bucket interface
         size_type bucket_count() const { return buckets_.second - buckets_.first; }
         size_type max_bucket_count() const { return balloc.max_size(); }
@@ -725,15 +858,7 @@ namespace std
         size_type bucket_size(size_type n) const
         {
           assert(n >= 0 && n < bucket_count());
-          bucket_type& b = buckets_.first[n];
-          if(!b.dirty)
-            n = b.size;
-          else{
-            n = 0;
-            const hash_t hkey = b.hash;
-            for(node_type* p = b.elems; p && p->hkey == hkey; p = p->next, ++n);
-          }
-          return n;
+          return buckets_.first[n].size;
         }
 
         size_type bucket(const key_type& k) const
@@ -786,27 +911,16 @@ namespace std
           table buckets(b, b + n);
           memset(b, 0, sizeof(bucket_type)*n);
 
-          // swap it with old
+          // swap it with old and relink the nodes
           std::swap(buckets, buckets_);
           head_ = nullptr;
-          count_ = 0; // increased by following inserts
-          copy_from(buckets);
-
-          // destroy old buckets
-          b = buckets.first;
-          while(b != buckets.second){
-            if(!b->elems || b->size == 0){
-              b++;
-              continue;
-            }
-            node* p = b->elems;
-            while(b->size--){
-              node* d = p;
-              p = p->next;
-              nalloc.deallocate(d, 1);
+          count_ = 0; // increased by following links
+          for(b = buckets.first; b != buckets.second; ++b){
+            for(node* p = b->elems; p; ){
+              node* const next = p->next;
+              link_node(p);
+              p = next;
             }
-            b->elems = nullptr;
-            b++;
           }
           balloc.deallocate(buckets.first, buckets.second-buckets.first);
         }
@@ -833,7 +947,7 @@ namespace std
           const_iterator hint = end();
           while(b != buckets.second){
             if(b->elems){
-              node_type* p = b->elems;
+              node* p = b->elems;
               while(p){
                 hint = insert(hint, std::move(p->elem));
                 p = p->next;
@@ -843,14 +957,14 @@ namespace std
           }
         }
 
-        template<bool> node_type* move_element(node_type* to, const value_type& v, true_type)
+        template<bool> node* move_element(node* to, const value_type& v, true_type)
         {
           to->elem = v;
           return to;
         }
-        template<bool> node_type* move_element(node_type* to, const value_type& v, false_type)
+        template<bool> node* move_element(node* to, const value_type& v, false_type)
         {
-          node_type* p = nalloc.allocate(1);
+          node* p = nalloc.allocate(1);
           nalloc.construct(p, v, to->hkey);
           p->next = to->next; p->prev = to->prev;
           nalloc.destroy(to);
@@ -861,6 +975,194 @@ namespace std
         template<class V> static const key_type& value2key(const V& x, true_type)   { return x.first; }
         template<class V> static const key_type& value2key(const V& x, false_type)  { return x; }
 
+        static const key_type& node_key(const node* p) { return value2key(p->elem, is_map()); }
+
+        iterator make_iterator(node* p)
+        {
+          return iterator(p, &buckets_.first[mapkey(p->hkey)], buckets_.second);
+        }
+
+        template<typename K>
+        node* find_node(const K& k, hash_t hkey) const
+        {
+          for(node* p = buckets_.first[mapkey(hkey)].elems; p; p = p->next){
+            if(p->hkey == hkey && equal_(k, node_key(p)))
+              return p;
+          }
+          return nullptr;
+        }
+
+        template<class Iterator, class ForwardIterator, class OutputIterator>
+        OutputIterator find_batch_impl(ForwardIterator first, ForwardIterator last, OutputIterator result) const
+        {
+          static const size_t group = 16;
+          hash_t hkeys[group];
+          bucket_type* buckets[group];
+          while(first != last){
+            size_t n = 0;
+            for(ForwardIterator k = first; n < group && k != last; ++k, ++n){
+              hkeys[n] = hash_(*k);
+              buckets[n] = &buckets_.first[mapkey(hkeys[n])];
+              ntl::cpu::prefetch(buckets[n]);
+            }
+            for(size_t i = 0; i < n; ++i){
+              if(buckets[i]->elems)
+                ntl::cpu::prefetch(buckets[i]->elems);
+            }
+            for(size_t i = 0; i < n; ++i, ++first, ++result){
+              node* p = buckets[i]->elems;
+              while(p && !(p->hkey == hkeys[i] && equal_(*first, node_key(p))))
+                p = p->next;
+              *result = p ? Iterator(p, buckets[i], buckets_.second) : Iterator();
+            }
+          }
+          return result;
+        }
+
+        template<typename K>
+        iterator find_impl(const K& k)
+        {
+          node* p = find_node(k, hash_(k));
+          return p ? make_iterator(p) : end();
+        }
+
+        template<typename K>
+        size_type count_impl(const K& k) const
+        {
+          const hash_t hkey = hash_(k);
+          size_type n = 0;
+          for(const node* p = buckets_.first[mapkey(hkey)].elems; p; p = p->next){
+            if(p->hkey == hkey && equal_(k, node_key(p))){
+              ++n;
+              if(is_unique::value)
+                break;
+            }
+          }
+          return n;
+        }
+
+        template<typename K>
+        std::pair<iterator, iterator> equal_range_impl(const K& k)
+        {
+          const hash_t hkey = hash_(k);
+          node* p = find_node(k, hkey);
+          if(!p)
+            return std::make_pair(end(), end());
+
+          // the equivalent keys are linked together, see link_node()
+          const iterator first = make_iterator(p);
+          iterator last = first;
+          do
+            ++last;
+          while(!is_unique::value && last.p && last.b == first.b && last.p->hkey == hkey && equal_(k, node_key(last.p)));
+          return std::make_pair(first, last);
+        }
+
+        /**
+         *  Links the free node \p p into its bucket. The nodes with the same hash value and the equivalent keys among them
+         *  are kept together, the node with a new hash value becomes the bucket head, so it doesn't split the run of the head.
+         **/
+        iterator link_node(node* p)
+        {
+          const hash_t hkey = p->hkey;
+          bucket_type& b = buckets_.first[mapkey(hkey)];
+          p->prev = p->next = nullptr;
+
+          if(!b.elems){
+            b.elems = p;
+            b.hash = hkey;
+            b.dirty = false;
+            if(count_ == 0 || head_ > &b)
+              head_ = &b;
+          }else{
+            node* pos = b.elems;
+            while(pos && pos->hkey != hkey)
+              pos = pos->next;
+            if(pos && !is_unique::value){
+              for(node* q = pos; q && q->hkey == hkey; q = q->next){
+                if(equal_(node_key(q), node_key(p))){
+                  pos = q;
+                  break;
+                }
+              }
+            }
+            if(!pos){
+              p->link_before(b.elems);
+              b.elems = p;
+              b.hash = hkey;
+              b.dirty = true;
+            }else{
+              p->link_before(pos);
+              if(pos == b.elems)
+                b.elems = p;
+            }
+          }
+          b.size++;
+          count_++;
+          return iterator(p, &b, buckets_.second);
+        }
+
+        /** Unlinks the node \p p from the bucket \p b, the node isn't destroyed */
+        void unlink_node(bucket_type& b, node* p)
+        {
+          if(b.elems == p){
+            b.elems = p->next;
+            if(p->next)
+              b.hash = p->next->hkey;
+          }
+          p->unlink();
+          if(--b.size <= 1)
+            b.dirty = false;
+          --count_;
+          if(!b.elems && head_ == &b){
+            // find next nonempty bucket for head
+            bucket_type* h = &b;
+            while(++h != buckets_.second && !h->elems);
+            head_ = h != buckets_.second ? h : nullptr;
+          }
+        }
+
+        /** hash value of the node coming from the table with the hasher of type \p H2 */
+        template<class H2>
+        hash_t merge_hash(const H2&, const node* p) const
+        {
+          // the stateless hasher of the same type gives the same value
+          return is_same<H2, hasher>::value && is_empty<hasher>::value ? p->hkey : hash_(node_key(p));
+        }
+
+      #ifdef NTL_CXX_RV
+        std::pair<iterator, bool> link_handle(node_type& nh)
+        {
+          if(nh.empty())
+            return std::make_pair(end(), false);
+          assert(nalloc == nh.alloc);
+
+          // the node may come from the table with another hasher
+          node* p = nh.p;
+          p->hkey = hash_(node_key(p));
+          if(is_unique::value){
+            node* x = find_node(node_key(p), p->hkey);
+            if(x)
+              return std::make_pair(make_iterator(x), false);
+          }
+          nh.p = nullptr;
+          return std::make_pair(link_node(p), true);
+        }
+
+        insert_return_type insert_node(node_type& nh, true_type)
+        {
+          const std::pair<iterator, bool> re = link_handle(nh);
+          return insert_return_type(re.first, re.second, move(nh));
+        }
+
+        iterator insert_node(node_type& nh, false_type)
+        {
+          return link_handle(nh).first;
+        }
+      #endif
+
+        template<class, class, class, class, class, bool, bool> friend class chained_hashtable;
+
       protected:
 
         /**
@@ -906,4 +1208,4 @@ namespace std
   }
 }
 
-#endif // NTL__EXT_HASHTABLE
\ No newline at end of file
+#endif // NTL__EXT_HASHTABLE
\ No newline at end of file
@@ -0,0 +1,312 @@
+/**\file*********************************************************************
+ *                                                                     \brief
+ *  d-ary heap with stable handles
+ *
+ ****************************************************************************
+ */
+#ifndef NTL__EXT_INDEXED_HEAP
+#define NTL__EXT_INDEXED_HEAP
+#pragma once
+
+#include "../vector.hxx"
+#include "../functional.hxx"
+
+namespace std
+{
+  namespace ext
+  {
+    /**\addtogroup  lib_containers *********** 23 Containers library [containers]
+     *@{*/
+
+    /**
+     *	@brief Priority queue with stable handles
+     *
+     *  indexed_heap is a \p D-ary heap ordered like \c std::priority_queue: top() is the element for which no other
+     *  element compares greater by \p Compare (so <tt>greater<T></tt> makes a min-heap). The wider nodes make the heap
+     *  shallower and keep the children of a node on one cache line, 4 by default.
+     *
+     *  push() returns a handle which stays valid until the element is popped or erased, so the element can be
+     *  found in O(1) and updated or erased in O(log N). The handles of the removed elements are reused.
+     **/
+    template<class T, class Compare = less<T>, size_t D = 4, class Allocator = allocator<T> >
+    class indexed_heap
+    {
+      static_assert(D >= 2, "heap arity shall be at least 2");
+
+      typedef typename Allocator::template rebind<size_t>::other  index_allocator;
+      typedef vector<T, Allocator>                                heap_type;
+      typedef vector<size_t, index_allocator>                     index_type;
+    public:
+      typedef T                                       value_type;
+      typedef Compare                                 value_compare;
+      typedef Allocator                               allocator_type;
+      typedef const T&                                reference;
+      typedef const T&                                const_reference;
+      typedef size_t                                  size_type;
+      typedef size_t                                  handle_type;
+
+      /** Elements in the heap order */
+      typedef typename heap_type::const_iterator      const_iterator;
+      typedef const_iterator                          iterator;
+
+      static const size_type arity = D;
+
+    public:
+      ///\name construct/copy/destroy
+      explicit indexed_heap(const Compare& comp = Compare(), const Allocator& a = Allocator())
+        :heap_(a), handles_(a), index_(a), free_(npos), comp_(comp)
+      {}
+
+      allocator_type get_allocator() const { return heap_.get_allocator(); }
+
+      ///\name iterators
+      const_iterator begin() const { return heap_.begin(); }
+      const_iterator end()   const { return heap_.end(); }
+
+      /** The handle of the element at \p position */
+      handle_type handle_of(const_iterator position) const { return handles_[position - heap_.begin()]; }
+
+      ///\name capacity
+      bool      empty() const { return heap_.empty(); }
+      size_type size()  const { return heap_.size(); }
+
+      void reserve(size_type n)
+      {
+        heap_.reserve(n);
+        handles_.reserve(n);
+        index_.reserve(n);
+      }
+
+      ///\name element access
+      const_reference top() const { assert(!empty()); return heap_.front(); }
+      handle_type top_handle() const { assert(!empty()); return handles_.front(); }
+
+      /** Checks whether \p h refers to an element of the heap */
+      bool contains(handle_type h) const { return h < index_.size() && !(index_[h] & free_bit); }
+
+      const_reference operator[](handle_type h) const
+      {
+        assert(contains(h));
+        return heap_[index_[h]];
+      }
+
+      ///\name modifiers
+      handle_type push(const T& x)
+      {
+        const handle_type h = acquire_handle();
+        __ntl_try{
+          handles_.push_back(h);
+          __ntl_try{
+            heap_.push_back(x);
+          }
+          __ntl_catch(...){
+            handles_.pop_back();
+            __ntl_rethrow;
+          }
+        }
+        __ntl_catch(...){
+          release_handle(h);
+          __ntl_rethrow;
+        }
+        index_[h] = heap_.size()-1;
+        sift_up(heap_.size()-1);
+        return h;
+      }
+
+    #ifdef NTL_CXX_RV
+      handle_type push(T&& x)
+      {
+        const handle_type h = acquire_handle();
+        __ntl_try{
+          handles_.push_back(h);
+          __ntl_try{
+            heap_.push_back(move(x));
+          }
+          __ntl_catch(...){
+            handles_.pop_back();
+            __ntl_rethrow;
+          }
+        }
+        __ntl_catch(...){
+          release_handle(h);
+          __ntl_rethrow;
+        }
+        index_[h] = heap_.size()-1;
+        sift_up(heap_.size()-1);
+        return h;
+      }
+    #endif
+
+      void pop()
+      {
+        assert(!empty());
+        erase(handles_.front());
+      }
+
+      /** Removes the element \p h */
+      void erase(handle_type h)
+      {
+        assert(contains(h));
+        const size_type i = index_[h], last = heap_.size()-1;
+        if(i != last){
+          heap_[i] = move(heap_[last]);
+          handles_[i] = handles_[last];
+          index_[handles_[i]] = i;
+        }
+        heap_.pop_back();
+        handles_.pop_back();
+        release_handle(h);
+        if(i != last)
+          restore(i);
+      }
+
+      /** Replaces the value of the element \p h with \p x */
+      void update(handle_type h, const T& x)
+      {
+        assert(contains(h));
+        const size_type i = index_[h];
+        heap_[i] = x;
+        restore(i);
+      }
+
+      /**
+       *  Replaces the value of the element \p h with \p x which does not compare less than the current value
+       *  (a lower key for a min-heap), so the element can only move toward the top.
+       **/
+      void decrease_key(handle_type h, const T& x)
+      {
+        assert(contains(h));
+        const size_type i = index_[h];
+        assert(!comp_(x, heap_[i]));
+        heap_[i] = x;
+        sift_up(i);
+      }
+
+      void clear() __ntl_nothrow
+      {
+        heap_.clear();
+        handles_.clear();
+        index_.clear();
+        free_ = npos;
+      }
+
+      void swap(indexed_heap& x)
+      {
+        heap_.swap(x.heap_);
+        handles_.swap(x.handles_);
+        index_.swap(x.index_);
+        std::swap(free_, x.free_);
+        std::swap(comp_, x.comp_);
+      }
+
+      ///\name observers
+      value_compare value_comp() const { return comp_; }
+      ///\}
+
+    private:
+      static const size_t npos = static_cast<size_t>(-1);
+      static const size_t free_bit = ~(npos >> 1);
+
+      handle_type acquire_handle()
+      {
+        if(free_ != npos){
+          const handle_type h = free_;
+          free_ = index_[h] & ~free_bit;
+          if(free_ == (npos & ~free_bit))
+            free_ = npos;
+          return h;
+        }
+        index_.push_back(0);
+        return index_.size()-1;
+      }
+
+      void release_handle(handle_type h)
+      {
+        // the free handles are chained through their index entries
+        index_[h] = free_bit | (free_ & ~free_bit);
+        free_ = h;
+      }
+
+      void place(size_type i, handle_type h)
+      {
+        handles_[i] = h;
+        index_[h] = i;
+      }
+
+      void sift_up(size_type i)
+      {
+        if(i == 0 || !comp_(heap_[(i-1)/D], heap_[i]))
+          return;
+        T x(move(heap_[i]));
+        const handle_type h = handles_[i];
+        do{
+          const size_type parent = (i-1)/D;
+          if(!comp_(heap_[parent], x))
+            break;
+          heap_[i] = move(heap_[parent]);
+          place(i, handles_[parent]);
+          i = parent;
+        }while(i > 0);
+        heap_[i] = move(x);
+        place(i, h);
+      }
+
+      void sift_down(size_type i)
+      {
+        const size_type n = heap_.size();
+        size_type child = max_child(i, n);
+        if(child == npos || !comp_(heap_[i], heap_[child]))
+          return;
+        T x(move(heap_[i]));
+        const handle_type h = handles_[i];
+        do{
+          heap_[i] = move(heap_[child]);
+          place(i, handles_[child]);
+          i = child;
+          child = max_child(i, n);
+        }while(child != npos && comp_(x, heap_[child]));
+        heap_[i] = move(x);
+        place(i, h);
+      }
+
+      /** the greatest child of \p i or npos */
+      size_type max_child(size_type i, size_type n) const
+      {
+        const size_type first = i*D + 1;
+        if(first >= n)
+          return npos;
+        const size_type last = n - first > D ? first + D : n;
+        size_type best = first;
+        for(size_type c = first+1; c < last; ++c)
+          if(comp_(heap_[best], heap_[c]))
+            best = c;
+        return best;
+      }
+
+      void restore(size_type i)
+      {
+        if(i > 0 && comp_(heap_[(i-1)/D], heap_[i]))
+          sift_up(i);
+        else
+          sift_down(i);
+      }
+
+    private:
+      heap_type   heap_;
+      index_type  handles_;   // heap position -> handle
+      index_type  index_;     // handle -> heap position or the next free handle
+      size_t      free_;
+      Compare     comp_;
+    };
+
+    template<class T, class Compare, size_t D, class Allocator>
+    inline void swap(indexed_heap<T, Compare, D, Allocator>& x, indexed_heap<T, Compare, D, Allocator>& y)
+    {
+      x.swap(y);
+    }
+
+    /**@} lib_containers */
+  } // ext
+} // std
+
+#endif // NTL__EXT_INDEXED_HEAP
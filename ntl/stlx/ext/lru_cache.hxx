@@ -0,0 +1,494 @@
+/**\file*********************************************************************
+ *                                                                     \brief
+ *  Bounded LRU and CLOCK caches
+ *
+ ****************************************************************************
+ */
+#ifndef NTL__EXT_LRU_CACHE
+#define NTL__EXT_LRU_CACHE
+#pragma once
+
+#include "hashtable.hxx"
+#include "../mutex.hxx"
+#include "../../linked_list.hxx"
+
+namespace std
+{
+  namespace ext
+  {
+    /**\addtogroup  lib_containers *********** 23 Containers library [containers]
+     *@{*/
+
+    /** Replacement policies of lru_cache */
+    namespace cache
+    {
+      /**
+       *	@brief Least recently used replacement
+       *
+       *  The entries are kept in the recency order, a hit moves the entry to the front and the victim is the back one.
+       **/
+      class lru
+      {
+      public:
+        struct hook: ntl::linked<2>
+        {};
+
+        lru()
+        {
+          head.prev = head.next = &head;
+        }
+
+        void inserted(hook* e) { e->link(&head); }
+        void touched(hook* e)  { e->unlink(); e->link(&head); }
+        void removed(hook* e)  { e->unlink(); }
+
+        /** The entry to evict, the policy shall not be empty */
+        hook* victim()
+        {
+          assert(head.prev != &head);
+          return static_cast<hook*>(head.prev);
+        }
+
+      private:
+        lru(const lru&) __deleted;
+        lru& operator=(const lru&) __deleted;
+
+        ntl::linked<2> head;
+      };
+
+      /**
+       *	@brief CLOCK (second chance) replacement
+       *
+       *  A hit only sets the reference bit of the entry and never touches the list. The clock hand sweeps the ring
+       *  of entries, clears the reference bits on its way and stops at the first unreferenced entry;
+       *  the new entries are placed behind the hand, so they are swept last.
+       **/
+      class clock
+      {
+      public:
+        struct hook: ntl::linked<2>
+        {
+          bool referenced;
+        };
+
+        clock()
+          :hand(&head)
+        {
+          head.prev = head.next = &head;
+        }
+
+        void inserted(hook* e)
+        {
+          e->referenced = false;
+          e->link(hand->prev, hand);
+        }
+
+        void touched(hook* e)  { e->referenced = true; }
+
+        void removed(hook* e)
+        {
+          if(hand == e)
+            hand = e->next;
+          e->unlink();
+        }
+
+        /** The entry to evict, the policy shall not be empty */
+        hook* victim()
+        {
+          assert(head.next != &head);
+          for(;;){
+            if(hand == &head)
+              hand = head.next;
+            hook* const e = static_cast<hook*>(hand);
+            if(!e->referenced)
+              return e;
+            e->referenced = false;
+            hand = hand->next;
+          }
+        }
+
+      private:
+        clock(const clock&) __deleted;
+        clock& operator=(const clock&) __deleted;
+
+        ntl::linked<2>  head;
+        ntl::linked<2>* hand;
+      };
+    } // cache
+
+    /**
+     *	@brief Bounded associative cache
+     *
+     *  lru_cache maps the unique keys to the values and holds no more than capacity() units: every entry is charged
+     *  by put() with a caller-computed weight, 1 by default, so the capacity is either a number of entries or a number
+     *  of bytes. When the total charge exceeds the capacity, the entries chosen by the replacement \p Policy
+     *  (cache::lru or cache::clock) are evicted and passed to the eviction callback.
+     *
+     *  The entries are the nodes of a chained_hashtable which carry the replacement hook as well, so an entry costs
+     *  one allocation, and get(), put() and erase() take O(1) on average: the table doubles its buckets as the number
+     *  of entries reaches it, which relinks the nodes but does not move the entries.
+     *  The pointers returned by get() stay valid until the entry is evicted or erased.
+     **/
+    template<class Key, class T,
+             class Hash = hash<Key>,
+             class Pred = equal_to<Key>,
+             class Policy = cache::lru,
+             class Allocator = allocator<pair<const Key, T> > >
+    class lru_cache
+    {
+      struct entry: Policy::hook
+      {
+        T           value;
+        size_t      charge;
+        const Key*  key;
+
+        entry(const T& value, size_t charge)
+          :value(value), charge(charge), key()
+        {}
+      };
+
+      typedef typename Allocator::template rebind<pair<const Key, entry> >::other table_allocator;
+      typedef hashtable::chained_hashtable<Key, entry, Hash, Pred, table_allocator> table_type;
+    public:
+      ///\name types
+      typedef Key                                     key_type;
+      typedef T                                       mapped_type;
+      typedef Hash                                    hasher;
+      typedef Pred                                    key_equal;
+      typedef Policy                                  policy_type;
+      typedef Allocator                               allocator_type;
+      typedef size_t                                  size_type;
+
+      /** Called with the evicted entry before it is destroyed, it shall not access the cache */
+      typedef void (*eviction_callback)(const key_type& k, mapped_type& value, void* context);
+      ///\}
+
+    public:
+      ///\name construct/destroy
+      explicit lru_cache(size_type capacity, const hasher& hf = hasher(), const key_equal& eql = key_equal(), const allocator_type& a = allocator_type())
+        :table_(table_type::initial_count, hf, eql, a), capacity_(capacity), usage_(0), evicted_(), context_()
+      {}
+
+      ~lru_cache()
+      {
+        clear();
+      }
+
+      /** Sets the function which is called for every entry evicted to fit the capacity, \p context is passed to it */
+      void on_evict(eviction_callback f, void* context = nullptr)
+      {
+        evicted_ = f;
+        context_ = context;
+      }
+
+      ///\name capacity
+      bool      empty()    const { return table_.empty(); }
+      size_type size()     const { return table_.size(); }
+      /** The total charge of the entries */
+      size_type usage()    const { return usage_; }
+      size_type capacity() const { return capacity_; }
+
+      /** Changes the capacity, evicting the entries which do not fit */
+      void set_capacity(size_type capacity)
+      {
+        capacity_ = capacity;
+        evict();
+      }
+
+      ///\name lookup
+      /** Returns the cached value of \p k and marks it as used, or nullptr */
+      mapped_type* get(const key_type& k)
+      {
+        const typename table_type::iterator i = table_.find(k);
+        if(i == table_.end())
+          return nullptr;
+        entry& e = i->second;
+        policy_.touched(&e);
+        return &e.value;
+      }
+
+      /** Copies the cached value of \p k to \p value and marks it as used */
+      bool get(const key_type& k, mapped_type& value)
+      {
+        const mapped_type* p = get(k);
+        if(p)
+          value = *p;
+        return p != nullptr;
+      }
+
+      /** Checks the presence of \p k without marking it as used */
+      bool contains(const key_type& k) const { return table_.contains(k); }
+
+      ///\name modifiers
+      /**
+       *  Caches \p value for \p k charged by \p charge, replacing the previous value, and evicts the entries
+       *  which exceed the capacity. Returns false if the entry itself has been evicted, which happens only if its
+       *  charge exceeds the capacity.
+       **/
+      bool put(const key_type& k, const mapped_type& value, size_type charge = 1)
+      {
+        typename table_type::iterator i = table_.find(k);
+        if(i != table_.end()){
+          entry& e = i->second;
+          e.value = value;
+          usage_ = usage_ - e.charge + charge;
+          e.charge = charge;
+          policy_.touched(&e);
+        }else{
+          if(table_.size() >= table_.bucket_count())
+            table_.rehash(table_.size() + 1);
+          i = table_.insert(make_pair(k, entry(value, charge))).first;
+          entry& e = i->second;
+          e.key = &i->first;
+          policy_.inserted(&e);
+          usage_ += charge;
+        }
+        return evict(&i->second);
+      }
+
+      /** Removes \p k without calling the eviction callback */
+      bool erase(const key_type& k)
+      {
+        const typename table_type::iterator i = table_.find(k);
+        if(i == table_.end())
+          return false;
+        remove(i);
+        return true;
+      }
+
+      /** Removes all entries without calling the eviction callback */
+      void clear()
+      {
+        for(typename table_type::iterator i = table_.begin(); i != table_.end(); ++i)
+          policy_.removed(&i->second);
+        table_.clear();
+        usage_ = 0;
+      }
+
+      ///\name observers
+      hasher hash_function() const { return table_.hash_function(); }
+      key_equal key_eq() const { return table_.key_eq(); }
+      ///\}
+
+    private:
+      lru_cache(const lru_cache&) __deleted;
+      lru_cache& operator=(const lru_cache&) __deleted;
+
+      void remove(typename table_type::iterator i)
+      {
+        policy_.removed(&i->second);
+        usage_ -= i->second.charge;
+        table_.erase(i);
+      }
+
+      /** Evicts the entries over the capacity, returns false if \p keep was among them */
+      bool evict(const entry* keep = nullptr)
+      {
+        bool kept = true;
+        while(usage_ > capacity_ && !table_.empty()){
+          entry* const e = static_cast<entry*>(policy_.victim());
+          if(e == keep){
+            if(table_.size() > 1){
+              // the CLOCK hand may reach the new entry first, give it a second chance
+              policy_.touched(e);
+              continue;
+            }
+            kept = false;
+          }
+          const typename table_type::iterator i = table_.find(*e->key);
+          assert(i != table_.end() && &i->second == e);
+          policy_.removed(e);
+          usage_ -= e->charge;
+          if(evicted_)
+            evicted_(i->first, e->value, context_);
+          table_.erase(i);
+        }
+        return kept;
+      }
+
+    private:
+      table_type        table_;
+      Policy            policy_;
+      size_type         capacity_;
+      size_type         usage_;
+      eviction_callback evicted_;
+      void*             context_;
+    };
+
+    /**
+     *	@brief Thread-safe lru_cache
+     *
+     *  The keys are spread over the independent shards by their hash, every shard is an lru_cache guarded by
+     *  its own mutex and gets an equal part of the capacity, so the replacement order is kept per shard only.
+     *  The lookups return a copy of the value, since the entry may be evicted as soon as the shard is unlocked;
+     *  the eviction callback is called under the lock of the shard.
+     **/
+    template<class Key, class T,
+             class Hash = hash<Key>,
+             class Pred = equal_to<Key>,
+             class Policy = cache::lru,
+             class Allocator = allocator<pair<const Key, T> > >
+    class sharded_lru_cache
+    {
+      typedef lru_cache<Key, T, Hash, Pred, Policy, Allocator> cache_type;
+    public:
+      ///\name types
+      typedef Key                                     key_type;
+      typedef T                                       mapped_type;
+      typedef Hash                                    hasher;
+      typedef Pred                                    key_equal;
+      typedef Policy                                  policy_type;
+      typedef Allocator                               allocator_type;
+      typedef size_t                                  size_type;
+      typedef typename cache_type::eviction_callback  eviction_callback;
+
+      /** default number of shards */
+      static const size_type default_shards = 16;
+      ///\}
+
+    public:
+      ///\name construct/destroy
+      explicit sharded_lru_cache(size_type capacity, size_type shards = default_shards, const hasher& hf = hasher(), const key_equal& eql = key_equal(), const allocator_type& a = allocator_type())
+        :shards_(nullptr), mask_(0), hash_(hf), salloc(a)
+      {
+        // round the number of shards up to the power of two
+        size_type n = 1;
+        while(n < shards)
+          n <<= 1;
+        const size_type part = (capacity + n - 1) / n;
+        shards_ = salloc.allocate(n);
+        mask_ = n - 1;
+        size_type i = 0;
+        __ntl_try{
+          for(; i < n; ++i)
+            new (&shards_[i]) shard(part, hf, eql, a);
+        }
+        __ntl_catch(...){
+          destroy(i);
+          __ntl_rethrow;
+        }
+      }
+
+      ~sharded_lru_cache()
+      {
+        destroy(mask_ + 1);
+      }
+
+      /** Sets the function which is called for every entry evicted to fit the capacity, \p context is passed to it */
+      void on_evict(eviction_callback f, void* context = nullptr)
+      {
+        for(size_type i = 0; i <= mask_; ++i){
+          lock_guard<mutex> lock(shards_[i].m);
+          shards_[i].cache.on_evict(f, context);
+        }
+      }
+
+      ///\name capacity
+      size_type shards() const { return mask_ + 1; }
+
+      size_type size() const
+      {
+        size_type n = 0;
+        for(size_type i = 0; i <= mask_; ++i){
+          lock_guard<mutex> lock(shards_[i].m);
+          n += shards_[i].cache.size();
+        }
+        return n;
+      }
+
+      size_type usage() const
+      {
+        size_type n = 0;
+        for(size_type i = 0; i <= mask_; ++i){
+          lock_guard<mutex> lock(shards_[i].m);
+          n += shards_[i].cache.usage();
+        }
+        return n;
+      }
+
+      ///\name lookup
+      /** Copies the cached value of \p k to \p value and marks it as used */
+      bool get(const key_type& k, mapped_type& value)
+      {
+        shard& s = shard_of(k);
+        lock_guard<mutex> lock(s.m);
+        return s.cache.get(k, value);
+      }
+
+      bool contains(const key_type& k) const
+      {
+        const shard& s = shard_of(k);
+        lock_guard<mutex> lock(s.m);
+        return s.cache.contains(k);
+      }
+
+      ///\name modifiers
+      bool put(const key_type& k, const mapped_type& value, size_type charge = 1)
+      {
+        shard& s = shard_of(k);
+        lock_guard<mutex> lock(s.m);
+        return s.cache.put(k, value, charge);
+      }
+
+      bool erase(const key_type& k)
+      {
+        shard& s = shard_of(k);
+        lock_guard<mutex> lock(s.m);
+        return s.cache.erase(k);
+      }
+
+      void clear()
+      {
+        for(size_type i = 0; i <= mask_; ++i){
+          lock_guard<mutex> lock(shards_[i].m);
+          shards_[i].cache.clear();
+        }
+      }
+      ///\}
+
+    private:
+      sharded_lru_cache(const sharded_lru_cache&) __deleted;
+      sharded_lru_cache& operator=(const sharded_lru_cache&) __deleted;
+
+      struct shard
+      {
+        mutable mutex m;
+        cache_type    cache;
+
+        shard(size_type capacity, const hasher& hf, const key_equal& eql, const allocator_type& a)
+          :cache(capacity, hf, eql, a)
+        {}
+      };
+
+      typedef typename Allocator::template rebind<shard>::other shard_allocator;
+
+      shard& shard_of(const key_type& k) const
+      {
+        // the shard tables use the low bits of the hash, so take the shard from the high bits of the mixed one
+        size_t h = hash_(k);
+        h ^= h >> (sizeof(size_t) * 4);
+        h *= static_cast<size_t>(0x9E3779B97F4A7C15ULL);
+        return shards_[(h >> (sizeof(size_t) * 8 - 16)) & mask_];
+      }
+
+      void destroy(size_type n)
+      {
+        if(!shards_)
+          return;
+        while(n)
+          shards_[--n].~shard();
+        salloc.deallocate(shards_, mask_ + 1);
+      }
+
+    private:
+      shard*          shards_;
+      size_type       mask_;
+      hasher          hash_;
+      shard_allocator salloc;
+    };
+
+    /**@} lib_containers */
+  } // ext
+} // std
+
+#endif // NTL__EXT_LRU_CACHE
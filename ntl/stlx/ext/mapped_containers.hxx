@@ -0,0 +1,893 @@
+/**\file*********************************************************************
+ *                                                                     \brief
+ *  Position-independent containers for the memory-mapped files
+ *
+ ****************************************************************************
+ */
+#ifndef NTL__EXT_MAPPED_CONTAINERS
+#define NTL__EXT_MAPPED_CONTAINERS
+#pragma once
+
+#include "../new.hxx"
+#include "../stdstring.hxx"
+#include "../type_traits.hxx"
+#include "../utility.hxx"
+#include "offset_ptr.hxx"
+
+namespace std
+{
+  namespace ext
+  {
+    /**\addtogroup  lib_containers
+     *@{*/
+
+    /**
+     *	@brief The block of the shared memory or the mapped file which holds the mapped containers
+     *
+     *  The region starts with this header and serves the bump allocations from the rest of the block. All references inside
+     *  the region are offset_ptr, so a structure built in one process is queried in another one at any address of the mapping,
+     *  with no deserialization:
+     *  \code
+     *  // builder
+     *  std::ext::mapped_region* r = std::ext::mapped_region::create(view, size);
+     *  table_type* t = r->construct<table_type>();
+     *  t->insert("key", 42);
+     *  r->set_root(t);
+     *
+     *  // reader, e.g. over the view of ntl::nt::section::mmap()
+     *  std::ext::mapped_region* r = std::ext::mapped_region::attach(view, size);
+     *  table_type* t = r ? r->root<table_type>() : nullptr;
+     *  \endcode
+     *  The processes sharing the region shall have the same pointer size and the same layout of the stored types.
+     *  The freed block returns to the region only if it is the last one allocated, so the region suits the structures
+     *  which are built once and read afterwards. The region is not synchronized.
+     **/
+    class mapped_region:
+      noncopyable
+    {
+    public:
+      static const uint32_t signature = 0x4D4C544E; // 'NTLM'
+
+      /** Formats \p size bytes at \p base as the empty region, returns nullptr if they can't hold the header */
+      static mapped_region* create(void* base, size_t size)
+      {
+        return size >= sizeof(mapped_region) ? ::new(base) mapped_region(size) : nullptr;
+      }
+
+      /** Returns the region created at \p base before, nullptr if the \p size bytes at \p base don't hold the valid one */
+      static mapped_region* attach(void* base, size_t size)
+      {
+        mapped_region* const r = static_cast<mapped_region*>(base);
+        return size >= sizeof(mapped_region) && r->magic == signature && r->header_size == sizeof(mapped_region)
+          && r->size_ <= size && r->top <= r->size_ ? r : nullptr;
+      }
+
+      /** Allocates \p bytes aligned on \p alignment (a power of 2), returns nullptr if the region is full */
+      void* allocate(size_t bytes, size_t alignment)
+      {
+        const size_t p = (top + alignment - 1) & ~(alignment - 1);
+        if(p > size_ || bytes > size_ - p)
+          return nullptr;
+        top = p + bytes;
+        return address(p);
+      }
+
+      void deallocate(void* p, size_t bytes)
+      {
+        if(offset_of(p) + bytes == top)
+          top = offset_of(p);
+      }
+
+      /** Resizes the last allocated block \p p of \p old_size bytes in place, returns false if it is not the last one or the region is full */
+      bool extend(void* p, size_t old_size, size_t new_size)
+      {
+        const size_t at = offset_of(p);
+        if(at + old_size != top || new_size > size_ - at)
+          return false;
+        top = at + new_size;
+        return true;
+      }
+
+      /** Constructs the object in the region, the mapped containers are given the region */
+      template<class T>
+      T* construct();
+
+      /** The object to start the queries of the reader from */
+      template<class T>
+      T* root() const { return static_cast<T*>(root_.get()); }
+
+      void set_root(void* p) { root_ = p; }
+
+      bool owns(const void* p) const
+      {
+        return p >= this && p < address(size_);
+      }
+
+      size_t size() const { return size_; }
+      size_t used() const { return top; }
+
+    private:
+      explicit mapped_region(size_t size)
+        :magic(signature), header_size(sizeof(mapped_region)), size_(size), top(sizeof(mapped_region))
+      {}
+
+      char* address(size_t offset) const
+      {
+        return const_cast<char*>(reinterpret_cast<const char*>(this)) + offset;
+      }
+
+      size_t offset_of(const void* p) const
+      {
+        return static_cast<const char*>(p) - reinterpret_cast<const char*>(this);
+      }
+
+      uint32_t          magic;
+      uint32_t          header_size;
+      size_t            size_;
+      size_t            top;
+      offset_ptr<void>  root_;
+    };
+
+    namespace __
+    {
+      /** The base of the containers which keep their state in the mapped_region */
+      struct mapped_object {};
+
+      inline void* mapped_allocate(mapped_region& r, size_t bytes, size_t alignment)
+      {
+        void* const p = r.allocate(bytes, alignment);
+        if(!p)
+          __ntl_throw(bad_alloc());
+        return p;
+      }
+
+      /** Constructs the plain types from the arguments and the mapped containers from the region and the arguments */
+      template<class T, bool IsMapped = is_base_of<mapped_object, T>::value>
+      struct mapped_construct
+      {
+        static T* construct(void* p, mapped_region&) { return ::new(p) T(); }
+        template<class A>
+        static T* construct(void* p, mapped_region&, const A& a) { return ::new(p) T(a); }
+
+        static void relocate(void* p, mapped_region&, T& from)
+        {
+          ::new(p) T(from);
+          from.~T();
+        }
+      };
+
+      template<class T>
+      struct mapped_construct<T, true>
+      {
+        static T* construct(void* p, mapped_region& r) { return ::new(p) T(r); }
+        template<class A>
+        static T* construct(void* p, mapped_region& r, const A& a) { return ::new(p) T(r, a); }
+
+        // the offsets of the moved object would be wrong, so the contents are swapped into the new one
+        static void relocate(void* p, mapped_region& r, T& from)
+        {
+          (::new(p) T(r))->swap(from);
+          from.~T();
+        }
+      };
+
+      /** FNV-1a, which gives the same hash in every process */
+      inline size_t mapped_hash_bytes(const void* data, size_t size)
+      {
+        const bool wide = sizeof(size_t) > 4;
+        size_t h = wide ? size_t(14695981039346656037ULL) : size_t(2166136261U);
+        const size_t prime = wide ? size_t(1099511628211ULL) : size_t(16777619U);
+        for(const unsigned char* p = static_cast<const unsigned char*>(data), *end = p + size; p != end; ++p)
+          h = (h ^ *p) * prime;
+        return h;
+      }
+    }
+
+    template<class T>
+    inline T* mapped_region::construct()
+    {
+      return __::mapped_construct<T>::construct(__::mapped_allocate(*this, sizeof(T), alignof(T)), *this);
+    }
+
+    /**
+     *	@brief The vector in the mapped_region
+     *  @details The elements are the plain types or the mapped containers, which get the region of the vector.
+     *  The storage grows in place while it is the last block of the region.
+     **/
+    template<class T>
+    class mapped_vector:
+      public __::mapped_object,
+      noncopyable
+    {
+      typedef __::mapped_construct<T> construct_type;
+    public:
+      typedef T                 value_type;
+      typedef T&                reference;
+      typedef const T&          const_reference;
+      typedef T*                iterator;
+      typedef const T*          const_iterator;
+      typedef offset_ptr<T>     pointer;
+      typedef offset_ptr<const T> const_pointer;
+      typedef size_t            size_type;
+      typedef ptrdiff_t         difference_type;
+
+      explicit mapped_vector(mapped_region& r)
+        :region(&r), begin_(), size_(), capacity_()
+      {}
+
+      ~mapped_vector()
+      {
+        clear();
+        if(capacity_)
+          region->deallocate(begin_.get(), capacity_ * sizeof(T));
+      }
+
+      iterator        begin()       { return begin_.get(); }
+      const_iterator  begin() const { return begin_.get(); }
+      iterator        end()         { return begin_.get() + size_; }
+      const_iterator  end()   const { return begin_.get() + size_; }
+
+      size_type size()      const { return size_; }
+      size_type capacity()  const { return capacity_; }
+      bool      empty()     const { return size_ == 0; }
+
+      reference       operator[](size_type n)       { assert(n < size_); return begin_[n]; }
+      const_reference operator[](size_type n) const { assert(n < size_); return begin_.get()[n]; }
+      reference       front()       { return begin_[0]; }
+      const_reference front() const { return begin_.get()[0]; }
+      reference       back()        { return begin_[size_ - 1]; }
+      const_reference back()  const { return begin_.get()[size_ - 1]; }
+      T*              data()        { return begin_.get(); }
+      const T*        data()  const { return begin_.get(); }
+
+      void reserve(size_type n)
+      {
+        if(n > capacity_)
+          reallocate(n);
+      }
+
+      /** Appends the element constructed from \p x, which may refer to an element of this vector */
+      template<class A>
+      void push_back(const A& x)
+      {
+        if(size_ < capacity_ || extend(next_capacity())){
+          construct_type::construct(begin_.get() + size_, *region, x);
+        }else{
+          // the new element is constructed before the old storage is released
+          const size_type n = next_capacity();
+          T* const p = static_cast<T*>(__::mapped_allocate(*region, n * sizeof(T), alignof(T)));
+          __ntl_try {
+            construct_type::construct(p + size_, *region, x);
+          }
+          __ntl_catch(...) {
+            region->deallocate(p, n * sizeof(T));
+            __ntl_rethrow;
+          }
+          adopt(p, n);
+        }
+        ++size_;
+      }
+
+      /** Appends the default element, e.g. the empty mapped container */
+      reference emplace_back()
+      {
+        grow();
+        T* const p = construct_type::construct(begin_.get() + size_, *region);
+        ++size_;
+        return *p;
+      }
+
+      void pop_back()
+      {
+        assert(size_);
+        begin_[--size_].~T();
+      }
+
+      void resize(size_type n)
+      {
+        reserve(n);
+        while(size_ < n)
+          emplace_back();
+        while(size_ > n)
+          pop_back();
+      }
+
+      void clear()
+      {
+        while(size_)
+          pop_back();
+      }
+
+      void swap(mapped_vector& x)
+      {
+        assert(region == x.region);
+        std::ext::swap(begin_, x.begin_);
+        std::swap(size_, x.size_);
+        std::swap(capacity_, x.capacity_);
+      }
+
+    private:
+      size_type next_capacity() const
+      {
+        return capacity_ ? capacity_ * 2 : 4;
+      }
+
+      void grow()
+      {
+        if(size_ == capacity_)
+          reallocate(next_capacity());
+      }
+
+      /** Grows the storage in place if it is the last block of the region */
+      bool extend(size_type n)
+      {
+        if(!capacity_ || !region->extend(begin_.get(), capacity_ * sizeof(T), n * sizeof(T)))
+          return false;
+        capacity_ = n;
+        return true;
+      }
+
+      void reallocate(size_type n)
+      {
+        if(!extend(n))
+          adopt(static_cast<T*>(__::mapped_allocate(*region, n * sizeof(T), alignof(T))), n);
+      }
+
+      /** Moves the elements to the new storage \p p of \p n elements and releases the old one */
+      void adopt(T* p, size_type n)
+      {
+        T* const old = begin_.get();
+        for(size_type i = 0; i < size_; ++i)
+          construct_type::relocate(p + i, *region, old[i]);
+        if(capacity_)
+          region->deallocate(old, capacity_ * sizeof(T));
+        begin_ = p;
+        capacity_ = n;
+      }
+
+      offset_ptr<mapped_region> region;
+      offset_ptr<T> begin_;
+      size_type size_;
+      size_type capacity_;
+    };
+
+    /**
+     *	@brief The string in the mapped_region
+     *  @details Compares and hashes with the character arrays and any string with \c data() and \c size()
+     *  without the conversion, so the mapped tables are queried by the ordinary strings.
+     **/
+    template<class charT, class traits = char_traits<charT> >
+    class basic_mapped_string:
+      public __::mapped_object,
+      noncopyable
+    {
+    public:
+      typedef traits            traits_type;
+      typedef charT             value_type;
+      typedef const charT*      const_iterator;
+      typedef charT*            iterator;
+      typedef size_t            size_type;
+      typedef ptrdiff_t         difference_type;
+
+      explicit basic_mapped_string(mapped_region& r)
+        :region(&r), data_(), size_(), capacity_()
+      {}
+
+      basic_mapped_string(mapped_region& r, const charT* s)
+        :region(&r), data_(), size_(), capacity_()
+      {
+        assign(s);
+      }
+
+      /** Copies any string with data() and size(), e.g. basic_mapped_string and basic_string */
+      template<class String>
+      basic_mapped_string(mapped_region& r, const String& s)
+        :region(&r), data_(), size_(), capacity_()
+      {
+        assign(s.data(), s.size());
+      }
+
+      ~basic_mapped_string()
+      {
+        if(capacity_)
+          region->deallocate(data_.get(), (capacity_ + 1) * sizeof(charT));
+      }
+
+      basic_mapped_string& operator=(const charT* s) { return assign(s); }
+      basic_mapped_string& operator+=(const charT* s) { return append(s, traits::length(s)); }
+      basic_mapped_string& operator+=(charT c) { push_back(c); return *this; }
+
+      basic_mapped_string& assign(const charT* s, size_type n)
+      {
+        if(inside(s)){
+          // the part of this string fits to its storage
+          traits::move(data_.get(), s, n);
+          size_ = n;
+          data_[size_] = charT();
+          return *this;
+        }
+        size_ = 0;
+        return append(s, n);
+      }
+
+      basic_mapped_string& assign(const charT* s)
+      {
+        return assign(s, traits::length(s));
+      }
+
+      basic_mapped_string& append(const charT* s, size_type n)
+      {
+        if(n > capacity_ - size_){
+          // s may point to this string, which moves to the new storage
+          const bool self = inside(s);
+          const size_type offset = self ? s - data_.get() : 0;
+          reserve(size_ + n);
+          if(self)
+            s = data_.get() + offset;
+        }
+        traits::copy(data_.get() + size_, s, n);
+        size_ += n;
+        data_[size_] = charT();
+        return *this;
+      }
+
+      void push_back(charT c)
+      {
+        append(&c, 1);
+      }
+
+      void reserve(size_type n)
+      {
+        if(n <= capacity_)
+          return;
+        if(n < capacity_ * 2)
+          n = capacity_ * 2;
+        charT* const old = data_.get();
+        if(capacity_ && region->extend(old, (capacity_ + 1) * sizeof(charT), (n + 1) * sizeof(charT))){
+          capacity_ = n;
+          return;
+        }
+        charT* const p = static_cast<charT*>(__::mapped_allocate(*region, (n + 1) * sizeof(charT), alignof(charT)));
+        traits::copy(p, c_str(), size_ + 1);
+        if(capacity_)
+          region->deallocate(old, (capacity_ + 1) * sizeof(charT));
+        data_ = p;
+        capacity_ = n;
+      }
+
+      void clear()
+      {
+        if(size_)
+          data_[size_ = 0] = charT();
+      }
+
+      const charT* c_str() const
+      {
+        static const charT empty = charT();
+        return capacity_ ? data_.get() : &empty;
+      }
+      const charT* data() const { return c_str(); }
+
+      size_type size()      const { return size_; }
+      size_type length()    const { return size_; }
+      size_type capacity()  const { return capacity_; }
+      bool      empty()     const { return size_ == 0; }
+
+      const_iterator begin() const { return c_str(); }
+      const_iterator end()   const { return c_str() + size_; }
+      iterator begin() { return data_.get(); }
+      iterator end()   { return data_.get() + size_; }
+
+      const charT& operator[](size_type pos) const { assert(pos <= size_); return c_str()[pos]; }
+      charT& operator[](size_type pos) { assert(pos < size_); return data_[pos]; }
+
+      int compare(const charT* s, size_type n) const
+      {
+        const int r = traits::compare(c_str(), s, size_ < n ? size_ : n);
+        return r ? r : size_ < n ? -1 : size_ > n ? 1 : 0;
+      }
+      int compare(const charT* s) const { return compare(s, traits::length(s)); }
+      int compare(const basic_mapped_string& s) const { return compare(s.data(), s.size()); }
+
+      void swap(basic_mapped_string& x)
+      {
+        assert(region == x.region);
+        std::ext::swap(data_, x.data_);
+        std::swap(size_, x.size_);
+        std::swap(capacity_, x.capacity_);
+      }
+
+    private:
+      bool inside(const charT* s) const
+      {
+        return capacity_ && s >= data_.get() && s <= data_.get() + size_;
+      }
+
+      offset_ptr<mapped_region> region;
+      offset_ptr<charT> data_;
+      size_type size_;
+      size_type capacity_;
+    };
+
+    typedef basic_mapped_string<char>     mapped_string;
+    typedef basic_mapped_string<wchar_t>  mapped_wstring;
+
+    template<class charT, class traits>
+    inline bool operator==(const basic_mapped_string<charT, traits>& a, const basic_mapped_string<charT, traits>& b) { return a.compare(b) == 0; }
+    template<class charT, class traits>
+    inline bool operator==(const basic_mapped_string<charT, traits>& a, const charT* b) { return a.compare(b) == 0; }
+    template<class charT, class traits>
+    inline bool operator==(const charT* a, const basic_mapped_string<charT, traits>& b) { return b.compare(a) == 0; }
+    template<class charT, class traits>
+    inline bool operator!=(const basic_mapped_string<charT, traits>& a, const basic_mapped_string<charT, traits>& b) { return a.compare(b) != 0; }
+    template<class charT, class traits>
+    inline bool operator!=(const basic_mapped_string<charT, traits>& a, const charT* b) { return a.compare(b) != 0; }
+    template<class charT, class traits>
+    inline bool operator!=(const charT* a, const basic_mapped_string<charT, traits>& b) { return b.compare(a) != 0; }
+    template<class charT, class traits>
+    inline bool operator<(const basic_mapped_string<charT, traits>& a, const basic_mapped_string<charT, traits>& b) { return a.compare(b) < 0; }
+
+    /**
+     *	@brief The hash of the mapped_hash_map keys, which is the same in every process
+     *  @details Hashes the bytes of the integral and enumeration keys.
+     **/
+    template<class T>
+    struct mapped_hash
+    {
+      size_t operator()(const T& x) const
+      {
+        return __::mapped_hash_bytes(&x, sizeof(T));
+      }
+    };
+
+    template<class charT, class traits>
+    struct mapped_hash<basic_mapped_string<charT, traits> >
+    {
+      size_t operator()(const charT* s) const
+      {
+        return __::mapped_hash_bytes(s, traits::length(s) * sizeof(charT));
+      }
+
+      /** Hashes any string with data() and size(), e.g. basic_mapped_string and basic_string */
+      template<class String>
+      size_t operator()(const String& s) const
+      {
+        return __::mapped_hash_bytes(s.data(), s.size() * sizeof(charT));
+      }
+    };
+
+    /** The key equality of the mapped_hash_map, which compares the stored key with the one of the query */
+    template<class T>
+    struct mapped_equal_to
+    {
+      template<class K>
+      bool operator()(const T& a, const K& b) const { return a == b; }
+    };
+
+    template<class charT, class traits>
+    struct mapped_equal_to<basic_mapped_string<charT, traits> >
+    {
+      bool operator()(const basic_mapped_string<charT, traits>& a, const charT* b) const
+      {
+        return a.compare(b) == 0;
+      }
+
+      template<class String>
+      bool operator()(const basic_mapped_string<charT, traits>& a, const String& b) const
+      {
+        return a.compare(b.data(), b.size()) == 0;
+      }
+    };
+
+    /**
+     *	@brief The unordered map in the mapped_region
+     *
+     *  The chained hash table with the power of 2 buckets, which doubles when there are more elements than buckets.
+     *  The elements never move, the rehash relinks them. The keys and the values are the plain types or the mapped
+     *  containers; the lookup, insert() and operator[] take any key which \p Hash and \p Pred accept,
+     *  so <tt>mapped_hash_map<mapped_string, int></tt> is queried by <tt>const char*</tt> and \c std::string.
+     *  The hashes are computed identically by all processes.
+     **/
+    template<class Key, class T, class Hash = mapped_hash<Key>, class Pred = mapped_equal_to<Key> >
+    class mapped_hash_map:
+      public __::mapped_object,
+      noncopyable
+    {
+    public:
+      typedef Key       key_type;
+      typedef T         mapped_type;
+      typedef Hash      hasher;
+      typedef Pred      key_equal;
+      typedef size_t    size_type;
+      typedef ptrdiff_t difference_type;
+
+      struct value_type
+      {
+        Key first;
+        T second;
+      };
+
+    private:
+      struct node
+      {
+        offset_ptr<node> next;
+        size_t hash;
+        value_type value;
+      };
+
+      typedef offset_ptr<node> bucket_type;
+
+      template<class V, class Map>
+      class basic_iterator
+      {
+        friend class mapped_hash_map;
+        template<class, class> friend class basic_iterator;
+
+        basic_iterator(Map* map, size_type bucket, node* n)
+          :map(map), bucket(bucket), n(n)
+        {}
+      public:
+        typedef forward_iterator_tag  iterator_category;
+        typedef typename remove_const<V>::type value_type;
+        typedef ptrdiff_t             difference_type;
+        typedef V*                    pointer;
+        typedef V&                    reference;
+
+        basic_iterator()
+          :map(), bucket(), n()
+        {}
+
+        template<class V2, class Map2>
+        basic_iterator(const basic_iterator<V2, Map2>& i)
+          :map(i.map), bucket(i.bucket), n(i.n)
+        {}
+
+        reference operator*() const { return n->value; }
+        pointer operator->() const { return &n->value; }
+
+        basic_iterator& operator++()
+        {
+          n = n->next.get();
+          if(!n)
+            n = map->first_node(bucket + 1, bucket);
+          return *this;
+        }
+
+        basic_iterator operator++(int)
+        {
+          basic_iterator tmp(*this);
+          ++*this;
+          return tmp;
+        }
+
+        friend bool operator==(const basic_iterator& a, const basic_iterator& b) { return a.n == b.n; }
+        friend bool operator!=(const basic_iterator& a, const basic_iterator& b) { return a.n != b.n; }
+
+      private:
+        Map* map;
+        size_type bucket;
+        node* n;
+      };
+
+    public:
+      typedef basic_iterator<value_type, mapped_hash_map>             iterator;
+      typedef basic_iterator<const value_type, const mapped_hash_map> const_iterator;
+
+      explicit mapped_hash_map(mapped_region& r)
+        :region(&r), buckets(), bucket_count_(), size_()
+      {}
+
+      ~mapped_hash_map()
+      {
+        clear();
+        if(bucket_count_)
+          region->deallocate(buckets.get(), bucket_count_ * sizeof(bucket_type));
+      }
+
+      iterator begin()
+      {
+        size_type b;
+        node* const n = first_node(0, b);
+        return iterator(this, b, n);
+      }
+      const_iterator begin() const
+      {
+        size_type b;
+        node* const n = first_node(0, b);
+        return const_iterator(this, b, n);
+      }
+      iterator end() { return iterator(this, bucket_count_, nullptr); }
+      const_iterator end() const { return const_iterator(this, bucket_count_, nullptr); }
+
+      size_type size()          const { return size_; }
+      bool      empty()         const { return size_ == 0; }
+      size_type bucket_count()  const { return bucket_count_; }
+
+      template<class K>
+      iterator find(const K& key)
+      {
+        size_type b;
+        node* const n = find_node(key, hasher()(key), b);
+        return n ? iterator(this, b, n) : end();
+      }
+
+      template<class K>
+      const_iterator find(const K& key) const
+      {
+        size_type b;
+        node* const n = find_node(key, hasher()(key), b);
+        return n ? const_iterator(this, b, n) : end();
+      }
+
+      template<class K>
+      size_type count(const K& key) const
+      {
+        size_type b;
+        return find_node(key, hasher()(key), b) ? 1 : 0;
+      }
+
+      /** Inserts the element with the key and the value constructed from \p key and \p value unless the key is present */
+      template<class K, class V>
+      pair<iterator, bool> insert(const K& key, const V& value)
+      {
+        const size_t h = hasher()(key);
+        size_type b;
+        if(node* const n = find_node(key, h, b))
+          return make_pair(iterator(this, b, n), false);
+        node* const n = new_node(key, h);
+        __ntl_try {
+          __::mapped_construct<T>::construct(&n->value.second, *region, value);
+        }
+        __ntl_catch(...){
+          free_node(n, false);
+          __ntl_rethrow;
+        }
+        return make_pair(link(n), true);
+      }
+
+      /** Returns the value of \p key, inserts the default one (e.g. the empty mapped container) if the key is absent */
+      template<class K>
+      T& operator[](const K& key)
+      {
+        const size_t h = hasher()(key);
+        size_type b;
+        if(node* const n = find_node(key, h, b))
+          return n->value.second;
+        node* const n = new_node(key, h);
+        __ntl_try {
+          __::mapped_construct<T>::construct(&n->value.second, *region);
+        }
+        __ntl_catch(...){
+          free_node(n, false);
+          __ntl_rethrow;
+        }
+        return link(n)->second;
+      }
+
+      template<class K>
+      size_type erase(const K& key)
+      {
+        if(!bucket_count_)
+          return 0;
+        const size_t h = hasher()(key);
+        for(bucket_type* p = &buckets[h & (bucket_count_ - 1)]; node* const n = p->get(); p = &n->next){
+          if(n->hash == h && key_equal()(n->value.first, key)){
+            *p = n->next;
+            free_node(n, true);
+            --size_;
+            return 1;
+          }
+        }
+        return 0;
+      }
+
+      void clear()
+      {
+        for(size_type b = 0; b < bucket_count_; ++b){
+          while(node* n = buckets[b].get()){
+            buckets[b] = n->next;
+            free_node(n, true);
+          }
+        }
+        size_ = 0;
+      }
+
+      void rehash(size_type n)
+      {
+        size_type count = 8;
+        while(count < n)
+          count *= 2;
+        if(count <= bucket_count_)
+          return;
+        bucket_type* const nb = static_cast<bucket_type*>(__::mapped_allocate(*region, count * sizeof(bucket_type), alignof(bucket_type)));
+        for(size_type i = 0; i < count; ++i)
+          ::new(&nb[i]) bucket_type();
+        for(size_type b = 0; b < bucket_count_; ++b){
+          while(node* const n = buckets[b].get()){
+            buckets[b] = n->next;
+            bucket_type& to = nb[n->hash & (count - 1)];
+            n->next = to;
+            to = n;
+          }
+        }
+        if(bucket_count_)
+          region->deallocate(buckets.get(), bucket_count_ * sizeof(bucket_type));
+        buckets = nb;
+        bucket_count_ = count;
+      }
+
+      void swap(mapped_hash_map& x)
+      {
+        assert(region == x.region);
+        std::ext::swap(buckets, x.buckets);
+        std::swap(bucket_count_, x.bucket_count_);
+        std::swap(size_, x.size_);
+      }
+
+    private:
+      template<class K>
+      node* find_node(const K& key, size_t h, size_type& b) const
+      {
+        if(!bucket_count_)
+          return nullptr;
+        b = h & (bucket_count_ - 1);
+        for(node* n = buckets[b].get(); n; n = n->next.get())
+          if(n->hash == h && key_equal()(n->value.first, key))
+            return n;
+        return nullptr;
+      }
+
+      node* first_node(size_type from, size_type& b) const
+      {
+        for(b = from; b < bucket_count_; ++b)
+          if(node* const n = buckets[b].get())
+            return n;
+        return nullptr;
+      }
+
+      template<class K>
+      node* new_node(const K& key, size_t h)
+      {
+        node* const n = static_cast<node*>(__::mapped_allocate(*region, sizeof(node), alignof(node)));
+        ::new(&n->next) bucket_type();
+        n->hash = h;
+        __ntl_try {
+          __::mapped_construct<Key>::construct(&n->value.first, *region, key);
+        }
+        __ntl_catch(...){
+          region->deallocate(n, sizeof(node));
+          __ntl_rethrow;
+        }
+        return n;
+      }
+
+      void free_node(node* n, bool constructed)
+      {
+        if(constructed)
+          n->value.second.~T();
+        n->value.first.~Key();
+        region->deallocate(n, sizeof(node));
+      }
+
+      iterator link(node* n)
+      {
+        if(size_ >= bucket_count_)
+          rehash(bucket_count_ * 2);
+        const size_type b = n->hash & (bucket_count_ - 1);
+        n->next = buckets[b];
+        buckets[b] = n;
+        ++size_;
+        return iterator(this, b, n);
+      }
+
+      offset_ptr<mapped_region> region;
+      offset_ptr<bucket_type> buckets;
+      size_type bucket_count_;
+      size_type size_;
+    };
+
+    /**@} lib_containers */
+  } // ext
+} // std
+
+#endif // NTL__EXT_MAPPED_CONTAINERS
@@ -0,0 +1,198 @@
+/**\file*********************************************************************
+ *                                                                     \brief
+ *  Fixed-size node pool allocator
+ *
+ ****************************************************************************
+ */
+#ifndef NTL__EXT_NODE_POOL_ALLOCATOR
+#define NTL__EXT_NODE_POOL_ALLOCATOR
+#pragma once
+
+#include "../atomic.hxx"
+#include "../memory.hxx"
+
+namespace std
+{
+  namespace ext
+  {
+    /**\addtogroup  lib_memory
+     *@{*/
+
+    /**
+     *	@brief The pools of node_pool_allocator
+     *
+     *  A pool policy provides the nested template \c pool<NodeSize,ChunkSize> with the static \c allocate() and
+     *  \c deallocate(void*) of a single node. The pools are shared by all allocators of the same node size,
+     *  they take the chunks of \c ChunkSize nodes from the global operator new and keep them for the lifetime of the process.
+     **/
+    namespace node_pool
+    {
+      /** The pool shared by all threads with the lock-free free list */
+      struct lock_free
+      {
+        template<size_t NodeSize, size_t ChunkSize>
+        class pool
+        {
+          struct node { node* next; };
+
+          // the head of the free list carries the version counter in the bits above the address,
+          // which protects the pop from the ABA problem
+          static const unsigned tag_shift = sizeof(void*) == 8 ? 48 : 32;
+          static const uint64_t address_mask = (uint64_t(1) << tag_shift) - 1;
+
+          static uint64_t pack(node* p, uint64_t version)
+          {
+            return (static_cast<uint64_t>(reinterpret_cast<uintptr_t>(p)) & address_mask) | version << tag_shift;
+          }
+
+          static node* unpack(uint64_t head)
+          {
+            // the high part of the address is the sign extension of its top bit
+            const int64_t address = static_cast<int64_t>(head << (64 - tag_shift)) >> (64 - tag_shift);
+            return reinterpret_cast<node*>(static_cast<uintptr_t>(address));
+          }
+
+          static uint64_t version(uint64_t head) { return head >> tag_shift; }
+
+          static void push(node* first, node* last)
+          {
+            uint64_t h = free_list.load(memory_order_relaxed);
+            do{
+              last->next = unpack(h);
+            }while(!free_list.compare_exchange_weak(h, pack(first, version(h) + 1), memory_order_release, memory_order_relaxed));
+          }
+
+          static node* grow()
+          {
+            char* const chunk = static_cast<char*>(::operator new(NodeSize * ChunkSize));
+            node* const first = reinterpret_cast<node*>(chunk);
+            if(ChunkSize > 1){
+              for(size_t i = 1; i < ChunkSize - 1; ++i)
+                reinterpret_cast<node*>(chunk + i * NodeSize)->next = reinterpret_cast<node*>(chunk + (i + 1) * NodeSize);
+              push(reinterpret_cast<node*>(chunk + NodeSize), reinterpret_cast<node*>(chunk + (ChunkSize - 1) * NodeSize));
+            }
+            return first;
+          }
+
+        public:
+          static void* allocate()
+          {
+            uint64_t h = free_list.load(memory_order_acquire);
+            for(;;){
+              node* const p = unpack(h);
+              if(!p)
+                return grow();
+              // p may be taken and reused by another thread meanwhile, then the version has changed and the exchange fails
+              if(free_list.compare_exchange_weak(h, pack(p->next, version(h) + 1), memory_order_acquire, memory_order_acquire))
+                return p;
+            }
+          }
+
+          static void deallocate(void* p)
+          {
+            push(static_cast<node*>(p), static_cast<node*>(p));
+          }
+
+        private:
+          static atomic_ullong free_list;
+        };
+      };
+
+      /**
+       *	@brief The pool of the calling thread
+       *  @details Takes no synchronization at all. A node freed by another thread joins the pool of that thread;
+       *  the nodes cached by a thread are not reclaimed when it exits.
+       **/
+      struct per_thread
+      {
+        template<size_t NodeSize, size_t ChunkSize>
+        class pool
+        {
+          struct node { node* next; };
+
+        public:
+          static void* allocate()
+          {
+            node* p = free_list;
+            if(!p){
+              char* const chunk = static_cast<char*>(::operator new(NodeSize * ChunkSize));
+              for(size_t i = 1; i < ChunkSize; ++i)
+                reinterpret_cast<node*>(chunk + i * NodeSize)->next = i + 1 < ChunkSize ? reinterpret_cast<node*>(chunk + (i + 1) * NodeSize) : nullptr;
+              free_list = ChunkSize > 1 ? reinterpret_cast<node*>(chunk + NodeSize) : nullptr;
+              return chunk;
+            }
+            free_list = p->next;
+            return p;
+          }
+
+          static void deallocate(void* p)
+          {
+            node* const n = static_cast<node*>(p);
+            n->next = free_list;
+            free_list = n;
+          }
+
+        private:
+          static __thread_local node* free_list;
+        };
+      };
+
+      template<size_t NodeSize, size_t ChunkSize>
+      atomic_ullong lock_free::pool<NodeSize, ChunkSize>::free_list;
+
+      template<size_t NodeSize, size_t ChunkSize>
+      __thread_local typename per_thread::pool<NodeSize, ChunkSize>::node* per_thread::pool<NodeSize, ChunkSize>::free_list;
+    }
+
+    /**
+     *	@brief Fixed-size node pool allocator
+     *
+     *  Serves the single object allocations of the node-based containers from the pool of the nodes of the same size,
+     *  so a rebind of the allocator to the node type of \c list, \c forward_list, \c rb_tree or \c chained_hashtable
+     *  gets the nodes from the chunked free lists instead of the general heap. The array allocations (the vector storage,
+     *  the bucket arrays) are passed to \c std::allocator.
+     *
+     *  The allocator is stateless, all allocators with the same \p ChunkSize and \p Pool are equal.
+     *  The kernel mode drivers may use \c ntl::km::lookaside_node_pool, which keeps the nodes in the nonpaged lookaside lists.
+     **/
+    template<class T, size_t ChunkSize = 64, class Pool = node_pool::lock_free>
+    class node_pool_allocator:
+      public std::allocator<T>
+    {
+      static_assert(ChunkSize > 0, "chunk shall hold at least one node");
+
+      static const size_t node_size = sizeof(T) < sizeof(void*) ? sizeof(void*) : (sizeof(T) + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+      typedef typename Pool::template pool<node_size, ChunkSize> pool_type;
+    public:
+      typedef typename std::allocator<T>::pointer   pointer;
+      typedef typename std::allocator<T>::size_type size_type;
+      template<class U> struct rebind { typedef node_pool_allocator<U, ChunkSize, Pool> other; };
+
+      node_pool_allocator() __ntl_nothrow {}
+      node_pool_allocator(const node_pool_allocator&) __ntl_nothrow {}
+      template<class U> node_pool_allocator(const node_pool_allocator<U, ChunkSize, Pool>&) __ntl_nothrow {}
+
+      pointer allocate(size_type n, const void* hint = 0)
+      {
+        return n == 1 ? static_cast<pointer>(pool_type::allocate()) : std::allocator<T>::allocate(n, hint);
+      }
+
+      void deallocate(pointer p, size_type n)
+      {
+        if(n == 1)
+          pool_type::deallocate(p);
+        else
+          std::allocator<T>::deallocate(p, n);
+      }
+    };
+
+    template<class T, class U, size_t ChunkSize, class Pool>
+    inline bool operator==(const node_pool_allocator<T, ChunkSize, Pool>&, const node_pool_allocator<U, ChunkSize, Pool>&) __ntl_nothrow { return true; }
+    template<class T, class U, size_t ChunkSize, class Pool>
+    inline bool operator!=(const node_pool_allocator<T, ChunkSize, Pool>&, const node_pool_allocator<U, ChunkSize, Pool>&) __ntl_nothrow { return false; }
+
+    /**@} lib_memory */
+  } // ext
+} // std
+
+#endif // NTL__EXT_NODE_POOL_ALLOCATOR
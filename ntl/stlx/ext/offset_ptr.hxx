@@ -0,0 +1,162 @@
+/**\file*********************************************************************
+ *                                                                     \brief
+ *  Self-relative pointer
+ *
+ ****************************************************************************
+ */
+#ifndef NTL__EXT_OFFSET_PTR
+#define NTL__EXT_OFFSET_PTR
+#pragma once
+
+#include "../cstddef.hxx"
+#include "../iterator.hxx"
+#include "../memory.hxx"
+#include "../type_traits.hxx"
+
+namespace std
+{
+  namespace ext
+  {
+    /**\addtogroup  lib_memory
+     *@{*/
+
+    namespace __
+    {
+      template<class T> struct offset_ptr_reference { typedef T& type; };
+      template<> struct offset_ptr_reference<void> { typedef void type; };
+      template<> struct offset_ptr_reference<const void> { typedef void type; };
+    }
+
+    /**
+     *	@brief Pointer which keeps the distance from itself to the object
+     *
+     *  The offset_ptr inside a block of memory which points into the same block keeps its value wherever the block
+     *  is placed, so the structures linked with offset_ptr may be written to a file or shared memory and used
+     *  at another address, e.g. in another process. It is the fancy pointer for \c pointer_traits and a random access iterator.
+     *  The copy of an offset_ptr points to the same object as the original.
+     **/
+    template<class T>
+    class offset_ptr
+    {
+      template<class> friend class offset_ptr;
+
+      // the offset of 1 can't address the object because the pointer itself occupies that byte
+      static const ptrdiff_t null_offset = 1;
+
+      struct explicit_bool { int _; };
+      typedef int explicit_bool::*  explicit_bool_type;
+    public:
+      typedef T                                                 element_type;
+      typedef typename remove_cv<T>::type                       value_type;
+      typedef ptrdiff_t                                         difference_type;
+      typedef offset_ptr                                        pointer;
+      typedef typename __::offset_ptr_reference<T>::type        reference;
+      typedef random_access_iterator_tag                        iterator_category;
+      template<class U> struct rebind { typedef offset_ptr<U> other; };
+
+      offset_ptr() __ntl_nothrow
+        :offset(null_offset)
+      {}
+
+      offset_ptr(nullptr_t) __ntl_nothrow
+        :offset(null_offset)
+      {}
+
+      offset_ptr(T* p) __ntl_nothrow
+      {
+        set(p);
+      }
+
+      offset_ptr(const offset_ptr& r) __ntl_nothrow
+      {
+        set(r.get());
+      }
+
+      template<class U>
+      offset_ptr(const offset_ptr<U>& r, typename enable_if<is_convertible<U*, T*>::value>::type* = 0) __ntl_nothrow
+      {
+        set(static_cast<T*>(r.get()));
+      }
+
+      offset_ptr& operator=(const offset_ptr& r) __ntl_nothrow
+      {
+        set(r.get());
+        return *this;
+      }
+
+      offset_ptr& operator=(T* p) __ntl_nothrow
+      {
+        set(p);
+        return *this;
+      }
+
+      template<class U>
+      static offset_ptr pointer_to(U& r) __ntl_nothrow
+      {
+        return offset_ptr(std::addressof(r));
+      }
+
+      T* get() const __ntl_nothrow
+      {
+        return offset == null_offset ? nullptr : reinterpret_cast<T*>(const_cast<char*>(reinterpret_cast<const volatile char*>(this)) + offset);
+      }
+
+      reference operator*() const __ntl_nothrow { return *get(); }
+      T* operator->() const __ntl_nothrow { return get(); }
+      reference operator[](difference_type n) const __ntl_nothrow { return get()[n]; }
+
+      operator explicit_bool_type() const __ntl_nothrow { return offset != null_offset ? &explicit_bool::_ : 0; }
+
+      offset_ptr& operator++() __ntl_nothrow { return *this = get() + 1; }
+      offset_ptr& operator--() __ntl_nothrow { return *this = get() - 1; }
+      offset_ptr operator++(int) __ntl_nothrow { offset_ptr tmp(*this); ++*this; return tmp; }
+      offset_ptr operator--(int) __ntl_nothrow { offset_ptr tmp(*this); --*this; return tmp; }
+      offset_ptr& operator+=(difference_type n) __ntl_nothrow { return *this = get() + n; }
+      offset_ptr& operator-=(difference_type n) __ntl_nothrow { return *this = get() - n; }
+
+      friend offset_ptr operator+(const offset_ptr& p, difference_type n) __ntl_nothrow { return p.get() + n; }
+      friend offset_ptr operator+(difference_type n, const offset_ptr& p) __ntl_nothrow { return p.get() + n; }
+      friend offset_ptr operator-(const offset_ptr& p, difference_type n) __ntl_nothrow { return p.get() - n; }
+      friend difference_type operator-(const offset_ptr& a, const offset_ptr& b) __ntl_nothrow { return a.get() - b.get(); }
+
+      friend bool operator==(const offset_ptr& a, const offset_ptr& b) __ntl_nothrow { return a.get() == b.get(); }
+      friend bool operator!=(const offset_ptr& a, const offset_ptr& b) __ntl_nothrow { return a.get() != b.get(); }
+      friend bool operator< (const offset_ptr& a, const offset_ptr& b) __ntl_nothrow { return a.get() <  b.get(); }
+      friend bool operator> (const offset_ptr& a, const offset_ptr& b) __ntl_nothrow { return a.get() >  b.get(); }
+      friend bool operator<=(const offset_ptr& a, const offset_ptr& b) __ntl_nothrow { return a.get() <= b.get(); }
+      friend bool operator>=(const offset_ptr& a, const offset_ptr& b) __ntl_nothrow { return a.get() >= b.get(); }
+
+    private:
+      void set(const volatile void* p) __ntl_nothrow
+      {
+        offset = p ? reinterpret_cast<const volatile char*>(p) - reinterpret_cast<const volatile char*>(this) : null_offset;
+      }
+
+      ptrdiff_t offset;
+    };
+
+    template<class T>
+    inline void swap(offset_ptr<T>& a, offset_ptr<T>& b) __ntl_nothrow
+    {
+      T* const p = a.get();
+      a = b.get();
+      b = p;
+    }
+
+    template<class T, class U>
+    inline offset_ptr<T> static_pointer_cast(const offset_ptr<U>& r) __ntl_nothrow
+    {
+      return static_cast<T*>(r.get());
+    }
+
+    template<class T, class U>
+    inline offset_ptr<T> const_pointer_cast(const offset_ptr<U>& r) __ntl_nothrow
+    {
+      return const_cast<T*>(r.get());
+    }
+
+    /**@} lib_memory */
+  } // ext
+} // std
+
+#endif // NTL__EXT_OFFSET_PTR
@@ -12,7 +12,76 @@ namespace std
   {
     namespace tree
     {
-      template<class T, class Compare = std::less<T>, class Allocator = std::allocator<T> >
+      /**
+       *  Augmentation policies of rb_tree.
+       *
+       *  A policy keeps the metadata of a subtree in its root node: the node derives from <tt>data<T></tt> and
+       *  <tt>update(x)</tt> recomputes the metadata of \c x from its element and its children (\c child[0] and \c child[1]).
+       *  The tree calls it bottom-up along the modified path and for both nodes of every rotation.
+       **/
+      namespace augment
+      {
+        /** No metadata */
+        struct none
+        {
+          template<class T> struct data {};
+          template<class Node> static void update(Node*) {}
+        };
+
+        /** The number of nodes in the subtree, enables rb_tree::nth() and rb_tree::rank() */
+        struct subtree_size
+        {
+          template<class T> struct data
+          {
+            size_t subtree_size;
+          };
+
+          template<class Node>
+          static size_t size(const Node* x) { return x ? x->subtree_size : 0; }
+
+          template<class Node>
+          static void update(Node* x)
+          {
+            x->subtree_size = 1 + size(x->child[0]) + size(x->child[1]);
+          }
+        };
+
+        /** The endpoints of the closed interval \c T, shall be specialized for the user interval types */
+        template<class T>
+        struct interval_traits;
+
+        template<class E>
+        struct interval_traits<pair<E, E> >
+        {
+          typedef E endpoint_type;
+          static const E& low (const pair<E, E>& x) { return x.first;  }
+          static const E& high(const pair<E, E>& x) { return x.second; }
+        };
+
+        /**
+         *  The greatest high endpoint in the subtree, enables rb_tree::find_overlap() and rb_tree::for_each_overlap().
+         *  The tree shall be ordered by the low endpoints.
+         **/
+        struct interval_max
+        {
+          template<class T> struct data
+          {
+            typename interval_traits<T>::endpoint_type max_high;
+          };
+
+          template<class Node>
+          static void update(Node* x)
+          {
+            typedef interval_traits<typename Node::value_type> traits;
+            x->max_high = traits::high(x->elem);
+            for(int i = 0; i < 2; ++i)
+              if(x->child[i] && x->max_high < x->child[i]->max_high)
+                x->max_high = x->child[i]->max_high;
+          }
+        };
+      } // augment
+
+      template<class T, class Compare = std::less<T>, class Allocator = std::allocator<T>, class Augment = augment::none>
       class rb_tree
       {
         typedef typename
@@ -44,8 +113,10 @@ namespace std
           return b ? right : left;
         }
 
-        struct node
+        struct node:
+          Augment::template data<T>
         {
+          typedef T value_type;
           enum color_type { black, red, colors };
           union
           {
@@ -106,7 +177,7 @@ namespace std
           node& operator=(const node& n);
         };
 
-        typedef typename rb_tree<T, Compare, Allocator>::node node_type;
+        typedef typename rb_tree<T, Compare, Allocator, Augment>::node node_type;
 
         struct iterator_impl:
           std::iterator<std::bidirectional_iterator_tag, value_type, difference_type, pointer, reference>
@@ -130,12 +201,12 @@ namespace std
 
         protected:
           node_type* p;
-          rb_tree<T, Compare, Allocator>* tree_;
+          rb_tree<T, Compare, Allocator, Augment>* tree_;
 
           friend struct const_iterator_impl;
-          friend class rb_tree<T,Compare, Allocator>;
+          friend class rb_tree<T, Compare, Allocator, Augment>;
 
-          iterator_impl(node_type* const p, rb_tree<T, Compare, Allocator>* tree)
+          iterator_impl(node_type* const p, rb_tree<T, Compare, Allocator, Augment>* tree)
             :p(p), tree_(tree)
           {}
 
@@ -174,9 +245,9 @@ namespace std
 
         private:
           const node_type* p;
-          const rb_tree<T, Compare, Allocator>* tree_;
+          const rb_tree<T, Compare, Allocator, Augment>* tree_;
 
-          const_iterator_impl(const node_type* const p, const rb_tree<T, Compare, Allocator>* tree)
+          const_iterator_impl(const node_type* const p, const rb_tree<T, Compare, Allocator, Augment>* tree)
             :p(p), tree_(tree)
           {}
 
@@ -408,6 +479,7 @@ namespace std
             np->color(node::black);
             first_ = last_ = root_ = np;
             ++count_;
+            Augment::update(np);
             return make_iterator(root_);
           }
           assert(place != nullptr);
@@ -420,6 +492,7 @@ namespace std
           else if(q == last_ && greater)
             last_  = np;
           ++count_;
+          augment_path(np);
           // balance tree
           fixup_insert(np);
           return make_iterator(np);
@@ -491,6 +564,8 @@ namespace std
             using std::swap;
             swap(succ->elem, erasable->elem);
           }
+          // the path from the removed node contains the erasable one
+          augment_path(succ->parent());
           if ( succ->color() == node::black && x )
           {
             if ( !prev_root )
@@ -525,7 +600,7 @@ namespace std
           return pos == end() ? 0 : (erase(pos), 1);
         }
 
-        void swap(rb_tree<T, Compare, Allocator>& tree)
+        void swap(rb_tree<T, Compare, Allocator, Augment>& tree)
         {
           if ( this != &tree )
           {
@@ -575,6 +650,64 @@ namespace std
         // observes
         value_compare value_comp() const { return comparator_; }
 
+        // order statistics, require augment::subtree_size
+        /** Returns the element at the zero-based position \p k in the order or end() if <tt>k >= size()</tt> */
+        iterator nth(size_type k)
+        {
+          node* p = root_;
+          while(p){
+            const size_type l = augment::subtree_size::size(p->child[left]);
+            if(k == l)
+              break;
+            if(k < l){
+              p = p->child[left];
+            }else{
+              k -= l + 1;
+              p = p->child[right];
+            }
+          }
+          return make_iterator(p);
+        }
+
+        const_iterator nth(size_type k) const { return const_cast<rb_tree*>(this)->nth(k); }
+
+        /** Returns the number of elements preceding \p position */
+        size_type rank(const_iterator position) const
+        {
+          const node* p = position.p;
+          if(!p)
+            return count_;
+          size_type r = augment::subtree_size::size(p->child[left]);
+          for(const node* q = p->parent(); q; p = q, q = q->parent())
+            if(p == q->child[right])
+              r += augment::subtree_size::size(q->child[left]) + 1;
+          return r;
+        }
+
+        // interval queries, require augment::interval_max
+        /** Returns an element which overlaps the closed interval [\p lo, \p hi] or end() */
+        template<class E>
+        iterator find_overlap(const E& lo, const E& hi)
+        {
+          typedef augment::interval_traits<T> traits;
+          node* p = root_;
+          while(p && (hi < traits::low(p->elem) || traits::high(p->elem) < lo)){
+            node* const l = p->child[left];
+            p = l && !(l->max_high < lo) ? l : p->child[right];
+          }
+          return make_iterator(p);
+        }
+
+        template<class E>
+        const_iterator find_overlap(const E& lo, const E& hi) const { return const_cast<rb_tree*>(this)->find_overlap(lo, hi); }
+
+        /** Calls \p f for every element which overlaps the closed interval [\p lo, \p hi] in the order */
+        template<class E, class F>
+        void for_each_overlap(const E& lo, const E& hi, F f) const
+        {
+          for_each_overlap(root_, lo, hi, f);
+        }
+
       protected:
         node* next(node* from, direction_type direction) const __ntl_nothrow
         {
@@ -627,6 +760,17 @@ namespace std
           }
           prev->child[direction] = x;
           x->parent(prev);
+          Augment::update(x);
+          Augment::update(prev);
+        }
+
+        /** recomputes the metadata from \p p up to the root */
+        void augment_path(node* p) __ntl_nothrow
+        {
+          if(is_same<Augment, augment::none>::value)
+            return;
+          for(; p; p = p->parent())
+            Augment::update(p);
         }
 
         node* fixup_insert(node* x, direction_type direction) __ntl_nothrow
@@ -726,6 +870,21 @@ namespace std
           return comparator_(y, x);
         }
 
+        template<class E, class F>
+        static void for_each_overlap(const node* p, const E& lo, const E& hi, F& f)
+        {
+          typedef augment::interval_traits<T> traits;
+          // no interval of the subtree reaches lo
+          for(; p && !(p->max_high < lo); p = p->child[right]){
+            for_each_overlap(p->child[left], lo, hi, f);
+            // the rest of the subtree starts after hi
+            if(hi < traits::low(p->elem))
+              break;
+            if(!(traits::high(p->elem) < lo))
+              f(p->elem);
+          }
+        }
+
         iterator make_iterator(node* p)
         {
           return iterator(p, this);
@@ -755,45 +914,45 @@ namespace std
         typename allocator_type::template rebind<node_type>::other node_allocator;
       };
 
-      template<class T, class Compare, class Allocator>
-      inline bool operator == (const rb_tree<T, Compare, Allocator>& x, const rb_tree<T, Compare, Allocator>& y)
+      template<class T, class Compare, class Allocator, class Augment>
+      inline bool operator == (const rb_tree<T, Compare, Allocator, Augment>& x, const rb_tree<T, Compare, Allocator, Augment>& y)
       {
         return x.size() == y.size() && equal(x.cbegin(), x.cend(), y.cbegin());
       }
 
-      template<class T, class Compare, class Allocator>
-      inline bool operator != (const rb_tree<T, Compare, Allocator>& x, const rb_tree<T, Compare, Allocator>& y)
+      template<class T, class Compare, class Allocator, class Augment>
+      inline bool operator != (const rb_tree<T, Compare, Allocator, Augment>& x, const rb_tree<T, Compare, Allocator, Augment>& y)
       {
         return std::rel_ops::operator !=(x, y);
       }
 
-      template<class T, class Compare, class Allocator>
-      inline bool operator < (const rb_tree<T, Compare, Allocator>& x, const rb_tree<T, Compare, Allocator>& y)
+      template<class T, class Compare, class Allocator, class Augment>
+      inline bool operator < (const rb_tree<T, Compare, Allocator, Augment>& x, const rb_tree<T, Compare, Allocator, Augment>& y)
       {
         return lexicographical_compare(x.cbegin(), x.cend(), y.cbegin(), y.cend());
       }
 
-      template<class T, class Compare, class Allocator>
-      inline bool operator > (const rb_tree<T, Compare, Allocator>& x, const rb_tree<T, Compare, Allocator>& y)
+      template<class T, class Compare, class Allocator, class Augment>
+      inline bool operator > (const rb_tree<T, Compare, Allocator, Augment>& x, const rb_tree<T, Compare, Allocator, Augment>& y)
       {
         return std::rel_ops::operator >(x, y);
       }
 
-      template<class T, class Compare, class Allocator>
-      inline bool operator <= (const rb_tree<T, Compare, Allocator>& x, const rb_tree<T, Compare, Allocator>& y)
+      template<class T, class Compare, class Allocator, class Augment>
+      inline bool operator <= (const rb_tree<T, Compare, Allocator, Augment>& x, const rb_tree<T, Compare, Allocator, Augment>& y)
       {
         return std::rel_ops::operator <=(x, y);
       }
 
-      template<class T, class Compare, class Allocator>
-      inline bool operator >= (const rb_tree<T, Compare, Allocator>& x, const rb_tree<T, Compare, Allocator>& y)
+      template<class T, class Compare, class Allocator, class Augment>
+      inline bool operator >= (const rb_tree<T, Compare, Allocator, Augment>& x, const rb_tree<T, Compare, Allocator, Augment>& y)
       {
         return std::rel_ops::operator >=(x, y);
       }
 
       // specialized algorithms
-      template<class T, class Compare, class Allocator>
-      inline void swap(rb_tree<T, Compare, Allocator>& x, rb_tree<T, Compare, Allocator>& y)
+      template<class T, class Compare, class Allocator, class Augment>
+      inline void swap(rb_tree<T, Compare, Allocator, Augment>& x, rb_tree<T, Compare, Allocator, Augment>& y)
       {
         x.swap(y);
       }
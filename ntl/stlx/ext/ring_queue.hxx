@@ -0,0 +1,521 @@
+/**\file*********************************************************************
+ *                                                                     \brief
+ *  Bounded lock-free ring buffer queues
+ *
+ ****************************************************************************
+ */
+#ifndef NTL__EXT_RING_QUEUE
+#define NTL__EXT_RING_QUEUE
+#pragma once
+
+#include "../algorithm.hxx"
+#include "../atomic.hxx"
+#include "../condition_variable.hxx"
+#include "../memory.hxx"
+
+namespace std
+{
+  namespace ext
+  {
+    /**\addtogroup  lib_containers *********** 23 Containers library [containers]
+     *@{*/
+
+    namespace ring
+    {
+      /** The size of the cache line the indices of the producers and consumers are separated by */
+      static const size_t cache_line_size = 64;
+
+      /**
+       *	@brief Blocking support for the lock-free queues
+       *  @details The queue operations stay lock-free: the waiter registers itself and rechecks the queue under the lock,
+       *  the other side publishes its change with a sequentially consistent store and then looks for the waiters,
+       *  so either the waiter sees the change or the notifier sees the waiter.
+       **/
+      class event
+      {
+      public:
+        event()
+          :waiters(0)
+        {}
+
+        /** Blocks while <tt>(q.*blocked)()</tt> returns \c true */
+        template<class Queue>
+        void wait(const Queue& q, bool (Queue::*blocked)() const)
+        {
+          unique_lock<mutex> lock(m);
+          waiters.fetch_add(1); // orders the registration before the check
+          while((q.*blocked)())
+            cv.wait(lock);
+          waiters.fetch_sub(1, memory_order_relaxed);
+        }
+
+        /** Wakes the waiters up; shall follow the sequentially consistent publication of the change */
+        void notify()
+        {
+          if(waiters.load(memory_order_relaxed) != 0){
+            lock_guard<mutex> lock(m);
+            cv.notify_all();
+          }
+        }
+
+      private:
+        event(const event&) __deleted;
+        event& operator=(const event&) __deleted;
+
+        mutex m;
+        condition_variable cv;
+        atomic_size_t waiters;
+      };
+    }
+
+    /**
+     *	@brief Single producer single consumer bounded queue
+     *
+     *  A lock-free ring of \p N elements (a power of two) stored in the object. The producer and the consumer
+     *  indices live on separate cache lines together with the cached copy of the opposite index, so the sides
+     *  touch each other's line only when the ring looks full or empty.
+     *
+     *  try_push()/try_pop() never block, push()/pop() wait on the condition variable when the ring is full or empty.
+     *  The batch operations move several elements with a single index publication.
+     *  Only one thread may push and only one thread may pop at a time.
+     **/
+    template<class T, size_t N>
+    class spsc_ring
+    {
+      static_assert(N >= 2 && (N & (N-1)) == 0, "the capacity shall be a power of two");
+
+      typedef typename aligned_storage<sizeof(T), alignment_of<T>::value>::type slot_type;
+    public:
+      typedef T       value_type;
+      typedef size_t  size_type;
+
+      spsc_ring()
+        :head_cache_(0), tail_cache_(0)
+      {}
+
+      ~spsc_ring()
+      {
+        for(size_t h = head_.load(memory_order_relaxed), t = tail_.load(memory_order_relaxed); h != t; ++h)
+          slot(h)->~T();
+      }
+
+      ///\name capacity
+      static size_type capacity() { return N; }
+
+      /** The number of elements, exact only when called by the producer or the consumer with the other side idle */
+      size_type size() const
+      {
+        const size_t h = head_.load(memory_order_acquire);
+        return tail_.load(memory_order_acquire) - h;
+      }
+
+      bool empty() const { return head_.load(memory_order_acquire) == tail_.load(memory_order_acquire); }
+      bool full()  const { return tail_.load(memory_order_acquire) - head_.load(memory_order_acquire) == N; }
+
+      ///\name producer
+      /** Appends a copy of \p x unless the ring is full */
+      bool try_push(const T& x)
+      {
+        const size_t t = tail_.load(memory_order_relaxed);
+        if(!free_space(t, 1))
+          return false;
+        ::new(static_cast<void*>(slot(t))) T(x);
+        publish_tail(t+1);
+        return true;
+      }
+
+    #ifdef NTL_CXX_RV
+      bool try_push(T&& x)
+      {
+        const size_t t = tail_.load(memory_order_relaxed);
+        if(!free_space(t, 1))
+          return false;
+        ::new(static_cast<void*>(slot(t))) T(move(x));
+        publish_tail(t+1);
+        return true;
+      }
+    #endif
+
+      /** Appends up to \p n elements from \p first, returns the number of elements appended */
+      template<class InputIterator>
+      size_type try_push_n(InputIterator first, size_type n)
+      {
+        const size_t t = tail_.load(memory_order_relaxed);
+        n = min(n, free_space(t, n));
+        size_type i = 0;
+        __ntl_try{
+          for(; i < n; ++i, ++first)
+            ::new(static_cast<void*>(slot(t+i))) T(*first);
+        }
+        __ntl_catch(...){
+          if(i)
+            publish_tail(t+i);
+          __ntl_rethrow;
+        }
+        if(n)
+          publish_tail(t+n);
+        return n;
+      }
+
+      /** Appends a copy of \p x, waits while the ring is full */
+      void push(const T& x)
+      {
+        while(!try_push(x))
+          not_full_.wait(*this, &spsc_ring::full);
+      }
+
+    #ifdef NTL_CXX_RV
+      void push(T&& x)
+      {
+        while(!try_push(forward<T>(x)))
+          not_full_.wait(*this, &spsc_ring::full);
+      }
+    #endif
+
+      ///\name consumer
+      /** Moves the first element to \p x unless the ring is empty */
+      bool try_pop(T& x)
+      {
+        const size_t h = head_.load(memory_order_relaxed);
+        if(!available(h, 1))
+          return false;
+        T* const p = slot(h);
+        x = move(*p);
+        p->~T();
+        publish_head(h+1);
+        return true;
+      }
+
+      /** Moves up to \p n first elements to \p out, returns the number of elements moved */
+      template<class OutputIterator>
+      size_type try_pop_n(OutputIterator out, size_type n)
+      {
+        const size_t h = head_.load(memory_order_relaxed);
+        n = min(n, available(h, n));
+        size_type i = 0;
+        __ntl_try{
+          for(; i < n; ++i, ++out){
+            T* const p = slot(h+i);
+            *out = move(*p);
+            p->~T();
+          }
+        }
+        __ntl_catch(...){
+          // the element failed to move stays in the ring
+          if(i)
+            publish_head(h+i);
+          __ntl_rethrow;
+        }
+        if(n)
+          publish_head(h+n);
+        return n;
+      }
+
+      /** Moves the first element to \p x, waits while the ring is empty */
+      void pop(T& x)
+      {
+        while(!try_pop(x))
+          not_empty_.wait(*this, &spsc_ring::empty);
+      }
+      ///\}
+
+    private:
+      T* slot(size_t i) { return reinterpret_cast<T*>(&slots_[i & (N-1)]); }
+
+      /** free slots at \p t, refreshes the consumer index only if less than \p n are known to be free */
+      size_t free_space(size_t t, size_t n)
+      {
+        size_t space = N - (t - head_cache_);
+        if(space < n){
+          head_cache_ = head_.load(memory_order_acquire);
+          space = N - (t - head_cache_);
+        }
+        return space;
+      }
+
+      /** ready elements at \p h, refreshes the producer index only if less than \p n are known to be ready */
+      size_t available(size_t h, size_t n)
+      {
+        size_t ready = tail_cache_ - h;
+        if(ready < n){
+          tail_cache_ = tail_.load(memory_order_acquire);
+          ready = tail_cache_ - h;
+        }
+        return ready;
+      }
+
+      void publish_tail(size_t t)
+      {
+        tail_.store(t, memory_order_seq_cst);
+        not_empty_.notify();
+      }
+
+      void publish_head(size_t h)
+      {
+        head_.store(h, memory_order_seq_cst);
+        not_full_.notify();
+      }
+
+    private:
+      spsc_ring(const spsc_ring&) __deleted;
+      spsc_ring& operator=(const spsc_ring&) __deleted;
+
+      char          pad0_[ring::cache_line_size];
+      // producer line
+      atomic_size_t tail_;
+      size_t        head_cache_;
+      char          pad1_[ring::cache_line_size - sizeof(atomic_size_t) - sizeof(size_t)];
+      // consumer line
+      atomic_size_t head_;
+      size_t        tail_cache_;
+      char          pad2_[ring::cache_line_size - sizeof(atomic_size_t) - sizeof(size_t)];
+
+      ring::event   not_empty_, not_full_;
+      slot_type     slots_[N];
+    };
+
+
+    /**
+     *	@brief Multiple producers multiple consumers bounded queue
+     *
+     *  A lock-free ring with a sequence number in every slot (D. Vyukov's bounded MPMC queue): a producer claims
+     *  the slot by advancing the enqueue position and publishes it by bumping the slot sequence, a consumer does
+     *  the same with the dequeue position. The capacity is set at construction and rounded up to a power of two.
+     *
+     *  try_push()/try_pop() never block, push()/pop() wait on the condition variable when the ring is full or empty.
+     **/
+    template<class T, class Allocator = allocator<T> >
+    class mpmc_ring
+    {
+      struct cell
+      {
+        atomic_size_t sequence;
+        bool constructed;
+        typename aligned_storage<sizeof(T), alignment_of<T>::value>::type storage;
+
+        T* value() { return reinterpret_cast<T*>(&storage); }
+      };
+      typedef typename Allocator::template rebind<cell>::other cell_allocator;
+    public:
+      typedef T         value_type;
+      typedef size_t    size_type;
+      typedef Allocator allocator_type;
+
+      /** Creates the ring of at least \p capacity elements */
+      explicit mpmc_ring(size_type capacity, const Allocator& a = Allocator())
+        :alloc_(a), cells_(), mask_()
+      {
+        size_type n = 2;
+        while(n < capacity)
+          n <<= 1;
+        cells_ = alloc_.allocate(n);
+        for(size_type i = 0; i < n; ++i){
+          ::new(static_cast<void*>(cells_+i)) cell;
+          cells_[i].sequence.store(i, memory_order_relaxed);
+        }
+        mask_ = n - 1;
+      }
+
+      ~mpmc_ring()
+      {
+        for(size_t pos = dequeue_pos_.load(memory_order_relaxed), end = enqueue_pos_.load(memory_order_relaxed); pos != end; ++pos)
+          if(cells_[pos & mask_].constructed)
+            cells_[pos & mask_].value()->~T();
+        for(size_type i = 0; i <= mask_; ++i)
+          cells_[i].~cell();
+        alloc_.deallocate(cells_, mask_+1);
+      }
+
+      ///\name capacity
+      size_type capacity() const { return mask_ + 1; }
+
+      /** The approximate number of elements */
+      size_type size() const
+      {
+        const size_t d = dequeue_pos_.load(memory_order_acquire), e = enqueue_pos_.load(memory_order_acquire);
+        return e > d ? min(e - d, capacity()) : 0;
+      }
+
+      /** Checks whether the next slot to pop from is not ready */
+      bool empty() const
+      {
+        const size_t pos = dequeue_pos_.load(memory_order_acquire);
+        return static_cast<ptrdiff_t>(cells_[pos & mask_].sequence.load(memory_order_acquire) - (pos+1)) < 0;
+      }
+
+      /** Checks whether the next slot to push to is not released yet */
+      bool full() const
+      {
+        const size_t pos = enqueue_pos_.load(memory_order_acquire);
+        return static_cast<ptrdiff_t>(cells_[pos & mask_].sequence.load(memory_order_acquire) - pos) < 0;
+      }
+
+      ///\name producers
+      /** Appends a copy of \p x unless the ring is full */
+      bool try_push(const T& x)
+      {
+        size_t pos;
+        cell* const c = claim_push(pos);
+        if(!c)
+          return false;
+        __ntl_try{
+          ::new(static_cast<void*>(c->value())) T(x);
+        }
+        __ntl_catch(...){
+          abandon(c, pos);
+          __ntl_rethrow;
+        }
+        publish_push(c, pos);
+        return true;
+      }
+
+    #ifdef NTL_CXX_RV
+      bool try_push(T&& x)
+      {
+        size_t pos;
+        cell* const c = claim_push(pos);
+        if(!c)
+          return false;
+        __ntl_try{
+          ::new(static_cast<void*>(c->value())) T(move(x));
+        }
+        __ntl_catch(...){
+          abandon(c, pos);
+          __ntl_rethrow;
+        }
+        publish_push(c, pos);
+        return true;
+      }
+    #endif
+
+      /** Appends a copy of \p x, waits while the ring is full */
+      void push(const T& x)
+      {
+        while(!try_push(x))
+          not_full_.wait(*this, &mpmc_ring::full);
+      }
+
+    #ifdef NTL_CXX_RV
+      void push(T&& x)
+      {
+        while(!try_push(forward<T>(x)))
+          not_full_.wait(*this, &mpmc_ring::full);
+      }
+    #endif
+
+      ///\name consumers
+      /** Moves the first element to \p x unless the ring is empty */
+      bool try_pop(T& x)
+      {
+        for(;;){
+          size_t pos;
+          cell* const c = claim_pop(pos);
+          if(!c)
+            return false;
+          if(!c->constructed){
+            // the producer has failed to construct the element
+            release_pop(c, pos);
+            continue;
+          }
+          T* const p = c->value();
+          __ntl_try{
+            x = move(*p);
+          }
+          __ntl_catch(...){
+            p->~T();
+            release_pop(c, pos);
+            __ntl_rethrow;
+          }
+          p->~T();
+          release_pop(c, pos);
+          return true;
+        }
+      }
+
+      /** Moves the first element to \p x, waits while the ring is empty */
+      void pop(T& x)
+      {
+        while(!try_pop(x))
+          not_empty_.wait(*this, &mpmc_ring::empty);
+      }
+      ///\}
+
+    private:
+      /** claims the slot to push to or returns null if the ring is full */
+      cell* claim_push(size_t& pos)
+      {
+        pos = enqueue_pos_.load(memory_order_relaxed);
+        for(;;){
+          cell* const c = &cells_[pos & mask_];
+          const ptrdiff_t dif = static_cast<ptrdiff_t>(c->sequence.load(memory_order_acquire) - pos);
+          if(dif == 0){
+            if(enqueue_pos_.compare_exchange_weak(pos, pos+1, memory_order_relaxed, memory_order_relaxed))
+              return c;
+          }else if(dif < 0){
+            return nullptr;
+          }else{
+            pos = enqueue_pos_.load(memory_order_relaxed);
+          }
+        }
+      }
+
+      void publish_push(cell* c, size_t pos)
+      {
+        c->constructed = true;
+        c->sequence.store(pos+1, memory_order_seq_cst);
+        not_empty_.notify();
+      }
+
+      /** the claimed slot can't be given back, so it is published empty and skipped by the consumers */
+      void abandon(cell* c, size_t pos)
+      {
+        c->constructed = false;
+        c->sequence.store(pos+1, memory_order_seq_cst);
+        not_empty_.notify();
+      }
+
+      /** claims the slot to pop from or returns null if the ring is empty */
+      cell* claim_pop(size_t& pos)
+      {
+        pos = dequeue_pos_.load(memory_order_relaxed);
+        for(;;){
+          cell* const c = &cells_[pos & mask_];
+          const ptrdiff_t dif = static_cast<ptrdiff_t>(c->sequence.load(memory_order_acquire) - (pos+1));
+          if(dif == 0){
+            if(dequeue_pos_.compare_exchange_weak(pos, pos+1, memory_order_relaxed, memory_order_relaxed))
+              return c;
+          }else if(dif < 0){
+            return nullptr;
+          }else{
+            pos = dequeue_pos_.load(memory_order_relaxed);
+          }
+        }
+      }
+
+      void release_pop(cell* c, size_t pos)
+      {
+        c->sequence.store(pos + mask_ + 1, memory_order_seq_cst);
+        not_full_.notify();
+      }
+
+    private:
+      mpmc_ring(const mpmc_ring&) __deleted;
+      mpmc_ring& operator=(const mpmc_ring&) __deleted;
+
+      cell_allocator  alloc_;
+      cell*           cells_;
+      size_t          mask_;
+      char            pad0_[ring::cache_line_size];
+      atomic_size_t   enqueue_pos_;
+      char            pad1_[ring::cache_line_size - sizeof(atomic_size_t)];
+      atomic_size_t   dequeue_pos_;
+      char            pad2_[ring::cache_line_size - sizeof(atomic_size_t)];
+
+      ring::event     not_empty_, not_full_;
+    };
+
+    /**@} lib_containers */
+  } // ext
+} // std
+
+#endif // NTL__EXT_RING_QUEUE
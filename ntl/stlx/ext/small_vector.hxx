@@ -0,0 +1,711 @@
+/**\file*********************************************************************
+ *                                                                     \brief
+ *  Vector with the inline storage
+ *
+ ****************************************************************************
+ */
+#ifndef NTL__EXT_SMALL_VECTOR
+#define NTL__EXT_SMALL_VECTOR
+#pragma once
+
+#include "../algorithm.hxx"
+#include "../memory.hxx"
+#include "../stdexcept_fwd.hxx"
+
+namespace std
+{
+  namespace ext
+  {
+    /**\addtogroup  lib_containers *********** 23 Containers library [containers]
+     *@{*/
+
+    /**
+     *	@brief Vector with the inline storage
+     *
+     *  small_vector has the interface of \c std::vector, but keeps up to \p N elements inside the object itself
+     *  and uses the allocator only when it grows beyond that. Moving a spilled small_vector steals its heap block;
+     *  the inline elements are moved one by one, so the move and swap are not O(1) and invalidate the iterators
+     *  of the inline vectors.
+     *
+     *  The storage grows twice the capacity, the capacity never drops below \p N.
+     **/
+    template <class T, size_t N, class Allocator = allocator<T> >
+    class small_vector
+    {
+      static_assert(N > 0, "small_vector requires a non-empty inline storage");
+
+      typedef typename
+        Allocator::template rebind<T>::other        allocator;
+    public:
+      typedef           T                           value_type;
+      typedef           Allocator                   allocator_type;
+      typedef typename  allocator::pointer          pointer;
+      typedef typename  allocator::const_pointer    const_pointer;
+      typedef       value_type&                     reference;
+      typedef const value_type&                     const_reference;
+      typedef typename  allocator::size_type        size_type;
+      typedef typename  allocator::difference_type  difference_type;
+
+      typedef pointer                               iterator;
+      typedef const_pointer                         const_iterator;
+      typedef std::reverse_iterator<iterator>       reverse_iterator;
+      typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+      /** Number of the elements stored inline */
+      static const size_type inline_capacity = N;
+
+    public:
+      ///\name construct/copy/destroy
+      explicit small_vector(const Allocator& a = Allocator())
+        :array_allocator(a)
+      {
+        reset();
+      }
+
+      explicit small_vector(size_type n)
+      {
+        reset();
+        __ntl_try{
+          resize(n);
+        }
+        __ntl_catch(...){
+          dispose();
+          __ntl_rethrow;
+        }
+      }
+
+      small_vector(size_type n, const T& value, const Allocator& a = Allocator())
+        :array_allocator(a)
+      {
+        reset();
+        __ntl_try{
+          insert(end_, n, value);
+        }
+        __ntl_catch(...){
+          dispose();
+          __ntl_rethrow;
+        }
+      }
+
+      template <class InputIterator>
+      small_vector(InputIterator first, InputIterator last, const Allocator& a = Allocator(), typename enable_if<!is_integral<InputIterator>::value>::type* =0)
+        :array_allocator(a)
+      {
+        reset();
+        __ntl_try{
+          insert(end_, first, last);
+        }
+        __ntl_catch(...){
+          dispose();
+          __ntl_rethrow;
+        }
+      }
+
+      small_vector(const small_vector& x)
+        :array_allocator(x.array_allocator)
+      {
+        reset();
+        __ntl_try{
+          insert(end_, x.begin(), x.end());
+        }
+        __ntl_catch(...){
+          dispose();
+          __ntl_rethrow;
+        }
+      }
+
+      small_vector(initializer_list<T> il, const Allocator& a = Allocator())
+        :array_allocator(a)
+      {
+        reset();
+        __ntl_try{
+          insert(end_, il.begin(), il.end());
+        }
+        __ntl_catch(...){
+          dispose();
+          __ntl_rethrow;
+        }
+      }
+
+    #ifdef NTL_CXX_RV
+      small_vector(small_vector&& x)
+        :array_allocator(x.array_allocator)
+      {
+        reset();
+        steal(x);
+      }
+    #endif
+
+      ~small_vector() __ntl_nothrow
+      {
+        dispose();
+      }
+
+      small_vector& operator=(const small_vector& x)
+      {
+        if(this != &x)
+          assign(x.begin(), x.end());
+        return *this;
+      }
+
+    #ifdef NTL_CXX_RV
+      small_vector& operator=(small_vector&& x)
+      {
+        if(this != &x){
+          dispose();
+          reset();
+          steal(x);
+        }
+        return *this;
+      }
+    #endif
+
+      small_vector& operator=(initializer_list<T> il)
+      {
+        assign(il.begin(), il.end());
+        return *this;
+      }
+
+      template <class InputIterator>
+      void assign(InputIterator first, InputIterator last, typename enable_if<!is_integral<InputIterator>::value>::type* =0)
+      {
+        clear();
+        insert(end_, first, last);
+      }
+
+      void assign(size_type n, const T& u)
+      {
+        if(n > capacity()){
+          // `u` may live inside, so copy it before releasing the storage
+          small_vector tmp(n, u, get_allocator());
+          swap(tmp);
+        }else{
+          const size_type len = size();
+          std::fill_n(begin_, min(n, len), u);
+          if(n < len)
+            erase(begin_ + n, end_);
+          else
+            insert(end_, n - len, u);
+        }
+      }
+
+      void assign(initializer_list<T> il)
+      {
+        assign(il.begin(), il.end());
+      }
+
+      allocator_type get_allocator() const  { return static_cast<allocator_type>(array_allocator); }
+
+      ///\name iterators
+      iterator                begin()       { return begin_; }
+      const_iterator          begin() const { return begin_; }
+      iterator                end()         { return end_; }
+      const_iterator          end()   const { return end_; }
+
+      reverse_iterator        rbegin()       { return reverse_iterator(end_); }
+      const_reverse_iterator  rbegin() const { return const_reverse_iterator(end_); }
+      reverse_iterator        rend()         { return reverse_iterator(begin_); }
+      const_reverse_iterator  rend()   const { return const_reverse_iterator(begin_); }
+
+      const_iterator          cbegin() const { return begin(); }
+      const_iterator          cend()   const { return end(); }
+      const_reverse_iterator  crbegin()const { return rbegin(); }
+      const_reverse_iterator  crend()  const { return rend(); }
+
+      ///\name capacity
+      size_type size()      const { return static_cast<size_type>(end_- begin_); }
+      size_type max_size()  const { return array_allocator.max_size(); }
+      size_type capacity()  const { return capacity_; }
+      bool      empty()     const { return begin_ == end_; }
+
+      /** Returns true if the elements are kept in the inline storage */
+      bool is_inline()      const { return begin_ == inline_begin(); }
+
+      void resize(size_type sz)
+      {
+        if(sz > max_size())
+          __throw_length_error(__name__": `sz` too large");
+        if(sz < size())
+          erase(begin_ + sz, end_);
+        else{
+          reserve(sz);
+          while(end_ != begin_ + sz){
+          #if !defined(NTL_CXX_RV) || defined(NTL_CXX_RVFIX)
+            array_allocator.construct(end_, T());
+          #else
+            array_allocator.construct(end_, forward<value_type>(T()));
+          #endif
+            ++end_;
+          }
+        }
+      }
+
+      void resize(size_type sz, const T& c)
+      {
+        if(sz > max_size())
+          __throw_length_error(__name__": `sz` too large");
+        if(sz < size())
+          erase(begin_ + sz, end_);
+        else
+          insert(end_, sz - size(), c);
+      }
+
+      void reserve(size_type n) __ntl_throws(bad_alloc, length_error)
+      {
+        if(n > max_size())
+          __throw_length_error(__name__": size too big");
+        if(capacity_ < n)
+          relocate(array_allocator.allocate(n), n, size(), 0);
+      }
+
+      /** A non-binding request to reduce capacity() to max(size(), N); moves the elements back inline if they fit */
+      void shrink_to_fit()
+      {
+        if(is_inline() || capacity_ == size())
+          return;
+        if(size() <= N)
+          relocate(inline_begin(), N, size(), 0);
+        else
+          relocate(array_allocator.allocate(size()), size(), size(), 0);
+      }
+
+      ///\name element access
+      reference       operator[](size_type n)       { return *(begin_ + n); }
+      const_reference operator[](size_type n) const { return *(begin_ + n); }
+
+      const_reference at(size_type n) const __ntl_throws(out_of_range)
+      {
+        check_bounds(n);
+        return operator[](n);
+      }
+
+      reference at(size_type n) __ntl_throws(out_of_range)
+      {
+        check_bounds(n);
+        return operator[](n);
+      }
+
+      reference       front()       __ntl_nothrow { return *begin(); }
+      const_reference front() const __ntl_nothrow { return *begin(); }
+      reference       back()        __ntl_nothrow { return *(end() - 1); }
+      const_reference back()  const __ntl_nothrow { return *(end() - 1); }
+
+      ///\name data access
+      pointer       data()        __ntl_nothrow { return begin_; }
+      const_pointer data() const  __ntl_nothrow { return begin_; }
+
+      ///\name modifiers
+    #ifdef NTL_CXX_VT
+      template <class... Args> void emplace_back(Args&&... args)
+      {
+        if(end_ == begin_ + capacity_){
+          // the arguments may refer to the elements, construct the new one before relocation
+          const size_type cap = grow_capacity(1), len = size();
+          pointer mem = array_allocator.allocate(cap);
+          __ntl_try{
+            array_allocator.construct(mem + len, std::forward<Args>(args)...);
+          }
+          __ntl_catch(...){
+            array_allocator.deallocate(mem, cap);
+            __ntl_rethrow;
+          }
+          relocate(mem, cap, len, 1);
+        }else{
+          array_allocator.construct(end_, std::forward<Args>(args)...);
+          ++end_;
+        }
+      }
+
+      template <class... Args> iterator emplace(const_iterator position, Args&&... args)
+      {
+        const size_type index = position - begin_;
+        if(position == end_){
+          emplace_back(std::forward<Args>(args)...);
+        }else if(end_ != begin_ + capacity_){
+          value_type x(std::forward<Args>(args)...);
+          shift_insert(index, x);
+        }else{
+          const size_type cap = grow_capacity(1);
+          pointer mem = array_allocator.allocate(cap);
+          __ntl_try{
+            array_allocator.construct(mem + index, std::forward<Args>(args)...);
+          }
+          __ntl_catch(...){
+            array_allocator.deallocate(mem, cap);
+            __ntl_rethrow;
+          }
+          relocate(mem, cap, index, 1);
+        }
+        return begin_ + index;
+      }
+    #endif
+
+    #ifdef NTL_CXX_RV
+      void push_back(T&& x)
+      {
+        if(end_ == begin_ + capacity_){
+          const size_type cap = grow_capacity(1), len = size();
+          pointer mem = array_allocator.allocate(cap);
+          __ntl_try{
+            array_allocator.construct(mem + len, forward<value_type>(x));
+          }
+          __ntl_catch(...){
+            array_allocator.deallocate(mem, cap);
+            __ntl_rethrow;
+          }
+          relocate(mem, cap, len, 1);
+        }else{
+          array_allocator.construct(end_, forward<value_type>(x));
+          ++end_;
+        }
+      }
+    #endif
+
+      void push_back(const T& x)
+      {
+        if(end_ == begin_ + capacity_){
+          const size_type cap = grow_capacity(1), len = size();
+          pointer mem = array_allocator.allocate(cap);
+          __ntl_try{
+            array_allocator.construct(mem + len, x);
+          }
+          __ntl_catch(...){
+            array_allocator.deallocate(mem, cap);
+            __ntl_rethrow;
+          }
+          relocate(mem, cap, len, 1);
+        }else{
+          array_allocator.construct(end_, x);
+          ++end_;
+        }
+      }
+
+      void pop_back() __ntl_nothrow { array_allocator.destroy(--end_); }
+
+      iterator insert(const_iterator position, const T& x)
+      {
+        const size_type index = position - begin_;
+        if(position == end_){
+          push_back(x);
+        }else if(end_ != begin_ + capacity_){
+          value_type tmp(x);
+          shift_insert(index, tmp);
+        }else{
+          const size_type cap = grow_capacity(1);
+          pointer mem = array_allocator.allocate(cap);
+          __ntl_try{
+            array_allocator.construct(mem + index, x);
+          }
+          __ntl_catch(...){
+            array_allocator.deallocate(mem, cap);
+            __ntl_rethrow;
+          }
+          relocate(mem, cap, index, 1);
+        }
+        return begin_ + index;
+      }
+
+    #ifdef NTL_CXX_RV
+      iterator insert(const_iterator position, T&& x)
+      {
+        const size_type index = position - begin_;
+        if(position == end_)
+          push_back(forward<value_type>(x));
+        else if(end_ != begin_ + capacity_)
+          shift_insert(index, x);
+        else{
+          const size_type cap = grow_capacity(1);
+          pointer mem = array_allocator.allocate(cap);
+          __ntl_try{
+            array_allocator.construct(mem + index, forward<value_type>(x));
+          }
+          __ntl_catch(...){
+            array_allocator.deallocate(mem, cap);
+            __ntl_rethrow;
+          }
+          relocate(mem, cap, index, 1);
+        }
+        return begin_ + index;
+      }
+    #endif
+
+      iterator insert(const_iterator position, size_type n, const T& x)
+      {
+        const size_type index = position - begin_, len = size();
+        if(n == 0)
+          return begin_ + index;
+        if(len + n > capacity_){
+          // fill the new storage first, `x` may live in the old one
+          const size_type cap = grow_capacity(n);
+          pointer mem = array_allocator.allocate(cap);
+          __ntl_try{
+            uninitialized_fill_n(mem + index, n, x);
+          }
+          __ntl_catch(...){
+            array_allocator.deallocate(mem, cap);
+            __ntl_rethrow;
+          }
+          relocate(mem, cap, index, n);
+        }else{
+          // append and rotate into place, the existing elements stay where they are until `x` is copied
+          append_n(n, x);
+          std::rotate(begin_ + index, begin_ + len, end_);
+        }
+        return begin_ + index;
+      }
+
+      template <class InputIterator>
+      iterator insert(const_iterator position, InputIterator first, InputIterator last, typename enable_if<!is_integral<InputIterator>::value>::type* =0)
+      {
+        return insert__disp(position, first, last, typename iterator_traits<InputIterator>::iterator_category());
+      }
+
+      iterator insert(const_iterator position, initializer_list<T> il)
+      {
+        return insert__disp(position, il.begin(), il.end(), forward_iterator_tag());
+      }
+
+      iterator erase(const_iterator position) __ntl_nothrow
+      {
+        iterator i = const_cast<iterator>(position);
+        std::move(i + 1, end_, i);
+        array_allocator.destroy(--end_);
+        return i;
+      }
+
+      iterator erase(const_iterator first, const_iterator last) __ntl_nothrow
+      {
+        iterator first_ = const_cast<iterator>(first), last_ = const_cast<iterator>(last);
+        if(first_ != last_){
+          iterator new_end = std::move(last_, end_, first_);
+          destroy(new_end, end_);
+          end_ = new_end;
+        }
+        return first_;
+      }
+
+      void swap(small_vector& x)
+      {
+        if(this == &x)
+          return;
+        if(!is_inline() && !x.is_inline()){
+          using std::swap;
+          swap(begin_, x.begin_);
+          swap(end_, x.end_);
+          swap(capacity_, x.capacity_);
+        }else{
+          small_vector tmp(std::move(x));
+          x = std::move(*this);
+          *this = std::move(tmp);
+        }
+      }
+
+      void clear() __ntl_nothrow
+      {
+        destroy(begin_, end_);
+        end_ = begin_;
+      }
+      ///\}
+
+    private:
+      typedef typename aligned_storage<sizeof(T) * N, alignment_of<T>::value>::type storage_type;
+
+      pointer   begin_;
+      pointer   end_;
+      size_type capacity_;
+      storage_type storage_;
+
+      mutable allocator array_allocator;
+
+      pointer inline_begin() const { return reinterpret_cast<pointer>(const_cast<storage_type*>(&storage_)); }
+
+      void reset()
+      {
+        begin_ = end_ = inline_begin();
+        capacity_ = N;
+      }
+
+      void dispose()
+      {
+        clear();
+        if(!is_inline())
+          array_allocator.deallocate(begin_, capacity_);
+      }
+
+      void destroy(pointer first, pointer last)
+      {
+        if(!__::no_dtor<T>::value)
+          for(; first != last; ++first)
+            array_allocator.destroy(first);
+      }
+
+      void check_bounds(size_type n) const __ntl_throws(out_of_range)
+      {
+        if(n >= size()) __throw_out_of_range(__name__": no such element.");
+      }
+
+      size_type grow_capacity(size_type n) const
+      {
+        const size_type len = size();
+        if(max_size() - len < n)
+          __throw_length_error(__name__": size too big");
+        return max(len + n, capacity_ * 2);
+      }
+
+      /** Takes the elements of \p x: the heap block is stolen, the inline elements are moved one by one */
+      void steal(small_vector& x)
+      {
+        if(x.is_inline()){
+          for(pointer p = x.begin_; p != x.end_; ++p, ++end_)
+            array_allocator.construct(end_, std::move(*p));
+          x.clear();
+        }else{
+          begin_ = x.begin_, end_ = x.end_, capacity_ = x.capacity_;
+          x.reset();
+        }
+      }
+
+      /**
+       *  Moves the elements to \p mem (of \p cap elements), leaving a gap of \p gap elements at \p index,
+       *  which the caller has already constructed, and releases the old storage.
+       **/
+      void relocate(pointer mem, size_type cap, size_type index, size_type gap)
+      {
+        pointer dest = mem;
+        for(pointer src = begin_; src != end_; ++src, ++dest){
+          if(src == begin_ + index)
+            dest += gap;
+          array_allocator.construct(dest, std::move(*src));
+          array_allocator.destroy(src);
+        }
+        if(index == size())
+          dest += gap;
+        if(!is_inline())
+          array_allocator.deallocate(begin_, capacity_);
+        begin_ = mem, end_ = dest, capacity_ = cap;
+      }
+
+      /** Makes room at \p index by shifting the tail right and moves \p x there; requires a spare capacity */
+      void shift_insert(size_type index, value_type& x)
+      {
+        array_allocator.construct(end_, std::move(*(end_ - 1)));
+        ++end_;
+        pointer pos = begin_ + index;
+        std::move_backward(pos, end_ - 2, end_ - 1);
+        *pos = std::move(x);
+      }
+
+      void append_n(size_type n, const T& x)
+      {
+        const pointer old_end = end_;
+        __ntl_try{
+          for(; n; --n, ++end_)
+            array_allocator.construct(end_, x);
+        }
+        __ntl_catch(...){
+          destroy(old_end, end_);
+          end_ = old_end;
+          __ntl_rethrow;
+        }
+      }
+
+      template <class InputIterator>
+      iterator insert__disp(const_iterator position, InputIterator first, InputIterator last, input_iterator_tag)
+      {
+        const size_type index = position - begin_, len = size();
+        __ntl_try{
+          for(; first != last; ++first)
+            push_back(*first);
+        }
+        __ntl_catch(...){
+          erase(begin_ + len, end_);
+          __ntl_rethrow;
+        }
+        std::rotate(begin_ + index, begin_ + len, end_);
+        return begin_ + index;
+      }
+
+      template <class ForwardIterator>
+      iterator insert__disp(const_iterator position, ForwardIterator first, ForwardIterator last, forward_iterator_tag)
+      {
+        const size_type index = position - begin_, len = size(),
+          n = static_cast<size_type>(std::distance(first, last));
+        if(len + n > capacity_){
+          // the range may refer to the elements, copy it before relocation
+          const size_type cap = grow_capacity(n);
+          pointer mem = array_allocator.allocate(cap), p = mem + index;
+          __ntl_try{
+            for(; first != last; ++first, ++p)
+              array_allocator.construct(p, *first);
+          }
+          __ntl_catch(...){
+            while(p != mem + index)
+              array_allocator.destroy(--p);
+            array_allocator.deallocate(mem, cap);
+            __ntl_rethrow;
+          }
+          relocate(mem, cap, index, n);
+        }else{
+          const pointer old_end = end_;
+          __ntl_try{
+            for(; first != last; ++first, ++end_)
+              array_allocator.construct(end_, *first);
+          }
+          __ntl_catch(...){
+            destroy(old_end, end_);
+            end_ = old_end;
+            __ntl_rethrow;
+          }
+          std::rotate(begin_ + index, begin_ + len, end_);
+        }
+        return begin_ + index;
+      }
+    };
+
+    ///\name small_vector comparisons
+    template <class T, size_t N, class Allocator>
+    inline bool operator==(const small_vector<T, N, Allocator>& x, const small_vector<T, N, Allocator>& y)
+    {
+      return x.size() == y.size() && equal(x.begin(), x.end(), y.begin());
+    }
+
+    template <class T, size_t N, class Allocator>
+    inline bool operator< (const small_vector<T, N, Allocator>& x, const small_vector<T, N, Allocator>& y)
+    {
+      return lexicographical_compare(x.begin(), x.end(), y.begin(), y.end());
+    }
+
+    template <class T, size_t N, class Allocator>
+    inline bool operator!=(const small_vector<T, N, Allocator>& x, const small_vector<T, N, Allocator>& y)
+    {
+      return rel_ops::operator !=(x, y);
+    }
+
+    template <class T, size_t N, class Allocator>
+    inline bool operator> (const small_vector<T, N, Allocator>& x, const small_vector<T, N, Allocator>& y)
+    {
+      return rel_ops::operator >(x, y);
+    }
+
+    template <class T, size_t N, class Allocator>
+    inline bool operator>=(const small_vector<T, N, Allocator>& x, const small_vector<T, N, Allocator>& y)
+    {
+      return rel_ops::operator >=(x, y);
+    }
+
+    template <class T, size_t N, class Allocator>
+    inline bool operator<=(const small_vector<T, N, Allocator>& x, const small_vector<T, N, Allocator>& y)
+    {
+      return rel_ops::operator <=(x, y);
+    }
+
+    ///\name small_vector specialized algorithms
+    template <class T, size_t N, class Allocator>
+    inline void swap(small_vector<T, N, Allocator>& x, small_vector<T, N, Allocator>& y) { x.swap(y); }
+    ///\}
+
+    /**@} lib_containers */
+  } // ext
+} // std
+
+#endif // NTL__EXT_SMALL_VECTOR
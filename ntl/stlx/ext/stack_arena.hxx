@@ -0,0 +1,171 @@
+/**\file*********************************************************************
+ *                                                                     \brief
+ *  Arena allocator with the inline storage
+ *
+ ****************************************************************************
+ */
+#ifndef NTL__EXT_STACK_ARENA
+#define NTL__EXT_STACK_ARENA
+#pragma once
+
+#include "../cassert.hxx"
+#include "../cstddef.hxx"
+#include "../memory.hxx"
+#include "../utility.hxx"
+#include "../type_traits.hxx"
+
+namespace std
+{
+  namespace ext
+  {
+    /**\addtogroup  lib_memory
+     *@{*/
+
+    /**
+     *	@brief Bump allocation from a buffer of the caller
+     *  @details The freed block returns to the arena only if it is the last one allocated, the rest is reclaimed
+     *  by the destruction or reset() of the arena. The arena is not synchronized.
+     **/
+    class buffer_arena:
+      noncopyable
+    {
+    public:
+      buffer_arena(void* buffer, size_t size) __ntl_nothrow
+        :buf(static_cast<char*>(buffer)), end(static_cast<char*>(buffer) + size), top(static_cast<char*>(buffer))
+      {}
+
+      /** Allocates \p bytes aligned on \p alignment (a power of 2), returns nullptr if there is no room left */
+      void* allocate(size_t bytes, size_t alignment) __ntl_nothrow
+      {
+        char* const p = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(top) + alignment - 1) & ~(alignment - 1));
+        if(p > end || bytes > static_cast<size_t>(end - p))
+          return nullptr;
+        top = p + bytes;
+        return p;
+      }
+
+      void deallocate(void* p, size_t bytes) __ntl_nothrow
+      {
+        assert(owns(p));
+        if(static_cast<char*>(p) + bytes == top)
+          top = static_cast<char*>(p);
+      }
+
+      bool owns(const void* p) const __ntl_nothrow
+      {
+        return p >= buf && p < end;
+      }
+
+      /** Forgets all allocations, the memory allocated from the arena becomes invalid */
+      void reset() __ntl_nothrow { top = buf; }
+
+      size_t used() const __ntl_nothrow { return top - buf; }
+      size_t capacity() const __ntl_nothrow { return end - buf; }
+
+    private:
+      char* const buf;
+      char* const end;
+      char* top;
+    };
+
+    /**
+     *	@brief The arena with the \p N bytes of the inline storage
+     *  @details Placed on the stack, it serves the temporaries of a function without touching the heap:
+     *  \code
+     *  std::ext::stack_arena<512> arena;
+     *  std::ext::arena_allocator<wchar_t> alloc(arena);
+     *  std::basic_string<wchar_t, std::char_traits<wchar_t>, std::ext::arena_allocator<wchar_t> > component(alloc);
+     *  \endcode
+     *  The arena shall outlive the containers which use it.
+     **/
+    template<size_t N>
+    class stack_arena:
+      public buffer_arena
+    {
+    public:
+      static const size_t size = N;
+
+      stack_arena() __ntl_nothrow
+        :buffer_arena(&storage, N)
+      {}
+
+    private:
+      typename aligned_storage<N, alignment_of<max_align_t>::value>::type storage;
+    };
+
+    /**
+     *	@brief Allocator from the buffer_arena which falls back to \p Alloc when the arena is full
+     *
+     *  The rebound allocators share the arena, so the nodes of \c map and \c list and the storage of \c vector
+     *  and \c basic_string come from the same buffer. The allocators are equal if they use the same arena.
+     *  There is no default constructor: the container shall be given the allocator.
+     **/
+    template<class T, class Alloc = allocator<T> >
+    class arena_allocator:
+      public Alloc
+    {
+      template<class, class> friend class arena_allocator;
+    public:
+      typedef typename Alloc::value_type      value_type;
+      typedef typename Alloc::pointer         pointer;
+      typedef typename Alloc::const_pointer   const_pointer;
+      typedef typename Alloc::reference       reference;
+      typedef typename Alloc::const_reference const_reference;
+      typedef typename Alloc::size_type       size_type;
+      typedef typename Alloc::difference_type difference_type;
+      template<class U> struct rebind { typedef arena_allocator<U, typename Alloc::template rebind<U>::other> other; };
+
+      arena_allocator(buffer_arena& arena) __ntl_nothrow
+        :arena_(&arena)
+      {}
+
+      arena_allocator(buffer_arena& arena, const Alloc& parent)
+        :Alloc(parent), arena_(&arena)
+      {}
+
+      template<class U, class A2>
+      arena_allocator(const arena_allocator<U, A2>& a)
+        :Alloc(a.parent()), arena_(a.arena_)
+      {}
+
+      pointer allocate(size_type n, const void* hint = 0)
+      {
+        if(n <= size_t(-1) / sizeof(T)){
+          if(void* const p = arena_->allocate(n * sizeof(T), alignment_of<T>::value))
+            return static_cast<pointer>(p);
+        }
+        return Alloc::allocate(n, hint);
+      }
+
+      void deallocate(pointer p, size_type n)
+      {
+        if(arena_->owns(p))
+          arena_->deallocate(p, n * sizeof(T));
+        else
+          Alloc::deallocate(p, n);
+      }
+
+      const Alloc& parent() const { return *this; }
+      buffer_arena& arena() const { return *arena_; }
+
+    private:
+      buffer_arena* arena_;
+    };
+
+    template<class T, class A1, class U, class A2>
+    inline bool operator==(const arena_allocator<T, A1>& x, const arena_allocator<U, A2>& y)
+    {
+      return &x.arena() == &y.arena() && x.parent() == y.parent();
+    }
+
+    template<class T, class A1, class U, class A2>
+    inline bool operator!=(const arena_allocator<T, A1>& x, const arena_allocator<U, A2>& y)
+    {
+      return !(x == y);
+    }
+
+    /**@} lib_memory */
+  } // ext
+} // std
+
+#endif // NTL__EXT_STACK_ARENA
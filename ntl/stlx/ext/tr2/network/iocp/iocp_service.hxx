@@ -6,7 +6,7 @@
 #include <nt/thread.hxx>
 #include <nt/system_error.hxx>
 #include <atomic.hxx>
-#include <vector>
+#include <stlx/ext/indexed_heap.hxx>
 
 #ifndef NTL_DISABLE_SRWLOCK
 # include <nt/srwlock.hxx>
@@ -28,22 +28,11 @@ namespace std { namespace tr2 { namespace sys {
     typedef ntl::nt::status   status;
     typedef __::async_operation async_operation;
     typedef __::timer_scheduler::timer_data timer_data;
+    typedef __::timer_scheduler::timer_slot timer_slot;
     typedef ntl::nt::overlapped overlapped;
     
-    // sort by time, unique by handle
-    typedef std::vector<timer_data> timer_queue; // can't use std::priority_queue because of erase(timer)
-
-    struct find_timer
-    {
-      ntl::nt::legacy_handle h;
-      bool operator()(const timer_queue::value_type& t) const
-      {
-        return h == t.h;
-      }
-      explicit find_timer(ntl::nt::legacy_handle h)
-        : h(h)
-      {}
-    };
+    // the earliest on top, each timer keeps the handle of its entry in the slot
+    typedef std::ext::indexed_heap<timer_data, std::greater<timer_data> > timer_queue;
     
     // system codes
     static const ntl::nt::ntstatus
@@ -179,10 +168,10 @@ namespace std { namespace tr2 { namespace sys {
         : std::make_error_code(st);
     }
 
-    size_t add_timer(const void* timer, const timer_data* data)
+    size_t add_timer(timer_slot* slot, const timer_data* data)
     {
       if(!data)
-        return remove_timer(timer);
+        return remove_timer(slot);
 
       if(shutdown.test()) {
         post_immediate_completion(data->op);
@@ -192,28 +181,25 @@ namespace std { namespace tr2 { namespace sys {
       work_started();
 
       wlock lock(timer_lock);
-      const ntl::nt::legacy_handle t = reinterpret_cast<ntl::nt::legacy_handle>(timer);
-      timer_queue::iterator tm = std::find_if(timers.begin(), timers.end(), find_timer(t));
-      if(tm != timers.end()) {
-        timers.erase(tm);
+      if(*slot != __::timer_scheduler::no_slot) {
+        timers.erase(*slot);
       }
-      timers.push_back(*data);
+      *slot = timers.push(*data);
       timer_event.set();
       timer_thread.resume();
       return true;
     }
 
-    size_t remove_timer(const void* timer)
+    size_t remove_timer(timer_slot* slot)
     {
       if(shutdown.test())
         return 0;
 
       wlock lock(timer_lock);
-      const ntl::nt::legacy_handle t = reinterpret_cast<ntl::nt::legacy_handle>(timer);
-      timer_queue::iterator tm = std::find_if(timers.begin(), timers.end(), find_timer(t));
-      if(tm != timers.end()) {
-        async_operation* op = tm->op;
-        timers.erase(tm);
+      if(*slot != __::timer_scheduler::no_slot) {
+        async_operation* op = timers[*slot].op;
+        timers.erase(*slot);
+        *slot = __::timer_scheduler::no_slot;
 
         // wake up thread to recalculate timers
         timer_event.set();
@@ -364,8 +350,8 @@ namespace std { namespace tr2 { namespace sys {
 
     static uint32_t __stdcall timer_proc(void* Parameter)
     { return static_cast<iocp_service*>(Parameter)->timer_worker(); }
-    static size_t add_timer_(void* ctx, const void* timer, const timer_data* data)
-    { return static_cast<iocp_service*>(ctx)->add_timer(timer, data); }
+    static size_t add_timer_(void* ctx, timer_slot* slot, const timer_data* data)
+    { return static_cast<iocp_service*>(ctx)->add_timer(slot, data); }
 
     uint32_t __stdcall timer_worker()
     {
@@ -378,15 +364,13 @@ namespace std { namespace tr2 { namespace sys {
       do {
 
         timer_data first = {};
+        timer_queue::handle_type first_handle = 0;
         {
           count = 1;
           wlock lock(timer_lock);
           if(!timers.empty()) {
-            // remove the last timer now to eliminate a possible concurrent change when fired
-            if(timers.size() > 1)
-              std::sort(timers.begin(), timers.end(), std::greater<timer_queue::value_type>());
-            first = timers.back();
-            //timers.pop_back();
+            first = timers.top();
+            first_handle = timers.top_handle();
             handles[count++] = first.h;
           }
         }
@@ -399,19 +383,24 @@ namespace std { namespace tr2 { namespace sys {
         else if(st == status::wait_1) {
           // timer fired
           wlock lock(timer_lock);
-          timer_queue::iterator tm = std::find_if(timers.begin(), timers.end(), find_timer(first.h));
-          if(tm != timers.end()) {
+          // the handle may have been reused by another timer since the wait has started
+          if(timers.contains(first_handle) && timers[first_handle].h == first.h) {
             // fired and not erased yet
-            if(tm->period.count() != 0) {
+            const timer_data& tm = timers[first_handle];
+            if(tm.period.count() != 0) {
               // periodic timer, do not erase him
               // just adjust fire time to period one
-              tm->fire += tm->period.count();
-              post_immediate_completion(first.op);
+              timer_data next = tm;
+              next.fire += next.period.count();
+              timers.update(first_handle, next);
+              post_immediate_completion(next.op);
 
             } else {
               // deadline timer, remove him once fired
-              timers.erase(tm);
-              post_deferred_completion(first.op);
+              async_operation* op = tm.op;
+              *tm.slot = __::timer_scheduler::no_slot;
+              timers.erase(first_handle);
+              post_deferred_completion(op);
             }
           } else {
             // if erased, operation_aborted will be sent 
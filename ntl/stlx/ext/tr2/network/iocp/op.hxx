@@ -20,27 +20,32 @@ namespace std { namespace tr2 { namespace sys {
         , ctx()
       {}
 
+      /** The position of the timer in the scheduler queue, kept by the timer itself */
+      typedef size_t timer_slot;
+      static const timer_slot no_slot = static_cast<size_t>(-1);
+
       struct timer_data 
       {
         ntl::nt::legacy_handle h;
         async_operation* op;
         ntl::nt::systime_t fire;
         ntl::nt::system_duration period;
+        timer_slot* slot;
       };
 
-      typedef size_t add_timer_t(void* ctx, const void* timer, const timer_data* data);
+      typedef size_t add_timer_t(void* ctx, timer_slot* slot, const timer_data* data);
 
-      void add_timer(const void* timer, const timer_data* data)
+      void add_timer(const timer_data* data)
       {
         assert(handler);
         if(handler)
-          handler(ctx, timer, data);
+          handler(ctx, data->slot, data);
       }
 
-      size_t remove_timer(const void* timer)
+      size_t remove_timer(timer_slot* slot)
       {
         assert(handler);
-        return handler ? handler(ctx, timer, nullptr) : 0;
+        return handler ? handler(ctx, slot, nullptr) : 0;
       }
 
 
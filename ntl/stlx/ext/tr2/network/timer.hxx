@@ -64,10 +64,12 @@ namespace std { namespace tr2 { namespace sys {
         time_type       tp;
         duration_type   period;
         bool            periodic;
+        scheduler_type::timer_slot slot;
 
         implementation_type()
           :tm(Periodic ? tm.auto_reset : tm.manual_reset)
           ,periodic()
+          ,slot(scheduler_type::no_slot)
         {}
 
         bool reset(const time_type& t)
@@ -110,7 +112,7 @@ namespace std { namespace tr2 { namespace sys {
       size_t cancel(implementation_type& impl, error_code& ec) __ntl_nothrow
       {
         ec.clear();
-        size_t c = scheduler.remove_timer(impl.tm.get());
+        size_t c = scheduler.remove_timer(&impl.slot);
         if(!impl.tm.cancel())
           ec = std::make_error_code(impl.tm.last_status());
         return c;
@@ -148,9 +150,9 @@ namespace std { namespace tr2 { namespace sys {
 
         const __::timer_scheduler::timer_data data = { impl.tm.get(), p.op, 
           std::chrono::duration_cast<ntl::nt::system_duration>(impl.tp.time_since_epoch()).count(),
-          std::chrono::duration_cast<ntl::nt::system_duration>(impl.period) };
+          std::chrono::duration_cast<ntl::nt::system_duration>(impl.period), &impl.slot };
 
-        scheduler.add_timer(data.h, &data);
+        scheduler.add_timer(&data);
         p.release();
       }
 
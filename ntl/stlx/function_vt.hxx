@@ -12,6 +12,7 @@
 #include "functional.hxx"
 #include "fn_caller_vt.hxx"
 #include "algorithm.hxx" // for std::swap
+#include "new.hxx"
 
 namespace std
 {
@@ -64,12 +65,29 @@ namespace std
         struct caller
         {
           virtual R operator()(const Args&) const = 0;
-          virtual caller* clone() const = 0;
+          /** Copies the caller to \c buf if it fits there or to the heap otherwise */
+          virtual caller* clone(void* buf) const = 0;
+          /** Moves the caller stored inline to \c buf, returns \c this for the caller stored on the heap */
+          virtual caller* relocate(void* buf) = 0;
           virtual ~caller(){}
           virtual const type_info& target_type() const = 0;
           virtual void* target() = 0;
         };
 
+        /** The inline storage of function: the caller's vptr and up to 3 pointers of the callable */
+        union small_buffer
+        {
+          void* p[4];
+          void (*fn)();
+        };
+
+        /** The callers of the small callables which don't throw on copy are stored inline */
+        template<class Caller, class F>
+        struct is_small_caller:
+          integral_constant<bool, sizeof(Caller) <= sizeof(small_buffer) && alignof(Caller) <= alignof(small_buffer)
+                                  && has_nothrow_copy_constructor<F>::value>
+        {};
+
         /************************************************************************/
         /* Caller                                                               */
         /************************************************************************/
@@ -89,13 +107,27 @@ namespace std
           {
             return fn_caller<F,Args,R>::call(f, args);
           }
-          caller<R,Args>* clone() const
+          caller<R,Args>* clone(void* buf) const
+          {
+            return clone(buf, is_small_caller<fun_caller, F>());
+          }
+          caller<R,Args>* relocate(void* buf)
           {
-            return new fun_caller(f);
+            return relocate(buf, is_small_caller<fun_caller, F>());
           }
           const type_info& target_type() const { return target_type<false>(__::is_refwrap<F>()); }
           void* target() { return target<false>(__::is_refwrap<F>()); }
         protected:
+          caller<R,Args>* clone(void* buf, true_type) const { return ::new(buf) fun_caller(f); }
+          caller<R,Args>* clone(void*, false_type) const    { return new fun_caller(f); }
+          caller<R,Args>* relocate(void* buf, true_type)
+          {
+            fun_caller* p = ::new(buf) fun_caller(f);
+            this->~fun_caller();
+            return p;
+          }
+          caller<R,Args>* relocate(void*, false_type) { return this; }
+
           template<bool> const type_info& target_type(false_type) const { return __ntl_typeid(f); }
           template<bool> const type_info& target_type(true_type)  const { return __ntl_typeid(f.get()); }
           template<bool> void* target(false_type) { return reinterpret_cast<void*>(&f); }
@@ -143,7 +175,7 @@ namespace std
         /** Creates copy of \c r target */
         function(const function& r)
         {
-          caller = r.caller ? r.caller->clone() : 0;
+          caller = r.caller ? r.caller->clone(&buf) : 0;
         }
 
         /** dtor */
@@ -155,16 +187,19 @@ namespace std
         /** Constructs function wrapper from reference to callable object */
         template<typename F>
         explicit function(reference_wrapper<F> rf)
+          :caller()
         {
-          caller = new impl::fun_caller<R, reference_wrapper<F>, Args>(rf);
+          assign_impl<reference_wrapper<F> >(move(rf));
         }
 
         /** Copies \c r target */
         function& operator=(const function& r)
         {
-          clear();
-          if(r.caller)
-            caller = r.caller->clone();
+          if(this != &r){
+            clear();
+            if(r.caller)
+              caller = r.caller->clone(&buf);
+          }
           return *this;
         }
 
@@ -195,16 +230,23 @@ namespace std
         function(function&& r)
           :caller()
         {
-          if(r.caller)
-            std::swap(caller, r.caller);
+          if(r.caller){
+            caller = r.caller->relocate(&buf);
+            r.caller = nullptr;
+          }
         }
 
         /** Replaces the target of this wrapper with the target of \c r */
         function& operator=(function&& r)
         {
-          clear();
-          if(r.caller)
-            std::swap(caller, r.caller);
+          if(this != &r){
+            clear();
+            if(r.caller){
+              caller = r.caller->relocate(&buf);
+              r.caller = nullptr;
+            }
+          }
+          return *this;
         }
 
         /** Takes referenced callable to this wrapper */
@@ -239,7 +281,16 @@ namespace std
         /** Swaps this target with the target of \c r */
         void swap(function&  r) __ntl_nothrow
         {
-          std::swap(caller, r.caller);
+          if(this == &r)
+            return;
+          if(!is_local() && !r.is_local()){
+            std::swap(caller, r.caller);
+            return;
+          }
+          impl::small_buffer tmp;
+          caller_type* const t = caller ? caller->relocate(&tmp) : nullptr;
+          caller = r.caller ? r.caller->relocate(&buf) : nullptr;
+          r.caller = t ? t->relocate(&r.buf) : nullptr;
         }
 
         /** Assigns this object with callable \c f */
@@ -276,17 +327,27 @@ namespace std
         inline void clear()
         {
           if(caller){
-            delete caller;
+            if(is_local())
+              caller->~caller_type();
+            else
+              delete caller;
             caller = nullptr;
           }
         }
+        inline bool is_local() const
+        {
+          return static_cast<const void*>(caller) == &buf;
+        }
         ///\endcond
 
         template<class Fn> inline void assign_impl(Fn&& f)
         {
           static_assert(!is_reference<Fn>::value, "reference to reference isn't allowed");
+          typedef impl::fun_caller<result_type, typename remove_reference<Fn>::type, Args> fun_caller;
           if(check_ptr(f, is_pointer<typename remove_reference<Fn>::type>()))
-            caller = new impl::fun_caller<result_type, typename remove_reference<Fn>::type, Args>(forward<Fn>(f));
+            caller = impl::is_small_caller<fun_caller, Fn>::value
+              ? ::new(static_cast<void*>(&buf)) fun_caller(forward<Fn>(f))
+              : new fun_caller(forward<Fn>(f));
         }
 
         /** Checks pointer if it is */
@@ -295,7 +356,10 @@ namespace std
         template<class F> inline bool check_ptr(const F&,  false_type){ return true; }
 
       private:
-        impl::caller<result_type, Args>* caller;
+        typedef impl::caller<result_type, Args> caller_type;
+
+        caller_type* caller;
+        impl::small_buffer buf;
       };
     } // namespace v3
     namespace detail = v3;
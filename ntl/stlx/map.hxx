@@ -839,6 +839,19 @@ void swap(multimap<Key,T,Compare,Allocator>& x,
           multimap<Key,T,Compare,Allocator>& y);
 #endif
 ///@}
+
+namespace pmr
+{
+  template<class T> class polymorphic_allocator;
+#ifdef NTL_CXX_TT
+  /** map which allocates from a memory_resource */
+  template<class Key, class T, class Compare = less<Key> >
+  using map = std::map<Key, T, Compare, polymorphic_allocator<pair<const Key, T> > >;
+  template<class Key, class T, class Compare = less<Key> >
+  using multimap = std::multimap<Key, T, Compare, polymorphic_allocator<pair<const Key, T> > >;
+#endif
+}
+
 /**@} lib_associative */
 /**@} lib_containers */
 
@@ -59,7 +59,7 @@ template<class T, class Alloc> struct uses_allocator
     typedef typename Ptr::element_type element_type;
     typedef typename Ptr::difference_type difference_type;
 
-    template<class U> struct rebind { typedef U* other; }; //typedef Ptr::template rebind<U> other; };
+    template<class U> struct rebind { typedef typename Ptr::template rebind<U>::other other; };
 
     static pointer pointer_to(typename Ptr::element_type& r)
     {
@@ -184,6 +184,55 @@ template<class T, class Alloc> struct uses_allocator
     ///\}
   };
 
+///\name Allocator and relocation extensions
+namespace ext
+{
+  /**
+   *	@brief Trivially relocatable types
+   *  @details An object of such type can be moved to another address by the bitwise copy,
+   *  its source storage is released without a destructor call. Containers use it to relocate their elements with \c memcpy.
+   *  By default holds for the types with the trivial copy constructor and destructor;
+   *  specialize it to \c true_type for the types which do not keep pointers into themselves.
+   **/
+  template<class T>
+  struct is_trivially_relocatable:
+    integral_constant<bool, has_trivial_copy_constructor<T>::value && __::no_dtor<T>::value>
+  {};
+
+  /**
+   *	@brief Allocators which can resize the allocated block in place
+   *  @details Specialize it to \c true_type for the allocator which provides
+   *  <tt>bool expand(pointer p, size_type n, size_type new_n)</tt>: an attempt to grow the block of \c n objects
+   *  at \c p up to \c new_n objects without moving it.
+   **/
+  template<class Allocator>
+  struct allocator_can_expand:
+    false_type
+  {};
+}
+
+namespace __
+{
+  template<class Allocator, bool = ext::allocator_can_expand<Allocator>::value>
+  struct allocator_expand
+  {
+    static bool expand(Allocator&, typename Allocator::pointer, typename Allocator::size_type, typename Allocator::size_type)
+    {
+      return false;
+    }
+  };
+
+  template<class Allocator>
+  struct allocator_expand<Allocator, true>
+  {
+    static bool expand(Allocator& a, typename Allocator::pointer p, typename Allocator::size_type n, typename Allocator::size_type new_n)
+    {
+      return p && a.expand(p, n, new_n);
+    }
+  };
+}
+///\}
+
 /// 20.6.8 The default allocator [default.allocator]
 template<class T> class allocator;
 
@@ -0,0 +1,693 @@
+/**\file*********************************************************************
+ *                                                                     \brief
+ *  Memory resources [mem.res]
+ *
+ ****************************************************************************
+ */
+#ifndef NTL__STLX_MEMORY_RESOURCE
+#define NTL__STLX_MEMORY_RESOURCE
+#pragma once
+
+#include "cassert.hxx"
+#include "cstddef.hxx"
+#include "atomic.hxx"
+#include "memory.hxx"
+#include "mutex.hxx"
+
+namespace std
+{
+  /**\addtogroup  lib_utilities *** 20 General utilities library [utilities]
+   *@{*/
+  /**\defgroup  lib_memory_resource *** Memory resources [mem.res]
+   *@{*/
+
+  namespace pmr
+  {
+    /**
+     *	@brief Abstract interface to the unbounded set of classes encapsulating memory resources [mem.res.class]
+     **/
+    class memory_resource
+    {
+    protected:
+      static const size_t max_align = alignment_of<max_align_t>::value;
+    public:
+      virtual ~memory_resource() {}
+
+      void* allocate(size_t bytes, size_t alignment = max_align)
+      {
+        return do_allocate(bytes, alignment);
+      }
+
+      void deallocate(void* p, size_t bytes, size_t alignment = max_align)
+      {
+        do_deallocate(p, bytes, alignment);
+      }
+
+      bool is_equal(const memory_resource& other) const __ntl_nothrow
+      {
+        return do_is_equal(other);
+      }
+
+    private:
+      virtual void* do_allocate(size_t bytes, size_t alignment) = 0;
+      virtual void  do_deallocate(void* p, size_t bytes, size_t alignment) = 0;
+      virtual bool  do_is_equal(const memory_resource& other) const __ntl_nothrow = 0;
+    };
+
+    inline bool operator==(const memory_resource& a, const memory_resource& b) __ntl_nothrow
+    {
+      return &a == &b || a.is_equal(b);
+    }
+
+    inline bool operator!=(const memory_resource& a, const memory_resource& b) __ntl_nothrow
+    {
+      return !(a == b);
+    }
+
+    namespace __
+    {
+      /** Forwards to the global operator new, the over-aligned blocks keep the original pointer in front of them */
+      class new_delete_resource:
+        public memory_resource
+      {
+        void* do_allocate(size_t bytes, size_t alignment)
+        {
+          if(alignment <= max_align)
+            return ::operator new(bytes);
+          char* const raw = static_cast<char*>(::operator new(bytes + alignment + sizeof(void*)));
+          char* const p = raw + sizeof(void*) + (alignment - (reinterpret_cast<uintptr_t>(raw + sizeof(void*)) & (alignment - 1))) % alignment;
+          reinterpret_cast<void**>(p)[-1] = raw;
+          return p;
+        }
+
+        void do_deallocate(void* p, size_t, size_t alignment)
+        {
+          ::operator delete(alignment <= max_align ? p : static_cast<void**>(p)[-1]);
+        }
+
+        bool do_is_equal(const memory_resource& other) const __ntl_nothrow
+        {
+          return this == &other;
+        }
+      };
+
+      class null_memory_resource:
+        public memory_resource
+      {
+        void* do_allocate(size_t, size_t)
+        {
+          __ntl_throw(bad_alloc());
+        }
+
+        void do_deallocate(void*, size_t, size_t)
+        {}
+
+        bool do_is_equal(const memory_resource& other) const __ntl_nothrow
+        {
+          return this == &other;
+        }
+      };
+
+      template<class T>
+      struct default_resource_holder
+      {
+        static atomic<T*> resource;
+      };
+
+      template<class T>
+      atomic<T*> default_resource_holder<T>::resource;
+
+      typedef default_resource_holder<memory_resource> default_resource;
+
+      inline size_t min_size(size_t a, size_t b)
+      {
+        return a < b ? a : b;
+      }
+
+      inline size_t align_up(size_t n, size_t alignment)
+      {
+        return (n + alignment - 1) & ~(alignment - 1);
+      }
+    }
+
+    ///\name Access to program-wide memory_resource objects [mem.res.global]
+    /** The resource which uses the global operator new and operator delete */
+    inline memory_resource* new_delete_resource() __ntl_nothrow
+    {
+      return std::__::static_storage<__::new_delete_resource>::get_object();
+    }
+
+    /** The resource which throws bad_alloc on every allocation */
+    inline memory_resource* null_memory_resource() __ntl_nothrow
+    {
+      return std::__::static_storage<__::null_memory_resource>::get_object();
+    }
+
+    /** Sets the default resource, new_delete_resource() if \p r is null, and returns the previous one */
+    inline memory_resource* set_default_resource(memory_resource* r) __ntl_nothrow
+    {
+      memory_resource* const previous = __::default_resource::resource.exchange(r ? r : new_delete_resource(), memory_order_acq_rel);
+      return previous ? previous : new_delete_resource();
+    }
+
+    inline memory_resource* get_default_resource() __ntl_nothrow
+    {
+      memory_resource* const r = __::default_resource::resource.load(memory_order_acquire);
+      return r ? r : new_delete_resource();
+    }
+    ///\}
+
+    /**
+     *	@brief Allocator which uses a memory_resource [mem.poly.allocator.class]
+     *  @details The containers with polymorphic_allocator of the same type may use different resources.
+     *  The stlx containers copy the allocator, so the copy of a container uses the resource of the original,
+     *  and \c vector takes the resource of the vector assigned to it; select_on_container_copy_construction()
+     *  is there for the code which calls it through allocator_traits. The containers do not exchange the allocators
+     *  on swap and move assignment, so the containers swapped or moved shall use the same resource.
+     **/
+    template<class T>
+    class polymorphic_allocator
+    {
+    public:
+      typedef size_t      size_type;
+      typedef ptrdiff_t   difference_type;
+      typedef       T   * pointer;
+      typedef const T   * const_pointer;
+      typedef       T   & reference;
+      typedef const T   & const_reference;
+      typedef       T     value_type;
+      template<class U> struct rebind { typedef polymorphic_allocator<U> other; };
+
+      polymorphic_allocator() __ntl_nothrow
+        :r(get_default_resource())
+      {}
+
+      polymorphic_allocator(memory_resource* r)
+        :r(r)
+      {
+        assert(r);
+      }
+
+      polymorphic_allocator(const polymorphic_allocator& other) __ntl_nothrow
+        :r(other.resource())
+      {}
+
+      template<class U>
+      polymorphic_allocator(const polymorphic_allocator<U>& other) __ntl_nothrow
+        :r(other.resource())
+      {}
+
+      pointer address(reference x) const { return &x; }
+      const_pointer address(const_reference x) const { return &x; }
+
+      T* allocate(size_type n, const void* = 0)
+      {
+        if(n > max_size())
+          __ntl_throw(bad_alloc());
+        return static_cast<T*>(r->allocate(n * sizeof(T), alignment_of<T>::value));
+      }
+
+      void deallocate(T* p, size_type n)
+      {
+        r->deallocate(const_cast<typename remove_const<T>::type*>(p), n * sizeof(T), alignment_of<T>::value);
+      }
+
+      size_type max_size() const __ntl_nothrow { return size_t(-1) / sizeof(T); }
+
+    #ifdef NTL_CXX_VT
+      template<class U, class... Args>
+      void construct(U* p, Args&&... args)
+      {
+        ::new((void*)p) U(std::forward<Args>(args)...);
+      }
+    #else
+      template<class U>
+      void construct(U* p) { ::new((void*)p) U(); }
+      template<class U, class A1>
+      void construct(U* p, const A1& a1) { ::new((void*)p) U(a1); }
+      template<class U, class A1, class A2>
+      void construct(U* p, const A1& a1, const A2& a2) { ::new((void*)p) U(a1, a2); }
+      template<class U, class A1, class A2, class A3>
+      void construct(U* p, const A1& a1, const A2& a2, const A3& a3) { ::new((void*)p) U(a1, a2, a3); }
+    #endif
+
+      template<class U>
+      void destroy(U* p)
+      {
+        p->~U();
+      }
+
+      /** The allocator with the default resource, for the code which calls it on the copy of a container */
+      polymorphic_allocator select_on_container_copy_construction() const
+      {
+        return polymorphic_allocator();
+      }
+
+      memory_resource* resource() const __ntl_nothrow { return r; }
+
+    private:
+      memory_resource* r;
+    };
+
+    template<class T, class U>
+    inline bool operator==(const polymorphic_allocator<T>& a, const polymorphic_allocator<U>& b) __ntl_nothrow
+    {
+      return *a.resource() == *b.resource();
+    }
+
+    template<class T, class U>
+    inline bool operator!=(const polymorphic_allocator<T>& a, const polymorphic_allocator<U>& b) __ntl_nothrow
+    {
+      return !(a == b);
+    }
+
+    /** The pool resource parameters [mem.res.pool.options], zeros select the defaults */
+    struct pool_options
+    {
+      size_t max_blocks_per_chunk;
+      size_t largest_required_pool_block;
+    };
+
+    /**
+     *	@brief Pool resource for the single thread [mem.res.pool.overview]
+     *
+     *  The blocks up to \c largest_required_pool_block bytes come from the pools of power-of-two sizes; a pool carves
+     *  them from the chunks it gets from the upstream resource, every next chunk twice as large up to
+     *  \c max_blocks_per_chunk blocks, and keeps the deallocated blocks on its free list. The larger blocks are
+     *  passed to the upstream resource directly. Everything goes back to the upstream on release() or destruction.
+     **/
+    class unsynchronized_pool_resource:
+      public memory_resource
+    {
+      static const size_t min_block = sizeof(void*) * 2;
+      static const size_t default_blocks_per_chunk = 1024;
+      static const size_t default_largest_block = 4096;
+      static const size_t max_largest_block = size_t(1) << 20;
+      static const size_t initial_blocks = 16;
+      static const size_t max_pools = 20;
+    public:
+      unsynchronized_pool_resource(const pool_options& opts, memory_resource* upstream)
+        :upstream(upstream), large(nullptr)
+      {
+        init(opts);
+      }
+
+      unsynchronized_pool_resource()
+        :upstream(get_default_resource()), large(nullptr)
+      {
+        const pool_options opts = {};
+        init(opts);
+      }
+
+      explicit unsynchronized_pool_resource(memory_resource* upstream)
+        :upstream(upstream), large(nullptr)
+      {
+        const pool_options opts = {};
+        init(opts);
+      }
+
+      explicit unsynchronized_pool_resource(const pool_options& opts)
+        :upstream(get_default_resource()), large(nullptr)
+      {
+        init(opts);
+      }
+
+      ~unsynchronized_pool_resource()
+      {
+        release();
+      }
+
+      /** Returns all memory to the upstream resource */
+      void release()
+      {
+        for(size_t i = 0; i < pool_count; ++i){
+          pool& pl = pools[i];
+          while(chunk* c = pl.chunks){
+            pl.chunks = c->next;
+            upstream->deallocate(reinterpret_cast<char*>(c) - c->size, c->size + sizeof(chunk), chunk_alignment(pl.block_size));
+          }
+          pl.free = nullptr;
+          pl.next_blocks = __::min_size(initial_blocks, opts.max_blocks_per_chunk);
+        }
+        while(large){
+          large_block* const b = large;
+          large = b->next;
+          upstream->deallocate(b, large_offset(b->alignment) + b->size, b->alignment);
+        }
+      }
+
+      memory_resource* upstream_resource() const { return upstream; }
+      pool_options options() const { return opts; }
+
+    protected:
+      void* do_allocate(size_t bytes, size_t alignment)
+      {
+        const size_t i = pool_index(bytes, alignment);
+        if(i == pool_count)
+          return allocate_large(bytes, alignment);
+        pool& pl = pools[i];
+        if(!pl.free)
+          grow(pl);
+        free_block* const b = pl.free;
+        pl.free = b->next;
+        return b;
+      }
+
+      void do_deallocate(void* p, size_t bytes, size_t alignment)
+      {
+        const size_t i = pool_index(bytes, alignment);
+        if(i == pool_count)
+          return deallocate_large(p, alignment);
+        free_block* const b = static_cast<free_block*>(p);
+        b->next = pools[i].free;
+        pools[i].free = b;
+      }
+
+      bool do_is_equal(const memory_resource& other) const __ntl_nothrow
+      {
+        return this == &other;
+      }
+
+    private:
+      unsynchronized_pool_resource(const unsynchronized_pool_resource&) __deleted;
+      unsynchronized_pool_resource& operator=(const unsynchronized_pool_resource&) __deleted;
+
+      struct free_block
+      {
+        free_block* next;
+      };
+
+      /** placed behind the blocks of the chunk */
+      struct chunk
+      {
+        chunk*  next;
+        size_t  size;
+      };
+
+      struct pool
+      {
+        free_block* free;
+        chunk*      chunks;
+        size_t      block_size;
+        size_t      next_blocks;
+      };
+
+      /** placed in front of the large block */
+      struct large_block
+      {
+        large_block*  prev, *next;
+        size_t        size;
+        size_t        alignment;
+      };
+
+      void init(const pool_options& o)
+      {
+        opts.max_blocks_per_chunk = o.max_blocks_per_chunk ? o.max_blocks_per_chunk : default_blocks_per_chunk;
+        size_t largest = o.largest_required_pool_block ? o.largest_required_pool_block : default_largest_block;
+        if(largest > max_largest_block)
+          largest = max_largest_block;
+        pool_count = 0;
+        for(size_t size = min_block; ; size <<= 1){
+          pool& pl = pools[pool_count++];
+          pl.free = nullptr;
+          pl.chunks = nullptr;
+          pl.block_size = size;
+          pl.next_blocks = __::min_size(initial_blocks, opts.max_blocks_per_chunk);
+          if(size >= largest)
+            break;
+        }
+        opts.largest_required_pool_block = pools[pool_count-1].block_size;
+      }
+
+      /** the pool of the block or pool_count for the large one */
+      size_t pool_index(size_t bytes, size_t alignment) const
+      {
+        if(alignment > max_align)
+          return pool_count;
+        const size_t size = bytes > alignment ? bytes : alignment;
+        size_t i = 0;
+        while(i < pool_count && pools[i].block_size < size)
+          ++i;
+        return i;
+      }
+
+      static size_t chunk_alignment(size_t block_size)
+      {
+        return __::min_size(block_size, max_align);
+      }
+
+      void grow(pool& pl)
+      {
+        const size_t n = pl.next_blocks, size = n * pl.block_size;
+        char* const p = static_cast<char*>(upstream->allocate(size + sizeof(chunk), chunk_alignment(pl.block_size)));
+        chunk* const c = reinterpret_cast<chunk*>(p + size);
+        c->next = pl.chunks;
+        c->size = size;
+        pl.chunks = c;
+        // the blocks are handed out in the address order
+        for(size_t i = n; i--; ){
+          free_block* const b = reinterpret_cast<free_block*>(p + i * pl.block_size);
+          b->next = pl.free;
+          pl.free = b;
+        }
+        if(n < opts.max_blocks_per_chunk)
+          pl.next_blocks = __::min_size(n * 2, opts.max_blocks_per_chunk);
+      }
+
+      static size_t large_offset(size_t alignment)
+      {
+        return __::align_up(sizeof(large_block), alignment);
+      }
+
+      void* allocate_large(size_t bytes, size_t alignment)
+      {
+        if(alignment < alignment_of<large_block>::value)
+          alignment = alignment_of<large_block>::value;
+        large_block* const b = static_cast<large_block*>(upstream->allocate(large_offset(alignment) + bytes, alignment));
+        b->prev = nullptr;
+        b->next = large;
+        b->size = bytes;
+        b->alignment = alignment;
+        if(large)
+          large->prev = b;
+        large = b;
+        return reinterpret_cast<char*>(b) + large_offset(alignment);
+      }
+
+      void deallocate_large(void* p, size_t alignment)
+      {
+        if(alignment < alignment_of<large_block>::value)
+          alignment = alignment_of<large_block>::value;
+        large_block* const b = reinterpret_cast<large_block*>(static_cast<char*>(p) - large_offset(alignment));
+        (b->prev ? b->prev->next : large) = b->next;
+        if(b->next)
+          b->next->prev = b->prev;
+        upstream->deallocate(b, large_offset(alignment) + b->size, alignment);
+      }
+
+    private:
+      memory_resource*  upstream;
+      pool_options      opts;
+      pool              pools[max_pools];
+      size_t            pool_count;
+      large_block*      large;
+    };
+
+    /**
+     *	@brief Pool resource for the concurrent use
+     *  @details The unsynchronized_pool_resource serialized by a mutex.
+     **/
+    class synchronized_pool_resource:
+      public memory_resource
+    {
+    public:
+      synchronized_pool_resource(const pool_options& opts, memory_resource* upstream)
+        :pools(opts, upstream)
+      {}
+
+      synchronized_pool_resource()
+      {}
+
+      explicit synchronized_pool_resource(memory_resource* upstream)
+        :pools(upstream)
+      {}
+
+      explicit synchronized_pool_resource(const pool_options& opts)
+        :pools(opts)
+      {}
+
+      void release()
+      {
+        lock_guard<mutex> lock(m);
+        pools.release();
+      }
+
+      memory_resource* upstream_resource() const { return pools.upstream_resource(); }
+      pool_options options() const { return pools.options(); }
+
+    protected:
+      void* do_allocate(size_t bytes, size_t alignment)
+      {
+        lock_guard<mutex> lock(m);
+        return pools.allocate(bytes, alignment);
+      }
+
+      void do_deallocate(void* p, size_t bytes, size_t alignment)
+      {
+        lock_guard<mutex> lock(m);
+        pools.deallocate(p, bytes, alignment);
+      }
+
+      bool do_is_equal(const memory_resource& other) const __ntl_nothrow
+      {
+        return this == &other;
+      }
+
+    private:
+      synchronized_pool_resource(const synchronized_pool_resource&) __deleted;
+      synchronized_pool_resource& operator=(const synchronized_pool_resource&) __deleted;
+
+      mutex m;
+      unsynchronized_pool_resource pools;
+    };
+
+    /**
+     *	@brief Arena resource [mem.res.monotonic.buffer]
+     *
+     *  Hands out the memory sequentially from the current buffer, which is the initial one or a chunk of the
+     *  upstream resource, each next chunk twice as large. The deallocation does nothing; release() returns
+     *  the chunks to the upstream at once and restarts from the initial buffer.
+     **/
+    class monotonic_buffer_resource:
+      public memory_resource
+    {
+      static const size_t default_size = 1024;
+    public:
+      explicit monotonic_buffer_resource(memory_resource* upstream)
+        :upstream(upstream), initial_buffer(nullptr), initial_size(default_size), chunks(nullptr)
+      {
+        reset();
+      }
+
+      monotonic_buffer_resource(size_t initial_size, memory_resource* upstream)
+        :upstream(upstream), initial_buffer(nullptr), initial_size(initial_size ? initial_size : 1), chunks(nullptr)
+      {
+        reset();
+      }
+
+      /** Uses \p buffer of \p size bytes first */
+      monotonic_buffer_resource(void* buffer, size_t size, memory_resource* upstream)
+        :upstream(upstream), initial_buffer(static_cast<char*>(buffer)), initial_size(size ? size : 1), chunks(nullptr)
+      {
+        reset();
+      }
+
+      monotonic_buffer_resource()
+        :upstream(get_default_resource()), initial_buffer(nullptr), initial_size(default_size), chunks(nullptr)
+      {
+        reset();
+      }
+
+      explicit monotonic_buffer_resource(size_t initial_size)
+        :upstream(get_default_resource()), initial_buffer(nullptr), initial_size(initial_size ? initial_size : 1), chunks(nullptr)
+      {
+        reset();
+      }
+
+      monotonic_buffer_resource(void* buffer, size_t size)
+        :upstream(get_default_resource()), initial_buffer(static_cast<char*>(buffer)), initial_size(size ? size : 1), chunks(nullptr)
+      {
+        reset();
+      }
+
+      ~monotonic_buffer_resource()
+      {
+        release();
+      }
+
+      /** Returns all chunks to the upstream resource, the allocated memory becomes invalid */
+      void release()
+      {
+        while(chunks){
+          chunk* const c = chunks;
+          chunks = c->next;
+          upstream->deallocate(c, c->size, c->alignment);
+        }
+        reset();
+      }
+
+      memory_resource* upstream_resource() const { return upstream; }
+
+    protected:
+      void* do_allocate(size_t bytes, size_t alignment)
+      {
+        uintptr_t p = __::align_up(reinterpret_cast<uintptr_t>(current), alignment);
+        if(!current || p + bytes > reinterpret_cast<uintptr_t>(end)){
+          grow(bytes, alignment);
+          p = __::align_up(reinterpret_cast<uintptr_t>(current), alignment);
+        }
+        current = reinterpret_cast<char*>(p + bytes);
+        return reinterpret_cast<void*>(p);
+      }
+
+      void do_deallocate(void*, size_t, size_t)
+      {}
+
+      bool do_is_equal(const memory_resource& other) const __ntl_nothrow
+      {
+        return this == &other;
+      }
+
+    private:
+      monotonic_buffer_resource(const monotonic_buffer_resource&) __deleted;
+      monotonic_buffer_resource& operator=(const monotonic_buffer_resource&) __deleted;
+
+      /** placed in front of the upstream chunk */
+      struct chunk
+      {
+        chunk*  next;
+        size_t  size;
+        size_t  alignment;
+      };
+
+      void reset()
+      {
+        current = initial_buffer;
+        end = initial_buffer ? initial_buffer + initial_size : nullptr;
+        next_size = initial_size;
+      }
+
+      void grow(size_t bytes, size_t alignment)
+      {
+        if(alignment < max_align)
+          alignment = max_align;
+        const size_t header = __::align_up(sizeof(chunk), alignment);
+        size_t size = next_size;
+        while(size < bytes + alignment)
+          size *= 2;
+        chunk* const c = static_cast<chunk*>(upstream->allocate(header + size, alignment));
+        c->next = chunks;
+        c->size = header + size;
+        c->alignment = alignment;
+        chunks = c;
+        current = reinterpret_cast<char*>(c) + header;
+        end = current + size;
+        next_size = size * 2;
+      }
+
+    private:
+      memory_resource*  upstream;
+      char* const       initial_buffer;
+      const size_t      initial_size;
+      chunk*            chunks;
+      char*             current;
+      char*             end;
+      size_t            next_size;
+    };
+  } // pmr
+
+  /**@} lib_memory_resource */
+  /**@} lib_utilities */
+} // std
+
+#endif // NTL__STLX_MEMORY_RESOURCE
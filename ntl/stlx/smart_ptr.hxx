@@ -643,6 +643,15 @@ namespace std
   };//template class unique_ptr<T[N], default_delete<T[N]> >
 #endif
 
+  namespace ext
+  {
+    // unique_ptr with the stateless deleter holds only the pointer
+    template<class T>
+    struct is_trivially_relocatable<unique_ptr<T, default_delete<T> > >: true_type {};
+    template<class T>
+    struct is_trivially_relocatable<unique_ptr<T[], default_delete<T[]> > >: true_type {};
+  }
+
   ///\name 20.8.11.4 unique_ptr specialized algorithms [unique.shared.special]
   template <class T, class D> inline void swap(unique_ptr<T, D>& x, unique_ptr<T, D>& y)
   {
@@ -797,6 +806,7 @@ namespace std
       struct shared_cast_const{};
       struct shared_allocator_tag{};
       template<class> struct check_shared;
+      template<class> struct shared_ptr_inplace;
 
       template<class T, class U>
       inline shared_ptr_data<T>* shared_data_cast(shared_ptr_data<U>* data)
@@ -815,6 +825,7 @@ namespace std
 
       template<class Y> friend class weak_ptr;
       template<class Y> friend class shared_ptr;
+      template<class Y> friend struct __::shared_ptr_inplace;
       template<class D, class T> 
       friend D* get_deleter(shared_ptr<T> const& p);
 
@@ -1047,6 +1058,12 @@ namespace std
           add_ref();
         }
       }
+      explicit shared_ptr(__::shared_ptr_inplace<T>* s) __ntl_nothrow
+        :shared(s),ptr()
+      {
+        set(s->p);
+        check_shared(s->p, this);
+      }
     protected:
       bool empty() const __ntl_nothrow { return !shared; }
       void add_ref()
@@ -1081,72 +1098,195 @@ namespace std
 
     //////////////////////////////////////////////////////////////////////////
     // 20.8.12.2.6, shared_ptr creation
-  #ifdef NTL_CXX_VT
-    template<class T, class... Args> shared_ptr<T> make_shared(Args&&... args);
-    template<class T, class A, class... Args>
-    shared_ptr<T> allocate_shared(const A& a, Args&&... args);
-  #else
     namespace __
     {
-      template<class T, class Alloc>
-      inline shared_ptr<T> shared_ptr_allocate(T* p, const Alloc& a)
+      /** The control block which holds the object itself, so make_shared takes the single allocation */
+      template<class T>
+      struct shared_ptr_inplace
+        : shared_ptr_data<T>
       {
-        struct deleter
+        typedef T value_type;
+
+        typename aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+        shared_ptr_inplace()
+          :shared_ptr_data<T>(nullptr)
+        {}
+
+        static shared_ptr_inplace* allocate()
+        {
+          return new shared_ptr_inplace();
+        }
+        void deallocate() __ntl_nothrow
         {
-          Alloc a;
-          deleter(const Alloc& a)
-            :a(a){}
-          void operator()(T* p)__ntl_nothrow
-          {
-            a.destroy(p);
-            a.deallocate(p, 1);
+          delete this;
+        }
+
+        void* place() { return &storage; }
+
+        /** Takes the ownership of the object constructed in place() */
+        shared_ptr<T> share()
+        {
+          this->p = reinterpret_cast<T*>(&storage);
+          return shared_ptr<T>(this);
+        }
+
+        void free() __ntl_nothrow
+        {
+          if(this->p){
+            T* pp = this->p; this->p = nullptr;
+            pp->~T();
           }
-        } d(a);
-        return shared_ptr<T>(p, d, a);
-      }
+        }
+      };
+
+      /** The control block of allocate_shared, lives in the memory of the allocator */
+      template<class T, class A>
+      struct shared_ptr_inplace_a
+        : shared_ptr_inplace<T>
+      {
+        typedef typename A::template rebind<shared_ptr_inplace_a>::other block_allocator;
+
+        A alloc;
+
+        explicit shared_ptr_inplace_a(const A& a)
+          :alloc(a)
+        {}
 
+        static shared_ptr_inplace_a* allocate(const A& a)
+        {
+          block_allocator ba(a);
+          shared_ptr_inplace_a* s = ba.allocate(1);
+          ::new(static_cast<void*>(s)) shared_ptr_inplace_a(a);
+          return s;
+        }
+        void deallocate() __ntl_nothrow
+        {
+          block_allocator ba(alloc);
+          this->~shared_ptr_inplace_a();
+          ba.deallocate(this, 1);
+        }
+
+        void dispose() __ntl_nothrow
+        {
+          this->free();
+          deallocate();
+        }
+      };
+
+      /** Releases the control block if the constructor of the object throws */
+      template<class Block>
+      class shared_ptr_inplace_guard:
+        std::noncopyable
+      {
+        Block* s;
+      public:
+        explicit shared_ptr_inplace_guard(Block* s)
+          :s(s)
+        {}
+        ~shared_ptr_inplace_guard() __ntl_nothrow
+        {
+          if(s)
+            s->deallocate();
+        }
+
+        void* place() { return s->place(); }
+
+        shared_ptr<typename Block::value_type> share()
+        {
+          Block* b = s; s = nullptr;
+          return b->share();
+        }
+      };
+    }
+
+  #ifdef NTL_CXX_VT
+    template<class T, class... Args>
+    inline shared_ptr<T> make_shared(const Args&... args)
+    {
+      __::shared_ptr_inplace_guard<__::shared_ptr_inplace<T> > s(__::shared_ptr_inplace<T>::allocate());
+      ::new(s.place()) T(args...);
+      return s.share();
     }
 
+    template<class T, class Alloc, class... Args>
+    inline shared_ptr<T> allocate_shared(const Alloc& a, const Args&... args)
+    {
+      __::shared_ptr_inplace_guard<__::shared_ptr_inplace_a<T, Alloc> > s(__::shared_ptr_inplace_a<T, Alloc>::allocate(a));
+      ::new(s.place()) T(args...);
+      return s.share();
+    }
+  #else
     template<class T>
     inline shared_ptr<T> make_shared()
     {
-      return shared_ptr<T>(new T());
+      __::shared_ptr_inplace_guard<__::shared_ptr_inplace<T> > s(__::shared_ptr_inplace<T>::allocate());
+      ::new(s.place()) T();
+      return s.share();
     }
     template<class T, class A1>
     inline shared_ptr<T> make_shared(const A1& a1)
     {
-      return shared_ptr<T>(new T(a1));
+      __::shared_ptr_inplace_guard<__::shared_ptr_inplace<T> > s(__::shared_ptr_inplace<T>::allocate());
+      ::new(s.place()) T(a1);
+      return s.share();
     }
     template<class T, class A1, class A2>
     inline shared_ptr<T> make_shared(const A1& a1, const A2& a2)
     {
-      return shared_ptr<T>(new T(a1,a2));
+      __::shared_ptr_inplace_guard<__::shared_ptr_inplace<T> > s(__::shared_ptr_inplace<T>::allocate());
+      ::new(s.place()) T(a1, a2);
+      return s.share();
+    }
+    template<class T, class A1, class A2, class A3>
+    inline shared_ptr<T> make_shared(const A1& a1, const A2& a2, const A3& a3)
+    {
+      __::shared_ptr_inplace_guard<__::shared_ptr_inplace<T> > s(__::shared_ptr_inplace<T>::allocate());
+      ::new(s.place()) T(a1, a2, a3);
+      return s.share();
+    }
+    template<class T, class A1, class A2, class A3, class A4>
+    inline shared_ptr<T> make_shared(const A1& a1, const A2& a2, const A3& a3, const A4& a4)
+    {
+      __::shared_ptr_inplace_guard<__::shared_ptr_inplace<T> > s(__::shared_ptr_inplace<T>::allocate());
+      ::new(s.place()) T(a1, a2, a3, a4);
+      return s.share();
     }
 
     template<class T, class Alloc>
     inline shared_ptr<T> allocate_shared(const Alloc& a)
     {
-      typename Alloc::template rebind<T>::other at(a);
-      T* p = at.allocate(1);
-      at.construct(p, T());
-      return __::shared_ptr_allocate(p, at);
+      __::shared_ptr_inplace_guard<__::shared_ptr_inplace_a<T, Alloc> > s(__::shared_ptr_inplace_a<T, Alloc>::allocate(a));
+      ::new(s.place()) T();
+      return s.share();
     }
-
     template<class T, class Alloc, class A1>
     inline shared_ptr<T> allocate_shared(const Alloc& a, const A1& a1)
     {
-      typename Alloc::template rebind<T>::other at(a);
-      T* p = at.allocate(1);
-      at.construct(p, a1);
-      return __::shared_ptr_allocate(p, at);
+      __::shared_ptr_inplace_guard<__::shared_ptr_inplace_a<T, Alloc> > s(__::shared_ptr_inplace_a<T, Alloc>::allocate(a));
+      ::new(s.place()) T(a1);
+      return s.share();
     }
     template<class T, class Alloc, class A1, class A2>
     inline shared_ptr<T> allocate_shared(const Alloc& a, const A1& a1, const A2& a2)
     {
-      typename Alloc::template rebind<T>::other at(a);
-      T* p = at.allocate(1);
-      at.construct(p, a1,a2);
-      return __::shared_ptr_allocate(p, at);
+      __::shared_ptr_inplace_guard<__::shared_ptr_inplace_a<T, Alloc> > s(__::shared_ptr_inplace_a<T, Alloc>::allocate(a));
+      ::new(s.place()) T(a1, a2);
+      return s.share();
+    }
+    template<class T, class Alloc, class A1, class A2, class A3>
+    inline shared_ptr<T> allocate_shared(const Alloc& a, const A1& a1, const A2& a2, const A3& a3)
+    {
+      __::shared_ptr_inplace_guard<__::shared_ptr_inplace_a<T, Alloc> > s(__::shared_ptr_inplace_a<T, Alloc>::allocate(a));
+      ::new(s.place()) T(a1, a2, a3);
+      return s.share();
+    }
+    template<class T, class Alloc, class A1, class A2, class A3, class A4>
+    inline shared_ptr<T> allocate_shared(const Alloc& a, const A1& a1, const A2& a2, const A3& a3, const A4& a4)
+    {
+      __::shared_ptr_inplace_guard<__::shared_ptr_inplace_a<T, Alloc> > s(__::shared_ptr_inplace_a<T, Alloc>::allocate(a));
+      ::new(s.place()) T(a1, a2, a3, a4);
+      return s.share();
     }
   #endif
 
@@ -660,6 +660,15 @@ namespace std
   };//template class unique_ptr<T[N], default_delete<T[N]> >
   #endif
 
+  namespace ext
+  {
+    // unique_ptr with the stateless deleter holds only the pointer
+    template<class T>
+    struct is_trivially_relocatable<unique_ptr<T, default_delete<T> > >: true_type {};
+    template<class T>
+    struct is_trivially_relocatable<unique_ptr<T[], default_delete<T[]> > >: true_type {};
+  }
+
   ///\name 20.8.11.4 unique_ptr creation [unique.ptr.create]
 
   namespace __
@@ -886,6 +895,7 @@ namespace std
     struct shared_cast_const{};
     struct shared_allocator_tag{};
     template<class> struct check_shared;
+    template<class> struct shared_ptr_inplace;
 
     template<class T, class U>
     inline shared_ptr_data<T>* shared_data_cast(shared_ptr_data<U>* data)
@@ -905,6 +915,7 @@ namespace std
     template<class Y> friend struct __::check_shared;
     template<class Y> friend class weak_ptr;
     template<class Y> friend class shared_ptr;
+    template<class Y> friend struct __::shared_ptr_inplace;
     template<class D, class T> 
     friend D* get_deleter(shared_ptr<T> const& p);
 
@@ -1168,6 +1179,11 @@ namespace std
         add_ref();
       }
     }
+    explicit shared_ptr(__::shared_ptr_inplace<T>* s) __ntl_nothrow
+      :shared(s),ptr()
+    {
+      set(s->p);
+    }
   protected:
     bool empty() const __ntl_nothrow { return !shared; }
     void add_ref()
@@ -1205,86 +1221,122 @@ namespace std
   // 20.7.12.2.6, shared_ptr creation
   namespace __
   {
-    template<class T, class Alloc>
-    inline shared_ptr<T> shared_ptr_allocate(T* p, Alloc&& a)
+    /** The control block which holds the object itself, so make_shared takes the single allocation */
+    template<class T>
+    struct shared_ptr_inplace
+      : shared_ptr_data<T>
     {
-      struct deleter
-      {
-        Alloc a;
-        deleter(Alloc&& a)
-          :a(forward<Alloc>(a)){}
-        deleter(deleter&& d)
-          :a(move(d.a))
-        {}
-        void operator()(T* p)__ntl_nothrow
-        {
-          a.destroy(p);
-          a.deallocate(p, 1);
-        }
-      } d(forward<Alloc>(a));
-      return shared_ptr<T>(p, d, a);
-    }
-  }
+      typedef T value_type;
 
-#ifdef NTL_CXX_VT
+      typename aligned_storage<sizeof(T), alignof(T)>::type storage;
 
-  template<class T, class... Args> 
-  inline shared_ptr<T> make_shared(Args&&... args)
-  {
-    struct object_deleter
-    {
-      int guard1;
-      typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
-      int guard2;
-      bool exists;
+      shared_ptr_inplace()
+        :shared_ptr_data<T>(nullptr)
+      {}
+
+      static shared_ptr_inplace* allocate()
+      {
+        return new shared_ptr_inplace();
+      }
+      void deallocate() __ntl_nothrow
+      {
+        delete this;
+      }
 
-      T* data() { return reinterpret_cast<T*>(&storage); }
+      void* place() { return &storage; }
 
-      void free()
+      /** Takes the ownership of the object constructed in place() */
+      shared_ptr<T> share()
       {
-        if(exists) {
-          exists = false;
-          data()->~T();
+        this->p = reinterpret_cast<T*>(&storage);
+        return shared_ptr<T>(this);
+      }
+
+      void free() __ntl_nothrow
+      {
+        if(this->p){
+          T* pp = this->p; this->p = nullptr;
+          pp->~T();
         }
       }
+    };
+
+    /** The control block of allocate_shared, lives in the memory of the allocator */
+    template<class T, class A>
+    struct shared_ptr_inplace_a
+      : shared_ptr_inplace<T>
+    {
+      typedef typename A::template rebind<shared_ptr_inplace_a>::other block_allocator;
+
+      A alloc;
 
-      void operator() (T*)
+      explicit shared_ptr_inplace_a(const A& a)
+        :alloc(a)
+      {}
+
+      static shared_ptr_inplace_a* allocate(const A& a)
       {
-        free();
+        block_allocator ba(a);
+        shared_ptr_inplace_a* s = ba.allocate(1);
+        ::new(static_cast<void*>(s)) shared_ptr_inplace_a(a);
+        return s;
+      }
+      void deallocate() __ntl_nothrow
+      {
+        block_allocator ba(alloc);
+        this->~shared_ptr_inplace_a();
+        ba.deallocate(this, 1);
       }
 
-      ~object_deleter()
+      void dispose() __ntl_nothrow
       {
-        free();
+        this->free();
+        deallocate();
       }
+    };
 
-      object_deleter()
-        : exists(false)
-        , guard1(32)
-        , guard2(64)
+    /** Releases the control block if the constructor of the object throws */
+    template<class Block>
+    class shared_ptr_inplace_guard:
+      ntl::noncopyable
+    {
+      Block* s;
+    public:
+      explicit shared_ptr_inplace_guard(Block* s)
+        :s(s)
       {}
-    };
+      ~shared_ptr_inplace_guard() __ntl_nothrow
+      {
+        if(s)
+          s->deallocate();
+      }
 
-    shared_ptr<T> sp(static_cast<T*>(nullptr), object_deleter());
-    object_deleter* sd = std::get_deleter<object_deleter>(sp);
-    
-    T* p = sd->data();
-    ::new ( static_cast<void*>(p) ) T(forward<Args>(args)...);
-    sd->exists = true;
+      void* place() { return s->place(); }
 
-    __::check_shared<T>::check(p, p, sp);
+      shared_ptr<typename Block::value_type> share()
+      {
+        Block* b = s; s = nullptr;
+        return b->share();
+      }
+    };
+  }
+
+#ifdef NTL_CXX_VT
 
-    std::shared_ptr<T> ret(sp, p);
-    return ret;
+  template<class T, class... Args>
+  inline shared_ptr<T> make_shared(Args&&... args)
+  {
+    __::shared_ptr_inplace_guard<__::shared_ptr_inplace<T> > s(__::shared_ptr_inplace<T>::allocate());
+    ::new(s.place()) T(forward<Args>(args)...);
+    return s.share();
   }
 
   template<class T, class Alloc, class... Args>
   inline shared_ptr<T> allocate_shared(const Alloc& a, Args&&... args)
   {
-    typename Alloc::template rebind<T>::other at(a);
-    T* p = at.allocate(1);
-    at.construct(p, forward<Args>(args)...);
-    return __::shared_ptr_allocate(p, at);
+    __::shared_ptr_inplace_guard<__::shared_ptr_inplace_a<T, Alloc> > s(__::shared_ptr_inplace_a<T, Alloc>::allocate(a));
+    ::new(s.place()) T(forward<Args>(args)...);
+    return s.share();
   }
 
 #else
@@ -1292,44 +1344,73 @@ namespace std
   template<class T>
   inline shared_ptr<T> make_shared()
   {
-    return shared_ptr<T>(new T());
+    __::shared_ptr_inplace_guard<__::shared_ptr_inplace<T> > s(__::shared_ptr_inplace<T>::allocate());
+    ::new(s.place()) T();
+    return s.share();
   }
   template<class T, class A1>
   inline shared_ptr<T> make_shared(A1&& a1)
   {
-    return shared_ptr<T>(new T(forward<A1>(a1)));
+    __::shared_ptr_inplace_guard<__::shared_ptr_inplace<T> > s(__::shared_ptr_inplace<T>::allocate());
+    ::new(s.place()) T(forward<A1>(a1));
+    return s.share();
   }
   template<class T, class A1, class A2>
   inline shared_ptr<T> make_shared(A1&& a1, A2&& a2)
   {
-    return shared_ptr<T>(new T(forward<A1>(a1),forward<A2>(a2)));
+    __::shared_ptr_inplace_guard<__::shared_ptr_inplace<T> > s(__::shared_ptr_inplace<T>::allocate());
+    ::new(s.place()) T(forward<A1>(a1), forward<A2>(a2));
+    return s.share();
+  }
+  template<class T, class A1, class A2, class A3>
+  inline shared_ptr<T> make_shared(A1&& a1, A2&& a2, A3&& a3)
+  {
+    __::shared_ptr_inplace_guard<__::shared_ptr_inplace<T> > s(__::shared_ptr_inplace<T>::allocate());
+    ::new(s.place()) T(forward<A1>(a1), forward<A2>(a2), forward<A3>(a3));
+    return s.share();
+  }
+  template<class T, class A1, class A2, class A3, class A4>
+  inline shared_ptr<T> make_shared(A1&& a1, A2&& a2, A3&& a3, A4&& a4)
+  {
+    __::shared_ptr_inplace_guard<__::shared_ptr_inplace<T> > s(__::shared_ptr_inplace<T>::allocate());
+    ::new(s.place()) T(forward<A1>(a1), forward<A2>(a2), forward<A3>(a3), forward<A4>(a4));
+    return s.share();
   }
 
   template<class T, class Alloc>
   inline shared_ptr<T> allocate_shared(const Alloc& a)
   {
-    typename Alloc::template rebind<T>::other at(a);
-    T* p = at.allocate(1);
-    at.construct(p, forward<T>(T()));
-    // NOTE: possible copy of at. may be allocate(p, move(at))?
-    return __::shared_ptr_allocate(p, at);
+    __::shared_ptr_inplace_guard<__::shared_ptr_inplace_a<T, Alloc> > s(__::shared_ptr_inplace_a<T, Alloc>::allocate(a));
+    ::new(s.place()) T();
+    return s.share();
   }
-
   template<class T, class Alloc, class A1>
   inline shared_ptr<T> allocate_shared(const Alloc& a, A1&& a1)
   {
-    typename Alloc::template rebind<T>::other at(a);
-    T* p = at.allocate(1);
-    at.construct(p, forward<A1>(a1));
-    return __::shared_ptr_allocate(p, at);
+    __::shared_ptr_inplace_guard<__::shared_ptr_inplace_a<T, Alloc> > s(__::shared_ptr_inplace_a<T, Alloc>::allocate(a));
+    ::new(s.place()) T(forward<A1>(a1));
+    return s.share();
   }
   template<class T, class Alloc, class A1, class A2>
   inline shared_ptr<T> allocate_shared(const Alloc& a, A1&& a1, A2&& a2)
   {
-    typename Alloc::template rebind<T>::other at(a);
-    T* p = at.allocate(1);
-    at.construct(p, forward<A1>(a1),forward<A2>(a2));
-    return __::shared_ptr_allocate(p, at);
+    __::shared_ptr_inplace_guard<__::shared_ptr_inplace_a<T, Alloc> > s(__::shared_ptr_inplace_a<T, Alloc>::allocate(a));
+    ::new(s.place()) T(forward<A1>(a1), forward<A2>(a2));
+    return s.share();
+  }
+  template<class T, class Alloc, class A1, class A2, class A3>
+  inline shared_ptr<T> allocate_shared(const Alloc& a, A1&& a1, A2&& a2, A3&& a3)
+  {
+    __::shared_ptr_inplace_guard<__::shared_ptr_inplace_a<T, Alloc> > s(__::shared_ptr_inplace_a<T, Alloc>::allocate(a));
+    ::new(s.place()) T(forward<A1>(a1), forward<A2>(a2), forward<A3>(a3));
+    return s.share();
+  }
+  template<class T, class Alloc, class A1, class A2, class A3, class A4>
+  inline shared_ptr<T> allocate_shared(const Alloc& a, A1&& a1, A2&& a2, A3&& a3, A4&& a4)
+  {
+    __::shared_ptr_inplace_guard<__::shared_ptr_inplace_a<T, Alloc> > s(__::shared_ptr_inplace_a<T, Alloc>::allocate(a));
+    ::new(s.place()) T(forward<A1>(a1), forward<A2>(a2), forward<A3>(a3), forward<A4>(a4));
+    return s.share();
   }
 #endif
 
@@ -545,7 +545,7 @@ struct char_traits<wchar_t>
     __forceinline
     basic_string& operator=(initializer_list<charT> il)
     {
-      return *this = basic_string(il);
+      return *this = basic_string(il, alloc);
     }
 
 
@@ -1012,7 +1012,7 @@ struct char_traits<wchar_t>
 
     basic_string& replace(size_type pos, size_type n1, size_type n2, charT c)
     {
-      return replace(pos, n1, basic_string(n2,c));
+      return replace(pos, n1, basic_string(n2,c,alloc));
     }
 
     basic_string& replace(iterator i1, iterator i2, const basic_string& str)
@@ -1032,7 +1032,7 @@ struct char_traits<wchar_t>
 
     basic_string& replace(iterator i1, iterator i2, size_type n, charT c)
     {
-      return replace(i1,i2,basic_string(n,c));
+      return replace(i1,i2,basic_string(n,c,alloc));
     }
 
     template<class InputIterator>
@@ -1073,7 +1073,7 @@ struct char_traits<wchar_t>
               advance(src, rlen-xlen);
             else if(first_pos < pos && first_pos+rlen > pos){
               // splitted
-              basic_string tmp(first, last);
+              basic_string tmp(first, last, alloc);
               return replace_it(pos, n, tmp.begin(), tmp.end(), iterator_traits<RandomIterator>::iterator_category());
             }
           }
@@ -1163,7 +1163,7 @@ struct char_traits<wchar_t>
               pos2 += rlen-xlen;
             else if(s+pos2 < buffer_+pos1 && s+pos2+rlen > buffer_+pos1){
               // splitted part
-              basic_string tmp(s+pos2, rlen);
+              basic_string tmp(s+pos2, rlen, alloc);
               return replace_impl(pos1, n1, tmp.c_str(), tmp.length(), 0, rlen);
             }
           }
@@ -1553,9 +1553,9 @@ next_xpos:;
     {
       if(pos > size()){
         __throw_out_of_range("std::basic_string::substr(): invalid `pos`");
-        return basic_string();
+        return basic_string(alloc);
       }
-      return basic_string(*this, pos, n);
+      return basic_string(*this, pos, n, alloc);
     }
 
     ///\name  basic_string::compare [21.4.7.9 string::compare]
@@ -1631,7 +1631,7 @@ next_xpos:;
     friend
       basic_string operator+(const basic_string& lhs, const basic_string& rhs)
     {
-      basic_string<charT, traits, Allocator> sum;
+      basic_string<charT, traits, Allocator> sum(lhs.alloc);
       sum.alloc__new(lhs.size() + rhs.size());
       sum.append_to__reserved(lhs.begin(), lhs.end());
       sum.append_to__reserved(rhs.begin(), rhs.end());
@@ -1641,7 +1641,7 @@ next_xpos:;
     friend
       basic_string operator+(const charT* lhs, const basic_string& rhs)
     {
-      basic_string<charT, traits, Allocator> sum;
+      basic_string<charT, traits, Allocator> sum(rhs.alloc);
       sum.alloc__new(traits_type::length(lhs) + rhs.size());
       sum.append_to__reserved(lhs);
       sum.append_to__reserved(rhs.begin(), rhs.end());
@@ -1651,7 +1651,7 @@ next_xpos:;
     friend
       basic_string operator+(charT lhs, const basic_string& rhs)
     {
-      basic_string<charT, traits, Allocator> sum;
+      basic_string<charT, traits, Allocator> sum(rhs.alloc);
       sum.alloc__new(1 + rhs.size());
       sum.append_to__reserved(lhs);
       sum.append_to__reserved(rhs.begin(), rhs.end());
@@ -1661,7 +1661,7 @@ next_xpos:;
     friend
       basic_string operator+(const basic_string& lhs, const charT* rhs)
     {
-      basic_string<charT, traits, Allocator> sum;
+      basic_string<charT, traits, Allocator> sum(lhs.alloc);
       sum.alloc__new(lhs.size() + traits_type::length(rhs));
       sum.append_to__reserved(lhs.begin(), lhs.end());
       sum.append_to__reserved(rhs);
@@ -1671,7 +1671,7 @@ next_xpos:;
     friend
       basic_string operator+(const basic_string& lhs, charT rhs)
     {
-      basic_string<charT, traits, Allocator> sum;
+      basic_string<charT, traits, Allocator> sum(lhs.alloc);
       sum.alloc__new(lhs.size() + 1);
       sum.append_to__reserved(lhs.begin(), lhs.end());
       sum.push_back(rhs);
@@ -1998,6 +1998,18 @@ typedef basic_string<char16_t> u16string;
 /** Specialization of basic_string for the \e char32_t characters */
 typedef basic_string<char32_t> u32string;
 
+namespace pmr
+{
+  template<class T> class polymorphic_allocator;
+#ifdef NTL_CXX_TT
+  /** basic_string which allocates from a memory_resource */
+  template<class charT, class traits = char_traits<charT> >
+  using basic_string = std::basic_string<charT, traits, polymorphic_allocator<charT> >;
+#endif
+  typedef std::basic_string<char, char_traits<char>, polymorphic_allocator<char> >          string;
+  typedef std::basic_string<wchar_t, char_traits<wchar_t>, polymorphic_allocator<wchar_t> > wstring;
+}
+
 
 ///\name 21.5 Numeric Conversions [string.conversions]
 
@@ -307,10 +307,29 @@ namespace std
   }
 
   // Hashing
-  template<> struct hash<string_ref>;
-  template<> struct hash<u16string_ref>;
-  template<> struct hash<u32string_ref>;
-  template<> struct hash<wstring_ref>;
+  namespace __
+  {
+    /**
+     *  basic_string_ref<> hash implementation, it gives the same values as the basic_string<> hash
+     *  and is transparent, so the unordered containers of strings can be searched by string_ref or character pointer.
+     **/
+    template <class charT, class traits>
+    struct string_hash<basic_string_ref<charT, traits> >:
+      unary_function<basic_string_ref<charT, traits>, size_t>
+    {
+      typedef void is_transparent;
+
+      inline size_t operator()(const basic_string_ref<charT, traits>& str) const __ntl_nothrow
+      {
+        return FNVHash()(str.data(), str.length()*sizeof(charT));
+      }
+    };
+  }
+
+  template<> struct hash<string_ref>: __::string_hash<string_ref>{};
+  template<> struct hash<u16string_ref>: __::string_hash<u16string_ref>{};
+  template<> struct hash<u32string_ref>: __::string_hash<u32string_ref>{};
+  template<> struct hash<wstring_ref>: __::string_hash<wstring_ref>{};
 
   //////////////////////////////////////////////////////////////////////////
   // string literals
@@ -232,6 +232,24 @@ namespace std {
     /** Swap contents of container with \c r */
     void swap(unordered_map& r);
 
+    /** Unlinks the element in specified position and returns its node */
+    node_type extract(const_iterator position);
+
+    /** Unlinks an element with the given key and returns its node, which is empty if there is no such element */
+    node_type extract(const key_type& k);
+
+    /** Inserts the element owned by the node handle without copying it */
+    insert_return_type insert(node_type&& nh);
+
+    /** Inserts the element owned by the node handle without copying it */
+    iterator insert(const_iterator hint, node_type&& nh);
+
+    /** Moves the elements of \c source whose keys are not present in the container, without copying them */
+    template<class H2, class P2> void merge(unordered_map<Key, T, H2, P2, Allocator>& source);
+
+    /** Moves the elements of \c source whose keys are not present in the container, without copying them */
+    template<class H2, class P2> void merge(unordered_multimap<Key, T, H2, P2, Allocator>& source);
+
     ///\name observers
 
     /** Returns hash function */
@@ -256,6 +274,20 @@ namespace std {
 
     /** Returns a range containing all elements with keys equivalent to given (maximum 1) */
     std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const;
+
+    /** Checks whether the container has an element with the given key */
+    bool contains(const key_type& k) const;
+
+    /** If both \c hasher and \c key_equal are transparent, find(), count(), equal_range() and contains()
+        also accept a key of any type \c K comparable with \c key_type */
+    template<class K> iterator find(const K& k);
+
+    /** Looks up the keys <tt>[first, last)</tt> and writes an iterator (a const_iterator for the const container) to the element or end() for each of them to \c result,
+        overlapping the memory accesses of the independent lookups */
+    template<class ForwardIterator, class OutputIterator>
+    OutputIterator find_batch(ForwardIterator first, ForwardIterator last, OutputIterator result);
+    template<class ForwardIterator, class OutputIterator>
+    OutputIterator find_batch(ForwardIterator first, ForwardIterator last, OutputIterator result) const;
 #endif
 
     /** If the unordered_map does not already contain an element with the given key, inserts a default mapped value the value with the specified key */
@@ -516,6 +548,24 @@ namespace std {
     /** Swap contents of container with \c r */
     void swap(unordered_multimap& r);
 
+    /** Unlinks the element in specified position and returns its node */
+    node_type extract(const_iterator position);
+
+    /** Unlinks an element with the given key and returns its node, which is empty if there is no such element */
+    node_type extract(const key_type& k);
+
+    /** Inserts the element owned by the node handle without copying it */
+    iterator insert(node_type&& nh);
+
+    /** Inserts the element owned by the node handle without copying it */
+    iterator insert(const_iterator hint, node_type&& nh);
+
+    /** Moves all elements of \c source, without copying them */
+    template<class H2, class P2> void merge(unordered_multimap<Key, T, H2, P2, Allocator>& source);
+
+    /** Moves all elements of \c source, without copying them */
+    template<class H2, class P2> void merge(unordered_map<Key, T, H2, P2, Allocator>& source);
+
     ///\name observers
 
     /** Returns hash function */
@@ -541,6 +591,20 @@ namespace std {
     /** Returns a range containing all elements with keys equivalent to given */
     std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const;
 
+    /** Checks whether the container has an element with the given key */
+    bool contains(const key_type& k) const;
+
+    /** If both \c hasher and \c key_equal are transparent, find(), count(), equal_range() and contains()
+        also accept a key of any type \c K comparable with \c key_type */
+    template<class K> iterator find(const K& k);
+
+    /** Looks up the keys <tt>[first, last)</tt> and writes an iterator (a const_iterator for the const container) to the element or end() for each of them to \c result,
+        overlapping the memory accesses of the independent lookups */
+    template<class ForwardIterator, class OutputIterator>
+    OutputIterator find_batch(ForwardIterator first, ForwardIterator last, OutputIterator result);
+    template<class ForwardIterator, class OutputIterator>
+    OutputIterator find_batch(ForwardIterator first, ForwardIterator last, OutputIterator result) const;
+
     ///\name bucket interface
 
     /** Returns the number of buckets. */
@@ -583,6 +647,18 @@ namespace std {
   template <class Key, class T, class Hash, class Pred, class Alloc>
   inline void swap(unordered_multimap<Key, T, Hash, Pred, Alloc>& x, unordered_multimap<Key, T, Hash, Pred, Alloc>& y) { x.swap(y); }
 
+  namespace pmr
+  {
+    template<class T> class polymorphic_allocator;
+#ifdef NTL_CXX_TT
+    /** unordered_map which allocates from a memory_resource */
+    template<class Key, class T, class Hash = hash<Key>, class Pred = equal_to<Key> >
+    using unordered_map = std::unordered_map<Key, T, Hash, Pred, polymorphic_allocator<pair<const Key, T> > >;
+    template<class Key, class T, class Hash = hash<Key>, class Pred = equal_to<Key> >
+    using unordered_multimap = std::unordered_multimap<Key, T, Hash, Pred, polymorphic_allocator<pair<const Key, T> > >;
+#endif
+  }
+
   /**@} lib_unord */
   /**@} lib_containers */
 
@@ -417,40 +417,26 @@ class vector
 
   private:
 
+    /** Makes a raw gap of \c n elements at \c position, returns the end of the gap */
     iterator insert__blank_space(const_iterator position, const size_type n)
     {
-      const size_type old_capacity = capacity_;
-      iterator old_mem = 0;
-      iterator new_end = end_ + n;
-      // a hint to compiler - may be it'll eliminate  while ( tail_size-- ) ...
-      difference_type tail_size = end_ - position;
-      // realloc the first part if needed
-      if ( capacity_ < end_- begin_ + n )
+      const iterator pos = begin_ + (position - begin_);
+      const size_type new_capacity = capacity_ - size() < n ? grow_capacity(n) : 0;
+      if ( new_capacity && !expand(new_capacity) )
       {
-        old_mem = begin_;
-        capacity_ = n + capacity_factor();
-        const iterator new_mem = array_allocator.allocate(capacity_);
-        new_end = new_mem + difference_type(new_end - old_mem);
-        //new_end += difference_type(new_mem - old_mem);        // dangerous alignment
-        iterator dest = begin_ = new_mem;
-        // this is safe for begin_ == 0 && end_ == 0, but keep vector() intact
-        //#ifndef NTL_CXX_RV
-        for ( iterator src = old_mem; src != position; ++src, ++dest )
-          move(dest, src);
-        //#else
-        //for ( iterator src = old_mem; src != position; ++src, ++dest ){
-        //  *dest = std::move(*src);
-        //  array_allocator.destroy(src);
-        //}
-        //#endif
+        // relocate both parts to the new storage
+        const iterator new_mem = array_allocator.allocate(new_capacity);
+        const iterator gap_end = relocate(begin_, pos, new_mem, is_trivially_relocatable()) + n;
+        const iterator new_end = relocate(pos, end_, gap_end, is_trivially_relocatable());
+        if ( begin_ ) array_allocator.deallocate(begin_, capacity_);
+        begin_ = new_mem;
+        end_ = new_end;
+        capacity_ = new_capacity;
+        return gap_end;
       }
-      // move the tail. iterators are reverse - may be no realloc
-      iterator r_src = end();
-      iterator r_dest = end_ = new_end;
-      while ( tail_size-- )
-        move(--r_dest, --r_src);
-      if ( old_mem ) array_allocator.deallocate(old_mem, old_capacity);
-      return r_dest;
+      // move the tail in place
+      end_ = relocate_backward(pos, end_, end_ + n, is_trivially_relocatable());
+      return pos + n;
     }
 
     iterator insert__impl(const_iterator position, size_type n, const T& x)
@@ -522,17 +508,20 @@ class vector
     #ifdef NTL_CXX_RV
     void push_back(T&& x)
     {
-      if ( size() == capacity() ) realloc(capacity_factor());
-      //*end_++ = move(x);
-      array_allocator.construct(end_++, forward<value_type>(x));
+      if ( size() == capacity() && !expand(capacity_factor()) )
+        append__realloc(forward<value_type>(x));
+      else
+        array_allocator.construct(end_++, forward<value_type>(x));
     }
     #endif
 
     __forceinline
     void push_back(const T& x)
     {
-      if ( size() == capacity() ) realloc(capacity_factor());
-      array_allocator.construct(end_++, (x));
+      if ( size() == capacity() && !expand(capacity_factor()) )
+        append__realloc(x);
+      else
+        array_allocator.construct(end_++, (x));
     }
 
     void pop_back() __ntl_nothrow { array_allocator.destroy(--end_); }
@@ -695,26 +684,109 @@ class vector
       array_allocator.destroy(from);
     }
 
-    void realloc(size_type n) __ntl_throws(bad_alloc)
+    typedef ext::is_trivially_relocatable<T> is_trivially_relocatable;
+
+    /** Moves [first, last) to the raw storage at \c dest, the source storage becomes raw */
+    iterator relocate(iterator first, iterator last, iterator dest, false_type)
     {
-      const iterator new_mem = array_allocator.allocate(n);
-      const size_type old_capacity = capacity_;
+      // this is safe for begin_ == 0 && end_ == 0
+      for ( ; first != last; ++first, ++dest )
+        move(dest, first);
+      return dest;
+    }
+
+    iterator relocate(iterator first, iterator last, iterator dest, true_type)
+    {
+      const size_type n = static_cast<size_type>(last - first);
+      if ( n ) memcpy(dest, first, n * sizeof(T));
+      return dest + n;
+    }
+
+    /** Moves [first, last) to the right, ending at \c dest_last; the ranges may overlap */
+    iterator relocate_backward(iterator first, iterator last, iterator dest_last, false_type)
+    {
+      const iterator end = dest_last;
+      while ( first != last )
+        move(--dest_last, --last);
+      return end;
+    }
+
+    iterator relocate_backward(iterator first, iterator last, iterator dest_last, true_type)
+    {
+      const size_type n = static_cast<size_type>(last - first);
+      if ( n ) memmove(dest_last - n, first, n * sizeof(T));
+      return dest_last;
+    }
+
+    /** Tries to grow the storage in place, if the allocator supports it */
+    bool expand(size_type n)
+    {
+      if ( !__::allocator_expand<allocator>::expand(array_allocator, begin_, capacity_, n) )
+        return false;
       capacity_ = n;
-      iterator dest = new_mem;
-      // this is safe for begin_ == 0 && end_ == 0, but keep vector() coherent
-      for ( iterator src = begin_; src != end_; ++src, ++dest )
-        move(dest, src);
-      if ( begin_ ) array_allocator.deallocate(begin_, old_capacity);
+      return true;
+    }
+
+    /** Moves the elements to the new storage of \c n elements */
+    void replace_storage(const iterator new_mem, size_type n)
+    {
+      end_ = relocate(begin_, end_, new_mem, is_trivially_relocatable());
+      if ( begin_ ) array_allocator.deallocate(begin_, capacity_);
       begin_ = new_mem;
-      end_ = dest;
+      capacity_ = n;
+    }
+
+    void realloc(size_type n) __ntl_throws(bad_alloc)
+    {
+      if ( !expand(n) )
+        replace_storage(array_allocator.allocate(n), n);
+    }
+
+    // `x` may refer to an element, so construct it in the new storage before the relocation
+    void append__realloc(const T& x)
+    {
+      const size_type n = capacity_factor();
+      const iterator new_mem = array_allocator.allocate(n);
+      __ntl_try {
+        array_allocator.construct(new_mem + size(), x);
+      }
+      __ntl_catch(...) {
+        array_allocator.deallocate(new_mem, n);
+        __ntl_rethrow;
+      }
+      replace_storage(new_mem, n);
+      ++end_;
+    }
+
+    #ifdef NTL_CXX_RV
+    void append__realloc(T&& x)
+    {
+      const size_type n = capacity_factor();
+      const iterator new_mem = array_allocator.allocate(n);
+      __ntl_try {
+        array_allocator.construct(new_mem + size(), forward<value_type>(x));
+      }
+      __ntl_catch(...) {
+        array_allocator.deallocate(new_mem, n);
+        __ntl_rethrow;
+      }
+      replace_storage(new_mem, n);
+      ++end_;
     }
+    #endif
+
+    // Geometric growth by 1.5 (starting from 8 elements): push_back is amortized O(1),
+    // and unlike the doubling, the sum of the freed blocks eventually exceeds the next request,
+    // so the heap can reuse them.
+    //      8, 12, 18, 27, 40, 60, 90, 135, 202, ...
+    size_type capacity_factor() const { return capacity_ < 8 ? 8 : capacity_ + capacity_ / 2; }
 
-    //  + 8/2 serves two purposes:
-    //    capacity_ may be 0;
-    //    for smal capacity_ values reallocation will be more efficient
-    //      2,  4,  8,  16,  32,  64, 128, 256, 512
-    //      8, 24, 56, 120, 248, 504,
-    size_type capacity_factor() const { return (capacity_ + 4) * 2; }
+    size_type grow_capacity(size_type n) const __ntl_throws(length_error)
+    {
+      if ( max_size() - size() < n )
+        __throw_length_error(__name__": size too big");
+      return max(size() + n, capacity_factor());
+    }
 
 };//class vector
 
@@ -761,6 +833,16 @@ template <class T, class Allocator>
 inline void swap(vector<T, Allocator>& x, vector<T, Allocator>& y) __ntl_nothrow { x.swap(y); }
 
 ///@}
+
+namespace pmr
+{
+  template<class T> class polymorphic_allocator;
+#ifdef NTL_CXX_TT
+  /** vector which allocates from a memory_resource */
+  template<class T>
+  using vector = std::vector<T, polymorphic_allocator<T> >;
+#endif
+}
 /**@} lib_sequence */
 /**@} lib_containers */
 
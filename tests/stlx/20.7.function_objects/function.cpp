@@ -0,0 +1,80 @@
+#include <ntl-tests-common.hxx>
+#include <functional>
+
+STLX_DEFAULT_TESTGROUP_NAME("std::function");
+
+namespace
+{
+  int add(int a, int b) { return a + b; }
+
+  int copies, moves, live;
+
+  struct counted
+  {
+    int k, pad[15];
+    explicit counted(int k) : k(k) { ++live; }
+    counted(const counted& r) : k(r.k) { ++copies; ++live; }
+  #ifdef NTL_CXX_RV
+    counted(counted&& r) : k(r.k) { ++moves; ++live; }
+  #endif
+    ~counted() { --live; }
+    int operator()(int a, int b) const { return a * b + k; }
+  };
+
+  struct big
+  {
+    int x[16];
+    big() { for(int i = 0; i < 16; ++i) x[i] = i; }
+    int operator()(int a, int b) const { return a + b + x[15]; }
+  };
+
+  typedef std::function<int(int, int)> function;
+}
+
+template<> template<> void tut::to::test<01>()
+{
+  function f(&add), g = big();
+  quick_ensure(f(2, 3) == 5 && g(2, 3) == 20);
+  function c(f), d(g);
+  quick_ensure(c(1, 1) == 2 && d(1, 1) == 17);
+  c.swap(d);
+  quick_ensure(c(1, 1) == 17 && d(1, 1) == 2);
+  // the target stored inline and on the heap survives the swap with itself
+  d.swap(d);
+  c.swap(c);
+  quick_ensure(c(1, 1) == 17 && d(1, 1) == 2);
+  f = nullptr;
+  quick_ensure(!f);
+}
+
+// the copies of the stored callable are destroyed with their wrappers
+template<> template<> void tut::to::test<02>()
+{
+  live = 0;
+  {
+    function f = counted(5);
+    quick_ensure(f(2, 3) == 11 && live == 1);
+    function c(f);
+    quick_ensure(c(2, 3) == 11 && live == 2);
+    function small = &add;
+    c.swap(small);
+    quick_ensure(c(2, 3) == 5 && small(2, 3) == 11 && live == 2);
+  }
+  quick_ensure(live == 0);
+}
+
+#ifdef NTL_CXX_RV
+// the rvalue callable is moved into the wrapper, not copied
+template<> template<> void tut::to::test<03>()
+{
+  copies = moves = 0;
+  counted c(7);
+  function f(std::move(c));
+  quick_ensure(f(1, 1) == 8);
+  quick_ensure(copies == 0 && moves > 0);
+
+  function g;
+  g = counted(3);
+  quick_ensure(g(1, 1) == 4 && copies == 0);
+}
+#endif
@@ -0,0 +1,185 @@
+#include <ntl-tests-common.hxx>
+#include <deque>
+
+STLX_DEFAULT_TESTGROUP_NAME("std::deque");
+
+namespace
+{
+  typedef std::deque<int> deque;
+
+  // the values form the sequence first, first + 1, ...
+  bool is_sequence(const deque& d, int first)
+  {
+    for(deque::size_type i = 0; i < d.size(); ++i)
+      if(d[i] != first + static_cast<int>(i))
+        return false;
+    return true;
+  }
+
+  int live;
+
+  struct counted
+  {
+    int v;
+    counted(int v = 0) : v(v) { ++live; }
+    counted(const counted& r) : v(r.v) { ++live; }
+    ~counted() { --live; }
+  };
+}
+
+// push and pop at both ends across the chunk boundaries
+template<> template<> void tut::to::test<01>()
+{
+  deque d;
+  const int n = 5000;
+  for(int i = 0; i < n; ++i)
+    d.push_back(i);
+  quick_ensure(d.size() == n && d.front() == 0 && d.back() == n - 1 && is_sequence(d, 0));
+
+  for(int i = 1; i <= n; ++i)
+    d.push_front(-i);
+  quick_ensure(d.size() == 2 * n && d.front() == -n && is_sequence(d, -n));
+
+  for(int i = 0; i < 3000; ++i)
+    d.pop_front();
+  for(int i = 0; i < 4000; ++i)
+    d.pop_back();
+  quick_ensure(d.size() == 2 * n - 7000 && d.front() == 3000 - n && d.back() == n - 4001 && is_sequence(d, 3000 - n));
+
+  while(!d.empty())
+    d.pop_back();
+  d.push_front(7);
+  quick_ensure(d.size() == 1 && d.front() == 7 && d.back() == 7);
+}
+
+// the map of the chunks is recentred and grown while the deque is used as a queue and as a stack
+template<> template<> void tut::to::test<02>()
+{
+  deque queue;
+  int first = 0;
+  for(int i = 0; i < 100000; ++i){
+    queue.push_back(i);
+    if(queue.size() > 3000){
+      queue.pop_front();
+      ++first;
+    }
+  }
+  quick_ensure(queue.size() == 3000 && is_sequence(queue, first));
+
+  for(int i = 0; i < 100000; ++i){
+    queue.push_front(--first);
+    if(queue.size() > 3000)
+      queue.pop_back();
+  }
+  quick_ensure(queue.size() == 3000 && is_sequence(queue, first));
+
+  deque stack;
+  for(int i = 0; i < 50000; ++i){
+    stack.push_front(-i - 1);
+    stack.push_back(i);
+  }
+  quick_ensure(stack.size() == 100000 && is_sequence(stack, -50000));
+}
+
+// the insertion and the erasure in the middle shift the shorter half
+template<> template<> void tut::to::test<03>()
+{
+  const int n = 3000;
+  deque d;
+  for(int i = 0; i < n; ++i)
+    d.push_back(i);
+
+  deque::iterator i = d.insert(d.begin() + 10, -1);
+  quick_ensure(*i == -1 && i - d.begin() == 10 && d.size() == n + 1);
+  i = d.insert(d.end() - 100, -2);
+  quick_ensure(*i == -2 && d.end() - i == 101 && d.size() == n + 2);
+  quick_ensure(d[9] == 9 && d[11] == 10 && d[n - 99] == -2 && d[n - 98] == n - 100 && d[n + 1] == n - 1);
+
+  i = d.erase(d.begin() + 10);
+  quick_ensure(*i == 10);
+  i = d.erase(d.end() - 101);
+  quick_ensure(*i == n - 100 && d.size() == n && is_sequence(d, 0));
+
+  // the ranges in the front and in the back half
+  i = d.erase(d.begin() + 100, d.begin() + 1200);
+  quick_ensure(*i == 1200 && d.size() == n - 1100 && d[99] == 99 && d[100] == 1200);
+  d.insert(d.begin() + 100, 1100, 0);
+  for(int k = 0; k < 1100; ++k)
+    d[100 + k] = 100 + k;
+  quick_ensure(d.size() == n && is_sequence(d, 0));
+
+  i = d.erase(d.end() - 1500, d.end() - 200);
+  quick_ensure(*i == n - 200 && d.size() == n - 1300 && d[n - 1501] == n - 1501);
+  d.insert(d.end() - 200, 1300, 0);
+  for(int k = 0; k < 1300; ++k)
+    d[n - 1500 + k] = n - 1500 + k;
+  quick_ensure(d.size() == n && is_sequence(d, 0));
+}
+
+// the iterators move across the chunks
+template<> template<> void tut::to::test<04>()
+{
+  deque d;
+  for(int i = 0; i < 10000; ++i)
+    d.push_front(9999 - i);
+  const deque& c = d;
+
+  quick_ensure(d.end() - d.begin() == 10000 && c.cend() - c.cbegin() == 10000);
+  deque::iterator i = d.begin();
+  for(int k = 0; k < 10000; k += 333)
+    quick_ensure(*(i + k) == k && &*(i + k) == &d[k] && (i + k) - i == k);
+
+  i += 1500;
+  quick_ensure(*i == 1500 && i[2500] == 4000 && i[-1500] == 0);
+  i -= 700;
+  quick_ensure(*i == 800 && i > d.begin() && i < d.end() && d.end() - i == 9200);
+  deque::iterator j = i;
+  for(int k = 0; k < 3000; ++k)
+    ++j;
+  quick_ensure(*j == 3800 && j - i == 3000);
+  for(int k = 0; k < 3000; ++k)
+    j--;
+  quick_ensure(j == i);
+
+  deque::const_iterator ci = c.end() - 1;
+  quick_ensure(*ci == 9999 && ci - c.begin() == 9999);
+
+  int expected = 9999;
+  bool ordered = true;
+  for(deque::const_reverse_iterator r = c.rbegin(); r != c.rend(); ++r)
+    ordered &= *r == expected--;
+  quick_ensure(ordered && expected == -1);
+}
+
+// clear and shrink_to_fit destroy the elements and keep the deque usable
+template<> template<> void tut::to::test<05>()
+{
+  live = 0;
+  {
+    std::deque<counted> d;
+    for(int i = 0; i < 5000; ++i){
+      d.push_back(counted(i));
+      d.push_front(counted(-i));
+    }
+    quick_ensure(live == 10000);
+
+    d.resize(3000);
+    quick_ensure(live == 3000 && d.size() == 3000 && d.back().v == -2000);
+    d.resize(4000, counted(5));
+    quick_ensure(live == 4000 && d.back().v == 5);
+
+    d.clear();
+    quick_ensure(live == 0 && d.empty() && d.begin() == d.end());
+    d.shrink_to_fit();
+    quick_ensure(d.empty());
+
+    for(int i = 0; i < 3000; ++i)
+      d.push_front(counted(i));
+    quick_ensure(live == 3000 && d.size() == 3000 && d.front().v == 2999 && d.back().v == 0);
+    for(int i = 0; i < 2000; ++i)
+      d.pop_back();
+    d.shrink_to_fit();
+    quick_ensure(live == 1000 && d.size() == 1000 && d.back().v == 2000);
+  }
+  quick_ensure(live == 0);
+}
@@ -0,0 +1,62 @@
+#include <ntl-tests-common.hxx>
+#include <unordered_map>
+
+STLX_DEFAULT_TESTGROUP_NAME("std::unordered_map#find_batch");
+
+namespace
+{
+  typedef std::unordered_map<int, int> map;
+
+  // remembers the positions and whether they were written as const_iterator
+  struct recorder
+  {
+    map::const_iterator* out;
+    bool* const_only;
+
+    recorder(map::const_iterator* out, bool* const_only)
+      :out(out), const_only(const_only)
+    {}
+
+    recorder& operator*() { return *this; }
+    recorder& operator++() { ++out; return *this; }
+    recorder& operator=(const map::const_iterator& i) { *out = i; return *this; }
+    recorder& operator=(const map::iterator& i) { *out = i; *const_only = false; return *this; }
+  };
+}
+
+template<> template<> void tut::to::test<01>()
+{
+  map m;
+  for(int i = 0; i < 100; ++i)
+    m[i*3] = i;
+
+  int keys[40];
+  for(int i = 0; i < 40; ++i)
+    keys[i] = i*5;
+
+  map::iterator found[40];
+  quick_ensure(m.find_batch(keys, keys + 40, found) == found + 40);
+  for(int i = 0; i < 40; ++i)
+    quick_ensure(found[i] == m.find(keys[i]));
+}
+
+// the const container gives the const iterators
+template<> template<> void tut::to::test<02>()
+{
+  map m;
+  for(int i = 0; i < 20; ++i)
+    m[i] = i*i;
+  const map& cm = m;
+
+  const int keys[] = { 0, 7, 19, 20, -1 };
+  map::const_iterator found[5];
+  bool const_only = true;
+  cm.find_batch(keys, keys + 5, recorder(found, &const_only));
+  quick_ensure(const_only);
+  quick_ensure(found[0]->second == 0 && found[1]->second == 49 && found[2]->second == 361);
+  quick_ensure(found[3] == cm.end() && found[4] == cm.end());
+
+  const_only = true;
+  m.find_batch(keys, keys + 5, recorder(found, &const_only));
+  quick_ensure(!const_only);
+}
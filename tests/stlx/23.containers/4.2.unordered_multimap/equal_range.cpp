@@ -0,0 +1,65 @@
+#include <ntl-tests-common.hxx>
+#include <unordered_map>
+
+STLX_DEFAULT_TESTGROUP_NAME("std::unordered_multimap#equal_range");
+
+namespace
+{
+  // the identity hash with a few buckets puts several hash values into one bucket
+  struct identity
+  {
+    size_t operator()(unsigned x) const { return x; }
+  };
+
+  typedef std::unordered_multimap<unsigned, unsigned, identity> multimap;
+
+  void check_all(const multimap& m, const unsigned* counts, unsigned n)
+  {
+    for(unsigned k = 0; k < n; ++k){
+      std::pair<multimap::const_iterator, multimap::const_iterator> r = m.equal_range(k);
+      unsigned found = 0;
+      for(; r.first != r.second; ++r.first, ++found)
+        quick_ensure(r.first->first == k && r.first->second % 1000 == k);
+      quick_ensure(found == counts[k]);
+      quick_ensure(m.count(k) == counts[k]);
+    }
+  }
+}
+
+template<> template<> void tut::to::test<01>()
+{
+  const unsigned keys = 100;
+  unsigned counts[keys] = {};
+  multimap m(8);
+  unsigned seed = 7;
+  for(unsigned i = 0; i < 1000; ++i){
+    seed = seed * 1103515245 + 12345;
+    const unsigned k = (seed >> 16) % keys;
+    m.insert(std::make_pair(k, i*1000 + k));
+    ++counts[k];
+  }
+  check_all(m, counts, keys);
+
+  for(unsigned k = 1; k < keys; k += 2){
+    quick_ensure(m.erase(k) == counts[k]);
+    counts[k] = 0;
+  }
+  check_all(m, counts, keys);
+}
+
+// rehash keeps the equivalent keys together
+template<> template<> void tut::to::test<02>()
+{
+  const unsigned keys = 50;
+  unsigned counts[keys] = {};
+  multimap m(4);
+  for(unsigned i = 0; i < 500; ++i){
+    const unsigned k = (i * 7) % keys;
+    m.insert(std::make_pair(k, i*1000 + k));
+    ++counts[k];
+  }
+  m.rehash(64);
+  check_all(m, counts, keys);
+  m.rehash(3);
+  check_all(m, counts, keys);
+}
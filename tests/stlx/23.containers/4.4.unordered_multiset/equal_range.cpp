@@ -0,0 +1,77 @@
+#include <ntl-tests-common.hxx>
+#include <unordered_set>
+
+STLX_DEFAULT_TESTGROUP_NAME("std::unordered_multiset#equal_range");
+
+namespace
+{
+  // the identity hash with a few buckets puts several hash values into one bucket
+  struct identity
+  {
+    size_t operator()(unsigned x) const { return x; }
+  };
+
+  typedef std::unordered_multiset<unsigned, identity> multiset;
+
+  void check_all(const multiset& s, const unsigned* counts, unsigned n)
+  {
+    for(unsigned k = 0; k < n; ++k){
+      std::pair<multiset::const_iterator, multiset::const_iterator> r = s.equal_range(k);
+      unsigned found = 0;
+      for(; r.first != r.second; ++r.first, ++found)
+        quick_ensure(*r.first == k);
+      quick_ensure(found == counts[k]);
+      quick_ensure(s.count(k) == counts[k]);
+    }
+  }
+}
+
+// the equivalent keys stay together whatever hash values collide in their bucket
+template<> template<> void tut::to::test<01>()
+{
+  const unsigned keys = 200;
+  unsigned counts[keys] = {};
+  multiset s(8);
+  unsigned seed = 1;
+  for(unsigned i = 0; i < 2000; ++i){
+    seed = seed * 1103515245 + 12345;
+    const unsigned k = (seed >> 16) % keys;
+    s.insert(k);
+    ++counts[k];
+  }
+  quick_ensure(s.size() == 2000);
+  check_all(s, counts, keys);
+
+  // erase(k) removes every equivalent element
+  size_t size = s.size();
+  for(unsigned k = 0; k < keys; k += 3){
+    quick_ensure(s.erase(k) == counts[k]);
+    size -= counts[k];
+    counts[k] = 0;
+  }
+  quick_ensure(s.size() == size);
+  check_all(s, counts, keys);
+}
+
+// the element with a new hash value goes to the bucket which head has the equivalent keys
+template<> template<> void tut::to::test<02>()
+{
+  multiset s(4);
+  const unsigned head = 1;
+  unsigned other = head + 1;
+  while(s.bucket(other) != s.bucket(head))
+    ++other;
+  unsigned third = other + 1;
+  while(s.bucket(third) != s.bucket(head))
+    ++third;
+  s.insert(head);
+  s.insert(head);
+  s.insert(head);
+  s.insert(other);
+  s.insert(third);
+  s.insert(other);
+  quick_ensure(std::distance(s.equal_range(head).first, s.equal_range(head).second) == 3);
+  quick_ensure(std::distance(s.equal_range(other).first, s.equal_range(other).second) == 2);
+  quick_ensure(s.erase(head) == 3 && s.count(head) == 0 && s.size() == 3);
+  quick_ensure(s.erase(other) == 2 && s.count(third) == 1);
+}
@@ -0,0 +1,86 @@
+#include <ntl-tests-common.hxx>
+#include <thread>
+#include <stlx/ext/basic_shared_ptr.hxx>
+
+STLX_DEFAULT_TESTGROUP_NAME("std::ext::basic_shared_ptr");
+
+namespace
+{
+  std::atomic_long live;
+
+  struct object
+  {
+    int v;
+    explicit object(int v) : v(v) { live.fetch_add(1); }
+    ~object() { v = -1; live.fetch_sub(1); }
+  };
+
+  typedef std::ext::basic_shared_ptr<object, std::ext::atomic_refcount> pointer;
+
+  std::atomic<pointer>* shared;
+
+  void reader()
+  {
+    for(int i = 0; i < 100000; ++i){
+      pointer p = shared->load();
+      if(!p || p->v < 0)
+        live.fetch_add(1000000);  // reports the failure to the main thread
+    }
+  }
+
+  void writer()
+  {
+    for(int i = 0; i < 20000; ++i){
+      switch(i % 3){
+      case 0:
+        shared->store(std::ext::make_basic_shared<object, std::ext::atomic_refcount>(i));
+        break;
+      case 1:
+        shared->exchange(pointer(new object(i)));
+        break;
+      default:
+        pointer expected = shared->load();
+        shared->compare_exchange_strong(expected, pointer(new object(i)));
+        break;
+      }
+    }
+  }
+}
+
+// the atomic holds its own reference of the value
+template<> template<> void tut::to::test<01>()
+{
+  {
+    std::atomic<pointer> a;
+    quick_ensure(!a.load());
+    pointer x(new object(7));
+    a.store(x);
+    quick_ensure(a.load() == x);
+    quick_ensure(x.use_count() == 2);
+
+    pointer expected;
+    quick_ensure(!a.compare_exchange_strong(expected, pointer()) && expected == x);
+    pointer y(new object(8));
+    quick_ensure(a.compare_exchange_strong(expected, y));
+    quick_ensure(a.load() == y);
+    expected = pointer();
+    quick_ensure(x.use_count() == 1 && y.use_count() == 2);
+    quick_ensure(a.exchange(pointer()) == y);
+    quick_ensure(!a.load() && y.use_count() == 1);
+    a = x;
+  }
+  quick_ensure(live.load() == 0);
+}
+
+// the concurrent loads never see the value freed by the stores
+template<> template<> void tut::to::test<02>()
+{
+  {
+    std::atomic<pointer> a(pointer(new object(0)));
+    shared = &a;
+    std::thread r1(reader), r2(reader), r3(reader), w1(writer), w2(writer);
+    r1.join(); r2.join(); r3.join(); w1.join(); w2.join();
+    quick_ensure(live.load() == 1);
+  }
+  quick_ensure(live.load() == 0);
+}
@@ -0,0 +1,113 @@
+#include <ntl-tests-common.hxx>
+#include <thread>
+#include <stlx/ext/concurrent_skip_map.hxx>
+
+STLX_DEFAULT_TESTGROUP_NAME("std::ext::concurrent_skip_map");
+
+namespace
+{
+  std::atomic_long live;
+
+  // counts the copies stored in the nodes, so a node which is never reclaimed or reclaimed twice is noticed
+  struct value
+  {
+    int v;
+    value(int v = 0) : v(v) { live.fetch_add(1); }
+    value(const value& r) : v(r.v) { live.fetch_add(1); }
+    value& operator=(const value& r) { v = r.v; return *this; }
+    ~value() { live.fetch_sub(1); }
+  };
+
+  typedef std::ext::concurrent_skip_map<int, value> map;
+
+  const int keys = 64;
+  const int workers = 4;
+  const int rounds = 40000;
+
+  map* shared;
+  // the net count of the insertions and the removals of each key by each worker
+  int balance[workers][keys];
+  bool wrong_value[workers];
+
+  void work(int id)
+  {
+    unsigned seed = 2166136261U * (id + 1);
+    for(int i = 0; i < rounds; ++i){
+      seed = seed * 1103515245 + 12345;
+      // all workers share the few keys, so the insertion of a tower races with its removal
+      const int k = (seed >> 8) % keys;
+      switch((seed >> 20) % 8){
+      case 0:
+        {
+          int popped;
+          value v;
+          if(shared->pop_front(popped, v)){
+            --balance[id][popped];
+            wrong_value[id] |= v.v != popped * 2;
+          }
+        }
+        break;
+      case 1: case 2: case 3:
+        balance[id][k] -= static_cast<int>(shared->erase(k));
+        break;
+      default:
+        if(shared->insert(map::value_type(k, value(k * 2))))
+          ++balance[id][k];
+        break;
+      }
+    }
+  }
+
+  struct ordered
+  {
+    int* last;
+    int* count;
+    bool* ok;
+    void operator()(const map::value_type& e) const
+    {
+      *ok &= e.first > *last && e.second.v == e.first * 2;
+      *last = e.first;
+      ++*count;
+    }
+  };
+}
+
+// the concurrent insertions, removals and pops of the same keys leave the map consistent
+template<> template<> void tut::to::test<01>()
+{
+  live.store(0);
+  {
+    map m;
+    shared = &m;
+    std::thread w0(work, 0), w1(work, 1), w2(work, 2), w3(work, 3);
+    w0.join(); w1.join(); w2.join(); w3.join();
+    quick_ensure(!wrong_value[0] && !wrong_value[1] && !wrong_value[2] && !wrong_value[3]);
+
+    size_t present = 0;
+    bool consistent = true;
+    for(int k = 0; k < keys; ++k){
+      int net = 0;
+      for(int id = 0; id < workers; ++id)
+        net += balance[id][k];
+      consistent &= (net == 0 || net == 1) && m.contains(k) == (net == 1);
+      present += net;
+    }
+    quick_ensure(consistent && m.size() == present);
+
+    int last = -1, count = 0;
+    bool ok = true;
+    ordered visit = { &last, &count, &ok };
+    m.for_each(visit);
+    quick_ensure(ok && count == static_cast<int>(present));
+
+    value v;
+    for(int k = 0; k < keys; ++k)
+      if(m.find(k, v))
+        ok &= v.v == k * 2;
+    quick_ensure(ok);
+
+    m.clear();
+    quick_ensure(m.empty() && m.size() == 0);
+  }
+  quick_ensure(live.load() == 0);
+}
@@ -0,0 +1,109 @@
+#include <ntl-tests-common.hxx>
+#include <thread>
+#include <stlx/ext/concurrent_unordered_map.hxx>
+
+STLX_DEFAULT_TESTGROUP_NAME("std::ext::concurrent_unordered_map");
+
+namespace
+{
+  std::atomic_long live;
+
+  // counts the copies stored in the nodes, so a node which is never reclaimed or reclaimed twice is noticed
+  struct value
+  {
+    int v;
+    value(int v = 0) : v(v) { live.fetch_add(1); }
+    value(const value& r) : v(r.v) { live.fetch_add(1); }
+    value& operator=(const value& r) { v = r.v; return *this; }
+    ~value() { live.fetch_sub(1); }
+  };
+
+  typedef std::ext::concurrent_unordered_map<int, value> map;
+
+  const int residents = 1000;   // present during the whole run
+  const int writers = 2;
+  const int readers = 2;
+  const int per_writer = 12000;
+
+  map* shared;
+  std::atomic_long writers_done;
+  bool reader_failed[readers];
+
+  int writer_key(int id, int i) { return residents + id * per_writer + i; }
+
+  void write(int id)
+  {
+    for(int i = 0; i < per_writer; ++i){
+      shared->insert(map::value_type(writer_key(id, i), value(writer_key(id, i))));
+      // the odd keys are erased again, so the chains change while they are relinked
+      if(i & 1)
+        shared->erase(writer_key(id, i));
+      if(i % 4000 == 3999)
+        shared->rehash(shared->bucket_count() * 2);
+    }
+    writers_done.fetch_add(1);
+  }
+
+  void read(int id)
+  {
+    bool failed = false;
+    value v;
+    do{
+      // a resident key missed while the table grows is the lookup which didn't retry
+      for(int k = 0; k < residents; k += 7)
+        failed |= !shared->find(k, v) || v.v != k;
+      for(int k = residents; k < residents + writers * per_writer; k += 101)
+        if(shared->find(k, v))
+          failed |= v.v != k;
+    }while(writers_done.load() < writers);
+    reader_failed[id] = failed;
+  }
+
+  struct counter
+  {
+    int* count;
+    bool* ok;
+    void operator()(const map::value_type& e) const
+    {
+      *ok &= e.second.v == e.first;
+      ++*count;
+    }
+  };
+}
+
+// the lookups find every present element while the writers grow the table
+template<> template<> void tut::to::test<01>()
+{
+  live.store(0);
+  {
+    map m(map::lock_stripes);
+    for(int k = 0; k < residents; ++k)
+      m.insert(map::value_type(k, value(k)));
+    const size_t initial_buckets = m.bucket_count();
+
+    shared = &m;
+    writers_done.store(0);
+    std::thread r0(read, 0), r1(read, 1), w0(write, 0), w1(write, 1);
+    w0.join(); w1.join(); r0.join(); r1.join();
+    quick_ensure(!reader_failed[0] && !reader_failed[1]);
+    quick_ensure(m.bucket_count() >= initial_buckets * 16);
+
+    bool ok = true;
+    for(int k = 0; k < residents; ++k)
+      ok &= m.contains(k);
+    for(int id = 0; id < writers; ++id)
+      for(int i = 0; i < per_writer; ++i)
+        ok &= m.contains(writer_key(id, i)) == !(i & 1);
+    quick_ensure(ok);
+
+    const int expected = residents + writers * per_writer / 2;
+    int count = 0;
+    counter visit = { &count, &ok };
+    m.for_each(visit);
+    quick_ensure(ok && count == expected && m.size() == static_cast<size_t>(expected));
+
+    m.clear();
+    quick_ensure(m.empty());
+  }
+  quick_ensure(live.load() == 0);
+}
@@ -0,0 +1,35 @@
+#include <ntl-tests-common.hxx>
+#include <stlx/ext/dynamic_bitset.hxx>
+
+STLX_DEFAULT_TESTGROUP_NAME("std::ext::dynamic_bitset");
+
+typedef std::ext::dynamic_bitset<> bitset;
+
+// find_first/find_next visit every set bit in order
+template<> template<> void tut::to::test<01>()
+{
+  bitset b(200);
+  const size_t bits[] = { 0, 1, 63, 64, 65, 127, 128, 199 };
+  for(size_t i = 0; i < _countof(bits); ++i)
+    b.set(bits[i]);
+
+  size_t n = 0;
+  for(size_t pos = b.find_first(); pos != bitset::npos; pos = b.find_next(pos))
+    quick_ensure(n < _countof(bits) && pos == bits[n++]);
+  quick_ensure(n == _countof(bits));
+}
+
+// the search past the last bit does not wrap around
+template<> template<> void tut::to::test<02>()
+{
+  bitset b(130);
+  b.set(0);
+  b.set(129);
+  quick_ensure(b.find_next(129) == bitset::npos);
+  quick_ensure(b.find_next(500) == bitset::npos);
+  quick_ensure(b.find_next(bitset::npos) == bitset::npos);
+
+  bitset e;
+  quick_ensure(e.find_first() == bitset::npos);
+  quick_ensure(e.find_next(bitset::npos) == bitset::npos);
+}
@@ -0,0 +1,61 @@
+#include <ntl-tests-common.hxx>
+#include <stlx/ext/lru_cache.hxx>
+
+STLX_DEFAULT_TESTGROUP_NAME("std::ext::lru_cache");
+
+namespace
+{
+  int evicted_key;
+  void on_evict(const int& k, int&, void* count)
+  {
+    evicted_key = k;
+    ++*static_cast<int*>(count);
+  }
+}
+
+// the least recently used entry is evicted
+template<> template<> void tut::to::test<01>()
+{
+  std::ext::lru_cache<int, int> c(3);
+  int evicted = 0;
+  c.on_evict(on_evict, &evicted);
+  for(int i = 0; i < 3; ++i)
+    c.put(i, i*10);
+  quick_ensure(*c.get(0) == 0);
+  c.put(3, 30);
+  quick_ensure(evicted == 1 && evicted_key == 1);
+  quick_ensure(c.size() == 3 && c.contains(0) && !c.contains(1) && c.contains(3));
+  quick_ensure(c.erase(3) && !c.erase(3) && c.size() == 2);
+}
+
+// the charge is counted against the capacity
+template<> template<> void tut::to::test<02>()
+{
+  std::ext::lru_cache<int, int> c(100);
+  quick_ensure(c.put(1, 1, 60));
+  quick_ensure(c.put(2, 2, 30));
+  quick_ensure(c.usage() == 90);
+  quick_ensure(c.put(3, 3, 20));
+  quick_ensure(c.usage() == 50 && !c.contains(1));
+  quick_ensure(!c.put(4, 4, 200) && !c.contains(4));
+}
+
+// the table grows with the entries and the entries stay in place
+template<> template<> void tut::to::test<03>()
+{
+  const int n = 50000;
+  std::ext::lru_cache<int, int> c(n);
+  c.put(-1, 42);
+  int* const first = c.get(-1);
+  for(int i = 0; i < n - 1; ++i)
+    c.put(i, i);
+  quick_ensure(c.size() == static_cast<size_t>(n));
+  quick_ensure(c.get(-1) == first && *first == 42);
+  for(int i = 0; i < n - 1; ++i)
+    quick_ensure(*c.get(i) == i);
+
+  // the next one evicts the least recently used entry
+  c.get(-1);
+  c.put(n, n);
+  quick_ensure(c.contains(-1) && !c.contains(0) && c.size() == static_cast<size_t>(n));
+}
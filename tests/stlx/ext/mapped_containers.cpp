@@ -0,0 +1,54 @@
+#include <ntl-tests-common.hxx>
+#include <stlx/ext/mapped_containers.hxx>
+
+STLX_DEFAULT_TESTGROUP_NAME("std::ext::mapped_containers");
+
+namespace
+{
+  using std::ext::mapped_region;
+  using std::ext::mapped_string;
+  using std::ext::mapped_vector;
+
+  long long image[4096];
+
+  mapped_region* create_region()
+  {
+    return mapped_region::create(image, sizeof(image));
+  }
+}
+
+// the element of the vector is appended to it while the storage moves
+template<> template<> void tut::to::test<01>()
+{
+  mapped_region* r = create_region();
+  mapped_vector<mapped_string>& v = *r->construct<mapped_vector<mapped_string> >();
+  v.push_back("alpha");
+  // the storage of the vector is not the last block anymore, so it can't grow in place
+  r->construct<int>();
+  while(v.size() < v.capacity())
+    v.push_back("beta");
+
+  const size_t n = v.size();
+  v.push_back(v[0]);
+  quick_ensure(v.size() == n + 1 && v.capacity() > n);
+  quick_ensure(v[n] == "alpha" && v[0] == "alpha" && v[1] == "beta");
+}
+
+// the string is appended and assigned from itself
+template<> template<> void tut::to::test<02>()
+{
+  mapped_region* r = create_region();
+  mapped_string& s = *r->construct<mapped_string>();
+  s = "abcdef";
+  r->construct<int>();
+
+  s.append(s.c_str(), s.size());
+  quick_ensure(s == "abcdefabcdef");
+  s.append(s.c_str() + 6, 3);
+  quick_ensure(s == "abcdefabcdefabc");
+
+  s.assign(s.c_str() + 2, 4);
+  quick_ensure(s == "cdef" && s.size() == 4);
+  s.assign(s.c_str(), s.size());
+  quick_ensure(s == "cdef");
+}
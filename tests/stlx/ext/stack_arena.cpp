@@ -0,0 +1,73 @@
+#include <ntl-tests-common.hxx>
+#include <string>
+#include <vector>
+#include <map>
+#include <stlx/ext/stack_arena.hxx>
+
+STLX_DEFAULT_TESTGROUP_NAME("std::ext::stack_arena");
+
+namespace
+{
+  typedef std::ext::arena_allocator<char> char_allocator;
+  typedef std::basic_string<char, std::char_traits<char>, char_allocator> string;
+}
+
+// the string and its temporaries take the memory from the arena of the source string
+template<> template<> void tut::to::test<01>()
+{
+  std::ext::stack_arena<1024> arena;
+  char_allocator alloc(arena);
+  string s("hello", alloc);
+  quick_ensure(arena.owns(s.c_str()));
+
+  s.append(", world");
+  string sub = s.substr(7);
+  quick_ensure(sub == "world" && arena.owns(sub.c_str()));
+  quick_ensure(sub.get_allocator() == alloc);
+
+  string sum = s.substr(0, 5) + "!";
+  quick_ensure(sum == "hello!" && arena.owns(sum.c_str()));
+  sum = "<" + sum + '>';
+  quick_ensure(sum == "<hello!>" && arena.owns(sum.c_str()));
+  sum = '[' + sub + string("]", alloc);
+  quick_ensure(sum == "[world]" && arena.owns(sum.c_str()));
+
+  s.replace(0, 5, 3, 'x');
+  quick_ensure(s == "xxx, world" && arena.owns(s.c_str()));
+  quick_ensure(s.compare(0, 3, "xxx") == 0);
+}
+
+// the vector and the map share the arena through the rebound allocators
+template<> template<> void tut::to::test<02>()
+{
+  std::ext::stack_arena<2048> arena;
+  std::ext::arena_allocator<int> alloc(arena);
+
+  std::vector<int, std::ext::arena_allocator<int> > v(alloc);
+  for(int i = 0; i < 32; ++i)
+    v.push_back(i);
+  quick_ensure(v.size() == 32 && v[31] == 31 && arena.owns(&v[0]));
+
+  typedef std::ext::arena_allocator<std::pair<const int, int> > pair_allocator;
+  const pair_allocator pairs(arena);
+  std::map<int, int, std::less<int>, pair_allocator> m(std::less<int>(), pairs);
+  for(int i = 0; i < 16; ++i)
+    m[i] = i * i;
+  quick_ensure(m.size() == 16 && m[15] == 225 && arena.owns(&*m.begin()));
+  m.erase(3);
+  quick_ensure(m.size() == 15 && m.find(3) == m.end());
+}
+
+// the allocations which don't fit to the arena go to the parent allocator
+template<> template<> void tut::to::test<03>()
+{
+  std::ext::stack_arena<64> arena;
+  std::ext::arena_allocator<int> alloc(arena);
+  std::vector<int, std::ext::arena_allocator<int> > v(alloc);
+  for(int i = 0; i < 100; ++i)
+    v.push_back(i);
+  quick_ensure(v.size() == 100 && v[99] == 99 && !arena.owns(&v[0]));
+
+  arena.reset();
+  quick_ensure(arena.used() == 0);
+}